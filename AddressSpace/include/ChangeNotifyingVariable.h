@@ -25,6 +25,9 @@
 #include <opcua_basedatavariabletype.h>
 #include <functional>
 #include <list>
+#include <memory>
+#include <mutex>
+#include <PublishPolicy.h>
 
 namespace AddressSpace
 {
@@ -55,8 +58,20 @@ public:
     virtual size_t changeListenerSize () const { return m_changeListeners.size(); }
     virtual void removeAllChangeListeners () { m_changeListeners.clear(); }
 
+    //! number of server-side updates held back by the publish policy of this variable
+    uint64_t suppressedUpdates () const { return m_publishFilter ? m_publishFilter->suppressed() : 0; }
+
 private:
+    //! publishes the update kept by the publish filter, from the timer thread of the filters
+    void publishPending ();
+
+    void notifyChangeListeners (const UaDataValue& dataValue);
+
     std::list<OnChangeListener> m_changeListeners;
+    //! orders the server-side updates with the ones published later by the publish filter
+    std::mutex m_publishLock;
+    //! null unless a PublishPolicy of the configuration matches this variable
+    std::unique_ptr<PublishFilter> m_publishFilter;
 };
 
 }
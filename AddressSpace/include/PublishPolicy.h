@@ -0,0 +1,116 @@
+/* © Copyright CERN, 2026.  All rights not expressly granted are reserved.
+ * PublishPolicy.h
+ *
+ *  This file is part of Quasar.
+ *
+ *  Quasar is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public Licence as published by
+ *  the Free Software Foundation, either version 3 of the Licence.
+ *
+ *  Quasar is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public Licence for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with Quasar.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ADDRESSSPACE_INCLUDE_PUBLISHPOLICY_H_
+#define ADDRESSSPACE_INCLUDE_PUBLISHPOLICY_H_
+
+#include <string>
+#include <mutex>
+#include <chrono>
+#include <functional>
+#include <stdint.h>
+#include <uadatavalue.h>
+
+namespace AddressSpace
+{
+
+/* How often a server-side update of a cache-variable reaches the address space (and thus the subscribers).
+ * Configured per variable in StandardMetaData.PublishPolicies of the configuration file.
+ */
+struct PublishPolicy
+{
+    enum DeadbandType { None, Absolute, Percent };
+
+    PublishPolicy (): deadbandType(None), deadband(0), minIntervalMs(0), maxIntervalMs(0) {}
+
+    DeadbandType deadbandType;
+    //! absolute: in units of the variable, percent: of the last published value
+    double       deadband;
+    //! updates closer than this to the last published one are held back until it passed
+    unsigned int minIntervalMs;
+    //! an update is published regardless of the deadband once this much time passed, 0 means never
+    unsigned int maxIntervalMs;
+};
+
+/* The policies read from the configuration, matched against the string node ids of the variables.
+ * Policies are added while configuring Meta, that is before the variables are created.
+ */
+namespace PublishPolicies
+{
+    //! throws std::runtime_error if the regular expression is not valid
+    void add (const std::string& variablesRegex, const PublishPolicy& policy);
+
+    //! the first policy matching the variable, false if none does
+    bool find (const std::string& stringId, PublishPolicy& policy);
+
+    void clear ();
+}
+
+/* Per variable state of a PublishPolicy.
+ * A suppressed update is not lost: the latest one is kept, and once the interval that held it back expires
+ * (the minimum interval, or the maximum interval for an update inside the deadband) the owner is told to publish it.
+ * An update inside the deadband with no maximum interval is dropped.
+ */
+class PublishFilter
+{
+public:
+    //! called from the timer thread of the filters when the kept update is due, see takePending
+    typedef std::function<void ()> OnExpiry;
+
+    PublishFilter (const PublishPolicy& policy, OnExpiry onExpiry);
+
+    //! waits for a running onExpiry to return
+    ~PublishFilter ();
+
+    /* Decides whether an update is published, and if so records it as the last published one.
+     * A change of status is always published, the deadband only applies to numeric scalars.
+     */
+    bool shouldPublish (const UaDataValue& dataValue);
+
+    //! the kept update if it is due, recorded as the last published one; false if there is none
+    bool takePending (UaDataValue& dataValue);
+
+    //! meant for the timer thread only
+    void expire () { m_onExpiry(); }
+
+    uint64_t suppressed () const { return m_suppressed; }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    //! when an update can be published: at once if not later than now, never if Clock::time_point::max()
+    Clock::time_point publishTime (bool isNumeric, double value, uint32_t statusCode) const;
+
+    void record (bool isNumeric, double value, uint32_t statusCode, Clock::time_point now);
+
+    const PublishPolicy m_policy;
+    const OnExpiry      m_onExpiry;
+    std::mutex          m_lock;
+    bool                m_hasPublished;
+    bool                m_lastNumeric;
+    double              m_lastValue;
+    uint32_t            m_lastStatus;
+    Clock::time_point   m_lastTime;
+    uint64_t            m_suppressed;
+    bool                m_hasPending;
+    UaDataValue         m_pending;
+};
+
+}
+
+#endif /* ADDRESSSPACE_INCLUDE_PUBLISHPOLICY_H_ */
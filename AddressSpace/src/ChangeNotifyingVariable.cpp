@@ -42,11 +42,18 @@ ChangeNotifyingVariable::ChangeNotifyingVariable(
         pNodeConfig,
         pSharedMutex)
 {
-
+    PublishPolicy policy;
+    if (nodeId.identifierType() == OpcUa_IdentifierType_String &&
+        PublishPolicies::find(UaString(nodeId.identifierString()).toUtf8(), policy))
+    {
+        m_publishFilter.reset(new PublishFilter(policy, [this](){ publishPending(); }));
+    }
 }
 
 ChangeNotifyingVariable::~ChangeNotifyingVariable()
 {
+    // before the members publishPending uses are gone
+    m_publishFilter.reset();
 }
 
 UaStatus ChangeNotifyingVariable::setValue(
@@ -54,15 +61,50 @@ UaStatus ChangeNotifyingVariable::setValue(
     const UaDataValue& dataValue,
     OpcUa_Boolean checkAccessLevel)
 {
-    UaStatus status = OpcUa::BaseDataVariableType::setValue(pSession, dataValue, checkAccessLevel);
-    if (status.isGood())
-        for (OnChangeListener& changeListener : m_changeListeners)
+    // the publish policy applies to server-side updates only, never to writes of clients
+    if (m_publishFilter && !pSession)
+    {
+        UaStatus status;
         {
-            changeListener(*this, dataValue);
+            std::lock_guard<std::mutex> lock (m_publishLock);
+            if (!m_publishFilter->shouldPublish(dataValue))
+                return OpcUa_Good; // kept by the filter until it is due, see publishPending
+            status = OpcUa::BaseDataVariableType::setValue(pSession, dataValue, checkAccessLevel);
         }
+        if (status.isGood())
+            notifyChangeListeners(dataValue);
+        return status;
+    }
+    UaStatus status = OpcUa::BaseDataVariableType::setValue(pSession, dataValue, checkAccessLevel);
+    if (status.isGood())
+        notifyChangeListeners(dataValue);
     return status;
 }
 
+void ChangeNotifyingVariable::publishPending()
+{
+    UaDataValue dataValue;
+    UaStatus status;
+    {
+        std::lock_guard<std::mutex> lock (m_publishLock);
+        if (!m_publishFilter->takePending(dataValue))
+            return;
+        status = OpcUa::BaseDataVariableType::setValue(/*session*/ nullptr, dataValue, /*check access*/ OpcUa_False);
+    }
+    if (status.isGood())
+        notifyChangeListeners(dataValue);
+    else
+        LOG(Log::ERR, "AddressSpace") << "Publishing the held back update of " << this->nodeId().toString().toUtf8() << " failed: " << status.toString().toUtf8();
+}
+
+void ChangeNotifyingVariable::notifyChangeListeners(const UaDataValue& dataValue)
+{
+    for (OnChangeListener& changeListener : m_changeListeners)
+    {
+        changeListener(*this, dataValue);
+    }
+}
+
 void ChangeNotifyingVariable::addChangeListener (OnChangeListener onChangeListener)
 {
     m_changeListeners.push_back(onChangeListener);
@@ -0,0 +1,269 @@
+/* © Copyright CERN, 2026.  All rights not expressly granted are reserved.
+ * PublishPolicy.cpp
+ *
+ *  This file is part of Quasar.
+ *
+ *  Quasar is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public Licence as published by
+ *  the Free Software Foundation, either version 3 of the Licence.
+ *
+ *  Quasar is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public Licence for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with Quasar.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <PublishPolicy.h>
+#include <vector>
+#include <map>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+#include <condition_variable>
+#include <algorithm>
+#include <uavariant.h>
+#include <boost/xpressive/xpressive.hpp>
+
+namespace AddressSpace
+{
+
+namespace PublishPolicies
+{
+
+namespace
+{
+    struct Entry
+    {
+        boost::xpressive::sregex expression;
+        PublishPolicy policy;
+    };
+    std::vector<Entry> g_policies;
+    std::mutex g_policiesLock;
+}
+
+void add (const std::string& variablesRegex, const PublishPolicy& policy)
+{
+    Entry entry;
+    try
+    {
+        entry.expression = boost::xpressive::sregex::compile( variablesRegex );
+    }
+    catch (boost::xpressive::regex_error &e)
+    {
+        throw std::runtime_error("PublishPolicy: variables regular expression ["+variablesRegex+"] is wrong: "+e.what());
+    }
+    entry.policy = policy;
+    std::lock_guard<std::mutex> lock (g_policiesLock);
+    g_policies.push_back(entry);
+}
+
+bool find (const std::string& stringId, PublishPolicy& policy)
+{
+    std::lock_guard<std::mutex> lock (g_policiesLock);
+    for (const Entry& entry : g_policies)
+    {
+        if (boost::xpressive::regex_match(stringId, entry.expression))
+        {
+            policy = entry.policy;
+            return true;
+        }
+    }
+    return false;
+}
+
+void clear ()
+{
+    std::lock_guard<std::mutex> lock (g_policiesLock);
+    g_policies.clear();
+}
+
+}
+
+namespace
+{
+
+/* Calls PublishFilter::expire when the kept update of a filter is due.
+ * The thread is started by the first filter that keeps an update, and never stopped:
+ * the timer is not destroyed, so that filters destroyed at exit can still unschedule themselves.
+ */
+class ExpiryTimer
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    static ExpiryTimer& instance ()
+    {
+        static ExpiryTimer* timer = new ExpiryTimer;
+        return *timer;
+    }
+
+    void schedule (PublishFilter* filter, Clock::time_point when)
+    {
+        std::lock_guard<std::mutex> lock (m_lock);
+        if (!m_started)
+        {
+            std::thread(&ExpiryTimer::run, this).detach();
+            m_started = true;
+        }
+        auto it = m_due.find(filter);
+        if (it == m_due.end() || when < it->second)
+            m_due[filter] = when;
+        m_changed.notify_all();
+    }
+
+    //! once it returns, the filter is not called anymore
+    void unschedule (PublishFilter* filter)
+    {
+        std::unique_lock<std::mutex> lock (m_lock);
+        m_due.erase(filter);
+        m_changed.wait(lock, [this, filter]{ return m_running != filter; });
+    }
+
+private:
+    ExpiryTimer (): m_started(false), m_running(nullptr) {}
+
+    void run ()
+    {
+        std::unique_lock<std::mutex> lock (m_lock);
+        while (true)
+        {
+            if (m_due.empty())
+            {
+                m_changed.wait(lock);
+                continue;
+            }
+            auto next = std::min_element(m_due.begin(), m_due.end(),
+                [](const std::pair<PublishFilter* const, Clock::time_point>& a,
+                   const std::pair<PublishFilter* const, Clock::time_point>& b){ return a.second < b.second; });
+            if (next->second > Clock::now())
+            {
+                m_changed.wait_until(lock, next->second);
+                continue;
+            }
+            // the filter publishes without this lock, so that it can schedule itself or other filters
+            m_running = next->first;
+            m_due.erase(next);
+            lock.unlock();
+            m_running->expire();
+            lock.lock();
+            m_running = nullptr;
+            m_changed.notify_all();
+        }
+    }
+
+    std::mutex m_lock;
+    std::condition_variable m_changed;
+    std::map<PublishFilter*, Clock::time_point> m_due;
+    bool m_started;
+    PublishFilter* m_running;
+};
+
+//! false for arrays and non-numeric types
+bool numericValue (const UaDataValue& dataValue, double& numeric)
+{
+    UaVariant variant (*dataValue.value());
+    OpcUa_Double value = 0;
+    const bool isNumeric = !variant.isArray() &&
+        variant.type() >= OpcUaType_SByte && variant.type() <= OpcUaType_Double &&
+        OpcUa_IsGood(variant.toDouble(value));
+    numeric = value;
+    return isNumeric;
+}
+
+}
+
+PublishFilter::PublishFilter (const PublishPolicy& policy, OnExpiry onExpiry):
+    m_policy(policy),
+    m_onExpiry(onExpiry),
+    m_hasPublished(false),
+    m_lastNumeric(false),
+    m_lastValue(0),
+    m_lastStatus(0),
+    m_suppressed(0),
+    m_hasPending(false)
+{
+}
+
+PublishFilter::~PublishFilter ()
+{
+    ExpiryTimer::instance().unschedule(this);
+}
+
+PublishFilter::Clock::time_point PublishFilter::publishTime (bool isNumeric, double value, uint32_t statusCode) const
+{
+    if (!m_hasPublished || statusCode != m_lastStatus)
+        return Clock::time_point::min();
+    const Clock::time_point afterMinInterval = m_lastTime + std::chrono::milliseconds(m_policy.minIntervalMs);
+    if (isNumeric && m_lastNumeric && m_policy.deadbandType != PublishPolicy::None)
+    {
+        const double threshold = (m_policy.deadbandType == PublishPolicy::Absolute) ?
+            m_policy.deadband : std::fabs(m_lastValue) * m_policy.deadband / 100.0;
+        if (std::fabs(value - m_lastValue) <= threshold)
+        {
+            if (m_policy.maxIntervalMs == 0)
+                return Clock::time_point::max();
+            return std::max(afterMinInterval, m_lastTime + std::chrono::milliseconds(m_policy.maxIntervalMs));
+        }
+    }
+    return afterMinInterval;
+}
+
+void PublishFilter::record (bool isNumeric, double value, uint32_t statusCode, Clock::time_point now)
+{
+    m_hasPublished = true;
+    m_lastNumeric = isNumeric;
+    m_lastValue = value;
+    m_lastStatus = statusCode;
+    m_lastTime = now;
+}
+
+bool PublishFilter::shouldPublish (const UaDataValue& dataValue)
+{
+    double value = 0;
+    const bool isNumeric = numericValue(dataValue, value);
+    std::lock_guard<std::mutex> lock (m_lock);
+    const Clock::time_point now = Clock::now();
+    const Clock::time_point when = publishTime(isNumeric, value, dataValue.statusCode());
+    if (when <= now)
+    {
+        record(isNumeric, value, dataValue.statusCode(), now);
+        m_hasPending = false;
+        return true;
+    }
+    m_suppressed++;
+    m_hasPending = (when != Clock::time_point::max());
+    if (m_hasPending)
+    {
+        m_pending = dataValue;
+        ExpiryTimer::instance().schedule(this, when);
+    }
+    return false;
+}
+
+bool PublishFilter::takePending (UaDataValue& dataValue)
+{
+    std::lock_guard<std::mutex> lock (m_lock);
+    if (!m_hasPending)
+        return false;
+    double value = 0;
+    const bool isNumeric = numericValue(m_pending, value);
+    const Clock::time_point now = Clock::now();
+    const Clock::time_point when = publishTime(isNumeric, value, m_pending.statusCode());
+    if (when > now)
+    {
+        // e.g. held back by the minimum interval, but inside the deadband
+        m_hasPending = (when != Clock::time_point::max());
+        if (m_hasPending)
+            ExpiryTimer::instance().schedule(this, when);
+        return false;
+    }
+    record(isNumeric, value, m_pending.statusCode(), now);
+    m_hasPending = false;
+    dataValue = m_pending;
+    return true;
+}
+
+}
@@ -25,6 +25,7 @@
 #include <ChangeNotifyingVariable.h>
 #include <muParser.h>
 #include <ParserVariableRequestUserData.h>
+#include <CompiledFormula.h>
 
 namespace CalculatedVariables
 {
@@ -59,14 +60,33 @@ public:
 
     bool isConstant () const { return m_valueVariables.size() + m_statusVariables.size() == 0; }
 
+    //! True if value (and status, if present) formulas run as bytecode rather than through muparser
+    bool isCompiled () const { return m_valueFormula.isCompiled() && (!m_hasStatusFormula || m_statusFormula.isCompiled()); }
+
+    //! Used by the Engine to queue this variable only once per update cycle
+    bool isUpdatePending () const { return m_updatePending; }
+    void setUpdatePending (bool v) { m_updatePending = v; }
+
+    //! Topological position in the calculation graph: 0 if no input is a CalculatedVariable, otherwise one more than the highest ranked input
+    unsigned int rank () const { return m_rank; }
+
 private:
     void initializeParser(
             mu::Parser& parser,
             const std::string& formula,
             ParserVariableRequestUserData::Type formulaType);
 
+    void computeRank();
+
+    //! Translates the formula to bytecode; keeps muparser as the evaluator if that's not possible
+    void compileFormula(
+            CompiledFormula& compiled,
+            mu::Parser& parser,
+            const std::string& formula);
+
     /* Value-Formula part */
     mu::Parser m_valueParser;
+    CompiledFormula m_valueFormula;
     std::list<ParserVariable*> m_valueVariables;
 
     //! True if the output should be boolean instead of double (e.g. when logical operators are used in formula)
@@ -75,12 +95,17 @@ private:
     /* Status-Formula part */
     bool m_hasStatusFormula;
     mu::Parser m_statusParser;
+    CompiledFormula m_statusFormula;
     //! Points to ParserVariables which are used by statusFormula
     std::list<ParserVariable*> m_statusVariables;
 
     //! Keeping this reference is necessary to efficiently construct synchronization graph
     ParserVariable* m_notifiedVariable;
 
+    bool m_updatePending;
+
+    unsigned int m_rank;
+
 };
 
 }
@@ -23,6 +23,10 @@
 #define CALCULATEDVARIABLES_INCLUDE_CALCULATEDVARIABLESENGINE_H_
 
 #include <list>
+#include <vector>
+#include <unordered_map>
+#include <atomic>
+#include <stdint.h>
 
 #include <uanodeid.h>
 
@@ -39,6 +43,8 @@ class ChangeNotifyingVariable;
 namespace CalculatedVariables
 {
 
+class CalculatedVariable;
+
 class Engine
 {
 public:
@@ -55,6 +61,32 @@ public:
     //! userData should be the 'this' of a CalculatedVariable this is being requested
     static double* parserVariableRequestHandler(const char* name, void* userData);
 
+    //! Returns nullptr if there is no ParserVariable of given name
+    static ParserVariable* findParserVariable(const std::string& name);
+
+    /* Update cycles: while one is open in the calling thread, input changes only mark dependent
+     * CalculatedVariables as dirty. When the outermost cycle ends they are evaluated in topological
+     * order (see CalculatedVariable::rank()), so each of them is evaluated once per cycle even if many
+     * of its inputs, direct or through other CalculatedVariables, have changed.
+     * A write made outside of any cycle forms a cycle of its own. A variable already made dirty by
+     * another thread is evaluated when that thread's cycle ends.
+     * Use the UpdateCycle guard rather than calling these directly.
+     */
+    static void beginUpdateCycle();
+    static void endUpdateCycle();
+    static void scheduleUpdate(CalculatedVariable* variable);
+
+    struct UpdateStatistics
+    {
+        //! Number of times a CalculatedVariable was evaluated
+        uint64_t evaluations;
+        //! Input change notifications which didn't cause an evaluation of their own because the
+        //! notified variable was already dirty in that cycle (i.e. evaluations saved by coalescing)
+        uint64_t coalescedNotifications;
+    };
+    static UpdateStatistics updateStatistics();
+    static void printUpdateStatistics();
+
     static void printInstantiationStatistics ();
 
     static void setupSynchronization();
@@ -75,9 +107,29 @@ public:
 
 private:
     static std::list <ParserVariable> s_parserVariables;
+    static std::unordered_map<std::string, ParserVariable*> s_parserVariablesByName;
     static size_t s_numSynchronizers;
     static size_t s_numCalculatedVariables;
+    static size_t s_numCompiledCalculatedVariables;
     static std::map<std::string, std::string> s_genericFormulas;
+
+    static thread_local unsigned int s_updateCycleDepth;
+    //! Binary heap with the lowest rank on top
+    static thread_local std::vector<CalculatedVariable*> s_pendingUpdates;
+    static std::atomic<uint64_t> s_numEvaluations;
+    static std::atomic<uint64_t> s_numCoalescedNotifications;
+};
+
+//! Scope guard grouping all input writes made within it into one update cycle
+class UpdateCycle
+{
+public:
+    UpdateCycle() { Engine::beginUpdateCycle(); }
+    //! Evaluates the pending variables; errors are logged, never thrown
+    ~UpdateCycle();
+private:
+    UpdateCycle(const UpdateCycle&) = delete;
+    UpdateCycle& operator=(const UpdateCycle&) = delete;
 };
 
 } /* namespace CalculatedVariables */
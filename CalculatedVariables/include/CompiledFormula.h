@@ -0,0 +1,109 @@
+/* © Copyright CERN, 2018.  All rights not expressly granted are reserved.
+ * CompiledFormula.h
+ *
+ *  This file is part of Quasar.
+ *
+ *  Quasar is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public Licence as published by
+ *  the Free Software Foundation, either version 3 of the Licence.
+ *
+ *  Quasar is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public Licence for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with Quasar.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CALCULATEDVARIABLES_INCLUDE_COMPILEDFORMULA_H_
+#define CALCULATEDVARIABLES_INCLUDE_COMPILEDFORMULA_H_
+
+#include <string>
+#include <vector>
+#include <functional>
+
+namespace CalculatedVariables
+{
+
+/* A formula translated to a flat stack bytecode.
+ * Operands are read through a table of variable slots (pointers to the values
+ * of ParserVariables) which is resolved once at compile time, so evaluation is a
+ * single pass over a contiguous instruction array without any name lookups.
+ * Only the subset of muparser syntax listed in CompiledFormula.cpp is understood;
+ * for anything else compile() returns false and the caller keeps using muparser.
+ */
+class CompiledFormula
+{
+public:
+    //! Given a variable name found in the formula returns the address of its value, or nullptr if unknown
+    typedef std::function<const double*(const std::string&)> SlotResolver;
+
+    CompiledFormula();
+
+    //! Returns true if the whole formula could be translated to bytecode
+    bool compile(const std::string& formula, const SlotResolver& resolver);
+
+    bool isCompiled() const { return m_compiled; }
+
+    //! Reentrant: the operand stack lives on the caller's stack
+    double evaluate() const;
+
+    //! Formulas needing a deeper operand stack are not compiled
+    static const size_t MaxStackDepth = 64;
+
+    size_t numInstructions() const { return m_code.size(); }
+    size_t numSlots() const { return m_slots.size(); }
+
+    enum OpCode
+    {
+        PushConstant,
+        PushSlot,
+        //! factor*slot+offset, factor is held in constant
+        PushScaledSlot,
+        //! slot^n for n = 2, 3 or 4, n is held in constant
+        PushSlotPower,
+        Negate,
+        Add,
+        Subtract,
+        Multiply,
+        Divide,
+        Power,
+        Less,
+        Greater,
+        LessEqual,
+        GreaterEqual,
+        Equal,
+        NotEqual,
+        LogicalAnd,
+        LogicalOr,
+        Call1,
+        Minimum,
+        Maximum,
+        Sum,
+        Average,
+        JumpIfZero,
+        Jump
+    };
+
+    struct Instruction
+    {
+        OpCode       op;
+        //! Slot index, jump target or number of arguments, depending on op
+        unsigned int arg;
+        double       constant;
+        double       offset;
+        double     (*function)(double);
+    };
+
+private:
+    class Compiler;
+
+    std::vector<Instruction>   m_code;
+    std::vector<const double*> m_slots;
+    bool m_compiled;
+};
+
+}
+
+#endif /* CALCULATEDVARIABLES_INCLUDE_COMPILEDFORMULA_H_ */
@@ -20,6 +20,8 @@
  */
 
 #include <algorithm>
+#include <cmath>
+#include <vector>
 
 #include <CalculatedVariable.h>
 #include <LogIt.h>
@@ -30,6 +32,20 @@
 namespace CalculatedVariables
 {
 
+//! Input values substituted when comparing a compiled formula against muparser
+static const double probeValues[] = {0.0, 1.0, -1.0, 0.5, -2.5, 3.0, 1000.0, 1e-3};
+static const size_t numProbeValues = sizeof probeValues / sizeof probeValues[0];
+
+//! Equal up to rounding, e.g. x*x*x against pow(x,3)
+static bool sameResult(double expected, double obtained)
+{
+    if (std::isnan(expected) || std::isnan(obtained))
+        return std::isnan(expected) && std::isnan(obtained);
+    if (expected == obtained)
+        return true;
+    return std::fabs(expected - obtained) <= 1e-12 * std::max(std::fabs(expected), std::fabs(obtained));
+}
+
 CalculatedVariable::CalculatedVariable(
     const UaNodeId&    nodeId,
     const UaString&    name,
@@ -50,11 +66,18 @@ CalculatedVariable::CalculatedVariable(
                     pSharedMutex),
                     m_isBoolean(isBoolean),
                     m_hasStatusFormula(hasStatusFormula),
-                    m_notifiedVariable(nullptr)
+                    m_notifiedVariable(nullptr),
+                    m_updatePending(false),
+                    m_rank(0)
 {
     this->initializeParser(m_valueParser, formula, ParserVariableRequestUserData::Type::Value);
+    this->compileFormula(m_valueFormula, m_valueParser, formula);
     if (m_hasStatusFormula)
+    {
         this->initializeParser(m_statusParser, statusFormula, ParserVariableRequestUserData::Type::Status);
+        this->compileFormula(m_statusFormula, m_statusParser, statusFormula);
+    }
+    this->computeRank();
 
     UaDataValue dataValue(UaVariant(), OpcUa_BadWaitingForInitialData, UaDateTime::now(), UaDateTime::now());
     this->setValue(nullptr, dataValue, OpcUa_False);
@@ -93,13 +116,13 @@ void CalculatedVariable::update()
     UaStatus finalStatus = OpcUa_Good;
     if (m_hasStatusFormula)
     {
-        double status = m_statusParser.Eval();
+        double status = m_statusFormula.isCompiled() ? m_statusFormula.evaluate() : m_statusParser.Eval();
         LOG(Log::TRC, logComponentId) << "status evaluates to: " << status;
         finalStatus = (status != 0) ? OpcUa_Good : OpcUa_Bad; // conversion of double to OPC-UA status code
     }
 
 
-    double updatedValue = m_valueParser.Eval();
+    double updatedValue = m_valueFormula.isCompiled() ? m_valueFormula.evaluate() : m_valueParser.Eval();
     UaVariant variant;
     if (m_isBoolean)
         variant.setBool(updatedValue != 0);
@@ -137,6 +160,87 @@ void CalculatedVariable::initializeParser(
     }
 }
 
+/* Note: muparser has already resolved (and registered as dependencies) all variables of the formula
+ * by the time we get here, so the compilation only needs to look them up. As a safety net against any
+ * difference in the grammar, both evaluators are compared on the current input values and on several
+ * sets of probe values, which are written to the inputs and restored afterwards. This runs while the
+ * configuration is loaded, before anything else can write to the inputs.
+ */
+void CalculatedVariable::compileFormula(
+        CompiledFormula& compiled,
+        mu::Parser& parser,
+        const std::string& formula)
+{
+    std::vector<double*> inputs;
+    bool isCompiled = compiled.compile(
+            formula,
+            [&inputs](const std::string& name) -> const double*
+            {
+                ParserVariable* variable = Engine::findParserVariable(name);
+                if (!variable)
+                    return nullptr;
+                inputs.push_back(variable->valuePtr());
+                return variable->valuePtr();
+            });
+    if (!isCompiled)
+    {
+        LOG(Log::DBG, logComponentId) << "At CalculatedVariable " << this->nodeId().toString().toUtf8() <<
+                " formula '" << formula << "' will be evaluated by muparser (not supported by the compiler)";
+        return;
+    }
+
+    std::vector<double> original;
+    for (double* input : inputs)
+        original.push_back(*input);
+    bool same = true;
+    double expected = 0;
+    double obtained = 0;
+    for (size_t set = 0; set <= numProbeValues && same; set++)
+    {
+        if (set > 0)
+            for (size_t i = 0; i < inputs.size(); i++)
+                *inputs[i] = probeValues[(i + set) % numProbeValues];
+        try
+        {
+            expected = parser.Eval();
+        }
+        catch (const mu::Parser::exception_type&)
+        {
+            continue; // e.g. a domain error of muparser for these inputs
+        }
+        obtained = compiled.evaluate();
+        same = sameResult(expected, obtained);
+    }
+    for (size_t i = inputs.size(); i > 0; i--)
+        *inputs[i-1] = original[i-1];
+
+    if (!same)
+    {
+        LOG(Log::WRN, logComponentId) << "At CalculatedVariable " << this->nodeId().toString().toUtf8() <<
+                " compiled formula '" << formula << "' gave " << obtained << " instead of " << expected <<
+                ", falling back to muparser";
+        compiled = CompiledFormula();
+        return;
+    }
+    LOG(Log::TRC, logComponentId) << "At CalculatedVariable " << this->nodeId().toString().toUtf8() <<
+            " compiled formula '" << formula << "' to " << compiled.numInstructions() << " instructions";
+}
+
+/* Inputs can only refer to variables which existed when this one was instantiated, so the
+ * calculation graph is acyclic and the ranks of all inputs are already final.
+ */
+void CalculatedVariable::computeRank()
+{
+    for (const std::list<ParserVariable*>* inputs : {&m_valueVariables, &m_statusVariables})
+        for (ParserVariable* input : *inputs)
+        {
+            const CalculatedVariable* calculatedInput = dynamic_cast<const CalculatedVariable*> (input->notifyingVariable());
+            if (calculatedInput)
+                m_rank = std::max(m_rank, calculatedInput->rank() + 1);
+        }
+    LOG(Log::TRC, logComponentId) << "CalculatedVariable " << this->nodeId().toString().toUtf8() << " has rank " << m_rank;
+}
+
 void CalculatedVariable::addDependentVariableForValue(ParserVariable* variable)
 {
     /* Adding same variable twice wouldn't buy us anything */
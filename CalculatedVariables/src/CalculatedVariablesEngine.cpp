@@ -30,6 +30,9 @@
 
 #include <Utils.h>
 
+#include <mutex> // for unique_lock
+#include <algorithm>
+
 #include <boost/xpressive/xpressive.hpp>
 
 #define LOG_AND_THROW_ERROR(FORMULA,ERROR) \
@@ -52,10 +55,17 @@ ParserVariable& Engine::registerVariableForCalculatedVariables(AddressSpace::Cha
 {
     LOG(Log::TRC, logComponentId) << "Putting on list of ParserVariables: " << variable->nodeId().toString().toUtf8();
     s_parserVariables.emplace_back(variable);
+    s_parserVariablesByName[s_parserVariables.back().name()] = &s_parserVariables.back();
     variable->addChangeListener(ChangeListener(s_parserVariables.back())); // using back() because we just added it a line above
     return s_parserVariables.back();
 }
 
+ParserVariable* Engine::findParserVariable(const std::string& name)
+{
+    decltype(s_parserVariablesByName)::iterator it = s_parserVariablesByName.find(name);
+    return it != std::end(s_parserVariablesByName) ? it->second : nullptr;
+}
+
 double* CalculatedVariables::Engine::parserVariableRequestHandler(const char* name, void* userData)
 {
     ParserVariableRequestUserData* requestUserData = static_cast<ParserVariableRequestUserData*> (userData);
@@ -64,11 +74,8 @@ double* CalculatedVariables::Engine::parserVariableRequestHandler(const char* na
     LOG(Log::TRC, logComponentId) <<
             "muparser asks for this variable: " << name <<
             " while instantiating: " << requestor->nodeId().toString().toUtf8();
-    decltype(s_parserVariables)::iterator it = std::find_if(
-            std::begin(s_parserVariables),
-            std::end(s_parserVariables),
-            [name](const ParserVariable& variable){return variable.name()==name;});
-    if (it == std::end(s_parserVariables))
+    ParserVariable* variable = findParserVariable(name);
+    if (!variable)
     {
         LOG(Log::ERR, logComponentId) << "Variable " << name << " can't be found. Formula error most likely? (While instantiating '" << requestor->nodeId().toString().toUtf8() << "')";
         throw std::runtime_error("Couldnt find formula variable. The exact error has been logged.");
@@ -77,14 +84,116 @@ double* CalculatedVariables::Engine::parserVariableRequestHandler(const char* na
     {
 
         if (requestUserData->type == ParserVariableRequestUserData::Type::Value)
-            requestor->addDependentVariableForValue(&(*it));
+            requestor->addDependentVariableForValue(variable);
         else if (requestUserData->type == ParserVariableRequestUserData::Type::Status)
-            requestor->addDependentVariableForStatus(&(*it));
+            requestor->addDependentVariableForStatus(variable);
         else
             throw_runtime_error_with_origin("Enum value not handled. Report to quasar-developers.");
-        it->addNotifiedVariable(requestor);
-        return it->valuePtr();
+        variable->addNotifiedVariable(requestor);
+        return variable->valuePtr();
+    }
+}
+
+void Engine::beginUpdateCycle()
+{
+    s_updateCycleDepth++;
+}
+
+static bool isRankedAfter(const CalculatedVariable* a, const CalculatedVariable* b)
+{
+    return a->rank() > b->rank();
+}
+
+void Engine::scheduleUpdate(CalculatedVariable* variable)
+{
+    if (variable->isUpdatePending())
+    {
+        s_numCoalescedNotifications.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    variable->setUpdatePending(true);
+    s_pendingUpdates.push_back(variable);
+    std::push_heap(s_pendingUpdates.begin(), s_pendingUpdates.end(), isRankedAfter);
+}
+
+//! All inputs of a CalculatedVariable belong to the same synchronization domain, so any of them will do
+static SharedSynchronizer synchronizerOf(CalculatedVariable* variable)
+{
+    for (ParserVariable* input : variable->valueVariables())
+        if (input->synchronizer())
+            return input->synchronizer();
+    for (ParserVariable* input : variable->statusVariables())
+        if (input->synchronizer())
+            return input->synchronizer();
+    return SharedSynchronizer();
+}
+
+void Engine::endUpdateCycle()
+{
+    if (s_updateCycleDepth > 1)
+    {
+        s_updateCycleDepth--;
+        return;
     }
+    // The cycle stays open while flushing: results of the evaluated variables only mark their own
+    // dependents as dirty. These have a higher rank so they are popped later in this same loop,
+    // after all of their other inputs have been brought up to date.
+    while (!s_pendingUpdates.empty())
+    {
+        std::pop_heap(s_pendingUpdates.begin(), s_pendingUpdates.end(), isRankedAfter);
+        CalculatedVariable* variable = s_pendingUpdates.back();
+        s_pendingUpdates.pop_back();
+        SharedSynchronizer synchronizer = synchronizerOf(variable);
+        std::unique_lock<Synchronizer> lock;
+        if (synchronizer)
+            lock = std::unique_lock<Synchronizer>(*synchronizer);
+        // cleared under the lock: writers of the inputs hold it while checking the flag
+        variable->setUpdatePending(false);
+        // a failing variable must not leave the others of the cycle pending
+        try
+        {
+            variable->update();
+        }
+        catch (const std::exception& e)
+        {
+            LOG(Log::ERR, logComponentId) << "Evaluation of " << variable->nodeId().toString().toUtf8() << " failed: " << e.what();
+        }
+        s_numEvaluations.fetch_add(1, std::memory_order_relaxed);
+    }
+    s_updateCycleDepth--;
+}
+
+UpdateCycle::~UpdateCycle()
+{
+    // destructors must not throw, the cycle may end during stack unwinding
+    try
+    {
+        Engine::endUpdateCycle();
+    }
+    catch (const std::exception& e)
+    {
+        LOG(Log::ERR, logComponentId) << "Ending the update cycle failed: " << e.what();
+    }
+    catch (...)
+    {
+        LOG(Log::ERR, logComponentId) << "Ending the update cycle failed with an unknown exception";
+    }
+}
+
+Engine::UpdateStatistics Engine::updateStatistics()
+{
+    UpdateStatistics statistics;
+    statistics.evaluations = s_numEvaluations.load(std::memory_order_relaxed);
+    statistics.coalescedNotifications = s_numCoalescedNotifications.load(std::memory_order_relaxed);
+    return statistics;
+}
+
+void Engine::printUpdateStatistics()
+{
+    UpdateStatistics statistics = updateStatistics();
+    LOG(Log::INF, logComponentId) <<
+            " #Evaluations: " << statistics.evaluations <<
+            " #CoalescedNotifications: " << statistics.coalescedNotifications;
 }
 
 static std::string elaborateParent(
@@ -254,6 +363,8 @@ void Engine::instantiateCalculatedVariable(
         calculatedVariable->update();
 
     s_numCalculatedVariables++;
+    if (calculatedVariable->isCompiled())
+        s_numCompiledCalculatedVariables++;
     LOG(Log::TRC, logComponentId) << "Instantiated Calculated Variable: " << calculatedVariable->nodeId().toString().toUtf8();
 }
 
@@ -266,6 +377,7 @@ void Engine::printInstantiationStatistics()
     LOG(Log::INF, logComponentId) <<
             " #ParserVariables: " << s_parserVariables.size() <<
             " #CalculatedVariables: " << s_numCalculatedVariables <<
+            " (compiled: " << s_numCompiledCalculatedVariables << ")" <<
             " #Synchronizers: " << s_numSynchronizers;
 }
 
@@ -289,6 +401,7 @@ void Engine::optimize()
                 if (cv)
                     cv->setNotifiedVariable(nullptr);
                 LOG(Log::TRC, logComponentId) << "Optimizing out: " << it->name();
+                s_parserVariablesByName.erase(it->name());
                 it = s_parserVariables.erase(it);
                 numOptimized++;
                 continue;
@@ -362,9 +475,15 @@ void Engine::setupSynchronization()
 
 Log::LogComponentHandle logComponentId = Log::INVALID_HANDLE;
 std::list <ParserVariable> Engine::s_parserVariables;
+std::unordered_map<std::string, ParserVariable*> Engine::s_parserVariablesByName;
 size_t Engine::s_numSynchronizers = 0;
 size_t Engine::s_numCalculatedVariables = 0;
+size_t Engine::s_numCompiledCalculatedVariables = 0;
 std::map<std::string, std::string> Engine::s_genericFormulas;
+thread_local unsigned int Engine::s_updateCycleDepth = 0;
+thread_local std::vector<CalculatedVariable*> Engine::s_pendingUpdates;
+std::atomic<uint64_t> Engine::s_numEvaluations (0);
+std::atomic<uint64_t> Engine::s_numCoalescedNotifications (0);
 
 
 } /* namespace CalculatedVariables */
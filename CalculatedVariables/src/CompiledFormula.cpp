@@ -0,0 +1,685 @@
+/* © Copyright CERN, 2018.  All rights not expressly granted are reserved.
+ * CompiledFormula.cpp
+ *
+ *  This file is part of Quasar.
+ *
+ *  Quasar is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public Licence as published by
+ *  the Free Software Foundation, either version 3 of the Licence.
+ *
+ *  Quasar is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public Licence for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with Quasar.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <algorithm>
+
+#include <CompiledFormula.h>
+
+/* Supported subset of the muparser syntax:
+ *  - numbers, variables (same name characters as given to muparser), constants _pi and _e,
+ *  - binary + - * / ^ < > <= >= == != && || and the ternary ?: operator,
+ *  - unary + and -,
+ *  - sin cos tan asin acos atan sinh cosh tanh asinh acosh atanh log2 log10 log ln exp sqrt sign rint abs,
+ *  - min max sum avg with any number of arguments.
+ * Precedences and associativity follow muparser 2.2 as shipped in ext_components: unary minus binds
+ * weaker than ^ (-2^2 is -4), ^ is right-associative and 'log' is the natural logarithm.
+ */
+
+namespace CalculatedVariables
+{
+
+namespace
+{
+
+double signOf(double v) { return (v < 0) ? -1 : ((v > 0) ? 1 : 0); }
+double roundToInt(double v) { return std::floor(v + 0.5); }
+double logBase2(double v) { return std::log(v) / std::log(2.0); }
+double absoluteValue(double v) { return (v >= 0) ? v : -v; } // as muparser, keeps abs(-0) negative
+
+typedef double (*UnaryFunction)(double);
+
+const std::map<std::string, UnaryFunction>& unaryFunctions()
+{
+    static const std::map<std::string, UnaryFunction> functions = {
+            {"sin", static_cast<UnaryFunction>(std::sin)},
+            {"cos", static_cast<UnaryFunction>(std::cos)},
+            {"tan", static_cast<UnaryFunction>(std::tan)},
+            {"asin", static_cast<UnaryFunction>(std::asin)},
+            {"acos", static_cast<UnaryFunction>(std::acos)},
+            {"atan", static_cast<UnaryFunction>(std::atan)},
+            {"sinh", static_cast<UnaryFunction>(std::sinh)},
+            {"cosh", static_cast<UnaryFunction>(std::cosh)},
+            {"tanh", static_cast<UnaryFunction>(std::tanh)},
+            {"asinh", static_cast<UnaryFunction>(std::asinh)},
+            {"acosh", static_cast<UnaryFunction>(std::acosh)},
+            {"atanh", static_cast<UnaryFunction>(std::atanh)},
+            {"log2", logBase2},
+            {"log10", static_cast<UnaryFunction>(std::log10)},
+            {"log", static_cast<UnaryFunction>(std::log)},
+            {"ln", static_cast<UnaryFunction>(std::log)},
+            {"exp", static_cast<UnaryFunction>(std::exp)},
+            {"sqrt", static_cast<UnaryFunction>(std::sqrt)},
+            {"sign", signOf},
+            {"rint", roundToInt},
+            {"abs", absoluteValue}
+    };
+    return functions;
+}
+
+bool isNameChar(char c)
+{
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == '.';
+}
+
+//! Thrown internally when the formula uses something outside of the supported subset
+struct NotSupported {};
+
+}
+
+class CompiledFormula::Compiler
+{
+public:
+    Compiler(const std::string& formula, const SlotResolver& resolver, CompiledFormula& output):
+        m_formula(formula),
+        m_position(0),
+        m_resolver(resolver),
+        m_output(output),
+        m_depth(0),
+        m_maxDepth(0),
+        m_barrier(0)
+    {}
+
+    void run()
+    {
+        parseTernary();
+        skipSpaces();
+        if (m_position != m_formula.size())
+            throw NotSupported();
+        if (m_maxDepth > MaxStackDepth)
+            throw NotSupported();
+    }
+
+private:
+    const std::string&  m_formula;
+    size_t              m_position;
+    const SlotResolver& m_resolver;
+    CompiledFormula&    m_output;
+    size_t              m_depth;
+    size_t              m_maxDepth;
+    //! Instructions before this index can't be folded, e.g. because a jump lands after them
+    size_t              m_barrier;
+
+    void skipSpaces()
+    {
+        while (m_position < m_formula.size() && std::isspace(static_cast<unsigned char>(m_formula[m_position])))
+            m_position++;
+    }
+
+    bool accept(const char* token)
+    {
+        skipSpaces();
+        size_t length = std::strlen(token);
+        if (m_formula.compare(m_position, length, token) != 0)
+            return false;
+        m_position += length;
+        return true;
+    }
+
+    //! Like accept() but won't take the first char of a two-char operator, e.g. '<' out of '<='
+    bool acceptSingle(char c, const char* notFollowedBy)
+    {
+        skipSpaces();
+        if (m_position >= m_formula.size() || m_formula[m_position] != c)
+            return false;
+        if (m_position + 1 < m_formula.size() && std::strchr(notFollowedBy, m_formula[m_position + 1]))
+            return false;
+        m_position++;
+        return true;
+    }
+
+    void expect(const char* token)
+    {
+        if (!accept(token))
+            throw NotSupported();
+    }
+
+    std::vector<Instruction>& code() { return m_output.m_code; }
+
+    size_t emit(OpCode op, unsigned int arg = 0, double constant = 0, UnaryFunction function = nullptr)
+    {
+        code().push_back(Instruction{op, arg, constant, 0, function});
+        return code().size() - 1;
+    }
+
+    void push()
+    {
+        m_depth++;
+        m_maxDepth = std::max(m_maxDepth, m_depth);
+    }
+
+    void pop(size_t n) { m_depth -= n; }
+
+    //! True if the last n instructions are constants that may be folded
+    bool lastAreConstants(size_t n)
+    {
+        if (code().size() < n || code().size() - n < m_barrier)
+            return false;
+        for (size_t i = code().size() - n; i < code().size(); ++i)
+            if (code()[i].op != PushConstant)
+                return false;
+        return true;
+    }
+
+    /* A PushConstant's arg tells whether muparser would also see it as a plain value, i.e. a literal
+     * or a binary operation folded from such. Only those are folded into && and ||, because muparser
+     * truncates to int when folding these (but not when evaluating them at run time).
+     */
+    enum { ComputedConstant = 0, PlainConstant = 1 };
+
+    //! For binary operations, arg tells where the right-hand operand is
+    enum { StackOperand = 0, ConstantOperand = 1 };
+
+    void emitConstant(double v)
+    {
+        emit(PushConstant, PlainConstant, v);
+        push();
+    }
+
+    void emitUnary(OpCode op, UnaryFunction function = nullptr)
+    {
+        if (lastAreConstants(1))
+        {
+            Instruction& constant = code().back();
+            constant.constant = (op == Negate) ? -constant.constant : function(constant.constant);
+            constant.arg = ComputedConstant;
+        }
+        else
+            emit(op, 0, 0, function);
+    }
+
+    void emitBinary(OpCode op)
+    {
+        pop(1);
+        bool isLogical = op == LogicalAnd || op == LogicalOr;
+        if (lastAreConstants(2) && (!isLogical || (code().back().arg == PlainConstant && code()[code().size()-2].arg == PlainConstant)))
+        {
+            Instruction b = code().back();
+            code().pop_back();
+            Instruction& a = code().back();
+            a.constant = applyBinary(op, a.constant, b.constant);
+            a.arg = (a.arg == PlainConstant && b.arg == PlainConstant) ? PlainConstant : ComputedConstant;
+        }
+        else if (!fuseWithSlot(op))
+        {
+            if (lastAreConstants(1))
+            {
+                // the constant becomes an immediate operand, saving a push
+                double b = code().back().constant;
+                code().pop_back();
+                emit(op, ConstantOperand, b);
+            }
+            else
+                emit(op, StackOperand);
+        }
+    }
+
+    bool isPlainConstant(const Instruction& i) { return i.op == PushConstant && i.arg == PlainConstant; }
+    bool isSlot(const Instruction& i) { return i.op == PushSlot || i.op == PushScaledSlot; }
+    double factorOf(const Instruction& i) { return i.op == PushSlot ? 1 : (i.op == PushScaledSlot ? i.constant : 0); }
+    double offsetOf(const Instruction& i) { return i.op == PushScaledSlot ? i.offset : (i.op == PushConstant ? i.constant : 0); }
+
+    /* Folds a binary operation between a variable and a constant (or the same variable twice) into a
+     * single factor*slot+offset or slot^n instruction. These are the same rewrites muparser's optimizer
+     * applies, with the same arithmetic, so both give identical results.
+     */
+    bool fuseWithSlot(OpCode op)
+    {
+        size_t n = code().size();
+        if (n < 2 || n - 2 < m_barrier)
+            return false;
+        Instruction& a = code()[n-2];
+        const Instruction& b = code()[n-1];
+        bool sameSlot = isSlot(a) && isSlot(b) && a.arg == b.arg;
+        switch (op)
+        {
+            case Add:
+            case Subtract:
+            {
+                if (!((isSlot(a) && isPlainConstant(b)) || (isPlainConstant(a) && isSlot(b)) || sameSlot))
+                    return false;
+                double sign = (op == Subtract) ? -1 : 1;
+                double factor = factorOf(a) + sign * factorOf(b);
+                double offset = offsetOf(a) + sign * offsetOf(b);
+                a.arg = isSlot(a) ? a.arg : b.arg;
+                a.constant = factor;
+                a.offset = offset;
+                break;
+            }
+            case Multiply:
+            {
+                if ((a.op == PushSlot && isPlainConstant(b)) || (isPlainConstant(a) && b.op == PushSlot))
+                {
+                    a.constant = isSlot(a) ? b.constant : a.constant;
+                    a.arg = isSlot(a) ? a.arg : b.arg;
+                    a.offset = 0;
+                }
+                else if ((a.op == PushScaledSlot && isPlainConstant(b)) || (isPlainConstant(a) && b.op == PushScaledSlot))
+                {
+                    const Instruction& slot = isSlot(a) ? a : b;
+                    double multiplier = isSlot(a) ? b.constant : a.constant;
+                    a.arg = slot.arg;
+                    a.offset = slot.offset * multiplier;
+                    a.constant = slot.constant * multiplier;
+                }
+                else if (a.op == PushSlot && b.op == PushSlot && sameSlot)
+                {
+                    a.op = PushSlotPower;
+                    a.constant = 2;
+                    code().pop_back();
+                    return true;
+                }
+                else
+                    return false;
+                break;
+            }
+            case Divide:
+                if (!(a.op == PushScaledSlot && isPlainConstant(b) && b.constant != 0))
+                    return false;
+                a.constant /= b.constant;
+                a.offset /= b.constant;
+                code().pop_back();
+                return true;
+            case Power:
+                if (!(a.op == PushSlot && isPlainConstant(b) && (b.constant == 2 || b.constant == 3 || b.constant == 4)))
+                    return false;
+                a.op = PushSlotPower;
+                a.constant = b.constant;
+                code().pop_back();
+                return true;
+            default:
+                return false;
+        }
+        a.op = PushScaledSlot;
+        code().pop_back();
+        return true;
+    }
+
+    void emitVariadic(OpCode op, unsigned int numArgs)
+    {
+        pop(numArgs - 1);
+        emit(op, numArgs);
+    }
+
+    void parseTernary()
+    {
+        parseLogicalOr();
+        if (!accept("?"))
+            return;
+        pop(1);
+        size_t jumpToElse = emit(JumpIfZero);
+        parseTernary();
+        expect(":");
+        pop(1);
+        size_t jumpToEnd = emit(Jump);
+        code()[jumpToElse].arg = code().size();
+        parseTernary();
+        code()[jumpToEnd].arg = code().size();
+        m_barrier = code().size();
+    }
+
+    void parseLogicalOr()
+    {
+        parseLogicalAnd();
+        while (accept("||"))
+        {
+            parseLogicalAnd();
+            emitBinary(LogicalOr);
+        }
+    }
+
+    void parseLogicalAnd()
+    {
+        parseComparison();
+        while (accept("&&"))
+        {
+            parseComparison();
+            emitBinary(LogicalAnd);
+        }
+    }
+
+    void parseComparison()
+    {
+        parseAdditive();
+        while (true)
+        {
+            OpCode op;
+            if (accept("<="))
+                op = LessEqual;
+            else if (accept(">="))
+                op = GreaterEqual;
+            else if (accept("=="))
+                op = Equal;
+            else if (accept("!="))
+                op = NotEqual;
+            else if (acceptSingle('<', "="))
+                op = Less;
+            else if (acceptSingle('>', "="))
+                op = Greater;
+            else
+                return;
+            parseAdditive();
+            emitBinary(op);
+        }
+    }
+
+    void parseAdditive()
+    {
+        parseMultiplicative();
+        while (true)
+        {
+            OpCode op;
+            if (accept("+"))
+                op = Add;
+            else if (accept("-"))
+                op = Subtract;
+            else
+                return;
+            parseMultiplicative();
+            emitBinary(op);
+        }
+    }
+
+    void parseMultiplicative()
+    {
+        parseUnary();
+        while (true)
+        {
+            OpCode op;
+            if (accept("*"))
+                op = Multiply;
+            else if (accept("/"))
+                op = Divide;
+            else
+                return;
+            parseUnary();
+            emitBinary(op);
+        }
+    }
+
+    void parseUnary()
+    {
+        if (accept("-"))
+        {
+            parseUnary();
+            emitUnary(Negate);
+        }
+        else if (accept("+"))
+        {
+            parseUnary();
+            // no-op, but to muparser it's a function call so the operand is no longer a plain value
+            if (lastAreConstants(1))
+                code().back().arg = ComputedConstant;
+            else
+                m_barrier = code().size();
+        }
+        else
+            parsePower();
+    }
+
+    //! ^ is right-associative and its exponent may carry a sign, e.g. 10^-3 or 2^3^2
+    void parsePower()
+    {
+        parsePrimary();
+        if (!accept("^"))
+            return;
+        bool negate = accept("-");
+        bool plus = !negate && accept("+");
+        parsePower();
+        if (negate)
+            emitUnary(Negate);
+        else if (plus && lastAreConstants(1))
+            code().back().arg = ComputedConstant;
+        else if (plus)
+            m_barrier = code().size();
+        emitBinary(Power);
+    }
+
+    void parsePrimary()
+    {
+        skipSpaces();
+        if (m_position >= m_formula.size())
+            throw NotSupported();
+        char c = m_formula[m_position];
+        if (c == '(')
+        {
+            m_position++;
+            parseTernary();
+            expect(")");
+        }
+        else if (std::isdigit(static_cast<unsigned char>(c)) || c == '.')
+            parseNumber();
+        else if (isNameChar(c))
+            parseName();
+        else
+            throw NotSupported();
+    }
+
+    void parseNumber()
+    {
+        const char* begin = m_formula.c_str() + m_position;
+        char* end = nullptr;
+        double v = std::strtod(begin, &end);
+        if (end == begin)
+            throw NotSupported();
+        m_position += end - begin;
+        if (m_position < m_formula.size() && isNameChar(m_formula[m_position]))
+            throw NotSupported();
+        emitConstant(v);
+    }
+
+    void parseName()
+    {
+        size_t begin = m_position;
+        while (m_position < m_formula.size() && isNameChar(m_formula[m_position]))
+            m_position++;
+        std::string name = m_formula.substr(begin, m_position - begin);
+        skipSpaces();
+        if (m_position < m_formula.size() && m_formula[m_position] == '(')
+        {
+            m_position++;
+            parseFunction(name);
+        }
+        else if (name == "_pi")
+            emitConstant(std::acos(-1.0));
+        else if (name == "_e")
+            emitConstant(std::exp(1.0));
+        else
+        {
+            const double* slot = m_resolver(name);
+            if (!slot)
+                throw NotSupported();
+            std::vector<const double*>& slots = m_output.m_slots;
+            std::vector<const double*>::iterator it = std::find(slots.begin(), slots.end(), slot);
+            unsigned int index = it - slots.begin();
+            if (it == slots.end())
+                slots.push_back(slot);
+            emit(PushSlot, index);
+            push();
+        }
+    }
+
+    void parseFunction(const std::string& name)
+    {
+        OpCode variadic;
+        if (name == "min")
+            variadic = Minimum;
+        else if (name == "max")
+            variadic = Maximum;
+        else if (name == "sum")
+            variadic = Sum;
+        else if (name == "avg")
+            variadic = Average;
+        else
+        {
+            std::map<std::string, UnaryFunction>::const_iterator it = unaryFunctions().find(name);
+            if (it == unaryFunctions().end())
+                throw NotSupported();
+            parseTernary();
+            expect(")");
+            emitUnary(Call1, it->second);
+            return;
+        }
+        unsigned int numArgs = 0;
+        do
+        {
+            parseTernary();
+            numArgs++;
+        }
+        while (accept(","));
+        expect(")");
+        emitVariadic(variadic, numArgs);
+    }
+
+public:
+    //! Used for constant folding. Like muparser's own folding, truncates operands of && and || to int.
+    static double applyBinary(OpCode op, double a, double b)
+    {
+        switch (op)
+        {
+            case Add:          return a + b;
+            case Subtract:     return a - b;
+            case Multiply:     return a * b;
+            case Divide:       return a / b;
+            case Power:        return std::pow(a, b);
+            case Less:         return a < b;
+            case Greater:      return a > b;
+            case LessEqual:    return a <= b;
+            case GreaterEqual: return a >= b;
+            case Equal:        return a == b;
+            case NotEqual:     return a != b;
+            case LogicalAnd:   return static_cast<int>(a) && static_cast<int>(b);
+            case LogicalOr:    return static_cast<int>(a) || static_cast<int>(b);
+            default:           throw NotSupported();
+        }
+    }
+};
+
+CompiledFormula::CompiledFormula():
+        m_compiled(false)
+{
+}
+
+bool CompiledFormula::compile(const std::string& formula, const SlotResolver& resolver)
+{
+    m_code.clear();
+    m_slots.clear();
+    m_compiled = false;
+    try
+    {
+        Compiler(formula, resolver, *this).run();
+        m_compiled = true;
+    }
+    catch (const NotSupported&)
+    {
+        m_code.clear();
+        m_slots.clear();
+    }
+    return m_compiled;
+}
+
+//! Right-hand operand is either immediate (arg != 0) or on the stack
+#define BINARY_OPERATION(EXPRESSION) \
+    { \
+    double b = instruction.arg ? instruction.constant : stack[--top]; \
+    double a = stack[top-1]; \
+    stack[top-1] = (EXPRESSION); \
+    break; \
+    }
+
+double CompiledFormula::evaluate() const
+{
+    double stack[MaxStackDepth];
+    size_t top = 0; // number of values on the stack
+    const Instruction* const code = m_code.data();
+    const size_t size = m_code.size();
+    for (size_t pc = 0; pc < size; ++pc)
+    {
+        const Instruction& instruction = code[pc];
+        switch (instruction.op)
+        {
+            case PushConstant: stack[top++] = instruction.constant; break;
+            case PushSlot:     stack[top++] = *m_slots[instruction.arg]; break;
+            case PushScaledSlot: stack[top++] = *m_slots[instruction.arg] * instruction.constant + instruction.offset; break;
+            case PushSlotPower:
+            {
+                double x = *m_slots[instruction.arg];
+                double result = x * x;
+                if (instruction.constant >= 3)
+                    result *= x;
+                if (instruction.constant >= 4)
+                    result *= x;
+                stack[top++] = result;
+                break;
+            }
+            case Negate:       stack[top-1] = -stack[top-1]; break;
+            case Call1:        stack[top-1] = instruction.function(stack[top-1]); break;
+            case Add:          BINARY_OPERATION(a + b);
+            case Subtract:     BINARY_OPERATION(a - b);
+            case Multiply:     BINARY_OPERATION(a * b);
+            case Divide:       BINARY_OPERATION(a / b);
+            case Power:        BINARY_OPERATION(std::pow(a, b));
+            case Less:         BINARY_OPERATION(a < b);
+            case Greater:      BINARY_OPERATION(a > b);
+            case LessEqual:    BINARY_OPERATION(a <= b);
+            case GreaterEqual: BINARY_OPERATION(a >= b);
+            case Equal:        BINARY_OPERATION(a == b);
+            case NotEqual:     BINARY_OPERATION(a != b);
+            case LogicalAnd:   BINARY_OPERATION(a && b);
+            case LogicalOr:    BINARY_OPERATION(a || b);
+            case Minimum:
+            case Maximum:
+            {
+                const double* args = stack + top - instruction.arg;
+                double result = args[0];
+                for (unsigned int i = 1; i < instruction.arg; ++i)
+                    result = (instruction.op == Minimum) ? std::min(result, args[i]) : std::max(result, args[i]);
+                top -= instruction.arg - 1;
+                stack[top-1] = result;
+                break;
+            }
+            case Sum:
+            case Average:
+            {
+                const double* args = stack + top - instruction.arg;
+                double result = 0; // starting from 0 (not args[0]) as muparser does; matters for -0
+                for (unsigned int i = 0; i < instruction.arg; ++i)
+                    result += args[i];
+                if (instruction.op == Average)
+                    result /= instruction.arg;
+                top -= instruction.arg - 1;
+                stack[top-1] = result;
+                break;
+            }
+            case JumpIfZero:
+                if (stack[--top] == 0)
+                    pc = instruction.arg - 1;
+                break;
+            case Jump:
+                pc = instruction.arg - 1;
+                break;
+        }
+    }
+    return stack[0];
+}
+
+}
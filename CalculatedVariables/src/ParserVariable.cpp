@@ -25,6 +25,7 @@
 #include <CalculatedVariablesLogComponentId.h>
 #include <ParserVariable.h>
 #include <CalculatedVariable.h>
+#include <CalculatedVariablesEngine.h>
 
 #include <mutex> // for lock_guard
 
@@ -57,10 +58,12 @@ void ParserVariable::setValueNonSynchronized(double v, State state)
 {
     m_value = v;
     m_state = state;
+    // dependents get evaluated when the cycle ends; right away unless the caller holds one open
+    UpdateCycle cycle;
     for (CalculatedVariable* notifiedVariable : m_notifiedVariables)
     {
-        LOG(Log::TRC, logComponentId) << "Notifying variable " << notifiedVariable->nodeId().toString().toUtf8();
-        notifiedVariable->update();
+        LOG(Log::TRC, logComponentId) << "Scheduling update of variable " << notifiedVariable->nodeId().toString().toUtf8();
+        Engine::scheduleUpdate(notifiedVariable);
     }
 }
 
@@ -25,10 +25,13 @@
 #include <mutex>
 #include <vector>
 #include <thread>
-#include <list>
-#include <queue>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <functional>
+#include <stdint.h>
 
 #include <statuscode.h>
 
@@ -45,27 +48,92 @@ public:
     virtual std::string describe() const = 0;
 };
 
+/* Every worker has its own job deque. Jobs added from a worker go to its own deque, jobs added
+ * from elsewhere are spread round-robin; an idle worker first takes the oldest job from its own
+ * deque and otherwise steals the newest job of another worker. This way there is no single lock
+ * all workers and submitters contend on.
+ * When maxJobs are pending, addJob() either fails immediately (maxBlockingTimeMs = 0) or blocks
+ * the submitter up to maxBlockingTimeMs for a slot to free up.
+ */
 class ThreadPool
 {
 public:
-    ThreadPool (unsigned int maxThreads, unsigned int maxJobs);
+    ThreadPool (unsigned int maxThreads, unsigned int maxJobs, unsigned int maxBlockingTimeMs = 0);
     ~ThreadPool ();
 
+    //! The pool takes ownership of the job, also when it gets rejected
     UaStatus addJob (ThreadPoolJob* job);
     UaStatus addJob (const std::function<void()>& functor, const std::string& description);
 
-private:
-    void work();
+    //! Counters are cumulative since the pool was created
+    struct Statistics
+    {
+        unsigned int queueDepth;
+        uint64_t     jobsExecuted;
+        uint64_t     jobsRejected;
+        //! Jobs whose submitter had to wait for a free slot
+        uint64_t     jobsDelayed;
+        uint64_t     steals;
+        uint64_t     totalWaitTimeUs;
+        uint64_t     totalRunTimeUs;
+    };
+    Statistics statistics () const;
+
+    //! Calls publisher every periodMs from a dedicated thread, until the pool is destroyed
+    void publishStatistics (const std::function<void(const Statistics&)>& publisher, unsigned int periodMs);
 
-    std::mutex m_accessLock;
-    bool m_quit;
+private:
+    struct PendingJob
+    {
+        ThreadPoolJob* job;
+        std::chrono::steady_clock::time_point addedAt;
+    };
+
+    struct WorkerQueue
+    {
+        std::mutex lock;
+        std::deque<PendingJob> jobs;
+    };
+
+    void work(unsigned int index);
+    bool takeJob(unsigned int index, PendingJob& pendingJob);
+    void runJob(const PendingJob& pendingJob);
+    bool reserveSlot();
+    void publisherLoop(std::function<void(const Statistics&)> publisher, unsigned int periodMs);
+
+    std::atomic<bool> m_quit;
+    std::vector<std::unique_ptr<WorkerQueue>> m_queues;
     std::vector<std::thread> m_workers;
-    std::queue<ThreadPoolJob*, std::list<ThreadPoolJob*> > m_pendingJobs;
 
     const unsigned int m_maxJobs;
-
-    // this is the notification business for conditional variable notification
-    std::condition_variable m_conditionVariable;
+    const unsigned int m_maxBlockingTimeMs;
+
+    //! Jobs accepted and not yet taken by a worker; this is what maxJobs limits
+    std::atomic<unsigned int> m_numReserved;
+    //! Jobs sitting in the worker queues; idle workers sleep while it's zero
+    std::atomic<unsigned int> m_numQueued;
+    std::atomic<unsigned int> m_nextQueue;
+
+    // idle workers wait here
+    std::mutex m_idleLock;
+    std::condition_variable m_workAvailable;
+    std::atomic<unsigned int> m_numIdle;
+
+    // submitters blocked on a full pool wait here
+    std::mutex m_fullLock;
+    std::condition_variable m_slotAvailable;
+    std::atomic<unsigned int> m_numBlocked;
+
+    std::atomic<uint64_t> m_jobsExecuted;
+    std::atomic<uint64_t> m_jobsRejected;
+    std::atomic<uint64_t> m_jobsDelayed;
+    std::atomic<uint64_t> m_steals;
+    std::atomic<uint64_t> m_totalWaitTimeUs;
+    std::atomic<uint64_t> m_totalRunTimeUs;
+
+    std::thread m_publisher;
+    std::mutex m_publisherLock;
+    std::condition_variable m_publisherWakeUp;
 
 };
 
@@ -27,76 +27,191 @@
 namespace Quasar
 {
 
-ThreadPool::ThreadPool (unsigned int maxThreads, unsigned int maxJobs):
+//! Identifies the pool and the worker the calling thread belongs to, if any
+static thread_local const ThreadPool* s_currentPool = nullptr;
+static thread_local unsigned int s_currentWorker = 0;
+
+ThreadPool::ThreadPool (unsigned int maxThreads, unsigned int maxJobs, unsigned int maxBlockingTimeMs):
         m_quit(false),
-        m_maxJobs(maxJobs)
+        m_maxJobs(maxJobs),
+        m_maxBlockingTimeMs(maxBlockingTimeMs),
+        m_numReserved(0),
+        m_numQueued(0),
+        m_nextQueue(0),
+        m_numIdle(0),
+        m_numBlocked(0),
+        m_jobsExecuted(0),
+        m_jobsRejected(0),
+        m_jobsDelayed(0),
+        m_steals(0),
+        m_totalWaitTimeUs(0),
+        m_totalRunTimeUs(0)
 {
+    maxThreads = std::max(maxThreads, 1u);
+    for (unsigned int i=0; i<maxThreads; ++i)
+        m_queues.emplace_back(new WorkerQueue);
     m_workers.reserve(maxThreads);
     for (unsigned int i=0; i<maxThreads; ++i)
-        m_workers.emplace_back( [this](){this->work();} );
+        m_workers.emplace_back( [this, i](){this->work(i);} );
 }
 
 ThreadPool::~ThreadPool ()
 {
     LOG(Log::INF) << "Stopping threadpool - this might take some time.";
-    m_quit = true;
-    m_conditionVariable.notify_all();
+    {
+        // taking the locks guarantees no waiter misses the flag
+        std::lock_guard<std::mutex> idleLock (m_idleLock);
+        std::lock_guard<std::mutex> publisherLock (m_publisherLock);
+        m_quit = true;
+    }
+    m_workAvailable.notify_all();
+    m_publisherWakeUp.notify_all();
+    if (m_publisher.joinable())
+        m_publisher.join();
     for (std::thread &t : m_workers)
         t.join();
     LOG(Log::INF) << "Stopped the threadpool";
     // all threads are stopped now, but are all jobs flushed?
-    while (!m_pendingJobs.empty())
+    for (std::unique_ptr<WorkerQueue>& queue : m_queues)
     {
-        ThreadPoolJob* job = m_pendingJobs.front();
-        m_pendingJobs.pop();
-        LOG(Log::WRN) << "Removing unfinished job: " << job->describe();
-        delete job;
+        for (const PendingJob& pendingJob : queue->jobs)
+        {
+            LOG(Log::WRN) << "Removing unfinished job: " << pendingJob.job->describe();
+            delete pendingJob.job;
+        }
     }
 }
 
-void ThreadPool::work()
+//! Own queue is served oldest first, victims are robbed of their newest job
+bool ThreadPool::takeJob(unsigned int index, PendingJob& pendingJob)
 {
-    while (!m_quit)
     {
-        std::unique_lock<std::mutex>lock (m_accessLock);
-        if (! m_pendingJobs.empty())
+        WorkerQueue& own = *m_queues[index];
+        std::lock_guard<std::mutex> lock (own.lock);
+        if (!own.jobs.empty())
         {
-            ThreadPoolJob *job = m_pendingJobs.front();
-            m_pendingJobs.pop();
-            unsigned int size = m_pendingJobs.size();
-            lock.unlock();
-            LOG(Log::TRC) << "Removed job from the threadpool, current number of jobs is:" << size;
-            try
-            {
-                job->execute();
-            }
-            catch (...)
-            {
-                LOG(Log::ERR) << "Job '" << job->describe() << "' has thrown an unhandled exception. The job description was '" + job->describe() + "'";
-            }
-
-            delete job;
+            pendingJob = own.jobs.front();
+            own.jobs.pop_front();
+            return true;
         }
-        else
+    }
+    for (size_t i=1; i<m_queues.size(); ++i)
+    {
+        WorkerQueue& victim = *m_queues[(index + i) % m_queues.size()];
+        std::lock_guard<std::mutex> lock (victim.lock);
+        if (!victim.jobs.empty())
         {
-            m_conditionVariable.wait(lock);
+            pendingJob = victim.jobs.back();
+            victim.jobs.pop_back();
+            m_steals.fetch_add(1, std::memory_order_relaxed);
+            return true;
         }
     }
+    return false;
 }
 
-UaStatus ThreadPool::addJob (ThreadPoolJob* job)
+void ThreadPool::runJob(const PendingJob& pendingJob)
 {
+    m_numQueued--;
+    m_numReserved--;
+    if (m_numBlocked > 0)
+    {
+        std::lock_guard<std::mutex> lock (m_fullLock);
+        m_slotAvailable.notify_one();
+    }
+
+    std::chrono::steady_clock::time_point startedAt = std::chrono::steady_clock::now();
+    try
     {
-        std::lock_guard<std::mutex>lock (m_accessLock);
-        if (m_pendingJobs.size() >= m_maxJobs)
+        pendingJob.job->execute();
+    }
+    catch (...)
+    {
+        LOG(Log::ERR) << "Job '" << pendingJob.job->describe() << "' has thrown an unhandled exception. The job description was '" + pendingJob.job->describe() + "'";
+    }
+    std::chrono::steady_clock::time_point finishedAt = std::chrono::steady_clock::now();
+    delete pendingJob.job;
+
+    m_jobsExecuted.fetch_add(1, std::memory_order_relaxed);
+    m_totalWaitTimeUs.fetch_add(
+            std::chrono::duration_cast<std::chrono::microseconds>(startedAt - pendingJob.addedAt).count(),
+            std::memory_order_relaxed);
+    m_totalRunTimeUs.fetch_add(
+            std::chrono::duration_cast<std::chrono::microseconds>(finishedAt - startedAt).count(),
+            std::memory_order_relaxed);
+}
+
+void ThreadPool::work(unsigned int index)
+{
+    s_currentPool = this;
+    s_currentWorker = index;
+    while (!m_quit)
+    {
+        PendingJob pendingJob;
+        if (takeJob(index, pendingJob))
         {
-            LOG(Log::ERR) << "The threadpool is already full (it has limit of " << m_maxJobs << " jobs. Cant add new jobs. Enlarge the threadpool";
-            return OpcUa_BadResourceUnavailable;
+            runJob(pendingJob);
+            continue;
         }
-        m_pendingJobs.push(job);
+        // m_numIdle is raised before checking m_numQueued, and submitters raise m_numQueued
+        // before checking m_numIdle, so a job added meanwhile always gets noticed or notified
+        std::unique_lock<std::mutex> lock (m_idleLock);
+        m_numIdle++;
+        m_workAvailable.wait(lock, [this](){ return m_quit || m_numQueued > 0; });
+        m_numIdle--;
+    }
+}
+
+//! Claims one of the maxJobs slots, waiting up to maxBlockingTimeMs if the pool is full
+bool ThreadPool::reserveSlot()
+{
+    unsigned int reserved = m_numReserved;
+    while (reserved < m_maxJobs)
+    {
+        if (m_numReserved.compare_exchange_weak(reserved, reserved + 1))
+            return true;
+    }
+    if (m_maxBlockingTimeMs == 0)
+        return false;
+    m_jobsDelayed.fetch_add(1, std::memory_order_relaxed);
+    std::chrono::steady_clock::time_point deadline =
+            std::chrono::steady_clock::now() + std::chrono::milliseconds(m_maxBlockingTimeMs);
+    std::unique_lock<std::mutex> lock (m_fullLock);
+    m_numBlocked++;
+    bool reservedSlot = false;
+    while (!reservedSlot && !m_quit)
+    {
+        reserved = m_numReserved;
+        if (reserved < m_maxJobs)
+            reservedSlot = m_numReserved.compare_exchange_weak(reserved, reserved + 1);
+        else if (m_slotAvailable.wait_until(lock, deadline) == std::cv_status::timeout && m_numReserved >= m_maxJobs)
+            break;
+    }
+    m_numBlocked--;
+    return reservedSlot;
+}
+
+UaStatus ThreadPool::addJob (ThreadPoolJob* job)
+{
+    if (!reserveSlot())
+    {
+        m_jobsRejected.fetch_add(1, std::memory_order_relaxed);
+        LOG(Log::ERR) << "The threadpool is already full (it has limit of " << m_maxJobs << " jobs. Cant add new jobs. Enlarge the threadpool";
+        delete job;
+        return OpcUa_BadResourceUnavailable;
+    }
+    unsigned int index = (s_currentPool == this) ? s_currentWorker : (m_nextQueue++ % m_queues.size());
+    {
+        WorkerQueue& queue = *m_queues[index];
+        std::lock_guard<std::mutex> lock (queue.lock);
+        queue.jobs.push_back(PendingJob{job, std::chrono::steady_clock::now()});
+    }
+    m_numQueued++;
+    if (m_numIdle > 0)
+    {
+        std::lock_guard<std::mutex> lock (m_idleLock);
+        m_workAvailable.notify_one();
     }
-    m_conditionVariable.notify_one();
-    LOG(Log::TRC) << "Added new job to threadpool, current number of jobs is:" << m_pendingJobs.size();
     return OpcUa_Good;
 }
 
@@ -121,6 +236,39 @@ UaStatus ThreadPool::addJob (const std::function<void()>& functor, const std::st
     return this->addJob (job);
 }
 
+ThreadPool::Statistics ThreadPool::statistics () const
+{
+    Statistics statistics;
+    statistics.queueDepth = m_numQueued;
+    statistics.jobsExecuted = m_jobsExecuted.load(std::memory_order_relaxed);
+    statistics.jobsRejected = m_jobsRejected.load(std::memory_order_relaxed);
+    statistics.jobsDelayed = m_jobsDelayed.load(std::memory_order_relaxed);
+    statistics.steals = m_steals.load(std::memory_order_relaxed);
+    statistics.totalWaitTimeUs = m_totalWaitTimeUs.load(std::memory_order_relaxed);
+    statistics.totalRunTimeUs = m_totalRunTimeUs.load(std::memory_order_relaxed);
+    return statistics;
 }
 
+void ThreadPool::publishStatistics (const std::function<void(const Statistics&)>& publisher, unsigned int periodMs)
+{
+    if (m_publisher.joinable())
+    {
+        LOG(Log::ERR) << "Statistics of this threadpool are already being published";
+        return;
+    }
+    m_publisher = std::thread( [this, publisher, periodMs](){this->publisherLoop(publisher, periodMs);} );
+}
 
+void ThreadPool::publisherLoop(std::function<void(const Statistics&)> publisher, unsigned int periodMs)
+{
+    std::unique_lock<std::mutex> lock (m_publisherLock);
+    while (!m_quit)
+    {
+        lock.unlock();
+        publisher(this->statistics());
+        lock.lock();
+        m_publisherWakeUp.wait_for(lock, std::chrono::milliseconds(periodMs), [this](){ return m_quit.load(); });
+    }
+}
+
+}
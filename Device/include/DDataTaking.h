@@ -0,0 +1,67 @@
+
+/*  © Copyright CERN, 2015. All rights not expressly granted are reserved.
+
+    The stub of this file was generated by quasar (https://github.com/quasar-team/quasar/)
+
+    Quasar is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public Licence as published by
+    the Free Software Foundation, either version 3 of the Licence.
+    Quasar is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public Licence for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Quasar.  If not, see <http://www.gnu.org/licenses/>.
+
+
+ */
+
+
+#ifndef __DDataTaking__H__
+#define __DDataTaking__H__
+
+#include <Base_DDataTaking.h>
+
+namespace Device
+{
+
+class
+    DDataTaking
+    : public Base_DDataTaking
+{
+
+public:
+    /* sample constructor */
+    explicit DDataTaking (
+        const Configuration::DataTaking& config,
+        Parent_DDataTaking* parent
+    ) ;
+    /* sample dtr */
+    ~DDataTaking ();
+
+    /* delegators for
+    cachevariables and sourcevariables */
+
+
+    /* delegators for methods */
+
+private:
+    /* Delete copy constructor and assignment operator */
+    DDataTaking( const DDataTaking& other );
+    DDataTaking& operator=(const DDataTaking& other);
+
+    // ----------------------------------------------------------------------- *
+    // -     CUSTOM CODE STARTS BELOW THIS COMMENT.                            *
+    // -     Don't change this comment, otherwise merge tool may be troubled.  *
+    // ----------------------------------------------------------------------- *
+
+private:
+
+
+
+};
+
+}
+
+#endif // __DDataTaking__H__
\ No newline at end of file
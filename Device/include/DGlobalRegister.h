@@ -0,0 +1,77 @@
+
+/*  © Copyright CERN, 2015. All rights not expressly granted are reserved.
+
+    The stub of this file was generated by quasar (https://github.com/quasar-team/quasar/)
+
+    Quasar is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public Licence as published by
+    the Free Software Foundation, either version 3 of the Licence.
+    Quasar is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public Licence for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Quasar.  If not, see <http://www.gnu.org/licenses/>.
+
+
+ */
+
+
+#ifndef __DGlobalRegister__H__
+#define __DGlobalRegister__H__
+
+#include <Base_DGlobalRegister.h>
+
+namespace Device
+{
+
+class
+    DGlobalRegister
+    : public Base_DGlobalRegister
+{
+
+public:
+    /* sample constructor */
+    explicit DGlobalRegister (
+        const Configuration::GlobalRegister& config,
+        Parent_DGlobalRegister* parent
+    ) ;
+    /* sample dtr */
+    ~DGlobalRegister ();
+
+    /* delegators for
+    cachevariables and sourcevariables */
+    /* ASYNCHRONOUS !! */
+    UaStatus readValue (
+        OpcUa_UInt16& value,
+        UaDateTime& sourceTime
+    );
+
+
+    /* delegators for methods */
+
+private:
+    /* Delete copy constructor and assignment operator */
+    DGlobalRegister( const DGlobalRegister& other );
+    DGlobalRegister& operator=(const DGlobalRegister& other);
+
+    // ----------------------------------------------------------------------- *
+    // -     CUSTOM CODE STARTS BELOW THIS COMMENT.                            *
+    // -     Don't change this comment, otherwise merge tool may be troubled.  *
+    // ----------------------------------------------------------------------- *
+
+public:
+    /* global register address, taken from the object name (RegNNN) */
+    uint32_t address () const { return m_address; }
+
+private:
+    const uint32_t m_address;
+
+
+
+};
+
+}
+
+#endif // __DGlobalRegister__H__
\ No newline at end of file
@@ -0,0 +1,76 @@
+
+/*  © Copyright CERN, 2015. All rights not expressly granted are reserved.
+
+    The stub of this file was generated by quasar (https://github.com/quasar-team/quasar/)
+
+    Quasar is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public Licence as published by
+    the Free Software Foundation, either version 3 of the Licence.
+    Quasar is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public Licence for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Quasar.  If not, see <http://www.gnu.org/licenses/>.
+
+
+ */
+
+
+#ifndef __DNetioStats__H__
+#define __DNetioStats__H__
+
+#include <Base_DNetioStats.h>
+
+namespace netio
+{
+class socket_stats;
+}
+
+namespace Device
+{
+
+class
+    DNetioStats
+    : public Base_DNetioStats
+{
+
+public:
+    /* sample constructor */
+    explicit DNetioStats (
+        const Configuration::NetioStats& config,
+        Parent_DNetioStats* parent
+    ) ;
+    /* sample dtr */
+    ~DNetioStats ();
+
+    /* delegators for
+    cachevariables and sourcevariables */
+
+
+    /* delegators for methods */
+
+private:
+    /* Delete copy constructor and assignment operator */
+    DNetioStats( const DNetioStats& other );
+    DNetioStats& operator=(const DNetioStats& other);
+
+    // ----------------------------------------------------------------------- *
+    // -     CUSTOM CODE STARTS BELOW THIS COMMENT.                            *
+    // -     Don't change this comment, otherwise merge tool may be troubled.  *
+    // ----------------------------------------------------------------------- *
+
+public:
+    /* copy the current counters of a netio socket into the address space */
+    void update (netio::socket_stats& stats);
+
+private:
+
+
+
+};
+
+}
+
+#endif // __DNetioStats__H__
\ No newline at end of file
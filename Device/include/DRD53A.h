@@ -21,8 +21,19 @@
 #ifndef __DRD53A__H__
 #define __DRD53A__H__
 
+#include <memory>
+#include <mutex>
+
 #include <Base_DRD53A.h>
 
+namespace RD53A
+{
+class FrontEnd;
+class RegisterCache;
+class HitHistograms;
+class EventMerger;
+}
+
 namespace Device
 {
 
@@ -45,6 +56,10 @@ public:
 
 
     /* delegators for methods */
+    UaStatus callDumpFlightRecorder (
+        const UaString&  name,
+        OpcUa_UInt32& events
+    ) ;
 
 private:
     /* Delete copy constructor and assignment operator */
@@ -57,10 +72,20 @@ private:
     // ----------------------------------------------------------------------- *
 
 public:
+    /* serve the GlobalRegister reads of this chip from the register cache of the front-end */
+    void attach (RD53A::FrontEnd* fe);
+    /* stop serving them, reads fail until attached again */
+    void detach ();
+    /* null while not attached */
+    std::shared_ptr<RD53A::RegisterCache> registerCache ();
+    /* publish the projections of the online histograms of the front-end */
+    void updateHistograms (const RD53A::HitHistograms& histos);
+    /* publish the completeness of the events of this chip in the event building across chips */
+    void updateMerging (RD53A::EventMerger& merger, uint32_t index);
 
 private:
-
-
+    std::mutex m_registerCacheLock;
+    std::shared_ptr<RD53A::RegisterCache> m_registerCache;
 
 };
 
@@ -22,6 +22,16 @@
 
 #include <DRD53A.h>
 #include <ASRD53A.h>
+#include <DGlobalRegister.h>
+#include <ASGlobalRegister.h>
+#include <DDataTaking.h>
+#include <DRoot.h>
+
+#include <unistd.h>
+#include <LogIt.h>
+
+#include "RD53Emulator/FrontEnd.h"
+#include "RD53Emulator/FlightRecorder.h"
 
 namespace Device
 {
@@ -68,6 +78,38 @@ DRD53A::~DRD53A ()
 
 
 /* delegators for methods */
+UaStatus DRD53A::callDumpFlightRecorder (
+    const UaString&  name,
+    OpcUa_UInt32& events
+)
+{
+    if (!RD53A::FlightRecorder::IsEnabled())
+    {
+        LOG(Log::ERR) << "The flight recorder is not enabled";
+        return OpcUa_BadInvalidState;
+    }
+    // only a plain file name, the directory comes from the configuration
+    std::string file = name.toUtf8();
+    if (file.find('/') != std::string::npos || file.find("..") != std::string::npos)
+    {
+        LOG(Log::ERR) << "Invalid flight recorder file name: " << file;
+        return OpcUa_BadInvalidArgument;
+    }
+    if (file.empty())
+        file = "flightrecorder-" + std::to_string(getpid()) + ".bin";
+    std::string directory = ".";
+    for (DDataTaking *settings : DRoot::getInstance()->datatakings())
+        directory = settings->FlightRecorderDirectory();
+    file = directory + "/" + file;
+    int64_t written = RD53A::FlightRecorder::Dump(file);
+    if (written < 0)
+    {
+        LOG(Log::ERR) << "Failed to write the flight recorder to " << file;
+        return OpcUa_BadResourceUnavailable;
+    }
+    events = written;
+    return OpcUa_Good;
+}
 
 // 3333333333333333333333333333333333333333333333333333333333333333333333333
 // 3     FULLY CUSTOM CODE STARTS HERE                                     3
@@ -75,4 +117,56 @@ DRD53A::~DRD53A ()
 // 3     You can do whatever you want, but please be decent.               3
 // 3333333333333333333333333333333333333333333333333333333333333333333333333
 
-}
\ No newline at end of file
+void DRD53A::attach (RD53A::FrontEnd* fe)
+{
+    for (DGlobalRegister* reg : globalregisters())
+    {
+        std::string fields;
+        for (const std::string& name : fe->GetConfig()->GetFieldNames(reg->address()))
+            fields += (fields.empty() ? "" : ",") + name;
+        reg->getAddressSpaceLink()->setFields(fields.c_str(), OpcUa_Good);
+    }
+    std::lock_guard<std::mutex> lock (m_registerCacheLock);
+    m_registerCache = fe->GetRegisterCache();
+}
+
+void DRD53A::detach ()
+{
+    std::lock_guard<std::mutex> lock (m_registerCacheLock);
+    m_registerCache.reset();
+}
+
+std::shared_ptr<RD53A::RegisterCache> DRD53A::registerCache ()
+{
+    std::lock_guard<std::mutex> lock (m_registerCacheLock);
+    return m_registerCache;
+}
+
+void DRD53A::updateHistograms (const RD53A::HitHistograms& histos)
+{
+    AddressSpace::ASRD53A* as = getAddressSpaceLink();
+    as->setHitCount(histos.GetNumHits(), OpcUa_Good);
+
+    std::vector<OpcUa_UInt64> projection;
+    histos.GetColumnOccupancy(projection);
+    as->setColumnOccupancy(projection, OpcUa_Good);
+    histos.GetRowOccupancy(projection);
+    as->setRowOccupancy(projection, OpcUa_Good);
+
+    std::vector<OpcUa_UInt64> tot(histos.GetTot(), histos.GetTot() + RD53A::HitHistograms::NUM_TOT);
+    as->setTotHistogram(tot, OpcUa_Good);
+    std::vector<OpcUa_UInt64> time(histos.GetTime(), histos.GetTime() + RD53A::HitHistograms::NUM_TIME);
+    as->setTimeHistogram(time, OpcUa_Good);
+}
+
+void DRD53A::updateMerging (RD53A::EventMerger& merger, uint32_t index)
+{
+    AddressSpace::ASRD53A* as = getAddressSpaceLink();
+    RD53A::EventMerger::Statistics stats = merger.GetStatistics(index);
+    as->setMergedFragments(stats.fragments, OpcUa_Good);
+    as->setMergedEvents(stats.matched, OpcUa_Good);
+    as->setMissedEvents(stats.missing, OpcUa_Good);
+    as->setDroppedFragments(stats.dropped, OpcUa_Good);
+}
+
+}
@@ -30,14 +30,23 @@
 #include "LogLevels.h"
 #include "LogItInstance.h"
 
+/**
+ * Compile time threshold: LOG invocations below this level are removed by the compiler
+ * (the level is a constant, so the whole statement - including the evaluation of the
+ * streamed arguments - is dead code). Override with e.g. -DLOGIT_COMPILED_MIN_LEVEL=Log::INF
+ */
+#ifndef LOGIT_COMPILED_MIN_LEVEL
+#define LOGIT_COMPILED_MIN_LEVEL Log::TRC
+#endif
+
 // internal macro - will be called by LOG(LOG_LEVEL)
 #define LOG_WITHOUT_COMPONENT(level) \
-     if( !Log::isLoggable(level) ) (void)0; \
+     if( (level) < LOGIT_COMPILED_MIN_LEVEL || !Log::isLoggable(level) ) (void)0; \
      else LogRecord(__FILE__, __LINE__, level).getStream()
 
 // internal macro - will be called by LOG(LOG_LEVEL, USER_COMPONENT)
 #define LOG_WITH_COMPONENT(level, component) \
-    if( !Log::isLoggable(level, component) ) (void)0; \
+    if( (level) < LOGIT_COMPILED_MIN_LEVEL || !Log::isLoggable(level, component) ) (void)0; \
     else LogRecord(__FILE__, __LINE__, level, component).getStream()
 
 /**
@@ -78,6 +87,21 @@ namespace Log
 	 */
 	SHARED_LIB_EXPORT_DEFN bool initializeDllLogging(LogItInstance* remoteLogInstance);
 
+	/**
+	 * Async mode (call after initializing): LOG invocations only format the user message and push the
+	 * record into a lock-free ring owned by the logging thread; a background thread formats the records
+	 * and writes them to the sinks. Logging threads never block, if a ring is full the record is dropped
+	 * and counted (see getDroppedLogCount).
+	 *
+	 * stopAsyncLogging writes out all pending records and returns to synchronous logging: call it before
+	 * exiting, records still in the rings are lost otherwise.
+	 *
+	 * RETURNS: false if logging is not initialized or async mode is already on.
+	 */
+	SHARED_LIB_EXPORT_DEFN bool startAsyncLogging(const size_t& ringCapacity = 4096);
+	SHARED_LIB_EXPORT_DEFN void stopAsyncLogging();
+	SHARED_LIB_EXPORT_DEFN uint64_t getDroppedLogCount();
+
     /**
      * register a user defined logging component.
      * LOG(LOG_LEVEL) invocations will be considered for logging
@@ -24,9 +24,27 @@
 
 #include <stdint.h>
 #include <sstream>
+#include <string>
+#include <chrono>
 #include "LogLevels.h"
 #include "LogItStaticDefinitions.h"
 
+/**
+ * A log record captured in async mode: only the user message is formatted by the
+ * logging thread, the prefix (timestamp, file, line, level, component) is formatted
+ * by the drain thread.
+ */
+struct AsyncLogRecord
+{
+    std::chrono::system_clock::time_point m_time;
+    const char* m_file; // static storage (__FILE__)
+    int m_line;
+    Log::LOG_LEVEL m_level;
+    Log::LogComponentHandle m_componentHandle; // Log::INVALID_HANDLE if none/named
+    std::string m_componentName;
+    std::string m_message;
+};
+
 class LogRecord
 {
 public:
@@ -34,14 +52,31 @@ public:
 	SHARED_LIB_EXPORT_DEFN LogRecord(const std::string& file, const int& line, const Log::LOG_LEVEL& level, const Log::LogComponentHandle& componentHandle);
 	SHARED_LIB_EXPORT_DEFN LogRecord(const std::string& file, const int& line, const Log::LOG_LEVEL& level, const std::string& componentName);
 
+	/**
+	 * Used by the LOG macros: file must have static storage (i.e. __FILE__). In async mode only the
+	 * user message is formatted by the logging thread, the rest of the record is formatted by the
+	 * drain thread.
+	 */
+	SHARED_LIB_EXPORT_DEFN LogRecord(const char* file, const int& line, const Log::LOG_LEVEL& level);
+	SHARED_LIB_EXPORT_DEFN LogRecord(const char* file, const int& line, const Log::LOG_LEVEL& level, const Log::LogComponentHandle& componentHandle);
+	SHARED_LIB_EXPORT_DEFN LogRecord(const char* file, const int& line, const Log::LOG_LEVEL& level, const std::string& componentName);
+
 	SHARED_LIB_EXPORT_DEFN virtual ~LogRecord();
 
 	SHARED_LIB_EXPORT_DEFN std::ostream& getStream();
 
+	/**
+	 * Formats a record captured in async mode exactly as a synchronous record would have been.
+	 */
+	static std::string formatAsyncRecord(const AsyncLogRecord& record);
+
 private:
     static const std::string stripDirectory(const std::string& file);
     std::ostringstream& initializeStream(const std::string& file, const int& line, const Log::LOG_LEVEL& level);
+    bool initializeAsyncRecord(const char* file, const int& line, const Log::LOG_LEVEL& level);
     std::ostringstream m_stream;
+    AsyncLogRecord m_asyncRecord; // declared before m_isAsync: filled by its initializer
+    bool m_isAsync;
 };
 
 
@@ -24,7 +24,15 @@
 
 #include <string>
 #include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <stdint.h>
 #include "LogSinkInterface.h"
+#include "LogRecord.h"
 
 class LogSinks
 {
@@ -34,8 +42,44 @@ public:
     void addSink(LogSinkInterface* sink);
     void logMessage(const std::string& logMsg);
 
+    /**
+     * Async mode: each logging thread pushes its records into its own lock-free
+     * ring (single producer, single consumer), a background thread drains the rings,
+     * formats the records and passes them to the sinks. A logging thread never blocks:
+     * if its ring is full the record is dropped and counted.
+     *
+     * stopAsync() drains all rings and returns to synchronous logging.
+     */
+    bool startAsync(const size_t& ringCapacity);
+    void stopAsync();
+    bool isAsync() const { return m_async.load(std::memory_order_acquire); }
+    void logRecord(AsyncLogRecord& record);
+    uint64_t getDroppedCount() const;
+
 private:
+    class Ring;
+    typedef std::shared_ptr<Ring> RingPtr;
+
+    Ring* getThreadRing();
+    void drainLoop();
+    bool drainRings();
+    void writeRecord(const AsyncLogRecord& record);
+
     std::vector<LogSinkInterface*> m_sinks;
+
+    std::atomic<bool> m_async;
+    size_t m_ringCapacity;
+    std::atomic<uint32_t> m_generation;
+
+    mutable std::mutex m_ringsLock;
+    std::vector<RingPtr> m_rings;
+    uint64_t m_droppedByExitedThreads;
+    uint64_t m_droppedReported;
+
+    std::mutex m_drainLock;
+    std::condition_variable m_drainWakeup;
+    bool m_drainStop;
+    std::thread m_drainThread;
 };
 
 #endif /* SRC_INCLUDE_LOGSINKS_H_ */
@@ -95,6 +95,24 @@ bool Log::initializeDllLogging(LogItInstance* remoteInstance)
 	return LogItInstance::setInstance(remoteInstance);
 }
 
+bool Log::startAsyncLogging(const size_t& ringCapacity /*=4096*/)
+{
+	if(!LogItInstance::instanceExists()) return false;
+	return LogItInstance::getInstance()->m_logSinksInstance.startAsync(ringCapacity);
+}
+
+void Log::stopAsyncLogging()
+{
+	if(!LogItInstance::instanceExists()) return;
+	LogItInstance::getInstance()->m_logSinksInstance.stopAsync();
+}
+
+uint64_t Log::getDroppedLogCount()
+{
+	if(!LogItInstance::instanceExists()) return 0;
+	return LogItInstance::getInstance()->m_logSinksInstance.getDroppedCount();
+}
+
 Log::LogComponentHandle Log::registerLoggingComponent(const string& componentName, const Log::LOG_LEVEL& nonComponentLogLevel /*=Log::INF*/)
 {
     if(!LogItInstance::instanceExists()) return Log::INVALID_HANDLE;
@@ -32,35 +32,105 @@
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/date_time/posix_time/posix_time_io.hpp>
 #include <boost/format.hpp>
+#include <boost/date_time/c_local_time_adjustor.hpp>
 
 using boost::posix_time::time_facet;
 using boost::posix_time::microsec_clock;
+using boost::posix_time::ptime;
 
 using std::string;
 
 const string g_sTimestampFormat = "%Y-%m-%d %H:%M.%s";
 
+namespace
+{
+    ptime toLocalTime(const std::chrono::system_clock::time_point& time)
+    {
+        const int64_t sinceEpoch = std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count();
+        const ptime utc = boost::posix_time::from_time_t(static_cast<std::time_t>(sinceEpoch / 1000000)) + boost::posix_time::microseconds(sinceEpoch % 1000000);
+        return boost::date_time::c_local_adjustor<ptime>::utc_to_local(utc);
+    }
+}
+
 LogRecord::LogRecord(const string& file, const int& line, const Log::LOG_LEVEL& level)
+:m_isAsync(false)
 {
     initializeStream(file, line, level)<<"] ";
 }
 
 LogRecord::LogRecord(const string& file, const int& line, const Log::LOG_LEVEL& level, const Log::LogComponentHandle& componentHandle)
+:m_isAsync(false)
 {
     initializeStream(file, line, level)<<", "<<Log::getComponentName(componentHandle)<<"] ";
 }
 
 LogRecord::LogRecord(const std::string& file, const int& line, const Log::LOG_LEVEL& level, const std::string& componentName)
+:m_isAsync(false)
 {
 	initializeStream(file, line, level)<<", "<<componentName<<"] ";
 }
 
+LogRecord::LogRecord(const char* file, const int& line, const Log::LOG_LEVEL& level)
+:m_isAsync(initializeAsyncRecord(file, line, level))
+{
+    if(!m_isAsync) initializeStream(file, line, level)<<"] ";
+}
+
+LogRecord::LogRecord(const char* file, const int& line, const Log::LOG_LEVEL& level, const Log::LogComponentHandle& componentHandle)
+:m_isAsync(initializeAsyncRecord(file, line, level))
+{
+    if(m_isAsync) m_asyncRecord.m_componentHandle = componentHandle; // name resolved by the drain thread
+    else initializeStream(file, line, level)<<", "<<Log::getComponentName(componentHandle)<<"] ";
+}
+
+LogRecord::LogRecord(const char* file, const int& line, const Log::LOG_LEVEL& level, const std::string& componentName)
+:m_isAsync(initializeAsyncRecord(file, line, level))
+{
+    if(m_isAsync) m_asyncRecord.m_componentName = componentName;
+    else initializeStream(file, line, level)<<", "<<componentName<<"] ";
+}
+
 LogRecord::~LogRecord()
 {
+    if(m_isAsync)
+    {
+        m_asyncRecord.m_message = m_stream.str();
+        LogItInstance::getInstance()->m_logSinksInstance.logRecord(m_asyncRecord);
+        return;
+    }
     m_stream.flush();
     LogItInstance::getInstance()->m_logSinksInstance.logMessage(m_stream.str());
 }
 
+bool LogRecord::initializeAsyncRecord(const char* file, const int& line, const Log::LOG_LEVEL& level)
+{
+    if(!LogItInstance::getInstance()->m_logSinksInstance.isAsync()) return false;
+
+    m_asyncRecord.m_time = std::chrono::system_clock::now();
+    m_asyncRecord.m_file = file;
+    m_asyncRecord.m_line = line;
+    m_asyncRecord.m_level = level;
+    m_asyncRecord.m_componentHandle = Log::INVALID_HANDLE;
+    return true;
+}
+
+string LogRecord::formatAsyncRecord(const AsyncLogRecord& record)
+{
+    std::ostringstream stream;
+    stream.imbue(std::locale(stream.getloc(), new time_facet(g_sTimestampFormat.c_str())));
+    stream << toLocalTime(record.m_time) << " ["<<stripDirectory(record.m_file)<<":"<<record.m_line<<", "<<Log::logLevelToString(record.m_level);
+    if(record.m_componentHandle != Log::INVALID_HANDLE)
+    {
+        stream<<", "<<Log::getComponentName(record.m_componentHandle);
+    }
+    else if(!record.m_componentName.empty())
+    {
+        stream<<", "<<record.m_componentName;
+    }
+    stream<<"] "<<record.m_message;
+    return stream.str();
+}
+
 std::ostringstream& LogRecord::initializeStream(const string& file, const int& line, const Log::LOG_LEVEL& level)
 {
     m_stream.imbue(std::locale(m_stream.getloc(), new time_facet(g_sTimestampFormat.c_str())));
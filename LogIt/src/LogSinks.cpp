@@ -19,10 +19,96 @@
  *  along with Quasar.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "LogSinks.h"
+#include "LogRecord.h"
+#include <sstream>
 
 using std::vector;
+using std::string;
+
+namespace
+{
+    // the drain thread wakes up at least this often, or earlier when a ring is half full
+    const std::chrono::milliseconds g_sDrainInterval(2);
+
+    // false sharing between the producer and consumer indices is avoided by padding
+    const size_t g_sCacheLineSize = 64;
+
+    size_t roundUpToPowerOfTwo(size_t value)
+    {
+        size_t result = 2;
+        while(result < value) result <<= 1;
+        return result;
+    }
+}
+
+/**
+ * Single producer (the logging thread), single consumer (the drain thread) ring of log records.
+ */
+class LogSinks::Ring
+{
+public:
+    explicit Ring(const size_t& capacity)
+    :m_slots(roundUpToPowerOfTwo(capacity)), m_mask(m_slots.size()-1), m_head(0), m_tail(0), m_dropped(0)
+    {}
+
+    /**
+     * Moves the record into the ring. Returns the number of records in the ring after the push, or 0
+     * if the ring was full and the record has been dropped.
+     */
+    size_t push(AsyncLogRecord& record)
+    {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        const size_t head = m_head.load(std::memory_order_acquire);
+        if(tail - head >= m_slots.size())
+        {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return 0;
+        }
+        AsyncLogRecord& slot = m_slots[tail & m_mask];
+        slot.m_time = record.m_time;
+        slot.m_file = record.m_file;
+        slot.m_line = record.m_line;
+        slot.m_level = record.m_level;
+        slot.m_componentHandle = record.m_componentHandle;
+        slot.m_componentName.swap(record.m_componentName);
+        slot.m_message.swap(record.m_message);
+        m_tail.store(tail+1, std::memory_order_release);
+        return tail+1-head;
+    }
+
+    /**
+     * Passes every record currently in the ring to the given function. Returns the number of records.
+     */
+    template<typename Function> size_t pop(Function function)
+    {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        const size_t tail = m_tail.load(std::memory_order_acquire);
+        const size_t count = tail - head;
+        for(; head != tail; ++head)
+        {
+            function(m_slots[head & m_mask]);
+            m_head.store(head+1, std::memory_order_release);
+        }
+        return count;
+    }
+
+    bool empty() const { return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire); }
+    size_t capacity() const { return m_slots.size(); }
+    uint64_t getDroppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    vector<AsyncLogRecord> m_slots;
+    const size_t m_mask;
+    char m_padding0[g_sCacheLineSize];
+    std::atomic<size_t> m_head;
+    char m_padding1[g_sCacheLineSize - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> m_tail;
+    char m_padding2[g_sCacheLineSize - sizeof(std::atomic<size_t>)];
+    std::atomic<uint64_t> m_dropped;
+};
 
 LogSinks::LogSinks()
+:m_async(false), m_ringCapacity(0), m_generation(0), m_droppedByExitedThreads(0), m_droppedReported(0), m_drainStop(false)
 {}
 
 /**
@@ -30,6 +116,7 @@ LogSinks::LogSinks()
  */
 LogSinks::~LogSinks()
 {
+    stopAsync();
     for(vector<LogSinkInterface*>::iterator it = m_sinks.begin(); it!= m_sinks.end(); ++it)
     {
         delete *it;
@@ -51,3 +138,165 @@ void LogSinks::logMessage(const std::string& logMsg)
         (*it)->logMessage(logMsg);
     }
 }
+
+bool LogSinks::startAsync(const size_t& ringCapacity)
+{
+    if(isAsync()) return false;
+
+    m_ringCapacity = ringCapacity;
+    m_drainStop = false;
+    m_generation.fetch_add(1, std::memory_order_acq_rel);
+    m_drainThread = std::thread(&LogSinks::drainLoop, this);
+    m_async.store(true, std::memory_order_release);
+    return true;
+}
+
+/**
+ * Note: a record logged by another thread *while* async mode is being stopped may be lost
+ */
+void LogSinks::stopAsync()
+{
+    if(!m_async.exchange(false, std::memory_order_acq_rel)) return;
+
+    {
+        std::lock_guard<std::mutex> scopedLock(m_drainLock);
+        m_drainStop = true;
+    }
+    m_drainWakeup.notify_one();
+    m_drainThread.join();
+    drainRings();
+
+    // the rings of the stopped generation are abandoned, threads get a new one if async mode is restarted.
+    std::lock_guard<std::mutex> scopedLock(m_ringsLock);
+    for(vector<RingPtr>::const_iterator it = m_rings.begin(); it != m_rings.end(); ++it)
+    {
+        m_droppedByExitedThreads += (*it)->getDroppedCount();
+    }
+    m_rings.clear();
+    m_generation.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void LogSinks::logRecord(AsyncLogRecord& record)
+{
+    if(!isAsync())
+    {
+        writeRecord(record);
+        return;
+    }
+
+    Ring* ring = getThreadRing();
+    const size_t fill = ring->push(record);
+    if(fill == ring->capacity()/2)
+    {
+        m_drainWakeup.notify_one();
+    }
+}
+
+uint64_t LogSinks::getDroppedCount() const
+{
+    std::lock_guard<std::mutex> scopedLock(m_ringsLock);
+    uint64_t result = m_droppedByExitedThreads;
+    for(vector<RingPtr>::const_iterator it = m_rings.begin(); it != m_rings.end(); ++it)
+    {
+        result += (*it)->getDroppedCount();
+    }
+    return result;
+}
+
+LogSinks::Ring* LogSinks::getThreadRing()
+{
+    // the ring is shared with the registry so that records logged just before the thread exits are still written.
+    static thread_local RingPtr t_ring;
+    static thread_local const LogSinks* t_owner = nullptr;
+    static thread_local uint32_t t_generation = 0;
+
+    const uint32_t generation = m_generation.load(std::memory_order_acquire);
+    if(!t_ring || t_owner != this || t_generation != generation)
+    {
+        t_ring = std::make_shared<Ring>(m_ringCapacity);
+        t_owner = this;
+        t_generation = generation;
+        std::lock_guard<std::mutex> scopedLock(m_ringsLock);
+        m_rings.push_back(t_ring);
+    }
+    return t_ring.get();
+}
+
+void LogSinks::drainLoop()
+{
+    std::unique_lock<std::mutex> lock(m_drainLock);
+    while(!m_drainStop)
+    {
+        lock.unlock();
+        const bool drainedAny = drainRings();
+        lock.lock();
+        if(!drainedAny && !m_drainStop)
+        {
+            m_drainWakeup.wait_for(lock, g_sDrainInterval);
+        }
+    }
+}
+
+/**
+ * Writes the contents of every ring to the sinks. Returns true if any record was written.
+ * Called by the drain thread only (and by stopAsync() once the drain thread has stopped).
+ */
+bool LogSinks::drainRings()
+{
+    static thread_local vector<RingPtr> rings;
+    {
+        std::lock_guard<std::mutex> scopedLock(m_ringsLock);
+        rings.assign(m_rings.begin(), m_rings.end());
+    }
+
+    size_t count = 0;
+    uint64_t dropped = 0;
+    bool haveExitedThreads = false;
+    for(vector<RingPtr>::const_iterator it = rings.begin(); it != rings.end(); ++it)
+    {
+        count += (*it)->pop([this](const AsyncLogRecord& record){ writeRecord(record); });
+        dropped += (*it)->getDroppedCount();
+        // the registry and this vector hold the only references once the logging thread exited
+        if(it->use_count() == 2) haveExitedThreads = true;
+    }
+    rings.clear();
+
+    {
+        std::lock_guard<std::mutex> scopedLock(m_ringsLock);
+        dropped += m_droppedByExitedThreads;
+        if(haveExitedThreads)
+        {
+            for(vector<RingPtr>::iterator it = m_rings.begin(); it != m_rings.end();)
+            {
+                if(it->use_count() == 1 && (*it)->empty())
+                {
+                    m_droppedByExitedThreads += (*it)->getDroppedCount();
+                    it = m_rings.erase(it);
+                }
+                else ++it;
+            }
+        }
+    }
+
+    if(dropped > m_droppedReported)
+    {
+        std::ostringstream msg;
+        msg << "LogIt async mode: dropped ["<<(dropped-m_droppedReported)<<"] log records (ring buffer full), ["<<dropped<<"] in total";
+        AsyncLogRecord record;
+        record.m_time = std::chrono::system_clock::now();
+        record.m_file = __FILE__;
+        record.m_line = __LINE__;
+        record.m_level = Log::WRN;
+        record.m_componentHandle = Log::INVALID_HANDLE;
+        record.m_message = msg.str();
+        writeRecord(record);
+        m_droppedReported = dropped;
+    }
+
+    return count > 0;
+}
+
+void LogSinks::writeRecord(const AsyncLogRecord& record)
+{
+    logMessage(LogRecord::formatAsyncRecord(record));
+}
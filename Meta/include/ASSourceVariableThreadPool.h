@@ -88,6 +88,76 @@ public:
 
 
 
+    UaStatus getQueueDepth (OpcUa_UInt32 &) const ;
+    UaStatus setQueueDepth (const OpcUa_UInt32 value, OpcUa_StatusCode statusCode,const UaDateTime & srcTime = UaDateTime::now()) ;
+
+
+
+    /* short getter (possible because nullPolicy=nullForbidden) */
+    OpcUa_UInt32 getQueueDepth () const;
+
+
+
+    UaStatus getJobsExecuted (OpcUa_UInt64 &) const ;
+    UaStatus setJobsExecuted (const OpcUa_UInt64 value, OpcUa_StatusCode statusCode,const UaDateTime & srcTime = UaDateTime::now()) ;
+
+
+
+    /* short getter (possible because nullPolicy=nullForbidden) */
+    OpcUa_UInt64 getJobsExecuted () const;
+
+
+
+    UaStatus getJobsRejected (OpcUa_UInt64 &) const ;
+    UaStatus setJobsRejected (const OpcUa_UInt64 value, OpcUa_StatusCode statusCode,const UaDateTime & srcTime = UaDateTime::now()) ;
+
+
+
+    /* short getter (possible because nullPolicy=nullForbidden) */
+    OpcUa_UInt64 getJobsRejected () const;
+
+
+
+    UaStatus getJobsDelayed (OpcUa_UInt64 &) const ;
+    UaStatus setJobsDelayed (const OpcUa_UInt64 value, OpcUa_StatusCode statusCode,const UaDateTime & srcTime = UaDateTime::now()) ;
+
+
+
+    /* short getter (possible because nullPolicy=nullForbidden) */
+    OpcUa_UInt64 getJobsDelayed () const;
+
+
+
+    UaStatus getSteals (OpcUa_UInt64 &) const ;
+    UaStatus setSteals (const OpcUa_UInt64 value, OpcUa_StatusCode statusCode,const UaDateTime & srcTime = UaDateTime::now()) ;
+
+
+
+    /* short getter (possible because nullPolicy=nullForbidden) */
+    OpcUa_UInt64 getSteals () const;
+
+
+
+    UaStatus getAverageWaitTime (OpcUa_Double &) const ;
+    UaStatus setAverageWaitTime (const OpcUa_Double value, OpcUa_StatusCode statusCode,const UaDateTime & srcTime = UaDateTime::now()) ;
+
+
+
+    /* short getter (possible because nullPolicy=nullForbidden) */
+    OpcUa_Double getAverageWaitTime () const;
+
+
+
+    UaStatus getAverageRunTime (OpcUa_Double &) const ;
+    UaStatus setAverageRunTime (const OpcUa_Double value, OpcUa_StatusCode statusCode,const UaDateTime & srcTime = UaDateTime::now()) ;
+
+
+
+    /* short getter (possible because nullPolicy=nullForbidden) */
+    OpcUa_Double getAverageRunTime () const;
+
+
+
 
     /* delegators for cachevariables  */
 
@@ -113,6 +183,20 @@ private:
     * m_minThreads;
     OpcUa::BaseDataVariableType
     * m_maxThreads;
+    OpcUa::BaseDataVariableType
+    * m_queueDepth;
+    OpcUa::BaseDataVariableType
+    * m_jobsExecuted;
+    OpcUa::BaseDataVariableType
+    * m_jobsRejected;
+    OpcUa::BaseDataVariableType
+    * m_jobsDelayed;
+    OpcUa::BaseDataVariableType
+    * m_steals;
+    OpcUa::BaseDataVariableType
+    * m_averageWaitTime;
+    OpcUa::BaseDataVariableType
+    * m_averageRunTime;
 
 
     /* Device Logic link (if requested) */
@@ -33,6 +33,8 @@
 
 #include <Base_DSourceVariableThreadPool.h>
 
+#include <QuasarThreadPool.h>
+
 
 namespace Device
 {
@@ -47,7 +49,7 @@ class
 
 public:
     /* sample constructor */
-    explicit DSourceVariableThreadPool (const size_t& min, const size_t& max, const size_t& maxJobs);
+    explicit DSourceVariableThreadPool (const size_t& min, const size_t& max, const size_t& maxJobs, const size_t& maxBlockingTimeMs);
     /* sample dtr */
     ~DSourceVariableThreadPool ();
 
@@ -69,9 +71,15 @@ private:
     // ----------------------------------------------------------------------- *
 
 public:
+    //! Starts refreshing the pool statistics in the address space every periodMs
+    void publishStatistics (unsigned int periodMs);
 
 private:
+    //! Called from the statistics thread of the pool only
+    void updateStatistics (const Quasar::ThreadPool::Statistics& statistics);
 
+    //! Previous sample, to turn the cumulative wait and run times into averages per period
+    Quasar::ThreadPool::Statistics m_lastStatistics;
 
 };
 
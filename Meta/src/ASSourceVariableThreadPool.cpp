@@ -79,6 +79,118 @@ ASSourceVariableThreadPool::ASSourceVariableThreadPool (
 
 
 
+    ,
+    m_queueDepth (new
+
+                  OpcUa::BaseDataVariableType
+
+
+                  (nm->makeChildNodeId(this->nodeId(),UaString("queueDepth")), UaString("queueDepth"), nm->getNameSpaceIndex(), UaVariant(
+
+                       static_cast<OpcUa_UInt32>(0)
+                   ),
+
+                   OpcUa_AccessLevels_CurrentRead
+                   , nm))
+
+
+
+    ,
+    m_jobsExecuted (new
+
+                  OpcUa::BaseDataVariableType
+
+
+                  (nm->makeChildNodeId(this->nodeId(),UaString("jobsExecuted")), UaString("jobsExecuted"), nm->getNameSpaceIndex(), UaVariant(
+
+                       static_cast<OpcUa_UInt64>(0)
+                   ),
+
+                   OpcUa_AccessLevels_CurrentRead
+                   , nm))
+
+
+
+    ,
+    m_jobsRejected (new
+
+                  OpcUa::BaseDataVariableType
+
+
+                  (nm->makeChildNodeId(this->nodeId(),UaString("jobsRejected")), UaString("jobsRejected"), nm->getNameSpaceIndex(), UaVariant(
+
+                       static_cast<OpcUa_UInt64>(0)
+                   ),
+
+                   OpcUa_AccessLevels_CurrentRead
+                   , nm))
+
+
+
+    ,
+    m_jobsDelayed (new
+
+                  OpcUa::BaseDataVariableType
+
+
+                  (nm->makeChildNodeId(this->nodeId(),UaString("jobsDelayed")), UaString("jobsDelayed"), nm->getNameSpaceIndex(), UaVariant(
+
+                       static_cast<OpcUa_UInt64>(0)
+                   ),
+
+                   OpcUa_AccessLevels_CurrentRead
+                   , nm))
+
+
+
+    ,
+    m_steals (new
+
+                  OpcUa::BaseDataVariableType
+
+
+                  (nm->makeChildNodeId(this->nodeId(),UaString("steals")), UaString("steals"), nm->getNameSpaceIndex(), UaVariant(
+
+                       static_cast<OpcUa_UInt64>(0)
+                   ),
+
+                   OpcUa_AccessLevels_CurrentRead
+                   , nm))
+
+
+
+    ,
+    m_averageWaitTime (new
+
+                  OpcUa::BaseDataVariableType
+
+
+                  (nm->makeChildNodeId(this->nodeId(),UaString("averageWaitTime")), UaString("averageWaitTime"), nm->getNameSpaceIndex(), UaVariant(
+
+                       static_cast<OpcUa_Double>(0)
+                   ),
+
+                   OpcUa_AccessLevels_CurrentRead
+                   , nm))
+
+
+
+    ,
+    m_averageRunTime (new
+
+                  OpcUa::BaseDataVariableType
+
+
+                  (nm->makeChildNodeId(this->nodeId(),UaString("averageRunTime")), UaString("averageRunTime"), nm->getNameSpaceIndex(), UaVariant(
+
+                       static_cast<OpcUa_Double>(0)
+                   ),
+
+                   OpcUa_AccessLevels_CurrentRead
+                   , nm))
+
+
+
     ,
     m_deviceLink (0)
 
@@ -120,6 +232,97 @@ ASSourceVariableThreadPool::ASSourceVariableThreadPool (
     }
 
 
+    v.setUInt32 (
+    		static_cast<OpcUa_UInt32>(0)
+    );
+    m_queueDepth->setValue(/*pSession*/0, UaDataValue(UaVariant( v ), OpcUa_Good, UaDateTime::now(), UaDateTime::now() ), /*check access level*/OpcUa_False);
+
+    s = nm->addNodeAndReference(this, m_queueDepth, OpcUaId_HasComponent);
+    if (!s.isGood())
+    {
+        std::cout << "While addNodeAndReference from " << this->nodeId().toString().toUtf8() << " to " << m_queueDepth->nodeId().toString().toUtf8() << " : " << std::endl;
+        ASSERT_GOOD(s);
+    }
+
+
+    v.setUInt64 (
+    		static_cast<OpcUa_UInt64>(0)
+    );
+    m_jobsExecuted->setValue(/*pSession*/0, UaDataValue(UaVariant( v ), OpcUa_Good, UaDateTime::now(), UaDateTime::now() ), /*check access level*/OpcUa_False);
+
+    s = nm->addNodeAndReference(this, m_jobsExecuted, OpcUaId_HasComponent);
+    if (!s.isGood())
+    {
+        std::cout << "While addNodeAndReference from " << this->nodeId().toString().toUtf8() << " to " << m_jobsExecuted->nodeId().toString().toUtf8() << " : " << std::endl;
+        ASSERT_GOOD(s);
+    }
+
+
+    v.setUInt64 (
+    		static_cast<OpcUa_UInt64>(0)
+    );
+    m_jobsRejected->setValue(/*pSession*/0, UaDataValue(UaVariant( v ), OpcUa_Good, UaDateTime::now(), UaDateTime::now() ), /*check access level*/OpcUa_False);
+
+    s = nm->addNodeAndReference(this, m_jobsRejected, OpcUaId_HasComponent);
+    if (!s.isGood())
+    {
+        std::cout << "While addNodeAndReference from " << this->nodeId().toString().toUtf8() << " to " << m_jobsRejected->nodeId().toString().toUtf8() << " : " << std::endl;
+        ASSERT_GOOD(s);
+    }
+
+
+    v.setUInt64 (
+    		static_cast<OpcUa_UInt64>(0)
+    );
+    m_jobsDelayed->setValue(/*pSession*/0, UaDataValue(UaVariant( v ), OpcUa_Good, UaDateTime::now(), UaDateTime::now() ), /*check access level*/OpcUa_False);
+
+    s = nm->addNodeAndReference(this, m_jobsDelayed, OpcUaId_HasComponent);
+    if (!s.isGood())
+    {
+        std::cout << "While addNodeAndReference from " << this->nodeId().toString().toUtf8() << " to " << m_jobsDelayed->nodeId().toString().toUtf8() << " : " << std::endl;
+        ASSERT_GOOD(s);
+    }
+
+
+    v.setUInt64 (
+    		static_cast<OpcUa_UInt64>(0)
+    );
+    m_steals->setValue(/*pSession*/0, UaDataValue(UaVariant( v ), OpcUa_Good, UaDateTime::now(), UaDateTime::now() ), /*check access level*/OpcUa_False);
+
+    s = nm->addNodeAndReference(this, m_steals, OpcUaId_HasComponent);
+    if (!s.isGood())
+    {
+        std::cout << "While addNodeAndReference from " << this->nodeId().toString().toUtf8() << " to " << m_steals->nodeId().toString().toUtf8() << " : " << std::endl;
+        ASSERT_GOOD(s);
+    }
+
+
+    v.setDouble (
+    		static_cast<OpcUa_Double>(0)
+    );
+    m_averageWaitTime->setValue(/*pSession*/0, UaDataValue(UaVariant( v ), OpcUa_Good, UaDateTime::now(), UaDateTime::now() ), /*check access level*/OpcUa_False);
+
+    s = nm->addNodeAndReference(this, m_averageWaitTime, OpcUaId_HasComponent);
+    if (!s.isGood())
+    {
+        std::cout << "While addNodeAndReference from " << this->nodeId().toString().toUtf8() << " to " << m_averageWaitTime->nodeId().toString().toUtf8() << " : " << std::endl;
+        ASSERT_GOOD(s);
+    }
+
+
+    v.setDouble (
+    		static_cast<OpcUa_Double>(0)
+    );
+    m_averageRunTime->setValue(/*pSession*/0, UaDataValue(UaVariant( v ), OpcUa_Good, UaDateTime::now(), UaDateTime::now() ), /*check access level*/OpcUa_False);
+
+    s = nm->addNodeAndReference(this, m_averageRunTime, OpcUaId_HasComponent);
+    if (!s.isGood())
+    {
+        std::cout << "While addNodeAndReference from " << this->nodeId().toString().toUtf8() << " to " << m_averageRunTime->nodeId().toString().toUtf8() << " : " << std::endl;
+        ASSERT_GOOD(s);
+    }
+
+
 
 }
 
@@ -205,6 +408,210 @@ OpcUa_UInt32 ASSourceVariableThreadPool::getMaxThreads () const
 
 
 
+UaStatus ASSourceVariableThreadPool::setQueueDepth (const OpcUa_UInt32 value, OpcUa_StatusCode statusCode,const UaDateTime & srcTime )
+{
+    UaVariant v;
+
+    v.setUInt32( value );
+
+
+
+    return m_queueDepth->setValue (0, UaDataValue (v, statusCode, srcTime, UaDateTime::now()), /*check access*/OpcUa_False  ) ;
+
+}
+
+UaStatus ASSourceVariableThreadPool::getQueueDepth (OpcUa_UInt32 & r) const
+{
+    UaVariant v (* (m_queueDepth->value(/*session*/0).value()));
+    return v.toUInt32 ( r );
+}
+
+
+/* short getter (possible because this variable will never be null) */
+OpcUa_UInt32 ASSourceVariableThreadPool::getQueueDepth () const
+{
+    UaVariant v (* m_queueDepth->value (0).value() );
+    OpcUa_UInt32 v_value;
+    v.toUInt32 ( v_value );
+    return v_value;
+}
+
+
+UaStatus ASSourceVariableThreadPool::setJobsExecuted (const OpcUa_UInt64 value, OpcUa_StatusCode statusCode,const UaDateTime & srcTime )
+{
+    UaVariant v;
+
+    v.setUInt64( value );
+
+
+
+    return m_jobsExecuted->setValue (0, UaDataValue (v, statusCode, srcTime, UaDateTime::now()), /*check access*/OpcUa_False  ) ;
+
+}
+
+UaStatus ASSourceVariableThreadPool::getJobsExecuted (OpcUa_UInt64 & r) const
+{
+    UaVariant v (* (m_jobsExecuted->value(/*session*/0).value()));
+    return v.toUInt64 ( r );
+}
+
+
+/* short getter (possible because this variable will never be null) */
+OpcUa_UInt64 ASSourceVariableThreadPool::getJobsExecuted () const
+{
+    UaVariant v (* m_jobsExecuted->value (0).value() );
+    OpcUa_UInt64 v_value;
+    v.toUInt64 ( v_value );
+    return v_value;
+}
+
+
+UaStatus ASSourceVariableThreadPool::setJobsRejected (const OpcUa_UInt64 value, OpcUa_StatusCode statusCode,const UaDateTime & srcTime )
+{
+    UaVariant v;
+
+    v.setUInt64( value );
+
+
+
+    return m_jobsRejected->setValue (0, UaDataValue (v, statusCode, srcTime, UaDateTime::now()), /*check access*/OpcUa_False  ) ;
+
+}
+
+UaStatus ASSourceVariableThreadPool::getJobsRejected (OpcUa_UInt64 & r) const
+{
+    UaVariant v (* (m_jobsRejected->value(/*session*/0).value()));
+    return v.toUInt64 ( r );
+}
+
+
+/* short getter (possible because this variable will never be null) */
+OpcUa_UInt64 ASSourceVariableThreadPool::getJobsRejected () const
+{
+    UaVariant v (* m_jobsRejected->value (0).value() );
+    OpcUa_UInt64 v_value;
+    v.toUInt64 ( v_value );
+    return v_value;
+}
+
+
+UaStatus ASSourceVariableThreadPool::setJobsDelayed (const OpcUa_UInt64 value, OpcUa_StatusCode statusCode,const UaDateTime & srcTime )
+{
+    UaVariant v;
+
+    v.setUInt64( value );
+
+
+
+    return m_jobsDelayed->setValue (0, UaDataValue (v, statusCode, srcTime, UaDateTime::now()), /*check access*/OpcUa_False  ) ;
+
+}
+
+UaStatus ASSourceVariableThreadPool::getJobsDelayed (OpcUa_UInt64 & r) const
+{
+    UaVariant v (* (m_jobsDelayed->value(/*session*/0).value()));
+    return v.toUInt64 ( r );
+}
+
+
+/* short getter (possible because this variable will never be null) */
+OpcUa_UInt64 ASSourceVariableThreadPool::getJobsDelayed () const
+{
+    UaVariant v (* m_jobsDelayed->value (0).value() );
+    OpcUa_UInt64 v_value;
+    v.toUInt64 ( v_value );
+    return v_value;
+}
+
+
+UaStatus ASSourceVariableThreadPool::setSteals (const OpcUa_UInt64 value, OpcUa_StatusCode statusCode,const UaDateTime & srcTime )
+{
+    UaVariant v;
+
+    v.setUInt64( value );
+
+
+
+    return m_steals->setValue (0, UaDataValue (v, statusCode, srcTime, UaDateTime::now()), /*check access*/OpcUa_False  ) ;
+
+}
+
+UaStatus ASSourceVariableThreadPool::getSteals (OpcUa_UInt64 & r) const
+{
+    UaVariant v (* (m_steals->value(/*session*/0).value()));
+    return v.toUInt64 ( r );
+}
+
+
+/* short getter (possible because this variable will never be null) */
+OpcUa_UInt64 ASSourceVariableThreadPool::getSteals () const
+{
+    UaVariant v (* m_steals->value (0).value() );
+    OpcUa_UInt64 v_value;
+    v.toUInt64 ( v_value );
+    return v_value;
+}
+
+
+UaStatus ASSourceVariableThreadPool::setAverageWaitTime (const OpcUa_Double value, OpcUa_StatusCode statusCode,const UaDateTime & srcTime )
+{
+    UaVariant v;
+
+    v.setDouble( value );
+
+
+
+    return m_averageWaitTime->setValue (0, UaDataValue (v, statusCode, srcTime, UaDateTime::now()), /*check access*/OpcUa_False  ) ;
+
+}
+
+UaStatus ASSourceVariableThreadPool::getAverageWaitTime (OpcUa_Double & r) const
+{
+    UaVariant v (* (m_averageWaitTime->value(/*session*/0).value()));
+    return v.toDouble ( r );
+}
+
+
+/* short getter (possible because this variable will never be null) */
+OpcUa_Double ASSourceVariableThreadPool::getAverageWaitTime () const
+{
+    UaVariant v (* m_averageWaitTime->value (0).value() );
+    OpcUa_Double v_value;
+    v.toDouble ( v_value );
+    return v_value;
+}
+
+
+UaStatus ASSourceVariableThreadPool::setAverageRunTime (const OpcUa_Double value, OpcUa_StatusCode statusCode,const UaDateTime & srcTime )
+{
+    UaVariant v;
+
+    v.setDouble( value );
+
+
+
+    return m_averageRunTime->setValue (0, UaDataValue (v, statusCode, srcTime, UaDateTime::now()), /*check access*/OpcUa_False  ) ;
+
+}
+
+UaStatus ASSourceVariableThreadPool::getAverageRunTime (OpcUa_Double & r) const
+{
+    UaVariant v (* (m_averageRunTime->value(/*session*/0).value()));
+    return v.toDouble ( r );
+}
+
+
+/* short getter (possible because this variable will never be null) */
+OpcUa_Double ASSourceVariableThreadPool::getAverageRunTime () const
+{
+    UaVariant v (* m_averageRunTime->value (0).value() );
+    OpcUa_Double v_value;
+    v.toDouble ( v_value );
+    return v_value;
+}
+
+
+
 
 /* generate delegates (if requested) */
 
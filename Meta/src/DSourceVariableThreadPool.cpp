@@ -57,11 +57,12 @@ namespace Device
 // 2222222222222222222222222222222222222222222222222222222222222222222222222
 
 /* sample ctr */
-DSourceVariableThreadPool::DSourceVariableThreadPool (const size_t& min, const size_t& max, const size_t& maxJobs)
-:Base_DSourceVariableThreadPool()
+DSourceVariableThreadPool::DSourceVariableThreadPool (const size_t& min, const size_t& max, const size_t& maxJobs, const size_t& maxBlockingTimeMs)
+:Base_DSourceVariableThreadPool(),
+ m_lastStatistics()
 {
   #ifndef BACKEND_OPEN62541
-    AddressSpace::SourceVariables_initSourceVariablesThreadPool (min, max, maxJobs);
+    AddressSpace::SourceVariables_initSourceVariablesThreadPool (min, max, maxJobs, maxBlockingTimeMs);
   #endif
 }
 
@@ -80,7 +81,36 @@ DSourceVariableThreadPool::~DSourceVariableThreadPool ()
 // 3     You can do whatever you want, but please be decent.               3
 // 3333333333333333333333333333333333333333333333333333333333333333333333333
 
+void DSourceVariableThreadPool::publishStatistics (unsigned int periodMs)
+{
+  #ifndef BACKEND_OPEN62541
+    AddressSpace::SourceVariables_getThreadPool()->publishStatistics(
+        [this](const Quasar::ThreadPool::Statistics& statistics){ this->updateStatistics(statistics); },
+        periodMs);
+  #endif
+}
 
+void DSourceVariableThreadPool::updateStatistics (const Quasar::ThreadPool::Statistics& statistics)
+{
+    AddressSpace::ASSourceVariableThreadPool* as = getAddressSpaceLink();
+    if (!as)
+        return;
+    const uint64_t jobsInPeriod = statistics.jobsExecuted - m_lastStatistics.jobsExecuted;
+    as->setQueueDepth (statistics.queueDepth, OpcUa_Good);
+    as->setJobsExecuted (statistics.jobsExecuted, OpcUa_Good);
+    as->setJobsRejected (statistics.jobsRejected, OpcUa_Good);
+    as->setJobsDelayed (statistics.jobsDelayed, OpcUa_Good);
+    as->setSteals (statistics.steals, OpcUa_Good);
+    if (jobsInPeriod > 0)
+    {
+        // in microseconds, averaged over the jobs finished since the previous sample
+        as->setAverageWaitTime (
+            double(statistics.totalWaitTimeUs - m_lastStatistics.totalWaitTimeUs) / jobsInPeriod, OpcUa_Good);
+        as->setAverageRunTime (
+            double(statistics.totalRunTimeUs - m_lastStatistics.totalRunTimeUs) / jobsInPeriod, OpcUa_Good);
+    }
+    m_lastStatistics = statistics;
+}
 
 
 }
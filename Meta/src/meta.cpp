@@ -51,6 +51,7 @@
 #include <DQuasar.h>
 #include <ASServer.h>
 #include <DServer.h>
+#include <PublishPolicy.h>
 #include "MetaBuildInfo.h"
 
 using std::string;
@@ -156,8 +157,33 @@ void configureSourceVariableThreadPool(const Configuration::SourceVariableThread
 {
     AddressSpace::ASSourceVariableThreadPool *asSourceVariableThreadPool = new AddressSpace::ASSourceVariableThreadPool(parent->nodeId(), nm->getTypeNodeId(AddressSpace::ASInformationModel::AS_TYPE_SOURCEVARIABLESTHREADPOOL), nm, config.minThreads(), config.maxThreads());
 
-    Device::DSourceVariableThreadPool* dSourceVariableThreadPool = new Device::DSourceVariableThreadPool(config.minThreads(), config.maxThreads(), config.maxJobs());
+    Device::DSourceVariableThreadPool* dSourceVariableThreadPool = new Device::DSourceVariableThreadPool(config.minThreads(), config.maxThreads(), config.maxJobs(), config.maxBlockingTimeMs());
     MetaUtils::linkHandlerObjectAndAddressSpaceNode(dSourceVariableThreadPool, asSourceVariableThreadPool);
+    if (config.statisticsPeriodMs() > 0)
+        dSourceVariableThreadPool->publishStatistics(config.statisticsPeriodMs());
+}
+
+/**
+ * Registers the publish policies, they are picked up by the cache-variables as these are created
+ * (which happens after Meta is configured).
+ * @throw std::runtime_error if a variables regular expression is not valid
+ */
+void configurePublishPolicies(const Configuration::PublishPolicies& config)
+{
+	AddressSpace::PublishPolicies::clear();
+	for(const Configuration::PublishPolicy& policyConfig : config.PublishPolicy())
+	{
+		AddressSpace::PublishPolicy policy;
+		const string deadbandType = policyConfig.deadbandType();
+		if(deadbandType == "absolute") policy.deadbandType = AddressSpace::PublishPolicy::Absolute;
+		else if(deadbandType == "percent") policy.deadbandType = AddressSpace::PublishPolicy::Percent;
+		policy.deadband = policyConfig.deadband();
+		policy.minIntervalMs = policyConfig.minPublishIntervalMs();
+		policy.maxIntervalMs = policyConfig.maxPublishIntervalMs();
+		AddressSpace::PublishPolicies::add(policyConfig.variables(), policy);
+
+		LOG(Log::INF) << "publish policy for variables ["<<policyConfig.variables()<<"]: deadband ["<<deadbandType<<" "<<policy.deadband<<"] min interval ["<<policy.minIntervalMs<<"ms] max interval ["<<policy.maxIntervalMs<<"ms]";
+	}
 }
 
 void configureBuildInformation(AddressSpace::ASNodeManager *nm,  AddressSpace::ASStandardMetaData* parent)
@@ -231,6 +257,20 @@ const Configuration::SourceVariableThreadPool getSourceVariableThreadPoolConfig(
 	}
 }
 
+const Configuration::PublishPolicies getPublishPoliciesConfig(const Configuration::StandardMetaData & config)
+{
+	if( config.PublishPolicies().present() )
+	{
+		LOG(Log::INF) << "StandardMetaData.PublishPolicies configuration found in the configuration file, configuring StandardMetaData.PublishPolicies from the configuration file";
+		return config.PublishPolicies().get();
+	}
+	else
+	{
+		LOG(Log::INF) << "no StandardMetaData.PublishPolicies configuration found in the configuration file, every update of a cache-variable is published";
+		return Configuration::PublishPolicies();
+	}
+}
+
 const Configuration::Quasar getQuasarConfig(const Configuration::StandardMetaData & config)
 {
 	if( config.Quasar().present() )
@@ -309,6 +349,7 @@ Device::DStandardMetaData* configureMeta( const Configuration::StandardMetaData
     configureQuasar(getQuasarConfig(config), nm, asMeta, parent);
 	configureServer(getServerConfig(config), nm, asMeta, parent);
 	configureBuildInformation(nm, asMeta);
+	configurePublishPolicies(getPublishPoliciesConfig(config));
 	
     return dMeta;
 }
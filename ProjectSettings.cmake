@@ -35,3 +35,6 @@ set(BUILD_SERVER_SHARED_LIB OFF)
 ## Note: boost paths are resolved either from $BOOST_ROOT if defined or system paths as fallback
 ##
 set(ADDITIONAL_BOOST_LIBS )
+
+## LOG invocations below this level are removed at compile time (see LogIt/include/LogIt.h)
+## example: add_definitions(-DLOGIT_COMPILED_MIN_LEVEL=Log::DBG)
@@ -109,6 +109,7 @@ class Command{
   static const uint32_t BCR=7;     /**< Type for the RD53ABCR command */
   static const uint32_t NOOP=8;    /**< Type for the RD53ANoop command */
   static const uint32_t SYNC=9;    /**< Type for the RD53ASync command */
+  static const uint32_t MACRO=10;  /**< Type for a pre-encoded command sequence (RD53AMacro) */
 
   /**
    * Empty constructor
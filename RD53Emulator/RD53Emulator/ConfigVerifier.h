@@ -0,0 +1,159 @@
+#ifndef RD53A_CONFIGVERIFIER_H
+#define RD53A_CONFIGVERIFIER_H
+
+#include <cstdint>
+#include <vector>
+#include <mutex>
+
+namespace RD53A{
+
+class Configuration;
+class Matrix;
+
+/**
+ * The ConfigVerifier compares the configuration read back from a chip
+ * with the configuration that was meant to be written.
+ *
+ * The intended state is copied from the Configuration and the Matrix when the verification
+ * starts (ConfigVerifier::Start). The pixel pairs are packed 4 per 64-bit word, and the
+ * global registers 4 per 64-bit word.
+ * The values read back are streamed into the same packed layout (ConfigVerifier::Receive)
+ * as the register frames arrive. Pixel pairs are read through the pixel portal, that has no
+ * address of its own, so the answers are assigned to the pairs in the order in which they
+ * were requested (ConfigVerifier::ExpectPair). For this to hold, no other read of the pixel portal
+ * may be answered while the verification is active: the FrontEnd leaves the portal out of
+ * FrontEnd::ReadGlobal, and the Handler out of the reads of the RegisterCache and the ReadTransactions,
+ * that time out instead.
+ *
+ * The comparison (ConfigVerifier::Compare) is a XOR of the intended and the read back words,
+ * masked with the values that have been received. Only the words that differ are looked into.
+ * It can be done at any time, also while the values are still arriving.
+ *
+ * Only the registers that hold configuration are compared (ConfigVerifier::FIRST_REGISTER
+ * to ConfigVerifier::LAST_REGISTER). The pixel region, the portal, the counters and the
+ * monitoring registers change by themselves, or while the pixels are being read.
+ *
+ * @brief RD53A configuration readback verification
+ * @date October 2026
+ **/
+class ConfigVerifier{
+
+ public:
+
+  /**
+   * Number of pixel pairs (200 double columns times 192 rows)
+   **/
+  static const uint32_t NUM_PAIRS = 200*192;
+
+  /**
+   * Number of global registers
+   **/
+  static const uint32_t NUM_REGISTERS = 138;
+
+  /**
+   * First register address that is compared (PIX_MODE)
+   **/
+  static const uint32_t FIRST_REGISTER = 3;
+
+  /**
+   * Last register address that is compared (AUTO_READ_B3)
+   **/
+  static const uint32_t LAST_REGISTER = 108;
+
+  /**
+   * Result of a comparison
+   **/
+  struct Report{
+    std::vector<uint32_t> pairs;     /**< Pixel pairs that differ as (double column<<16)|row */
+    std::vector<uint32_t> registers; /**< Register addresses that differ */
+    uint32_t missing_pairs;          /**< Pixel pairs requested but not received yet */
+    uint32_t missing_registers;      /**< Registers not received yet */
+  };
+
+  /**
+   * Create an inactive ConfigVerifier
+   **/
+  ConfigVerifier();
+
+  /**
+   * Delete the ConfigVerifier
+   **/
+  ~ConfigVerifier();
+
+  /**
+   * Copy the intended state and start receiving values. Previous values are discarded.
+   * @param config The intended global configuration
+   * @param matrix The intended pixel configuration
+   **/
+  void Start(Configuration * config, Matrix * matrix);
+
+  /**
+   * Stop receiving values. The last values received can still be compared.
+   **/
+  void Stop();
+
+  /**
+   * @return True if the values read back are being received
+   **/
+  bool IsActive();
+
+  /**
+   * Add a pixel pair to the sequence of pairs read through the pixel portal
+   * @param double_col The double column
+   * @param row The row
+   **/
+  void ExpectPair(uint32_t double_col, uint32_t row);
+
+  /**
+   * Store a value read back from the chip.
+   * Registers that are not compared are not taken.
+   * The verification stops by itself when all the values have been received.
+   * @param address Register address, the pixel portal is assigned to the next expected pair
+   * @param value The 16-bit value
+   * @return True if the value was taken by the verification
+   **/
+  bool Receive(uint32_t address, uint16_t value);
+
+  /**
+   * @return True if all the expected pairs and the compared registers have been received
+   **/
+  bool IsComplete();
+
+  /**
+   * Compare the values received so far with the intended state
+   * @return The list of differences
+   **/
+  Report Compare();
+
+ private:
+
+  static const uint32_t PAIR_WORDS = NUM_PAIRS/4;
+  static const uint32_t REGISTER_WORDS = (NUM_REGISTERS+3)/4;
+
+  /** Store a value, with the mutex held */
+  bool Store(uint32_t address, uint16_t value);
+
+  /** Expand 4 bits to 4 16-bit lane masks */
+  static uint64_t Lanes(uint32_t bits);
+
+  std::mutex m_mutex;
+  bool m_active;
+
+  std::vector<uint64_t> m_expected_pairs;
+  std::vector<uint64_t> m_readback_pairs;
+  uint64_t m_expected_registers[REGISTER_WORDS];
+  uint64_t m_readback_registers[REGISTER_WORDS];
+
+  std::vector<uint64_t> m_requested_pairs;   /**< bitmap of requested pairs */
+  std::vector<uint64_t> m_received_pairs;    /**< bitmap of received pairs */
+  uint64_t m_received_registers[3];          /**< bitmap of received registers */
+
+  std::vector<uint32_t> m_order;
+  uint32_t m_next;
+  uint32_t m_num_registers;
+
+};
+
+}
+
+#endif
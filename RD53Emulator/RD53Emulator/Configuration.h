@@ -6,6 +6,7 @@
 
 #include <iostream>
 #include <map>
+#include <string>
 #include <vector>
 
 namespace RD53A{
@@ -20,6 +21,11 @@ namespace RD53A{
  * and also each Field (Configuration::GetField). 
  * Note the index to access a given Field is given by Configuration::FieldType.
  *
+ * The position of the Fields in the registers is described by a single compile-time table
+ * shared by all the Configuration objects, indexed by Configuration::FieldType.
+ * The Field names are looked up with a perfect hash of the name, built at compile time.
+ * A Configuration object only holds the register values and the bitmap of updated registers.
+ *
  * Global register 0 (Configuration::PIX_PORTAL) is a virtual register to read and write
  * Pixel data. Each Pixel holds 8 or fewer bits of local configuration, and is addressed
  * as half of the 16-bit register value.
@@ -261,13 +267,18 @@ class Configuration{
   static const uint32_t VMUX_RAD_3 = 14;
   static const uint32_t VMUX_RAD_4 = 8;
 
+  /**
+   * Number of registers in the configuration
+   **/
+  static const uint32_t NUM_REGISTERS = 138;
+
   /**
    * Create a new configuration object. Initialize the fields to their default values.
    **/
   Configuration();
 
   /**
-   * Clear internal arrays
+   * Empty destructor
    **/
   ~Configuration();
 
@@ -297,6 +308,28 @@ class Configuration{
    **/
   void SetRegister(uint32_t index, uint16_t value);
 
+  /**
+   * Set the whole 16-bit value of a register without flagging it as updated,
+   * for values that are already being written to the chip by other means
+   * @param index Register index
+   * @param value The 16-bit register value
+   **/
+  void LoadRegister(uint32_t index, uint16_t value);
+
+  /**
+   * Flag a register as updated or not, without changing its value
+   * @param index Register index
+   * @param enable True if the register has been updated
+   **/
+  void Update(uint32_t index, bool enable=true);
+
+  /**
+   * Get if a register has been updated
+   * @param index Register index
+   * @return True if it has been updated
+   **/
+  bool IsUpdated(uint32_t index);
+
   /**
    * Set the Field value from a string. Note it is not necessarily the whole register
    * @param name Field name
@@ -313,18 +346,25 @@ class Configuration{
 
   /**
    * Get a Field inside the Configuration given
-   * its Field index (ie: Configuration::GateHitOr).
+   * its Field index (ie: Configuration::VTH_LIN).
    * @param index The Field index (Configuration::FieldType)
-   * @return pointer to the field
+   * @return the field, without bits if the index is not valid
    **/
-  Field * GetField(uint32_t index);
+  Field GetField(uint32_t index);
 
   /**
    * Get a Field inside the Configuration by name
-   * @param name The Field name (Configuration::m_name2index)
-   * @return pointer to the field
+   * @param name The Field name
+   * @return the field, without bits if the name is not known
+   **/
+  Field GetField(const std::string & name);
+
+  /**
+   * Get the names of the Fields stored in a given Register
+   * @param index Register index
+   * @return Field names in alphabetical order
    **/
-  Field * GetField(std::string name);
+  std::vector<std::string> GetFieldNames(uint32_t index);
 
   /**
    * Get list of addresses that have been updated
@@ -332,6 +372,14 @@ class Configuration{
    **/
   std::vector<uint32_t> GetUpdatedRegisters();
 
+  /**
+   * Get the lowest address that has been updated, and clear its updated flag.
+   * Only the words of the bitmap of updated registers are visited, nothing is allocated.
+   * @param index The Register index
+   * @return True if there was an updated register
+   **/
+  bool NextUpdatedRegister(uint32_t & index);
+
   /**
    * Get map of addresses
    * @return map of strings to addresses
@@ -347,11 +395,8 @@ class Configuration{
  private:
 
   bool m_verbose;
-  std::vector<Register> m_registers;
-  std::map<uint32_t, Field*> m_fields;
-  static std::map<std::string, uint32_t> m_name2index;
-  std::vector<std::string> m_names_yarr;
-  std::vector<std::string> m_names_rce;
+  uint16_t m_registers[NUM_REGISTERS];
+  uint64_t m_updated[(NUM_REGISTERS+63)/64];
   
   };
 
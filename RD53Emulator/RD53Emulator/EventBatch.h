@@ -0,0 +1,181 @@
+#ifndef RD53A_EVENTBATCH_H
+#define RD53A_EVENTBATCH_H
+
+#include <cstdint>
+#include <vector>
+
+namespace RD53A{
+
+/**
+ * Read-only view of a contiguous array
+ *
+ * @brief Read-only array view
+ * @date October 2026
+ **/
+template<typename T>
+class Span{
+
+ public:
+
+  Span(const T * data, uint32_t size){m_data=data; m_size=size;}
+  const T * begin() const {return m_data;}
+  const T * end() const {return m_data+m_size;}
+  const T * data() const {return m_data;}
+  uint32_t size() const {return m_size;}
+  bool empty() const {return m_size==0;}
+  const T & operator[](uint32_t index) const {return m_data[index];}
+
+ private:
+
+  const T * m_data;
+  uint32_t m_size;
+
+};
+
+/**
+ * An EventBatch holds the hits of consecutive events (triggers) of one FrontEnd in columns.
+ * The columns of the hits (EventBatch::GetCols, EventBatch::GetRows, EventBatch::GetTOTs)
+ * are contiguous arrays for the whole batch, ordered by event.
+ * The columns of the events hold the trigger header (EventBatch::GetTIDs, EventBatch::GetTTags,
+ * EventBatch::GetBCIDs) and the index of the first hit of each event (EventBatch::GetFirstHits).
+ * An event without hits is kept, it is a trigger without data.
+ *
+ * The memory of the columns is allocated once, for the maximum number of hits and events,
+ * and is reused every time the EventBatch is cleared (EventBatch::Clear).
+ * The batches are filled by the EventBuilder, and read through the Span views.
+ *
+ * @verbatim
+   for(uint32_t ev=0;ev<batch->GetNumEvents();ev++){
+     Span<uint16_t> cols = batch->GetCols(ev);
+     Span<uint16_t> rows = batch->GetRows(ev);
+     Span<uint8_t> tots = batch->GetTOTs(ev);
+     for(uint32_t i=0;i<cols.size();i++){
+       occupancy[cols[i]][rows[i]]++;
+     }
+   }
+   @endverbatim
+ *
+ * @brief RD53A columnar batch of events
+ * @date October 2026
+ **/
+class EventBatch{
+
+ public:
+
+  /**
+   * Create an empty EventBatch, and allocate its columns
+   * @param max_hits Maximum number of hits in the batch
+   * @param max_events Maximum number of events in the batch
+   **/
+  EventBatch(uint32_t max_hits, uint32_t max_events);
+
+  /**
+   * Delete the EventBatch
+   **/
+  ~EventBatch();
+
+  /**
+   * Remove all the events, keep the memory
+   **/
+  void Clear();
+
+  /**
+   * Start a new event
+   * @param tid The trigger ID
+   * @param ttag The trigger tag
+   * @param bcid The bunch crossing ID
+   **/
+  void AddEvent(uint32_t tid, uint32_t ttag, uint32_t bcid);
+
+  /**
+   * Add a hit to the last event
+   * @param col The pixel column
+   * @param row The pixel row
+   * @param tot The time over threshold
+   **/
+  void AddHit(uint32_t col, uint32_t row, uint32_t tot);
+
+  /**
+   * @return True if no more hits or no more events can be added
+   **/
+  bool IsFull() const;
+
+  /**
+   * @return True if there are no events
+   **/
+  bool IsEmpty() const;
+
+  /**
+   * @return The number of events in the batch
+   **/
+  uint32_t GetNumEvents() const;
+
+  /**
+   * @return The number of hits in the batch
+   **/
+  uint32_t GetNumHits() const;
+
+  /**
+   * @return The sequence number of the batch in its EventBuilder
+   **/
+  uint64_t GetSequence() const;
+
+  /**
+   * Set the sequence number of the batch
+   * @param sequence The sequence number
+   **/
+  void SetSequence(uint64_t sequence);
+
+  /** @return The trigger ID of every event **/
+  Span<uint8_t> GetTIDs() const;
+
+  /** @return The trigger tag of every event **/
+  Span<uint8_t> GetTTags() const;
+
+  /** @return The bunch crossing ID of every event **/
+  Span<uint16_t> GetBCIDs() const;
+
+  /** @return The index of the first hit of every event **/
+  Span<uint32_t> GetFirstHits() const;
+
+  /** @return The column of every hit **/
+  Span<uint16_t> GetCols() const;
+
+  /** @return The row of every hit **/
+  Span<uint16_t> GetRows() const;
+
+  /** @return The time over threshold of every hit **/
+  Span<uint8_t> GetTOTs() const;
+
+  /** @return The number of hits of an event **/
+  uint32_t GetNumHits(uint32_t event) const;
+
+  /** @return The column of the hits of an event **/
+  Span<uint16_t> GetCols(uint32_t event) const;
+
+  /** @return The row of the hits of an event **/
+  Span<uint16_t> GetRows(uint32_t event) const;
+
+  /** @return The time over threshold of the hits of an event **/
+  Span<uint8_t> GetTOTs(uint32_t event) const;
+
+ private:
+
+  uint32_t m_max_hits;
+  uint32_t m_max_events;
+  uint64_t m_sequence;
+
+  std::vector<uint8_t> m_tids;
+  std::vector<uint8_t> m_ttags;
+  std::vector<uint16_t> m_bcids;
+  std::vector<uint32_t> m_first;
+
+  std::vector<uint16_t> m_cols;
+  std::vector<uint16_t> m_rows;
+  std::vector<uint8_t> m_tots;
+
+};
+
+}
+
+#endif
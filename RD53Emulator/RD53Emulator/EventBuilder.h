@@ -0,0 +1,153 @@
+#ifndef RD53A_EVENTBUILDER_H
+#define RD53A_EVENTBUILDER_H
+
+#include "RD53Emulator/EventBatch.h"
+
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <functional>
+
+namespace RD53A{
+
+/**
+ * The EventBuilder groups the hits decoded by a FrontEnd into events, one per trigger header
+ * of the data stream (trigger ID, trigger tag and BCID), and stores them in EventBatch columns.
+ *
+ * The decoder side adds the headers (EventBuilder::AddHeader) and the hits (EventBuilder::AddHit)
+ * in the order of the data stream. Hits are assigned to the last header.
+ * The open batch is handed to the consumers when it is full, or when it is flushed
+ * (EventBuilder::Flush), after every block of data.
+ * An event whose data is split between two blocks appears in two consecutive batches
+ * with the same trigger header.
+ *
+ * The consumers take the oldest batch (EventBuilder::GetEvents), read it, and give it back
+ * (EventBuilder::ReleaseEvents). The batches are taken from a pool, the arena, that keeps
+ * the memory of the released batches, so nothing is allocated once the pool is warm.
+ * When too many batches are waiting, the oldest one is dropped and counted (EventBuilder::GetDropped).
+ * Without consumers the maximum number of batches is 0, and only the monitor sees the batches.
+ *
+ * A monitor (EventBuilder::SetMonitor) can look at every batch before it is handed to the consumers,
+ * from the thread that adds the data. It sees all the data, also the batches that are dropped later.
+ *
+ * @verbatim
+   while(builder.HasEvents()){
+     const EventBatch * batch = builder.GetEvents();
+     ...
+     builder.ReleaseEvents(batch);
+   }
+   @endverbatim
+ *
+ * @brief RD53A event builder
+ * @date October 2026
+ **/
+class EventBuilder{
+
+ public:
+
+  /**
+   * Create an EventBuilder
+   * @param max_hits Maximum number of hits in a batch
+   * @param max_events Maximum number of events in a batch
+   * @param max_batches Maximum number of batches waiting for the consumers, 0 if there are none
+   **/
+  EventBuilder(uint32_t max_hits=4096, uint32_t max_events=1024, uint32_t max_batches=64);
+
+  /**
+   * Delete the EventBuilder and all its batches.
+   * The batches taken by the consumers have to be released before.
+   **/
+  ~EventBuilder();
+
+  /**
+   * Start a new event
+   * @param tid The trigger ID
+   * @param ttag The trigger tag
+   * @param bcid The bunch crossing ID
+   **/
+  void AddHeader(uint32_t tid, uint32_t ttag, uint32_t bcid);
+
+  /**
+   * Add a hit to the current event
+   * @param col The pixel column
+   * @param row The pixel row
+   * @param tot The time over threshold
+   **/
+  void AddHit(uint32_t col, uint32_t row, uint32_t tot);
+
+  /**
+   * Hand the open batch to the consumers if it has any event
+   **/
+  void Flush();
+
+  /**
+   * @return True if there are batches waiting for the consumers
+   **/
+  bool HasEvents();
+
+  /**
+   * Take the oldest batch waiting for the consumers
+   * @return The EventBatch, or NULL if there is none
+   **/
+  const EventBatch * GetEvents();
+
+  /**
+   * Give back a batch taken with EventBuilder::GetEvents
+   * @param batch The EventBatch
+   **/
+  void ReleaseEvents(const EventBatch * batch);
+
+  /**
+   * Change the maximum number of batches waiting for the consumers.
+   * The oldest batches that do not fit are dropped.
+   * @param max_batches Maximum number of batches, 0 if there are no consumers
+   **/
+  void SetMaxBatches(uint32_t max_batches);
+
+  /**
+   * Set the function called with every batch before it is handed to the consumers
+   * @param monitor The function, or an empty function to remove it
+   **/
+  void SetMonitor(std::function<void(const EventBatch *)> monitor);
+
+  /**
+   * @return The number of batches dropped because nobody took them
+   **/
+  uint64_t GetDropped();
+
+  /**
+   * @return The number of batches allocated in the arena
+   **/
+  uint32_t GetAllocated();
+
+ private:
+
+  EventBatch * Acquire();
+  void Publish();
+
+  uint32_t m_max_hits;
+  uint32_t m_max_events;
+  uint32_t m_max_batches;
+
+  uint32_t m_tid;
+  uint32_t m_ttag;
+  uint32_t m_bcid;
+
+  EventBatch * m_open;
+  uint64_t m_sequence;
+
+  std::mutex m_mutex;
+  std::deque<EventBatch*> m_ready;
+  std::vector<EventBatch*> m_free;
+  uint32_t m_allocated;
+  uint64_t m_dropped;
+
+  std::mutex m_monitor_mutex;
+  std::function<void(const EventBatch *)> m_monitor;
+
+};
+
+}
+
+#endif
@@ -0,0 +1,221 @@
+#ifndef RD53A_EVENTMERGER_H
+#define RD53A_EVENTMERGER_H
+
+#include "RD53Emulator/EventBatch.h"
+
+#include <cstdint>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <functional>
+
+namespace RD53A{
+
+/**
+ * The EventMerger builds events across several FrontEnd objects, read through different data elinks,
+ * by matching the fragments of the same trigger, identified by its trigger tag and BCID.
+ *
+ * Every FrontEnd has a queue in the EventMerger, identified by its index.
+ * The thread that decodes the data of the FrontEnd copies the events of every EventBatch into the queue
+ * (EventMerger::AddFragments), without taking any lock. Each queue is a pair of single producer,
+ * single consumer rings, one for the fragment headers and one for the hits. A fragment that does not fit
+ * in the rings is dropped and counted.
+ *
+ * A helper thread takes the fragments from the queues and assigns them to the open events of the reorder window.
+ * A fragment is assigned to the oldest open event with the same trigger tag and BCID that has no fragment
+ * of its FrontEnd yet, otherwise it opens a new event. The continuation of an event split between two batches
+ * is added to the event of its first part.
+ * The events leave the window in the order in which they were opened, when they have the fragments of all the
+ * FrontEnd objects and every FrontEnd has sent a fragment of a later trigger (so no continuation can follow),
+ * when they are older than the timeout, or when the window is full and a new event has to be opened.
+ * They are handed to the consumer (EventMerger::SetConsumer) from the helper thread, in order,
+ * without holding the mutex of the EventMerger, so the consumer can read the statistics.
+ * A fragment that arrives after its event left the window opens a new, incomplete, event.
+ *
+ * The statistics of every FrontEnd (EventMerger::GetStatistics) count the fragments received, the events
+ * that had a fragment of it, the events that missed it, and the fragments dropped because the queue was full.
+ *
+ * @verbatim
+   EventMerger merger(2);
+   merger.SetConsumer([](const EventMerger::Event & event){ ... });
+   //data thread of the front-end 0
+   merger.AddFragments(0, batch);
+   //data thread of the front-end 1
+   merger.AddFragments(1, other_batch);
+   @endverbatim
+ *
+ * @brief RD53A event builder across front-ends
+ * @date October 2026
+ **/
+class EventMerger{
+
+ public:
+
+  typedef std::chrono::steady_clock Clock;
+
+  /**
+   * Maximum number of FrontEnd objects
+   **/
+  static const uint32_t MAX_FES = 64;
+
+  /**
+   * An event built from the fragments of several FrontEnd objects.
+   * The hits are stored in columns, ordered by FrontEnd index.
+   **/
+  struct Event{
+    uint32_t ttag;                 /**< Trigger tag */
+    uint32_t bcid;                 /**< Bunch crossing ID */
+    uint64_t fes;                  /**< Bit mask of the FrontEnd indices with a fragment */
+    std::vector<uint32_t> tids;    /**< Trigger ID of each FrontEnd index */
+    std::vector<uint8_t>  hit_fes; /**< FrontEnd index of each hit */
+    std::vector<uint16_t> cols;    /**< Column of each hit */
+    std::vector<uint16_t> rows;    /**< Row of each hit */
+    std::vector<uint8_t>  tots;    /**< ToT of each hit */
+  };
+
+  /**
+   * Completeness statistics of one FrontEnd
+   **/
+  struct Statistics{
+    uint64_t fragments; /**< Fragments received */
+    uint64_t matched;   /**< Events with a fragment of the FrontEnd */
+    uint64_t missing;   /**< Events without a fragment of the FrontEnd */
+    uint64_t dropped;   /**< Fragments dropped because the queue was full */
+  };
+
+  /**
+   * Create an EventMerger, and start its helper thread
+   * @param num_fes Number of FrontEnd objects (up to EventMerger::MAX_FES)
+   * @param window Maximum number of open events
+   * @param timeout_ms Time an event waits for its missing fragments in milliseconds
+   * @param queue_size Number of fragments in the queue of each FrontEnd, rounded up to a power of 2
+   * @param hits_size Number of hits in the queue of each FrontEnd, rounded up to a power of 2
+   **/
+  EventMerger(uint32_t num_fes, uint32_t window=64, uint32_t timeout_ms=100, uint32_t queue_size=4096, uint32_t hits_size=65536);
+
+  /**
+   * Stop the helper thread, and hand the open events to the consumer
+   **/
+  ~EventMerger();
+
+  /**
+   * Copy the events of a batch into the queue of a FrontEnd.
+   * It is meant to be called from a single thread per FrontEnd, and does not lock.
+   * @param fe The FrontEnd index
+   * @param batch The EventBatch
+   **/
+  void AddFragments(uint32_t fe, const EventBatch * batch);
+
+  /**
+   * Set the function called with every event that leaves the window, from the helper thread,
+   * or from the thread that calls EventMerger::Flush. The consumer must not call EventMerger::Flush.
+   * @param consumer The function, or an empty function to remove it
+   **/
+  void SetConsumer(std::function<void(const Event &)> consumer);
+
+  /**
+   * Take the fragments waiting in the queues, and hand all the open events to the consumer
+   **/
+  void Flush();
+
+  /**
+   * @param fe The FrontEnd index
+   * @return The completeness statistics of the FrontEnd
+   **/
+  Statistics GetStatistics(uint32_t fe);
+
+  /**
+   * @return The number of events with the fragments of all the FrontEnd objects
+   **/
+  uint64_t GetComplete();
+
+  /**
+   * @return The number of events that left the window with missing fragments
+   **/
+  uint64_t GetIncomplete();
+
+  /**
+   * @return The number of FrontEnd objects
+   **/
+  uint32_t GetNumFEs();
+
+ private:
+
+  struct Fragment{
+    uint32_t tid;
+    uint32_t ttag;
+    uint32_t bcid;
+    uint32_t nhits;
+    bool continuation;
+  };
+
+  struct Queue{
+    alignas(64) std::atomic<uint64_t> head;
+    alignas(64) std::atomic<uint64_t> tail;
+    alignas(64) std::atomic<uint64_t> hit_head;
+    alignas(64) std::atomic<uint64_t> hit_tail;
+    std::vector<Fragment> fragments;
+    std::vector<uint32_t> hits;
+    //only used by the producer
+    uint32_t last_tid;
+    uint32_t last_ttag;
+    uint32_t last_bcid;
+    bool has_last;
+    std::atomic<uint64_t> dropped;
+    //only used by the helper thread
+    uint64_t received;
+    uint64_t matched;
+    uint64_t missing;
+    uint64_t last_event;
+  };
+
+  struct Slot{
+    Event event;
+    uint64_t number;
+    Clock::time_point opened;
+  };
+
+  /** Take the fragments waiting in the queues, with the mutex held */
+  uint32_t Process();
+
+  /** Assign a fragment to the window, with the mutex held */
+  void Assign(uint32_t fe, Queue * queue, const Fragment & fragment, uint64_t first_hit);
+
+  /** Take the oldest open event out of the window for the consumer, with the mutex held */
+  void Close();
+
+  /** Hand the closed events to the consumer, with the delivery mutex held and the mutex not held */
+  void Deliver();
+
+  void Run();
+
+  uint32_t m_num_fes;
+  uint32_t m_window;
+  Clock::duration m_timeout;
+  uint64_t m_all_fes;
+  std::vector<Queue*> m_queues;
+
+  std::mutex m_mutex;
+  std::vector<Slot> m_slots;
+  uint32_t m_first;
+  uint32_t m_count;
+  uint64_t m_number;
+  uint64_t m_complete;
+  uint64_t m_incomplete;
+  std::function<void(const Event &)> m_consumer;
+  std::vector<Event> m_closed;
+  std::vector<Event> m_spare;
+
+  //keeps the events in order when the helper thread and EventMerger::Flush deliver at the same time
+  std::mutex m_deliver_mutex;
+
+  std::atomic<bool> m_running;
+  std::thread m_thread;
+
+};
+
+}
+
+#endif
@@ -2,15 +2,21 @@
 #define RD53A_FIELD_H
 
 #include <cstdint>
-#include <vector>
 
 #include "RD53Emulator/Register.h"
 
 namespace RD53A{
 
+class Configuration;
+
 /**
  * A Field contains the relevant Configuration bits for a particular setting.
  *
+ * The position of the bits is described by a Field::Layout. There is only one Layout
+ * per Field in the whole program, in a compile-time table of the Configuration.
+ * A Field object is a small view that binds a Layout to the registers of one
+ * Configuration, and is meant to be used right away (Configuration::GetField).
+ *
  * @brief RD53A Configuration Field
  * @author Carlos.Solans@cern.ch
  * @date May 2020
@@ -19,16 +25,24 @@ namespace RD53A{
 class Field{
 	
 public:
-    
+
+  /**
+   * Position of a Field in the Configuration registers
+   **/
+  struct Layout{
+    uint8_t address;  /**< Register index */
+    uint8_t start;    /**< First bit of the data */
+    uint8_t length;   /**< Length of the Field in bits, 0 if the Field has no bits */
+    uint16_t defval;  /**< Default value for the Field */
+    bool reversed;    /**< Flip the bit order of the Field if true */
+  };
+
   /**
-   * Construct a Field given a pointer to the Configuration register.
-   * @param data pointer to the Configuration register
-   * @param start First bit of the data
-   * @param len Length of the Field in bits
-   * @param defval Default value for the Field
-   * @param reversed Flip the bit order of the Field if true
+   * Construct a Field given the Configuration and the Field Layout
+   * @param config pointer to the Configuration
+   * @param layout pointer to the Field Layout
    **/
-  Field(Register * data, uint32_t start, uint32_t len, uint32_t defval=0, bool reversed=false);
+  Field(Configuration * config, const Layout * layout);
 
   /**
    * Empty Destructor
@@ -46,20 +60,19 @@ public:
    * @return The value of the Field
    **/
   uint32_t GetValue();
+
+  /**
+   * Get the Register that holds this Field
+   * @return the Register
+   **/
+  Register GetRegister();
   
 private:
 
-  Register * m_data;
-  uint32_t m_start;
-  uint32_t m_len;
-  uint32_t m_defval;
-  uint32_t m_mask;
-  uint32_t m_smask;
-  bool m_reversed;
-
-  static std::vector<uint32_t> m_masks;
-    
-  uint32_t Reverse(uint32_t value, uint32_t sz);
+  Configuration * m_config;
+  const Layout * m_layout;
+
+  static uint32_t Reverse(uint32_t value, uint32_t sz);
 
 };
 
@@ -0,0 +1,159 @@
+#ifndef RD53A_FLIGHTRECORDER_H
+#define RD53A_FLIGHTRECORDER_H
+
+#include <cstdint>
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace RD53A{
+
+/**
+ * The FlightRecorder keeps the last FlightRecorder::NUM_EVENTS trace events of every thread
+ * in a fixed-size binary ring buffer, so that there is something to look at when a module
+ * misbehaves, without the cost of printing to the console in the data path.
+ *
+ * Recording an event (FlightRecorder::Record) writes 24 bytes into the ring of the calling thread:
+ * no lock, no allocation, no system call. The time stamp is the CPU time stamp counter where available.
+ *
+ * The rings are written to a file on demand (FlightRecorder::Dump), when the process receives the
+ * dump signal, or when it crashes (FlightRecorder::InstallSignalHandlers).
+ * The dump is decoded with share/decode_flight_recorder.py.
+ *
+ * @verbatim
+   FlightRecorder::SetEnable(true);
+   FlightRecorder::InstallSignalHandlers("/tmp");
+   //from any thread
+   FlightRecorder::Record(FlightRecorder::MESSAGE_RECEIVED, elink, size);
+   //kill -USR1 <pid> writes /tmp/flightrecorder-<pid>.bin
+   @endverbatim
+ *
+ * A dump taken while other threads are recording is best effort: the oldest events of a ring
+ * may have been overwritten while it is being written.
+ *
+ * @brief RD53A FlightRecorder
+ * @date October 2026
+ **/
+class FlightRecorder{
+
+ public:
+
+  /**
+   * Event types. The meaning of the two arguments of an event depends on its type
+   **/
+  enum EventType{
+    MESSAGE_RECEIVED = 1, /**< arg0: elink (or chip id), arg1: message size in bytes */
+    FRAMES_DECODED   = 2, /**< arg0: chip id, arg1: number of frames */
+    COMMAND_SENT     = 3, /**< arg0: elink, arg1: message size in bytes */
+    REGISTER_MATCHED = 4, /**< arg0: chip id, arg1: (address<<16)|value */
+    SENSOR_UPDATED   = 5  /**< arg0: chip id, arg1: (sensor kind<<24)|(index<<16)|ADC, kind 0 is NTC, 1 is BJT */
+  };
+
+  /**
+   * A trace event as stored in the rings and in the dump file
+   **/
+  struct Event{
+    uint64_t time;
+    uint32_t type;
+    uint32_t arg0;
+    uint64_t arg1;
+  };
+
+  /**
+   * Number of events kept per thread (power of 2)
+   **/
+  static const uint32_t NUM_EVENTS = 8192;
+
+  /**
+   * Maximum number of threads with a ring. Rings of finished threads are reused.
+   **/
+  static const uint32_t MAX_THREADS = 128;
+
+  /**
+   * Enable or disable the recording of events. Disabled by default.
+   * @param enable Enable the recording if true
+   **/
+  static void SetEnable(bool enable);
+
+  /**
+   * @return True if events are being recorded
+   **/
+  static bool IsEnabled();
+
+  /**
+   * Record an event in the ring of the calling thread
+   * @param type The EventType
+   * @param arg0 First argument
+   * @param arg1 Second argument
+   **/
+  static inline void Record(uint32_t type, uint32_t arg0, uint64_t arg1){
+    if(!m_enabled.load(std::memory_order_relaxed)){return;}
+    Ring * ring = (m_ring ? m_ring : Attach());
+    if(!ring){return;}
+    uint64_t pos = ring->head.load(std::memory_order_relaxed);
+    Event & event = ring->events[pos&(NUM_EVENTS-1)];
+    event.time = Now();
+    event.type = type;
+    event.arg0 = arg0;
+    event.arg1 = arg1;
+    ring->head.store(pos+1, std::memory_order_release);
+  }
+
+  /**
+   * Write the rings of all threads to a file. Only async-signal-safe calls are used.
+   * @param path The output file
+   * @return The number of events written, or -1 if the file could not be written
+   **/
+  static int64_t Dump(const char * path);
+
+  /**
+   * Write the rings of all threads to a file.
+   * @param path The output file
+   * @return The number of events written, or -1 if the file could not be written
+   **/
+  static int64_t Dump(const std::string & path);
+
+  /**
+   * Dump the rings to directory/flightrecorder-<pid>.bin when the process receives dump_signal,
+   * and to directory/flightrecorder-<pid>-crash.bin before it dies of SIGSEGV, SIGBUS, SIGFPE,
+   * SIGILL or SIGABRT.
+   * @param directory The output directory
+   * @param dump_signal The signal that triggers a dump (default SIGUSR1)
+   **/
+  static void InstallSignalHandlers(const std::string & directory, int dump_signal=SIGUSR1);
+
+  /**
+   * The ring of one thread, only written by its owner
+   **/
+  struct Ring{
+    std::atomic<uint64_t> head;
+    std::atomic<bool> owned;
+    uint32_t tid;
+    Event events[NUM_EVENTS];
+  };
+
+ private:
+
+  static inline uint64_t Now(){
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+  }
+
+  static Ring * Attach();
+
+  static std::atomic<bool> m_enabled;
+  static thread_local Ring * m_ring;
+
+};
+
+}
+
+#endif
@@ -6,13 +6,21 @@
 #include "RD53Emulator/Command.h"
 #include "RD53Emulator/Configuration.h"
 #include "RD53Emulator/Matrix.h"
-#include "RD53Emulator/Hit.h"
+#include "RD53Emulator/EventBuilder.h"
+#include "RD53Emulator/HistogramEngine.h"
+#include "RD53Emulator/EventMerger.h"
+#include "RD53Emulator/HitWriter.h"
 #include "RD53Emulator/TemperatureSensor.h"
 #include "RD53Emulator/RadiationSensor.h"
+#include "RD53Emulator/RegisterCache.h"
+#include "RD53Emulator/MacroCache.h"
+#include "RD53Emulator/ReadTransactions.h"
+#include "RD53Emulator/ConfigVerifier.h"
 
 #include <queue>
 #include <vector>
 #include <mutex>
+#include <memory>
 
 
 namespace RD53A{
@@ -34,8 +42,11 @@ namespace RD53A{
  *
  * The Decoder decodes the data from the communication layer (FrontEnd::HandleData),
  * and assigns the read-back registers (RegisterFrame) to the global Configuration,
- * and converts the rest of the data (DataFrame) into Hit objects that are stored in a FIFO.
- * The status of the FIFO can be checked (FrontEnd::HasHits), and polled (FrontEnd::GetHit, FrontEnd::NextHit).
+ * and groups the rest of the data (DataFrame) into events, one per trigger header, by the EventBuilder.
+ * The events are stored in columnar batches (EventBatch) in a FIFO.
+ * The status of the FIFO can be checked (FrontEnd::HasEvents), and polled (FrontEnd::GetEvents, FrontEnd::ReleaseEvents).
+ * The events can also be matched with the events of other front-ends by an EventMerger (FrontEnd::SetEventMerger),
+ * and written to a file by a HitWriter (FrontEnd::SetHitWriter).
  *
  * The Configuration contains the global Register objects that can be accessed directly,
  * or through the virtual Field objects in which the Register objects are divided.
@@ -55,9 +66,10 @@ namespace RD53A{
 
    fe.HandleData(in_bytes, in_length);
 
-   while(fe.HasHits()){
-     Hit * hit = fe.GetHit();
-     hit.NextHit();
+   while(fe.HasEvents()){
+     const EventBatch * batch = fe.GetEvents();
+     Span<uint16_t> cols = batch->GetCols();
+     fe.ReleaseEvents(batch);
    }
 
    @endverbatim
@@ -118,7 +130,7 @@ namespace RD53A{
      * Get the global Configuration pointer for this FrontEnd.
      * It allows direct access to all the global 16-bit Register objects,
      * and the virtual Field objects associated like the HitOr
-     * (FrontEnd::GetConfig()->GetField(Configuration::REGION_ROW)->GetValue()).
+     * (FrontEnd::GetConfig()->GetField(Configuration::REGION_ROW).GetValue()).
      * @return The global Configuration pointer
      */
     Configuration * GetConfig();
@@ -264,12 +276,20 @@ namespace RD53A{
     void WriteGlobal();
 
     /**
-     * Request the reading of the global registers
-     * @todo Might need to put the registers that have been requested into a queue
-     * and compare with them in the HandleData
+     * Request the reading of the global registers.
+     * The answers are not tracked, use FrontEnd::ReadGlobal(uint32_t) to know when they arrived.
+     * The pixel portal is not read while a verification is active (FrontEnd::VerifyConfig).
      */
     void ReadGlobal();
 
+    /**
+     * Read back all the global registers through the ReadTransactions of this FrontEnd.
+     * The RdReg commands are sent right away in one message, not through the Encoder.
+     * @param timeout_ms Time to wait for all the answers in milliseconds
+     * @return Future holding the register values indexed by address
+     */
+    std::future<std::vector<uint16_t> > ReadGlobal(uint32_t timeout_ms);
+
     /**
      * Write the in-pixel configuration of all the pixels in the front-end
      */
@@ -288,6 +308,22 @@ namespace RD53A{
      */
     void ReadPixels();
 
+    /**
+     * Read back the global registers and all the pixel pairs, and compare them with the current
+     * configuration in the ConfigVerifier of this FrontEnd, as the values arrive.
+     * While the verification is active the values read back do not change the Configuration or the Matrix,
+     * and the pixel portal can only be read through FrontEnd::ReadPixelPair.
+     * The commands are added to the Encoder, nothing waits for the answers.
+     * Check ConfigVerifier::IsComplete, and get the differences with ConfigVerifier::Compare.
+     */
+    void VerifyConfig();
+
+    /**
+     * Get the verification of the configuration read back from the chip
+     * @return The ConfigVerifier pointer
+     */
+    ConfigVerifier * GetConfigVerifier();
+
     /**
      * Read the in-pixel configuration of the selected pixel pair to the front-end
      * @param double_col The pixel column pair (0 to 199)
@@ -329,17 +365,25 @@ namespace RD53A{
     void SelectCoreColumn(uint32_t ccol, bool enable);
 
     /**
-     * Initialize the ADC of the chip to read the radiation an temperature sensors
+     * Initialize the ADC of the chip to read the radiation an temperature sensors.
+     * The encoded sequence is replayed from the MacroCache when possible.
      */
     void InitAdc();
 
     /**
-     * Read a given radiation or temperature sensor
+     * Read a given radiation or temperature sensor.
+     * The encoded sequence is replayed from the MacroCache when possible.
      * @param pos Position of the sensor (0 to 3)
      * @param read_radiation_sensor true if is a radiation sensor.
      */
     void ReadSensor(uint32_t pos, bool read_radiation_sensor);
 
+    /**
+     * Get the cache of encoded command sequences
+     * @return The MacroCache pointer
+     */
+    MacroCache * GetMacroCache();
+
     /**
      * Get a NTC temperature sensor
      * @param index The index of the sensor (0 to 3)
@@ -354,6 +398,21 @@ namespace RD53A{
      */
     RadiationSensor * GetRadiationSensor(uint32_t index);
 
+    /**
+     * Get the shadow copy of the global registers, updated with every
+     * register value received from the chip (FrontEnd::HandleData).
+     * It can outlive the FrontEnd, in which case reads just fail.
+     * @return The RegisterCache shared pointer
+     */
+    std::shared_ptr<RegisterCache> GetRegisterCache();
+
+    /**
+     * Get the table of register reads waiting for an answer from the chip.
+     * Every register frame that is not an automatic read is matched against it (FrontEnd::HandleData).
+     * @return The ReadTransactions shared pointer
+     */
+    std::shared_ptr<ReadTransactions> GetReadTransactions();
+
     /**
      * Prepare the trigger sequence for the scan.
      * @param delay The number of BCs between CAL and Trigger commands
@@ -361,22 +420,76 @@ namespace RD53A{
     void Trigger(uint32_t delay=0);
 
     /**
-     * Get the next Hit from the FIFO
-     * @return The next available Hit
+     * Take the oldest batch of events from the FIFO.
+     * It has to be given back with FrontEnd::ReleaseEvents.
+     * @return The next available EventBatch, or NULL if there is none
+     */
+    const EventBatch * GetEvents();
+
+    /**
+     * Give back a batch of events taken with FrontEnd::GetEvents
+     * @param batch The EventBatch
+     */
+    void ReleaseEvents(const EventBatch * batch);
+
+    /**
+     * Check if the FIFO of events has any batch.
+     * @return True if the FIFO has batches.
      */
-    Hit * GetHit();
+    bool HasEvents();
 
     /**
-     * Pop the next Hit from the FIFO and delete it.
-     * @return True if there FIFO is still not empty.
+     * Get the EventBuilder that groups the hits into events
+     * @return The EventBuilder pointer
      */
-    bool NextHit();
+    EventBuilder * GetEventBuilder();
 
     /**
-     * Check if the FIFO of Hits has any hits.
-     * @return True if there FIFO has hits.
+     * Enable the online histograms of the hits (occupancy, ToT and time).
+     * They are filled with every batch of events in the thread of FrontEnd::HandleData.
+     * @param enable Create the histograms if true, delete them if false. The existing histograms are kept if already enabled.
      */
-    bool HasHits();
+    void SetMonitoring(bool enable);
+
+    /**
+     * Get the online histograms of the hits
+     * @return The HistogramEngine pointer, NULL if the monitoring is not enabled
+     */
+    HistogramEngine * GetHistograms();
+
+    /**
+     * Send the events of this FrontEnd to an EventMerger, that matches them with the events of other front-ends.
+     * The fragments are added in the thread of FrontEnd::HandleData. The EventMerger is not owned by the FrontEnd.
+     * @param merger The EventMerger, or NULL to stop sending the events
+     * @param index The index of this FrontEnd in the EventMerger
+     */
+    void SetEventMerger(EventMerger * merger, uint32_t index);
+
+    /**
+     * Get the EventMerger that receives the events of this FrontEnd
+     * @return The EventMerger pointer, NULL if there is none
+     */
+    EventMerger * GetEventMerger();
+
+    /**
+     * Get the index of this FrontEnd in its EventMerger
+     * @return The index given to FrontEnd::SetEventMerger
+     */
+    uint32_t GetEventMergerIndex();
+
+    /**
+     * Write the events of this FrontEnd to the output file of a HitWriter.
+     * The events are copied in the thread of FrontEnd::HandleData. The HitWriter is not owned by the FrontEnd.
+     * @param writer The HitWriter, or NULL to stop writing the events
+     * @param index The stream index of this FrontEnd in the HitWriter
+     */
+    void SetHitWriter(HitWriter * writer, uint32_t index);
+
+    /**
+     * Get the HitWriter that receives the events of this FrontEnd
+     * @return The HitWriter pointer, NULL if there is none
+     */
+    HitWriter * GetHitWriter();
 
     /**
      * Handle the data from the communication layer given by a byte array and its size.
@@ -410,6 +523,43 @@ namespace RD53A{
 
   private:
 
+    /**
+     * Write the pending registers, and add the cached sequence of an operation
+     * to the Encoder if the registers it writes have not changed since it was recorded.
+     * @param operation The MacroCache::Operation
+     * @param arg0 First argument of the operation
+     * @param arg1 Second argument of the operation
+     * @return True if the sequence was replayed
+     */
+    bool ReplayMacro(uint32_t operation, uint32_t arg0, uint32_t arg1);
+
+    /**
+     * Start recording the commands of an operation
+     * @return The index of the first Command of the operation in the Encoder
+     */
+    uint32_t BeginMacro();
+
+    /**
+     * Encode the commands added since FrontEnd::BeginMacro and store them in the MacroCache
+     * @param operation The MacroCache::Operation
+     * @param arg0 First argument of the operation
+     * @param arg1 Second argument of the operation
+     * @param first The index returned by FrontEnd::BeginMacro
+     */
+    void EndMacro(uint32_t operation, uint32_t arg0, uint32_t arg1, uint32_t first);
+
+    /**
+     * Add the hits of one of the two halves of a DataFrame to the current event
+     * @param data The DataFrame
+     * @param pos The half of the DataFrame (0 or 1)
+     */
+    void AddHits(DataFrame * data, uint32_t pos);
+
+    /**
+     * Install the monitor of the EventBuilder that fills the histograms, feeds the EventMerger, and writes the hits
+     */
+    void UpdateMonitor();
+
     bool m_verbose;
     bool m_active;
     uint32_t m_chipid;
@@ -419,11 +569,20 @@ namespace RD53A{
     Encoder *m_encoder;
     Configuration *m_config;
     Matrix *m_matrix;
-    std::deque<Hit*> m_hits;
-    std::mutex m_mutex;
+    EventBuilder *m_events;
+    HistogramEngine *m_histos;
+    EventMerger *m_merger;
+    uint32_t m_merger_index;
+    HitWriter *m_writer;
+    uint32_t m_writer_index;
 
     std::vector<TemperatureSensor*> m_ntcs;
     std::vector<RadiationSensor*> m_bjts;
+    std::shared_ptr<RegisterCache> m_registers;
+    std::shared_ptr<ReadTransactions> m_reads;
+    ConfigVerifier *m_verifier;
+    MacroCache *m_macros;
+    std::vector<uint16_t> m_macro_before;
   
   };
 
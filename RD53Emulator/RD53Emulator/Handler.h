@@ -2,6 +2,7 @@
 #define RD53A_HANDLER_H
 
 #include "RD53Emulator/FrontEnd.h"
+#include "RD53Emulator/TriggerTemplate.h"
 
 #include <vector>
 #include <cstdint>
@@ -12,6 +13,7 @@ namespace netio{
   class low_latency_send_socket;
   class low_latency_subscribe_socket;
   class context;
+  class socket_stats;
 }
 
 class TH1I;
@@ -49,16 +51,19 @@ class RunNumber;
  *
  * It is necessary to connect to FELIX (Handler::Connect) once all the FrontEnd objects have been added.
  * Once connected, all the FrontEnd objects can be configured (Handler::Config).
- * This will also create an output ROOT file that can contain the results of the scan.
+ * This will also create an output ROOT file that can contain the results of the scan,
+ * and, if enabled (Handler::EnableHitOutput), a file with the hits of every FrontEnd, written in the background (HitWriter).
  * Finally the run method (Handler::Run) implements the specific scan procedure.
  *
  * At the end of the scan, the output of each FrontEnd can be saved to the output directory.
  * This includes any ROOT histograms created during the scan, that are written to the output ROOT file.
+ * The events of all the front-ends can be matched by trigger tag and BCID online (Handler::EnableEventMerging).
  * The output data path is defined by the ITK_DATA_PATH, and can be overwritten by the user (Handler::SetOutPath).
  * This path contains
  *
  *  - The tuned configuration file (A_BM_01_1.json)
  *  - The results ROOT file (output.root)
+ *  - The hits file (hits.rd53), if enabled
  *  - The metadata file (metadata.txt)
  *
  * An example on how to use the Handler class is the following:
@@ -124,10 +129,24 @@ public:
 
   /**
    * Set the netio::context as a string
-   * @param context Back-end for the netio communication: posix or rdma
+   * @param context Back-end for the netio communication: posix, shm (same host) or rdma
    */
   void SetContext(std::string context);
 
+  /**
+   * Set the number of netio event loops (one thread each).
+   * Data elinks are distributed over the loops by FELIX endpoint.
+   * @param num_loops The number of event loops (default 1)
+   */
+  void SetEventLoops(uint32_t num_loops);
+
+  /**
+   * Trade CPU for latency: spin on the netio event loops for the given
+   * time before blocking, and request SO_BUSY_POLL on the FELIX sockets.
+   * @param usecs The busy poll budget in microseconds (0 disables it)
+   */
+  void SetBusyPoll(uint32_t usecs);
+
   /**
    * Set the network interface to use
    * @param interface The network interface to use.
@@ -235,7 +254,8 @@ public:
    * Subscribe to the data elink of each FrontEnd.
    * The received data is handled directly by the corresponding FrontEnd object (FrontEnd::HandleData),
    * the AddressRecord and ValueRecord are parsed automatically into the FrontEnd Configuration,
-   * and the rest of the Record fragments are converted into Hit objects (FrontEnd::GetHit, FrontEnd::NextHit).
+   * and the rest of the Record fragments are grouped into events.
+   * The events are not queued (FrontEnd::GetEvents), they feed the histograms, the EventMerger and the HitWriter.
    */
   void Connect();
 
@@ -268,22 +288,38 @@ public:
 
   /**
    * Save the configuration for each FrontEnd in the tuned folder.
+   * Save the online histograms of each FrontEnd (Handler::SaveHistograms).
    */
   void Save();
 
+  /**
+   * Save a snapshot of the online histograms of each FrontEnd in the output folder,
+   * in a binary file (HitHistograms::Save), and in the ROOT file.
+   */
+  void SaveHistograms();
+
   /**
    * Prepare the Trigger sequence for all the modules from the first FrontEnd.
-   * Build the corresponding netio::message.
+   * The sequence is encoded once per TX into a TriggerTemplate of ntriggers injections,
+   * that is sent in a single message by Handler::Trigger.
    * Here we assume that the front-ends are all connected to the same TX.
    * @param cal_delay Delay between the Command::Cal and the Command::Trigger in ns
+   * @param ntriggers Number of injections per message
    */
-  void PrepareTrigger(uint32_t cal_delay=49);
+  void PrepareTrigger(uint32_t cal_delay=49, uint32_t ntriggers=1);
 
   /**
    * Send a Trigger sequence to the FrontEnd through netio
    */
   void Trigger();
 
+  /**
+   * Send a Trigger sequence to the FrontEnd through netio,
+   * with consecutive trigger tags starting at first_tag
+   * @param first_tag The tag of the first trigger of the sequence
+   */
+  void Trigger(uint32_t first_tag);
+
   /**
    * Send the pending Command messages to the selected FrontEnd
    * @param fe FrontEnd to send the pending messages to
@@ -303,6 +339,20 @@ public:
    */
   std::vector<FrontEnd*> GetFEs();
 
+  /**
+   * Get the counters of the command socket used by a FrontEnd
+   * @param name of the frontend
+   * @return the socket counters, or nullptr if the FrontEnd is not connected
+   */
+  netio::socket_stats* GetCmdStats(std::string name);
+
+  /**
+   * Get the counters of the data socket used by a FrontEnd
+   * @param name of the frontend
+   * @return the socket counters, or nullptr if the FrontEnd is not connected
+   */
+  netio::socket_stats* GetDataStats(std::string name);
+
   /**
    * Define the path for the output of the results
    * @param path to the output
@@ -361,6 +411,59 @@ public:
    */
   bool GetEnableOutput();
 
+  /**
+   * Enable/Disable the online histograms of the hits of every FrontEnd (FrontEnd::SetMonitoring)
+   * They are written to the output folder by Handler::Save.
+   * @param enable Enable the histograms if true
+   */
+  void EnableMonitoring(bool enable);
+
+  /**
+   * Get the online histograms enabled of the Handler
+   * @return True if the online histograms are enabled
+   */
+  bool GetEnableMonitoring();
+
+  /**
+   * Enable/Disable the building of events across the front-ends by trigger tag and BCID.
+   * The EventMerger is created by Handler::Connect with the enabled front-ends,
+   * and its completeness statistics are printed by Handler::Disconnect.
+   * @param enable Enable the event building across front-ends if true
+   */
+  void EnableEventMerging(bool enable);
+
+  /**
+   * Get the event building across front-ends enabled of the Handler
+   * @return True if the event building across front-ends is enabled
+   */
+  bool GetEnableEventMerging();
+
+  /**
+   * Get the EventMerger that matches the events of all the front-ends
+   * @return The EventMerger pointer, NULL if not enabled or not connected
+   */
+  EventMerger * GetEventMerger();
+
+  /**
+   * Enable/Disable the output of the hits of every FrontEnd to the hits.rd53 file in the output folder.
+   * The file is written by a HitWriter, created by Handler::Connect, and closed by Handler::Disconnect.
+   * @param enable Enable the output of the hits if true
+   * @param direct Write the file with O_DIRECT, bypassing the page cache
+   */
+  void EnableHitOutput(bool enable, bool direct=false);
+
+  /**
+   * Get the output of the hits enabled of the Handler
+   * @return True if the output of the hits is enabled
+   */
+  bool GetEnableHitOutput();
+
+  /**
+   * Get the HitWriter that writes the hits of all the front-ends
+   * @return The HitWriter pointer, NULL if not enabled or not connected
+   */
+  HitWriter * GetHitWriter();
+
   /**
    * Set the threshold charge.
    * Maximum charge is 100k electrons.
@@ -409,11 +512,19 @@ public:
 
 protected:
 
+  /**
+   * Send the prepared TriggerTemplate of each TX, optionally changing its tags first
+   * @param retag Change the trigger tags before sending
+   * @param first_tag The tag of the first trigger of the sequence
+   */
+  void SendTrigger(bool retag, uint32_t first_tag);
+
   bool m_verbose;
   std::string m_backend;
   std::string m_interface;
   netio::context * m_context;
-  std::thread m_context_thread;
+  uint32_t m_event_loops;
+  uint32_t m_busy_poll;
   std::vector<std::string> m_config_path;
   TFile * m_rootfile;
   RunNumber * m_rn;
@@ -427,6 +538,12 @@ protected:
   std::string m_fulloutpath;
   bool m_enable;
   bool m_output;
+  bool m_monitoring;
+  bool m_merging;
+  EventMerger * m_merger;
+  bool m_hit_output;
+  bool m_direct_io;
+  HitWriter * m_writer;
   uint32_t m_nrow;
   uint32_t m_ncol;
   
@@ -444,8 +561,9 @@ protected:
   std::map<uint32_t, std::vector<FrontEnd*> > m_tx_fes;
   std::map<uint32_t, FrontEnd*> m_rx_fe;
   std::map<uint32_t, netio::low_latency_send_socket *> m_tx;
+  std::map<uint32_t, std::mutex> m_tx_mutex;
   std::map<uint32_t, netio::low_latency_subscribe_socket *> m_rx;
-  std::map<uint32_t, std::vector<uint8_t> > m_trigger_msgs;
+  std::map<uint32_t, TriggerTemplate> m_trigger_templates;
 
 
 };
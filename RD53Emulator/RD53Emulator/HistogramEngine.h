@@ -0,0 +1,107 @@
+#ifndef RD53A_HISTOGRAMENGINE_H
+#define RD53A_HISTOGRAMENGINE_H
+
+#include "RD53Emulator/HitHistograms.h"
+
+#include <cstdint>
+#include <vector>
+#include <mutex>
+#include <chrono>
+
+namespace RD53A{
+
+/**
+ * The HistogramEngine fills the HitHistograms of one FrontEnd from several threads.
+ *
+ * Every thread that fills (a worker) has a private copy of the histograms (HistogramEngine::Fill),
+ * guarded by its own lock, that only the worker takes while data arrives.
+ * The private copy is added to the shared histograms, and cleared, once per period,
+ * by the worker itself (HistogramEngine::Merge), so the shared histograms are not locked for every batch.
+ * Taking a copy of the shared histograms (HistogramEngine::Snapshot) merges all the private copies first,
+ * so it contains all the data filled until then.
+ *
+ * @verbatim
+   HistogramEngine engine(2, 1000);
+   //data thread 0
+   engine.Fill(0, batch);
+   //data thread 1
+   engine.Fill(1, other_batch);
+   //monitoring thread
+   HitHistograms histos;
+   engine.Snapshot(histos);
+   @endverbatim
+ *
+ * @brief RD53A histogram engine
+ * @date October 2026
+ **/
+class HistogramEngine{
+
+ public:
+
+  typedef std::chrono::steady_clock Clock;
+
+  /**
+   * Create the histograms
+   * @param num_workers Number of threads that fill the histograms
+   * @param period_ms Time between merges of the private copies in milliseconds
+   **/
+  HistogramEngine(uint32_t num_workers=1, uint32_t period_ms=1000);
+
+  /**
+   * Delete the histograms
+   **/
+  ~HistogramEngine();
+
+  /**
+   * Fill the private copy of a worker, and merge it if the period has passed.
+   * A worker is meant to be filled from a single thread.
+   * @param worker The worker index
+   * @param batch The EventBatch
+   **/
+  void Fill(uint32_t worker, const EventBatch * batch);
+
+  /**
+   * Add the private copy of a worker to the shared histograms, and clear it.
+   * @param worker The worker index
+   **/
+  void Merge(uint32_t worker);
+
+  /**
+   * Merge the private copies, and copy the shared histograms
+   * @param copy The HitHistograms where the shared histograms are copied
+   **/
+  void Snapshot(HitHistograms & copy);
+
+  /**
+   * Clear the shared histograms and the private copies
+   **/
+  void Clear();
+
+  /**
+   * @return The number of workers
+   **/
+  uint32_t GetNumWorkers();
+
+ private:
+
+  struct Worker{
+    std::mutex mutex;
+    HitHistograms histos;
+    Clock::time_point last_merge;
+    bool filled;
+  };
+
+  /** Merge a worker, with the lock of the worker held */
+  void MergeLocked(Worker * worker);
+
+  std::vector<Worker*> m_workers;
+  Clock::duration m_period;
+
+  std::mutex m_mutex;
+  HitHistograms m_merged;
+
+};
+
+}
+
+#endif
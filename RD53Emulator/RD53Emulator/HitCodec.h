@@ -0,0 +1,80 @@
+#ifndef RD53A_HITCODEC_H
+#define RD53A_HITCODEC_H
+
+#include "RD53Emulator/EventBatch.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace RD53A{
+
+/**
+ * The HitCodec compresses the columns of an EventBatch for the HitWriter, and expands them for the HitReader.
+ *
+ * Every column is encoded on its own, so that the values of the same kind are next to each other:
+ *
+ * | Column         | Encoding                                 |
+ * | -------------- | ---------------------------------------- |
+ * | Trigger ID     | zig-zag difference to the previous event |
+ * | Trigger tag    | zig-zag difference to the previous event |
+ * | BCID           | zig-zag difference to the previous event |
+ * | Number of hits | value                                    |
+ * | Column         | zig-zag difference to the previous hit   |
+ * | Row            | zig-zag difference to the previous hit   |
+ * | ToT            | two 4-bit values per byte                |
+ *
+ * The values and the differences are written as variable length integers, 7 bits per byte.
+ * The encoded block starts with the number of events, the number of hits, and the size of every column,
+ * as 32-bit little endian integers.
+ *
+ * @brief RD53A columnar hit compression
+ * @date October 2026
+ **/
+class HitCodec{
+
+ public:
+
+  /**
+   * Identifier of the encoding in the files
+   **/
+  static const uint32_t CODEC = 1;
+
+  /**
+   * Number of columns in an encoded block
+   **/
+  static const uint32_t NUM_COLUMNS = 7;
+
+  /**
+   * Size of the header of an encoded block in bytes
+   **/
+  static const uint32_t HEADER_SIZE = 4*(2+NUM_COLUMNS);
+
+  /**
+   * @param max_hits Number of hits
+   * @param max_events Number of events
+   * @return The maximum size of an encoded block in bytes
+   **/
+  static uint32_t GetMaxSize(uint32_t max_hits, uint32_t max_events);
+
+  /**
+   * Encode a batch, and add it to the end of a buffer
+   * @param batch The EventBatch
+   * @param out The buffer
+   * @return The size of the encoded block in bytes
+   **/
+  static uint32_t Encode(const EventBatch & batch, std::vector<uint8_t> & out);
+
+  /**
+   * Decode a block into a batch. The previous contents of the batch are removed.
+   * @param data The encoded block
+   * @param size The size of the encoded block in bytes
+   * @param batch The EventBatch, its memory grows if the block has more hits or events than its maximum
+   * @return False if the block is corrupted
+   **/
+  static bool Decode(const uint8_t * data, uint32_t size, EventBatch & batch);
+
+};
+
+}
+
+#endif
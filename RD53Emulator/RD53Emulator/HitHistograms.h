@@ -0,0 +1,158 @@
+#ifndef RD53A_HITHISTOGRAMS_H
+#define RD53A_HITHISTOGRAMS_H
+
+#include "RD53Emulator/EventBatch.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace RD53A{
+
+/**
+ * HitHistograms holds the online histograms of the hits of one FrontEnd in flat arrays:
+ *
+ * | Histogram | Bins                  | Content                                       |
+ * | --------- | --------------------- | --------------------------------------------- |
+ * | Occupancy | 400 x 192             | Hits per pixel                                |
+ * | ToT sum   | 400 x 192             | Sum of the ToT per pixel, for the mean ToT    |
+ * | ToT       | 16                    | Hits per ToT value                            |
+ * | Time      | 32                    | Hits per bunch crossing after the trigger     |
+ *
+ * The pixel histograms are indexed by col*NUM_ROWS+row.
+ * The bunch crossing after the trigger is the distance in BCID from the first header
+ * with the same trigger tag.
+ *
+ * The histograms are filled from an EventBatch (HitHistograms::Fill), and added to other
+ * histograms (HitHistograms::Add), without any allocation. They are meant to be filled by a
+ * single thread, see HistogramEngine for the merging of the histograms of several threads.
+ * They can be written to and read from a binary file (HitHistograms::Save, HitHistograms::Load).
+ *
+ * @brief RD53A online hit histograms
+ * @date October 2026
+ **/
+class HitHistograms{
+
+ public:
+
+  static const uint32_t NUM_COLS = 400;
+  static const uint32_t NUM_ROWS = 192;
+  static const uint32_t NUM_PIXELS = NUM_COLS*NUM_ROWS;
+  static const uint32_t NUM_TOT = 16;
+  static const uint32_t NUM_TIME = 32;
+
+  /**
+   * Create empty histograms
+   **/
+  HitHistograms();
+
+  /**
+   * Delete the histograms
+   **/
+  ~HitHistograms();
+
+  /**
+   * Fill the histograms with all the hits of a batch of events
+   * @param batch The EventBatch
+   **/
+  void Fill(const EventBatch * batch);
+
+  /**
+   * Add the contents of other histograms
+   * @param other The other HitHistograms
+   **/
+  void Add(const HitHistograms & other);
+
+  /**
+   * Reset all the bins. The trigger tag of the last event filled is kept,
+   * so that the bunch crossings of a trigger are counted across a reset.
+   **/
+  void Clear();
+
+  /**
+   * @return The number of hits filled
+   **/
+  uint64_t GetNumHits() const;
+
+  /**
+   * @return The number of events filled
+   **/
+  uint64_t GetNumEvents() const;
+
+  /**
+   * @return The occupancy of every pixel, indexed by col*NUM_ROWS+row
+   **/
+  const uint32_t * GetOccupancy() const;
+
+  /**
+   * @return The sum of the ToT of every pixel, indexed by col*NUM_ROWS+row
+   **/
+  const uint32_t * GetTotSum() const;
+
+  /**
+   * @return The ToT histogram, NUM_TOT bins
+   **/
+  const uint64_t * GetTot() const;
+
+  /**
+   * @return The time histogram, NUM_TIME bins
+   **/
+  const uint64_t * GetTime() const;
+
+  /**
+   * @param col The pixel column
+   * @param row The pixel row
+   * @return The number of hits of the pixel
+   **/
+  uint32_t GetOccupancy(uint32_t col, uint32_t row) const;
+
+  /**
+   * @param col The pixel column
+   * @param row The pixel row
+   * @return The mean ToT of the pixel, 0 if it has no hits
+   **/
+  double GetMeanTot(uint32_t col, uint32_t row) const;
+
+  /**
+   * Project the occupancy on the columns
+   * @param projection Vector of NUM_COLS bins
+   **/
+  void GetColumnOccupancy(std::vector<uint64_t> & projection) const;
+
+  /**
+   * Project the occupancy on the rows
+   * @param projection Vector of NUM_ROWS bins
+   **/
+  void GetRowOccupancy(std::vector<uint64_t> & projection) const;
+
+  /**
+   * Write the histograms to a binary file
+   * @param path The file path
+   * @return True if the file was written
+   **/
+  bool Save(const std::string & path) const;
+
+  /**
+   * Read the histograms from a binary file written by HitHistograms::Save
+   * @param path The file path
+   * @return True if the file was read
+   **/
+  bool Load(const std::string & path);
+
+ private:
+
+  std::vector<uint32_t> m_occupancy;
+  std::vector<uint32_t> m_totsum;
+  uint64_t m_tot[NUM_TOT];
+  uint64_t m_time[NUM_TIME];
+  uint64_t m_hits;
+  uint64_t m_events;
+
+  uint32_t m_last_ttag;
+  uint32_t m_first_bcid;
+
+};
+
+}
+
+#endif
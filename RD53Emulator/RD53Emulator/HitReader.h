@@ -0,0 +1,115 @@
+#ifndef RD53A_HITREADER_H
+#define RD53A_HITREADER_H
+
+#include "RD53Emulator/HitWriter.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <fstream>
+
+namespace RD53A{
+
+/**
+ * The HitReader reads the files written by the HitWriter.
+ *
+ * Opening a file (HitReader::Open) reads its header, and the index of the blocks from the end of the file.
+ * Any block can then be read and decoded into an EventBatch (HitReader::ReadBlock), in any order,
+ * for example only the blocks of one stream, or the block that holds a given event of a stream.
+ *
+ * @verbatim
+   HitReader reader;
+   reader.Open("hits.rd53");
+   EventBatch batch(reader.GetMaxHits(), reader.GetMaxEvents());
+   for(uint32_t i=0;i<reader.GetNumBlocks();i++){
+     if(reader.GetEntry(i).stream!=0){continue;}
+     reader.ReadBlock(i, batch);
+     ...
+   }
+   @endverbatim
+ *
+ * @brief RD53A hit file reader
+ * @date October 2026
+ **/
+class HitReader{
+
+ public:
+
+  /**
+   * Create a HitReader
+   **/
+  HitReader();
+
+  /**
+   * Close the file
+   **/
+  ~HitReader();
+
+  /**
+   * Open a file, and read its index
+   * @param path The path of the file
+   * @return False if the file cannot be read, or has no index
+   **/
+  bool Open(const std::string & path);
+
+  /**
+   * Close the file
+   **/
+  void Close();
+
+  /**
+   * @return The number of streams of the file
+   **/
+  uint32_t GetNumStreams();
+
+  /**
+   * @return The maximum number of hits in a block
+   **/
+  uint32_t GetMaxHits();
+
+  /**
+   * @return The maximum number of events in a block
+   **/
+  uint32_t GetMaxEvents();
+
+  /**
+   * @return The number of blocks in the file
+   **/
+  uint32_t GetNumBlocks();
+
+  /**
+   * @param index The block number in the index
+   * @return The index entry of the block
+   **/
+  const HitWriter::IndexEntry & GetEntry(uint32_t index);
+
+  /**
+   * Find the block that holds an event of a stream
+   * @param stream The stream index
+   * @param event The event number in the stream
+   * @return The block number in the index, or -1 if there is none
+   **/
+  int32_t FindBlock(uint32_t stream, uint64_t event);
+
+  /**
+   * Read and decode a block
+   * @param index The block number in the index
+   * @param batch The EventBatch where the events are decoded
+   * @return False if the block cannot be read or is corrupted
+   **/
+  bool ReadBlock(uint32_t index, EventBatch & batch);
+
+ private:
+
+  std::ifstream m_file;
+  uint32_t m_num_streams;
+  uint32_t m_max_hits;
+  uint32_t m_max_events;
+  std::vector<HitWriter::IndexEntry> m_index;
+  std::vector<uint8_t> m_buffer;
+
+};
+
+}
+
+#endif
@@ -0,0 +1,238 @@
+#ifndef RD53A_HITWRITER_H
+#define RD53A_HITWRITER_H
+
+#include "RD53Emulator/EventBatch.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+
+namespace RD53A{
+
+/**
+ * The HitWriter writes the events of several FrontEnd objects (streams) to a binary file,
+ * without blocking the threads that receive the data on the compression or on the disk.
+ *
+ * The events of each stream are copied into a block (HitWriter::Write), an EventBatch that holds
+ * the hits of many batches. When the block is full, or on request (HitWriter::Flush), it is handed
+ * to a pool of worker threads that compress it (HitCodec), and the stream continues in a new block.
+ * A writer thread appends the compressed blocks to a staging buffer, and writes it to the file
+ * in large sequential writes. The file can be opened with O_DIRECT, in which case the writes are
+ * aligned to HitWriter::ALIGNMENT bytes, and the page cache is not used.
+ *
+ * The blocks are taken from a pool that keeps their memory. The receiving threads never wait:
+ * when all the blocks are in use, the events are dropped and counted (HitWriter::GetDropped).
+ *
+ * The blocks are written in the order in which they are compressed. The file ends with an index
+ * of the blocks (HitWriter::IndexEntry), sorted by stream and sequence, for random access (HitReader):
+ *
+ * | Part    | Contents                                                                  |
+ * | ------- | ------------------------------------------------------------------------- |
+ * | Header  | Magic "RD53AHIT", version, codec, number of streams, max hits, max events |
+ * | Block   | Magic "BLK1", stream, codec, size, encoded block (HitCodec)               |
+ * | ...     | ...                                                                       |
+ * | Index   | One HitWriter::IndexEntry per block                                       |
+ * | Trailer | Offset of the index, number of entries, magic "RD53AIDX"                  |
+ *
+ * All the integers are little endian.
+ *
+ * @verbatim
+   HitWriter writer(2);
+   writer.Open("hits.rd53");
+   //data thread of the front-end 0
+   writer.Write(0, batch);
+   //data thread of the front-end 1
+   writer.Write(1, other_batch);
+   //at the end of the run
+   writer.Close();
+   @endverbatim
+ *
+ * @brief RD53A asynchronous hit writer
+ * @date October 2026
+ **/
+class HitWriter{
+
+ public:
+
+  /**
+   * Version of the file format
+   **/
+  static const uint32_t VERSION = 1;
+
+  /**
+   * Alignment of the writes with O_DIRECT
+   **/
+  static const uint32_t ALIGNMENT = 4096;
+
+  /**
+   * Size of the file header in bytes
+   **/
+  static const uint32_t HEADER_SIZE = 32;
+
+  /**
+   * Size of the header of a block in bytes
+   **/
+  static const uint32_t BLOCK_HEADER_SIZE = 16;
+
+  /**
+   * Size of the trailer in bytes
+   **/
+  static const uint32_t TRAILER_SIZE = 24;
+
+  /**
+   * Location of a block in the file, as stored in the index
+   **/
+  struct IndexEntry{
+    uint64_t offset;      /**< Position of the block in the file */
+    uint32_t size;        /**< Size of the block in the file, with its header */
+    uint32_t stream;      /**< Stream (FrontEnd index) */
+    uint64_t sequence;    /**< Number of the block in its stream */
+    uint64_t first_event; /**< Number of events of the stream before the block */
+    uint32_t num_events;  /**< Number of events in the block */
+    uint32_t num_hits;    /**< Number of hits in the block */
+  };
+
+  /**
+   * Create a HitWriter, and start its threads
+   * @param num_streams Number of streams
+   * @param num_workers Number of compression threads
+   * @param max_hits Maximum number of hits in a block
+   * @param max_events Maximum number of events in a block
+   * @param max_blocks Maximum number of blocks in the pool
+   * @param chunk_size Size of the writes to the file in bytes, rounded up to a multiple of HitWriter::ALIGNMENT
+   **/
+  HitWriter(uint32_t num_streams, uint32_t num_workers=2, uint32_t max_hits=65536, uint32_t max_events=16384,
+            uint32_t max_blocks=32, uint32_t chunk_size=4194304);
+
+  /**
+   * Close the file, stop the threads, and delete the blocks
+   **/
+  ~HitWriter();
+
+  /**
+   * Create the output file. A file that is already open is closed first.
+   * @param path The path of the file
+   * @param direct Write with O_DIRECT, if the file system supports it
+   * @return True if the file was created
+   **/
+  bool Open(const std::string & path, bool direct=false);
+
+  /**
+   * Copy the events of a batch into the block of a stream.
+   * It is meant to be called from a single thread per stream, and returns without waiting for the disk.
+   * Nothing is done if the file is not open.
+   * @param stream The stream index
+   * @param batch The EventBatch
+   **/
+  void Write(uint32_t stream, const EventBatch * batch);
+
+  /**
+   * Hand the blocks of all the streams to the workers, even if they are not full
+   **/
+  void Flush();
+
+  /**
+   * Write all the blocks, the index and the trailer, and close the file.
+   * It waits for the workers and the writer thread.
+   * @return True if all the data was written
+   **/
+  bool Close();
+
+  /**
+   * @return True if the file is open
+   **/
+  bool IsOpen();
+
+  /**
+   * @return The number of events dropped because all the blocks were in use
+   **/
+  uint64_t GetDropped();
+
+  /**
+   * @return The number of blocks written to the file
+   **/
+  uint64_t GetNumBlocks();
+
+  /**
+   * @return The number of bytes written to the file
+   **/
+  uint64_t GetBytesWritten();
+
+  /**
+   * @return The number of bytes of the blocks before the compression
+   **/
+  uint64_t GetBytesRaw();
+
+ private:
+
+  struct Block{
+    EventBatch * batch;
+    uint32_t stream;
+    uint64_t sequence;
+    uint64_t first_event;
+    std::vector<uint8_t> data;
+  };
+
+  struct Stream{
+    std::mutex mutex;
+    Block * block;
+    uint64_t sequence;
+    uint64_t events;
+  };
+
+  /** Take a block from the pool, or NULL if all of them are in use */
+  Block * Acquire();
+
+  /** Hand the block of a stream to the workers, with the lock of the stream held */
+  void Seal(Stream * stream);
+
+  /** Write the aligned part of the staging buffer to the file, and keep the rest */
+  void WriteStaging(bool all);
+
+  void Compress();
+  void Store();
+
+  uint32_t m_num_streams;
+  uint32_t m_max_hits;
+  uint32_t m_max_events;
+  uint32_t m_max_blocks;
+  uint32_t m_chunk_size;
+  std::vector<Stream*> m_streams;
+  std::atomic<bool> m_open;
+  std::atomic<uint64_t> m_dropped;
+
+  std::mutex m_mutex;
+  std::condition_variable m_sealed_cv;
+  std::condition_variable m_compressed_cv;
+  std::condition_variable m_done_cv;
+  std::vector<Block*> m_free;
+  std::deque<Block*> m_sealed;
+  std::deque<Block*> m_compressed;
+  uint32_t m_allocated;
+  uint32_t m_pending;
+  bool m_running;
+  std::vector<std::thread> m_workers;
+  std::thread m_writer;
+
+  //only used by the writer thread, or while no block is pending
+  int m_fd;
+  bool m_direct;
+  bool m_error;
+  uint8_t * m_staging;
+  uint32_t m_staging_size;
+  uint32_t m_staging_capacity;
+  uint64_t m_offset;
+  uint64_t m_bytes_written;
+  uint64_t m_bytes_raw;
+  std::vector<IndexEntry> m_index;
+
+};
+
+}
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef RD53A_MACRO_H
+#define RD53A_MACRO_H
+
+#include "RD53Emulator/Command.h"
+#include <vector>
+#include <memory>
+
+namespace RD53A{
+
+/**
+ * A Macro is a sequence of commands that has already been encoded, and is
+ * added to the Encoder as a single Command. Packing a Macro is a copy of its bytes.
+ * The bytes are shared with the MacroCache that created them, and with any clone.
+ *
+ * A Macro is never the result of decoding a byte stream, the Encoder decodes
+ * its contents as the individual commands. Macro::UnPack only recognizes the
+ * sequence of the Macro at the start of a byte array.
+ *
+ * @brief RD53A pre-encoded command sequence
+ * @date October 2026
+ **/
+
+class Macro: public Command{
+  
+ public:
+  
+  /**
+   * Create a Macro from an encoded byte sequence
+   * @param bytes The encoded commands
+   **/
+  Macro(std::shared_ptr<const std::vector<uint8_t> > bytes);
+  
+  /**
+   * Create a Macro as a copy from another one
+   * @param copy A Macro to copy
+   */
+  Macro(Macro * copy);
+
+  /**
+   * Empty destructor just for completeness.
+   **/
+  ~Macro();
+  
+  /**
+   * Clone this Macro
+   * @return A Macro copy of this one
+   */
+  Macro * Clone();
+
+  /**
+   * Return a human readable representation of the sequence
+   * @return The human readable representation of the sequence
+   **/
+  std::string ToString();
+
+  /**
+   * Check that the byte array starts with the encoded sequence of this Macro
+   * @param bytes the byte array
+   * @param maxlen the maximum number of bytes than can be read
+   * @return the size of the sequence, or 0 if it is longer than maxlen or the bytes differ
+   **/
+  uint32_t UnPack(uint8_t * bytes, uint32_t maxlen);
+  
+  /**
+   * Copy the encoded sequence to bytes
+   * @param bytes the byte array
+   * @return the number of bytes processed
+   **/
+  uint32_t Pack(uint8_t * bytes);
+
+  /**
+   * Get the type of command
+   * @return the type of the command
+   **/
+  uint32_t GetType();
+
+ private:
+
+  std::shared_ptr<const std::vector<uint8_t> > m_bytes;
+
+};
+
+}
+
+#endif 
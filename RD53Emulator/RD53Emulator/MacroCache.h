@@ -0,0 +1,123 @@
+#ifndef RD53A_MACROCACHE_H
+#define RD53A_MACROCACHE_H
+
+#include <cstdint>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <memory>
+
+namespace RD53A{
+
+class Configuration;
+
+/**
+ * The MacroCache keeps the encoded commands of recurring FrontEnd operations
+ * (FrontEnd::InitAdc, FrontEnd::ReadSensor), so that they do not have to be
+ * built from Configuration fields and encoded on every monitoring cycle.
+ *
+ * A cached sequence is identified by the chip id, the operation, and its arguments.
+ * Together with the bytes, it stores the global registers written by the sequence
+ * with their values before and after, since a WrReg contains the whole 16-bit register,
+ * including the fields that the operation does not change.
+ * A sequence can only be replayed (MacroCache::Find) if the registers
+ * it writes still have the values they had when it was recorded (MacroCache::Store).
+ * A few variants are kept per key, for operations that are called from different register states.
+ *
+ * @verbatim
+   MacroCache cache;
+   const MacroCache::Entry * entry = cache.Find(chipid, MacroCache::INIT_ADC, 0, 0, config);
+   if(entry){
+     ...apply entry->after, and send entry->bytes...
+   }
+   @endverbatim
+ *
+ * @brief RD53A cache of encoded command sequences
+ * @date October 2026
+ **/
+class MacroCache{
+
+ public:
+
+  /**
+   * Operations that can be cached
+   **/
+  enum Operation{
+    INIT_ADC = 1,   /**< FrontEnd::InitAdc */
+    READ_SENSOR = 2 /**< FrontEnd::ReadSensor, args: position, radiation sensor */
+  };
+
+  /**
+   * Maximum number of variants of the same key
+   **/
+  static const uint32_t MAX_VARIANTS = 4;
+
+  /**
+   * A recorded sequence
+   **/
+  struct Entry{
+    std::shared_ptr<const std::vector<uint8_t> > bytes;   /**< Encoded commands */
+    std::vector<std::pair<uint32_t,uint16_t> > before;    /**< Written registers and their values before the sequence */
+    std::vector<std::pair<uint32_t,uint16_t> > after;     /**< Written registers and their values after the sequence */
+  };
+
+  /**
+   * Create an empty MacroCache
+   **/
+  MacroCache();
+
+  /**
+   * Delete the MacroCache
+   **/
+  ~MacroCache();
+
+  /**
+   * Find a sequence that can be replayed from the current register values
+   * @param chipid The chip id
+   * @param operation The MacroCache::Operation
+   * @param arg0 First argument of the operation
+   * @param arg1 Second argument of the operation
+   * @param config The Configuration with the current value of the global registers
+   * @return The sequence or 0 if there is none for this register state
+   **/
+  const Entry * Find(uint32_t chipid, uint32_t operation, uint32_t arg0, uint32_t arg1,
+                     Configuration * config);
+
+  /**
+   * Store a sequence. The oldest variant of the key is replaced if there are too many.
+   * @param chipid The chip id
+   * @param operation The MacroCache::Operation
+   * @param arg0 First argument of the operation
+   * @param arg1 Second argument of the operation
+   * @param entry The recorded sequence
+   **/
+  void Store(uint32_t chipid, uint32_t operation, uint32_t arg0, uint32_t arg1, const Entry & entry);
+
+  /**
+   * Remove all the sequences
+   **/
+  void Clear();
+
+  /**
+   * @return Number of sequences replayed from the cache
+   **/
+  uint64_t GetHits();
+
+  /**
+   * @return Number of sequences that had to be recorded
+   **/
+  uint64_t GetMisses();
+
+ private:
+
+  typedef std::tuple<uint32_t,uint32_t,uint32_t,uint32_t> Key;
+
+  std::map<Key, std::vector<Entry> > m_entries;
+  uint64_t m_hits;
+  uint64_t m_misses;
+
+};
+
+}
+
+#endif
@@ -0,0 +1,150 @@
+#ifndef RD53A_READTRANSACTIONS_H
+#define RD53A_READTRANSACTIONS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <thread>
+#include <chrono>
+
+namespace RD53A{
+
+/**
+ * ReadTransactions keeps the table of register reads (RdReg) of one FrontEnd
+ * that are waiting for an answer from the chip, and resolves them as the answers arrive.
+ *
+ * A read (ReadTransactions::Read) adds one request per address to the table,
+ * sends all the addresses in one message through the function given to
+ * ReadTransactions::SetSender, and returns a std::future that is ready when
+ * all the values have arrived, or when the deadline of the read expires.
+ * In the latter case the future holds an exception.
+ *
+ * The chip answers the RdReg commands in order. Every register frame that is not an
+ * automatic read is given to ReadTransactions::Match, that resolves the oldest request
+ * for that address. Answers to requests that are not in the table are counted and ignored.
+ * Requests whose answer got lost stay in the table until their deadline.
+ *
+ * Expired requests are removed by a helper thread that sleeps until the next deadline,
+ * so that a future always becomes ready without anybody polling the table.
+ * The thread is started by the first read, a FrontEnd that never reads a register has none.
+ *
+ * @verbatim
+   ReadTransactions reads;
+   reads.SetSender([&](const std::vector<uint32_t> & addresses){ ... send RdReg(addresses) ... });
+   std::future<std::vector<uint16_t> > batch = reads.Read({1,2,3}, 100);
+   std::future<uint16_t> single = reads.Read(136, 100);
+   //from the data handler
+   reads.Match(address, value);
+   //any time later
+   uint16_t adc = single.get(); //throws if it timed out
+   @endverbatim
+ *
+ * @brief RD53A register read transactions
+ * @date October 2026
+ **/
+class ReadTransactions{
+
+ public:
+
+  typedef std::chrono::steady_clock Clock;
+
+  /**
+   * Create an empty table
+   **/
+  ReadTransactions();
+
+  /**
+   * Fail the outstanding requests, and stop the helper thread if it was started
+   **/
+  ~ReadTransactions();
+
+  /**
+   * Set the function used to send the RdReg commands to the chip.
+   * Reads fail immediately while no sender is set.
+   * @param sender Function that sends one RdReg per address in a single message
+   **/
+  void SetSender(std::function<void(const std::vector<uint32_t> &)> sender);
+
+  /**
+   * Read a register
+   * @param address Register address
+   * @param timeout_ms Time to wait for the answer in milliseconds
+   * @return Future holding the 16-bit register value
+   **/
+  std::future<uint16_t> Read(uint32_t address, uint32_t timeout_ms);
+
+  /**
+   * Read a batch of registers in a single message
+   * @param addresses Register addresses
+   * @param timeout_ms Time to wait for all the answers in milliseconds
+   * @return Future holding the register values in the order of the addresses
+   **/
+  std::future<std::vector<uint16_t> > Read(const std::vector<uint32_t> & addresses, uint32_t timeout_ms);
+
+  /**
+   * Resolve the oldest request for a register with the value reported by the chip
+   * @param address Register address
+   * @param value The 16-bit register value
+   * @return True if there was a request for this register
+   **/
+  bool Match(uint32_t address, uint16_t value);
+
+  /**
+   * @return Number of requests waiting for an answer
+   **/
+  uint32_t GetOutstanding();
+
+  /**
+   * @return Number of reads that expired before all their answers arrived
+   **/
+  uint64_t GetTimeouts();
+
+  /**
+   * @return Number of register frames that did not match any request
+   **/
+  uint64_t GetUnmatched();
+
+ private:
+
+  struct Transaction{
+    bool single;
+    std::promise<uint16_t> value;
+    std::promise<std::vector<uint16_t> > values;
+    std::vector<uint16_t> results;
+    uint32_t remaining;
+    bool done;
+  };
+
+  struct Request{
+    std::shared_ptr<Transaction> transaction;
+    uint32_t index;
+    uint32_t address;
+    Clock::time_point deadline;
+  };
+
+  void Submit(std::shared_ptr<Transaction> transaction, const std::vector<uint32_t> & addresses, uint32_t timeout_ms);
+  void Fail(Transaction & transaction, const std::string & reason);
+  void Expire();
+
+  std::mutex m_mutex;
+  std::condition_variable m_changed;
+  std::deque<Request> m_requests;
+  bool m_running;
+  std::thread m_thread;
+  uint64_t m_timeouts;
+  uint64_t m_unmatched;
+
+  std::mutex m_sender_mutex;
+  std::function<void(const std::vector<uint32_t> &)> m_sender;
+
+};
+
+}
+
+#endif
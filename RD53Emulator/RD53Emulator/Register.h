@@ -5,13 +5,18 @@
 
 namespace RD53A{
 
+class Configuration;
+
 /**
- * The FEI4B Configuration is divided into Register objects.
- * A Register holds the configuration of a particular functionality of the FEI4B.
+ * The RD53A Configuration is divided into 16-bit registers.
+ * A Register holds the configuration of a particular functionality of the RD53A.
  * The value of a Register can be set (Register::SetValue), and retrieved (Register::GetValue).
  * And it also contains a flag (Register::IsUpdated) to know if the register was updated since last reading.
  * The maximum content of a Register is 16-bits.
  *
+ * The values and the updated flags are stored in the Configuration.
+ * A Register object is a small view of one of them (Field::GetRegister).
+ *
  * @brief RD53A Register
  * @author Carlos.Solans@cern.ch
  * @date August 2020
@@ -22,9 +27,11 @@ class Register{
   public:
 
   /**
-   * Create a new Register
+   * Create a new Register view
+   * @param config pointer to the Configuration that holds the value
+   * @param index Register index
    **/
-  Register();
+  Register(Configuration * config, uint32_t index);
 
   /**
    * Delete the Register
@@ -54,10 +61,16 @@ class Register{
    */
   bool IsUpdated();
 
+  /**
+   * Get the index of the Register in the Configuration
+   * @return The Register index
+   */
+  uint32_t GetIndex();
+
   private:
 
-  uint16_t m_value;
-  bool m_updated;
+  Configuration * m_config;
+  uint32_t m_index;
 
 };
 
@@ -0,0 +1,134 @@
+#ifndef RD53A_REGISTERCACHE_H
+#define RD53A_REGISTERCACHE_H
+
+#include <cstdint>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+
+namespace RD53A{
+
+/**
+ * The RegisterCache keeps a shadow copy of the global registers of one FrontEnd,
+ * as last reported by the chip in a RegisterFrame (RegisterCache::Update).
+ *
+ * A read (RegisterCache::Read) is served from the shadow copy if it is younger than
+ * the requested maximum age. Otherwise the register is queued to be read back from the chip:
+ *
+ *  - Concurrent reads of the same register are coalesced into a single RdReg.
+ *  - The first reader waits a short batch window (RegisterCache::SetBatchWindow) for other
+ *    registers to be requested, and then sends all of them in a single command message
+ *    through the function given to RegisterCache::SetSender.
+ *
+ * The calling thread blocks until the value arrives or the timeout expires, so Read
+ * is meant to be called from worker threads, never from the thread that calls Update.
+ *
+ * @verbatim
+   RegisterCache cache;
+   cache.SetSender([&](const std::vector<uint32_t> & addresses){ ... send RdReg(addresses) ... });
+   //from the data handler
+   cache.Update(address, value);
+   //from any other thread
+   uint16_t value;
+   if(cache.Read(118, 1000, 500, value)){ ... } //BC_CTR
+   @endverbatim
+ *
+ * @brief RD53A RegisterCache
+ * @date October 2026
+ **/
+class RegisterCache{
+
+ public:
+
+  typedef std::chrono::steady_clock Clock;
+
+  /**
+   * Number of global registers of the RD53A
+   **/
+  static const uint32_t NUM_REGISTERS = 138;
+
+  /**
+   * Create an empty cache. No register has been read yet.
+   **/
+  RegisterCache();
+
+  /**
+   * Delete the cache
+   **/
+  ~RegisterCache();
+
+  /**
+   * Set the function used to request a batch of registers from the chip.
+   * Reads fail while no sender is set.
+   * @param sender Function that sends one RdReg per address in a single message
+   **/
+  void SetSender(std::function<void(const std::vector<uint32_t> &)> sender);
+
+  /**
+   * Set the time the first reader waits for other registers to be requested
+   * before sending the batch.
+   * @param usecs The batch window in microseconds
+   **/
+  void SetBatchWindow(uint32_t usecs);
+
+  /**
+   * Store the value of a register reported by the chip and wake up its readers.
+   * @param address Register address
+   * @param value The 16-bit register value
+   **/
+  void Update(uint32_t address, uint16_t value);
+
+  /**
+   * Get the value of a register, reading it back from the chip if the cached
+   * value is older than max_age_ms.
+   * @param address Register address
+   * @param max_age_ms Maximum age of the cached value in milliseconds
+   * @param timeout_ms Maximum time to wait for the chip in milliseconds
+   * @param value The 16-bit register value
+   * @param updated Time the value was reported by the chip (optional)
+   * @return True if a value young enough is available
+   **/
+  bool Read(uint32_t address, uint32_t max_age_ms, uint32_t timeout_ms,
+            uint16_t & value, Clock::time_point * updated=0);
+
+  /**
+   * Get the number of RdReg commands sent so far
+   * @return The number of registers requested from the chip
+   **/
+  uint64_t GetRequests();
+
+  /**
+   * Get the number of command messages sent so far
+   * @return The number of batches sent to the chip
+   **/
+  uint64_t GetBatches();
+
+ private:
+
+  struct Entry{
+    uint16_t value;
+    bool valid;
+    bool requested;
+    Clock::time_point updated;
+  };
+
+  std::mutex m_mutex;
+  std::condition_variable m_updated;
+  std::vector<Entry> m_entries;
+  std::vector<uint32_t> m_pending;
+  bool m_collecting;
+  bool m_has_sender;
+  uint32_t m_batch_window;
+  uint64_t m_requests;
+  uint64_t m_batches;
+
+  std::mutex m_sender_mutex;
+  std::function<void(const std::vector<uint32_t> &)> m_sender;
+
+};
+
+}
+
+#endif
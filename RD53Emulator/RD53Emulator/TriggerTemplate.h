@@ -0,0 +1,115 @@
+#ifndef RD53A_TRIGGERTEMPLATE_H
+#define RD53A_TRIGGERTEMPLATE_H
+
+#include <cstdint>
+#include <vector>
+
+namespace RD53A{
+
+/**
+ * A TriggerTemplate is a pre-encoded burst of calibration injections, each of them
+ * the same sequence that FrontEnd::Trigger adds to the Encoder:
+ *
+ * | Command | Count     | Bytes         |
+ * | ------- | --------- | ------------- |
+ * | Sync    | 1         | 2             |
+ * | Noop    | 1         | 2             |
+ * | Cal     | 1         | 6             |
+ * | Noop    | cal_delay | 2 x cal_delay |
+ * | Trigger | 1         | 2             |
+ *
+ * The burst is encoded once (TriggerTemplate::Build) into a single byte stream
+ * that can be sent in one message. The offsets of the trigger pattern and the trigger
+ * tag symbols of every injection are recorded, so that they can be changed in place
+ * (TriggerTemplate::SetTag, TriggerTemplate::SetTags, TriggerTemplate::SetPattern)
+ * without creating or encoding any Command.
+ *
+ * @verbatim
+   TriggerTemplate burst;
+   burst.Build(7, 49, 100);
+   for(uint32_t i=0;i<ninjections;i+=100){
+     burst.SetTags(i);
+     send(burst.GetBytes(), burst.GetLength());
+   }
+   @endverbatim
+ *
+ * @brief RD53A pre-encoded Trigger sequence
+ * @date October 2026
+ **/
+class TriggerTemplate{
+
+ public:
+
+  /**
+   * Create an empty TriggerTemplate
+   **/
+  TriggerTemplate();
+
+  /**
+   * Delete the TriggerTemplate
+   **/
+  ~TriggerTemplate();
+
+  /**
+   * Encode a burst of injections. Previous contents are discarded.
+   * All the triggers are built with the Trigger::Trigger_08 pattern and tag 0.
+   * @param chipid The chip id of the Cal command
+   * @param cal_delay Number of Noop commands between the Cal and the Trigger
+   * @param ntriggers Number of injections in the burst
+   **/
+  void Build(uint32_t chipid, uint32_t cal_delay, uint32_t ntriggers);
+
+  /**
+   * Change the tag of one trigger of the burst
+   * @param index The injection number in the burst
+   * @param tag The 5-bit Trigger tag
+   **/
+  void SetTag(uint32_t index, uint32_t tag);
+
+  /**
+   * Change the tags of all triggers of the burst to consecutive values
+   * starting at first_tag (modulo 32)
+   * @param first_tag The tag of the first trigger of the burst
+   **/
+  void SetTags(uint32_t first_tag);
+
+  /**
+   * Change the bunch crossing pattern of one trigger of the burst
+   * @param index The injection number in the burst
+   * @param pattern The Trigger pattern (Trigger::Trigger_01 to Trigger::Trigger_15)
+   **/
+  void SetPattern(uint32_t index, uint32_t pattern);
+
+  /**
+   * @return The encoded burst
+   **/
+  const uint8_t * GetBytes() const;
+
+  /**
+   * @return The length of the encoded burst in bytes
+   **/
+  uint32_t GetLength() const;
+
+  /**
+   * @return The number of injections in the burst
+   **/
+  uint32_t GetNumTriggers() const;
+
+  /**
+   * @return The length of a single injection in bytes
+   **/
+  uint32_t GetSequenceLength() const;
+
+ private:
+
+  std::vector<uint8_t> m_bytes;
+  std::vector<uint32_t> m_pattern_offsets;
+  std::vector<uint32_t> m_tag_offsets;
+  uint32_t m_sequence_length;
+  uint8_t m_tag_symbols[32];
+
+};
+
+}
+
+#endif
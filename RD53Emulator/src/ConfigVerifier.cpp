@@ -0,0 +1,151 @@
+#include "RD53Emulator/ConfigVerifier.h"
+#include "RD53Emulator/Configuration.h"
+#include "RD53Emulator/Matrix.h"
+
+#include <algorithm>
+
+using namespace std;
+using namespace RD53A;
+
+ConfigVerifier::ConfigVerifier(){
+  m_active=false;
+  m_expected_pairs.resize(PAIR_WORDS,0);
+  m_readback_pairs.resize(PAIR_WORDS,0);
+  m_requested_pairs.resize((NUM_PAIRS+63)/64,0);
+  m_received_pairs.resize((NUM_PAIRS+63)/64,0);
+  fill(m_expected_registers,m_expected_registers+REGISTER_WORDS,0);
+  fill(m_readback_registers,m_readback_registers+REGISTER_WORDS,0);
+  fill(m_received_registers,m_received_registers+3,0);
+  m_next=0;
+  m_num_registers=0;
+}
+
+ConfigVerifier::~ConfigVerifier(){}
+
+uint64_t ConfigVerifier::Lanes(uint32_t bits){
+  static const uint64_t lanes[16]={
+    0x0000000000000000ULL,0x000000000000FFFFULL,0x00000000FFFF0000ULL,0x00000000FFFFFFFFULL,
+    0x0000FFFF00000000ULL,0x0000FFFF0000FFFFULL,0x0000FFFFFFFF0000ULL,0x0000FFFFFFFFFFFFULL,
+    0xFFFF000000000000ULL,0xFFFF00000000FFFFULL,0xFFFF0000FFFF0000ULL,0xFFFF0000FFFFFFFFULL,
+    0xFFFFFFFF00000000ULL,0xFFFFFFFF0000FFFFULL,0xFFFFFFFFFFFF0000ULL,0xFFFFFFFFFFFFFFFFULL
+  };
+  return lanes[bits&0xF];
+}
+
+void ConfigVerifier::Start(Configuration * config, Matrix * matrix){
+  lock_guard<mutex> lock(m_mutex);
+  for(uint32_t i=0;i<NUM_PAIRS;i++){
+    uint64_t value=matrix->GetPair(i/192,i%192);
+    uint64_t & word=m_expected_pairs[i/4];
+    word&=~(0xFFFFULL<<(16*(i%4)));
+    word|=value<<(16*(i%4));
+  }
+  fill(m_expected_registers,m_expected_registers+REGISTER_WORDS,0);
+  for(uint32_t addr=0;addr<NUM_REGISTERS;addr++){
+    m_expected_registers[addr/4]|=((uint64_t)config->GetRegister(addr))<<(16*(addr%4));
+  }
+  fill(m_readback_pairs.begin(),m_readback_pairs.end(),0);
+  fill(m_requested_pairs.begin(),m_requested_pairs.end(),0);
+  fill(m_received_pairs.begin(),m_received_pairs.end(),0);
+  fill(m_readback_registers,m_readback_registers+REGISTER_WORDS,0);
+  fill(m_received_registers,m_received_registers+3,0);
+  m_order.clear();
+  m_order.reserve(NUM_PAIRS);
+  m_next=0;
+  m_num_registers=0;
+  m_active=true;
+}
+
+void ConfigVerifier::Stop(){
+  lock_guard<mutex> lock(m_mutex);
+  m_active=false;
+}
+
+bool ConfigVerifier::IsActive(){
+  lock_guard<mutex> lock(m_mutex);
+  return m_active;
+}
+
+void ConfigVerifier::ExpectPair(uint32_t double_col, uint32_t row){
+  lock_guard<mutex> lock(m_mutex);
+  if(!m_active or double_col>=200 or row>=192){return;}
+  uint32_t pair=double_col*192+row;
+  m_order.push_back(pair);
+  m_requested_pairs[pair/64]|=1ULL<<(pair%64);
+}
+
+bool ConfigVerifier::Receive(uint32_t address, uint16_t value){
+  lock_guard<mutex> lock(m_mutex);
+  if(!m_active){return false;}
+  bool taken=Store(address,value);
+  //nothing else to wait for
+  if(m_next==m_order.size() and m_num_registers==LAST_REGISTER-FIRST_REGISTER+1){m_active=false;}
+  return taken;
+}
+
+bool ConfigVerifier::Store(uint32_t address, uint16_t value){
+  if(address==0){
+    if(m_next>=m_order.size()){return false;}
+    uint32_t pair=m_order[m_next++];
+    uint64_t & word=m_readback_pairs[pair/4];
+    word&=~(0xFFFFULL<<(16*(pair%4)));
+    word|=((uint64_t)value)<<(16*(pair%4));
+    m_received_pairs[pair/64]|=1ULL<<(pair%64);
+    return true;
+  }
+  if(address<FIRST_REGISTER or address>LAST_REGISTER){return false;}
+  uint64_t & word=m_readback_registers[address/4];
+  word&=~(0xFFFFULL<<(16*(address%4)));
+  word|=((uint64_t)value)<<(16*(address%4));
+  if(!((m_received_registers[address/64]>>(address%64))&1)){m_num_registers++;}
+  m_received_registers[address/64]|=1ULL<<(address%64);
+  return true;
+}
+
+bool ConfigVerifier::IsComplete(){
+  lock_guard<mutex> lock(m_mutex);
+  return (m_next==m_order.size() and m_num_registers==LAST_REGISTER-FIRST_REGISTER+1);
+}
+
+ConfigVerifier::Report ConfigVerifier::Compare(){
+  lock_guard<mutex> lock(m_mutex);
+  Report report;
+  report.missing_pairs=0;
+  report.missing_registers=0;
+
+  //pixel pairs, 4 per word, 16 words per bitmap word
+  for(uint32_t i=0;i<m_requested_pairs.size();i++){
+    uint64_t requested=m_requested_pairs[i];
+    if(requested==0){continue;}
+    uint64_t received=m_received_pairs[i]&requested;
+    report.missing_pairs+=__builtin_popcountll(requested&~received);
+    for(uint32_t j=0;j<16 and i*16+j<PAIR_WORDS;j++){
+      uint32_t w=i*16+j;
+      uint64_t diff=(m_expected_pairs[w]^m_readback_pairs[w])&Lanes(received>>(4*j));
+      while(diff){
+        uint32_t lane=__builtin_ctzll(diff)/16;
+        uint32_t pair=w*4+lane;
+        report.pairs.push_back(((pair/192)<<16)|(pair%192));
+        diff&=~(0xFFFFULL<<(16*lane));
+      }
+    }
+  }
+
+  //global registers, 4 per word
+  for(uint32_t w=FIRST_REGISTER/4;w<=LAST_REGISTER/4;w++){
+    uint32_t bits=0;
+    for(uint32_t lane=0;lane<4;lane++){
+      uint32_t addr=w*4+lane;
+      if(addr<FIRST_REGISTER or addr>LAST_REGISTER){continue;}
+      if((m_received_registers[addr/64]>>(addr%64))&1){bits|=1<<lane;}
+      else{report.missing_registers++;}
+    }
+    uint64_t diff=(m_expected_registers[w]^m_readback_registers[w])&Lanes(bits);
+    while(diff){
+      uint32_t lane=__builtin_ctzll(diff)/16;
+      report.registers.push_back(w*4+lane);
+      diff&=~(0xFFFFULL<<(16*lane));
+    }
+  }
+  return report;
+}
@@ -3,515 +3,600 @@
 using namespace std;
 using namespace RD53A;
 
-std::map<std::string, uint32_t> Configuration::m_name2index={
-    {"AdcRead", ADC_READ},
-    {"AdcRefTrim", ADC_TRIM},
-    {"AdcTrim", ADC_TRIM},
-    {"AiPixCol", AI_PIX_COL},
-    {"AiPixRow", AI_PIX_ROW},
-    {"AuroraCbSend", AURORA_CB_SEND},
-    {"AuroraCbWaitHigh", AURORA_CB_WAIT_1},
-    {"AuroraCbWaitLow", AURORA_CB_WAIT_0},
-    {"AuroraCcSend", AURORA_CC_SEND},
-    {"AuroraCcWait", AURORA_CC_WAIT},
-    {"AuroraInitWait", AURORA_INIT_WAIT},
-    {"AutoReadA0", AUTO_READ_A0},
-    {"AutoReadA1", AUTO_READ_A1},
-    {"AutoReadA2", AUTO_READ_A2},
-    {"AutoReadA3", AUTO_READ_A3},
-    {"AutoReadB0", AUTO_READ_B0},
-    {"AutoReadB1", AUTO_READ_B1},
-    {"AutoReadB2", AUTO_READ_B2},
-    {"AutoReadB3", AUTO_READ_B3},
-    {"BcCounter", BC_CTR},
-    {"BflipErrCounter", BFLIP_ERR_CTR},
-    {"BflipWarnCounter", BFLIP_WARN_CTR},
-    {"CalColprDiff1", CAL_COLPR_DIFF_1},
-    {"CalColprDiff2", CAL_COLPR_DIFF_2},
-    {"CalColprDiff3", CAL_COLPR_DIFF_3},
-    {"CalColprDiff4", CAL_COLPR_DIFF_4},
-    {"CalColprDiff5", CAL_COLPR_DIFF_5},
-    {"CalColprLin1", CAL_COLPR_LIN_1},
-    {"CalColprLin2", CAL_COLPR_LIN_2},
-    {"CalColprLin3", CAL_COLPR_LIN_3},
-    {"CalColprLin4", CAL_COLPR_LIN_4},
-    {"CalColprLin5", CAL_COLPR_LIN_5},
-    {"CalColprSync1", CAL_COLPR_SYNC_1},
-    {"CalColprSync2", CAL_COLPR_SYNC_2},
-    {"CalColprSync3", CAL_COLPR_SYNC_3},
-    {"CalColprSync4", CAL_COLPR_SYNC_4},
-    {"CdrCpIbias", CDR_CP_IBIAS},
-    {"CdrEnGck", CDR_CONFIG},
-    {"CdrPdDel", CDR_CONFIG},
-    {"CdrPdSel", CDR_CONFIG},
-    {"CdrSelDelClk", CDR_CONFIG},
-    {"CdrSelSerClk", CDR_CONFIG},
-    {"CdrVcoGain", CDR_CONFIG},
-    {"ChSyncLock", CH_SYNC_LOCK},
-    {"ChSyncPhase", CH_SYNC_PHASE},
-    {"ChSyncUnlock", CH_SYNC_UNLOCK},
-    {"ClkDelay", CLK_DELAY},
-    {"ClkDelaySel", CLK_DELAY_SEL},
-    {"CmdDelay", CMD_DELAY},
-    {"CmdErrCounter", CMD_ERR_CTR},
-    {"CmlEn", CML_EN},
-    {"CmlEnTap", CML_EN_TAP},
-    {"CmlInvTap", CML_INV_TAP},
-    {"CmlTapBias0", CML_TAP_BIAS_1},
-    {"CmlTapBias1", CML_TAP_BIAS_2},
-    {"CmlTapBias2", CML_TAP_BIAS_3},
-    {"DebugConfig", DEBUG_CONFIG},
-    {"DiffComp", COMP_DIFF},
-    {"DiffFbCapEn", DIFF_FB_CAP_EN},
-    {"DiffFol", FOL_DIFF},
-    {"DiffLcc", LCC_DIFF},
-    {"DiffLccEn", LCC_EN},
-    {"DiffPrecomp", PRECOMP_DIFF},
-    {"DiffPrmp", PRMP_DIFF},
-    {"DiffVff", VFF_DIFF},
-    {"DiffVth1", VTH1_DIFF},
-    {"DiffVth2", VTH2_DIFF},
-    {"EnCoreColDiff1", EN_CORE_COL_DIFF_1},
-    {"EnCoreColDiff2", EN_CORE_COL_DIFF_2},
-    {"EnCoreColLin1", EN_CORE_COL_LIN_1},
-    {"EnCoreColLin2", EN_CORE_COL_LIN_2},
-    {"EnCoreColSync", EN_CORE_COL_SYNC},
-    {"ErrMask", ERR_MASK},
-    {"FifoFullCounter0", FIFO_FULL_CTR_1},
-    {"FifoFullCounter1", FIFO_FULL_CTR_2},
-    {"FifoFullCounter2", FIFO_FULL_CTR_3},
-    {"FifoFullCounter3", FIFO_FULL_CTR_4},
-    {"GlobalPulseRt", GLOBAL_PULSE_RT},
-    {"GpLvdsRoute", GP_LVDS_ROUTE},
-    {"HitOr0MaskDiff0", HITOR_MASK_DIFF_11},
-    {"HitOr0MaskDiff1", HITOR_MASK_DIFF_12},
-    {"HitOr0MaskLin0", HITOR_MASK_LIN_11},
-    {"HitOr0MaskLin1", HITOR_MASK_LIN_12},
-    {"HitOr0MaskSync", HITOR_MASK_SYNC_1},
-    {"HitOr1MaskDiff0", HITOR_MASK_DIFF_21},
-    {"HitOr1MaskDiff1", HITOR_MASK_DIFF_22},
-    {"HitOr1MaskLin0", HITOR_MASK_LIN_21},
-    {"HitOr1MaskLin1", HITOR_MASK_LIN_22},
-    {"HitOr1MaskSync", HITOR_MASK_SYNC_2},
-    {"HitOr2MaskDiff0", HITOR_MASK_DIFF_31},
-    {"HitOr2MaskDiff1", HITOR_MASK_DIFF_32},
-    {"HitOr2MaskLin0", HITOR_MASK_LIN_31},
-    {"HitOr2MaskLin1", HITOR_MASK_LIN_32},
-    {"HitOr2MaskSync", HITOR_MASK_SYNC_3},
-    {"HitOr3MaskDiff0", HITOR_MASK_DIFF_41},
-    {"HitOr3MaskDiff1", HITOR_MASK_DIFF_42},
-    {"HitOr3MaskLin0", HITOR_MASK_LIN_41},
-    {"HitOr3MaskLin1", HITOR_MASK_LIN_42},
-    {"HitOr3MaskSync", HITOR_MASK_SYNC_4},
-    {"HitOrCounter0", HITOR_CNT_1},
-    {"HitOrCounter1", HITOR_CNT_2},
-    {"HitOrCounter2", HITOR_CNT_3},
-    {"HitOrCounter3", HITOR_CNT_4},
-    {"InjAnaMode", INJ_MODE_ANA},
-    {"InjDelay", INJ_FINE_DELAY},
-    {"InjEnDig", INJ_MODE_DIG},
-    {"InjVcalHigh", VCAL_HIGH},
-    {"InjVcalMed", VCAL_MED},
-    {"LatencyConfig", LATENCY_CONFIG},
-    {"LinComp", COMP_LIN},
-    {"LinFcBias", FC_BIAS_LIN},
-    {"LinKrumCurr", KRUM_CURR_LIN},
-    {"LinLdac", LDAC_LIN},
-    {"LinPaInBias", PA_IN_BIAS_LIN},
-    {"LinRefKrum", REF_KRUM_LIN},
-    {"LinVth", VTH_LIN},
-    {"LockLossCounter", LCK_LOSS_CTR},
-    {"MonFrameSkip", MON_FRAME_SKIP},
-    {"MonitorEnable", MONITOR_EN},
-    {"MonitorImonMux", MONITOR_IMON_MUX},
-    {"MonitorVmonMux", MONITOR_VMON_MUX},
-    {"OutPadConfig", OUT_PAD_CONFIG},
-    {"OutputActiveLanes", OUT_ACTIVE_LANES},
-    {"OutputDataReadDelay", OUT_DATA_DELAY},
-    {"OutputFmt", OUT_FORMAT},
-    {"OutputSerType", OUT_SERIAL_TYPE},
-    {"PixAutoCol", PIX_AUTO_COL},
-    {"PixAutoRow", PIX_AUTO_ROW},
-    {"PixBroadcastEn", PIX_BCAST_EN},
-    {"PixBroadcastMask", PIX_BCAST_MASK},
-    {"PixDefaultConfig", PIX_DEFAULT_CONFIG},
-    {"PixPortal", PIX_PORTAL},
-    {"PixRegionCol", REGION_COL},
-    {"PixRegionRow", REGION_ROW},
-    {"RingOsc0", RING_OSC_1},
-    {"RingOsc1", RING_OSC_2},
-    {"RingOsc2", RING_OSC_3},
-    {"RingOsc3", RING_OSC_4},
-    {"RingOsc4", RING_OSC_5},
-    {"RingOsc5", RING_OSC_6},
-    {"RingOsc6", RING_OSC_7},
-    {"RingOsc7", RING_OSC_8},
-    {"RingOscEn", RING_OSC_ENABLE},
-    {"SelfTrigEn", SELF_TRIG_EN},
-    {"SensorCfg0", SENSOR_CONFIG_0},
-    {"SensorCfg1", SENSOR_CONFIG_1},
-    {"SensorBias0", SENSOR_BIAS_0},
-    {"SensorBias1", SENSOR_BIAS_1},
-    {"SensorBias2", SENSOR_BIAS_2},
-    {"SensorBias3", SENSOR_BIAS_3},
-    {"SensorCurrent0",SENSOR_CURRENT_0},
-    {"SensorCurrent1",SENSOR_CURRENT_1},
-    {"SensorCurrent2",SENSOR_CURRENT_2},
-    {"SensorCurrent3",SENSOR_CURRENT_3},
-    {"SensorEnable0",SENSOR_ENABLE_0},
-    {"SensorEnable1",SENSOR_ENABLE_1},
-    {"SensorEnable2",SENSOR_ENABLE_2},
-    {"SensorEnable3",SENSOR_ENABLE_3},
-    {"SerSelOut0", SER_SEL_OUT_0},
-    {"SerSelOut1", SER_SEL_OUT_1},
-    {"SerSelOut2", SER_SEL_OUT_2},
-    {"SerSelOut3", SER_SEL_OUT_3},
-    {"SkipTriggerCounter", SKP_TRIG_CNT},
-    {"SldoAnalogTrim", SLDO_ANALOG_TRIM},
-    {"SldoDigitalTrim", SLDO_DIGITAL_TRIM},
-    {"SyncAutoZero", AUTO_ZERO},
-    {"SyncFastTot", FAST_TOT},
-    {"SyncIbiasDisc", IBIAS_DISC_SYNC},
-    {"SyncIbiasKrum", IBIAS_KRUM_SYNC},
-    {"SyncIbiasSf", IBIAS_SF_SYNC},
-    {"SyncIbiasp1", IBIASP1_SYNC},
-    {"SyncIbiasp2", IBIASP2_SYNC},
-    {"SyncIctrlSynct", ICTRL_SYNCT_SYNC},
-    {"SyncSelC2F", SEL_C2F},
-    {"SyncSelC4F", SEL_C4F},
-    {"SyncVbl", VBL_SYNC},
-    {"SyncVrefKrum", VREF_KRUM_SYNC},
-    {"SyncVth", VTH_SYNC},
-    {"TrigCounter", TRIG_CTR},
-    {"VcoBuffBias", VCO_BUFF_BIAS},
-    {"VcoIbias", VCO_IBIAS},
-    {"WrSyncDelaySync", WR_SYNC_DELAY_SYNC}
+namespace{
+
+/**
+ * Layout of every Field, indexed by Configuration::FieldType.
+ * Address, first bit, length, default value, reversed.
+ * The fields that have no bits in the RD53A have length 0.
+ * The default register values are built from this table in order.
+ **/
+constexpr Field::Layout layouts[Configuration::NONE+1] = {
+  {  0, 0,16,     0,false}, //PIX_PORTAL
+  {  1, 0, 8,     0,false}, //REGION_COL
+  {  2, 0, 9,     0,false}, //REGION_ROW
+  {  3, 3, 3,     0,false}, //PIX_MODE
+  {  3, 5, 1,     0,false}, //PIX_BCAST_EN
+  {  3, 4, 1,     0,false}, //PIX_AUTO_COL
+  {  3, 3, 1,     0,false}, //PIX_AUTO_ROW
+  {  3, 0, 3,     0,false}, //PIX_BCAST_MASK
+  {  4, 0,16,0x9CE2,false}, //PIX_DEFAULT_CONFIG
+  {  5, 0,16,   100,false}, //IBIASP1_SYNC
+  {  6, 0,16,   150,false}, //IBIASP2_SYNC
+  {  7, 0,16,   100,false}, //IBIAS_SF_SYNC
+  {  8, 0,16,   140,false}, //IBIAS_KRUM_SYNC
+  {  9, 0,16,   200,false}, //IBIAS_DISC_SYNC
+  { 10, 0,16,   100,false}, //ICTRL_SYNCT_SYNC
+  { 11, 0,16,   450,false}, //VBL_SYNC
+  { 12, 0,16,   300,false}, //VTH_SYNC
+  { 13, 0,16,   490,false}, //VREF_KRUM_SYNC
+  { 30, 3, 1,     0,false}, //AUTO_ZERO
+  { 30, 2, 1,     1,false}, //SEL_C2F
+  { 30, 1, 1,     0,false}, //SEL_C4F
+  { 30, 0, 1,     0,false}, //FAST_TOT
+  { 14, 0, 9,   300,false}, //PA_IN_BIAS_LIN
+  { 15, 0, 8,    20,false}, //FC_BIAS_LIN
+  { 16, 0, 9,    50,false}, //KRUM_CURR_LIN
+  { 17, 0,10,    80,false}, //LDAC_LIN
+  { 18, 0, 9,   110,false}, //COMP_LIN
+  { 19, 0,10,   300,false}, //REF_KRUM_LIN
+  { 20, 0,10,   408,false}, //VTH_LIN
+  { 21, 0,10,   533,false}, //PRMP_DIFF
+  { 22, 0,10,   542,false}, //FOL_DIFF
+  { 23, 0,10,   551,false}, //PRECOMP_DIFF
+  { 24, 0,10,   528,false}, //COMP_DIFF
+  { 25, 0,10,   164,false}, //VFF_DIFF
+  { 26, 0,10,  1023,false}, //VTH1_DIFF
+  { 27, 0,10,     0,false}, //VTH2_DIFF
+  { 28, 0,10,    20,false}, //LCC_DIFF
+  { 29, 1, 1,     1,false}, //LCC_EN
+  { 29, 0, 1,     0,false}, //DIFF_FB_CAP_EN
+  { 31, 5, 5,    16,false}, //SLDO_ANALOG_TRIM
+  { 31, 0, 5,    16,false}, //SLDO_DIGITAL_TRIM
+  { 32, 0,16,  0xFF,false}, //EN_CORE_COL_SYNC
+  { 33, 0,16,  0xFF,false}, //EN_CORE_COL_LIN_1
+  { 34, 0, 1,     1,false}, //EN_CORE_COL_LIN_2
+  { 35, 0,16,  0xFF,false}, //EN_CORE_COL_DIFF_1
+  { 36, 0, 1,     1,false}, //EN_CORE_COL_DIFF_2
+  { 37, 0, 9,   500,false}, //LATENCY_CONFIG
+  { 38, 0, 5,    16,false}, //WR_SYNC_DELAY_SYNC
+  { 39, 5, 1,     0,false}, //INJ_MODE_ANA
+  { 39, 4, 1,     1,false}, //INJ_MODE_DIG
+  { 39, 0, 4,     0,false}, //INJ_FINE_DELAY
+  { 41, 0,12,   500,false}, //VCAL_HIGH
+  { 42, 0,12,   300,false}, //VCAL_MED
+  { 46, 0,16,0xFFFF,false}, //CAL_COLPR_SYNC_1
+  { 47, 0,16,0xFFFF,false}, //CAL_COLPR_SYNC_2
+  { 48, 0,16,0xFFFF,false}, //CAL_COLPR_SYNC_3
+  { 49, 0,16,0xFFFF,false}, //CAL_COLPR_SYNC_4
+  { 50, 0,16,0xFFFF,false}, //CAL_COLPR_LIN_1
+  { 51, 0,16,0xFFFF,false}, //CAL_COLPR_LIN_2
+  { 52, 0,16,0xFFFF,false}, //CAL_COLPR_LIN_3
+  { 53, 0,16,0xFFFF,false}, //CAL_COLPR_LIN_4
+  { 54, 0, 4,   0xF,false}, //CAL_COLPR_LIN_5
+  { 55, 0,16,0xFFFF,false}, //CAL_COLPR_DIFF_1
+  { 56, 0,16,0xFFFF,false}, //CAL_COLPR_DIFF_2
+  { 57, 0,16,0xFFFF,false}, //CAL_COLPR_DIFF_3
+  { 58, 0,16,0xFFFF,false}, //CAL_COLPR_DIFF_4
+  { 59, 0, 4,   0xF,false}, //CAL_COLPR_DIFF_5
+  { 40, 0, 9,     0,false}, //CLK_DATA_DELAY
+  { 40, 8, 1,     0,false}, //CLK_DELAY
+  { 40, 4, 4,     0,false}, //CLK_DELAY_SEL
+  { 40, 0, 4,     0,false}, //CMD_DELAY
+  { 43, 0,11,     0,false}, //CH_SYNC_CONF
+  { 43,10, 1,     0,false}, //CH_SYNC_PHASE
+  { 43, 5, 5,     0,false}, //CH_SYNC_LOCK
+  { 43, 0, 5,     0,false}, //CH_SYNC_UNLOCK
+  { 44, 0,16,     0,false}, //GLOBAL_PULSE_RT
+  { 60, 0, 2,     0,false}, //DEBUG_CONFIG
+  {  0, 0, 0,     0,false}, //ENABLE_EXT_CAL
+  { 61, 7, 2,     0,false}, //OUT_DATA_DELAY
+  { 61, 6, 1,     0,false}, //OUT_SERIAL_TYPE
+  { 61, 2, 4,     1,false}, //OUT_ACTIVE_LANES
+  { 61, 0, 1,     0,false}, //OUT_FORMAT
+  { 62, 0,14,     0,false}, //OUT_PAD_CONFIG
+  { 63, 0, 3,     0,false}, //GP_LVDS_ROUTE
+  { 64, 0,14,     0,false}, //CDR_CONFIG
+  { 65, 0,10,     0,false}, //VCO_BUFF_BIAS
+  { 66, 0,10,     0,false}, //CDR_CP_IBIAS
+  { 67, 0,14,     0,false}, //VCO_IBIAS
+  { 68, 0, 8,     0,false}, //SER_SEL_OUT
+  {  0, 0, 0,     0,false}, //SER_SEL_OUT_3
+  {  0, 0, 0,     0,false}, //SER_SEL_OUT_2
+  {  0, 0, 0,     0,false}, //SER_SEL_OUT_1
+  {  0, 0, 0,     0,false}, //SER_SEL_OUT_0
+  { 69, 0, 8,   0xF,false}, //CML_CONFIG
+  { 69, 6, 2,     0,false}, //CML_INV_TAP
+  { 69, 4, 2,     0,false}, //CML_EN_TAP
+  { 69, 0, 4,   0xF,false}, //CML_EN
+  { 70, 0,10,   500,false}, //CML_TAP_BIAS_1
+  { 71, 0,10,     0,false}, //CML_TAP_BIAS_2
+  { 72, 0,10,     0,false}, //CML_TAP_BIAS_3
+  { 73, 0, 8,   103,false}, //AURORA_CC_CFG
+  { 73, 2, 6,    25,false}, //AURORA_CC_WAIT
+  { 73, 0, 2,     3,false}, //AURORA_CC_SEND
+  { 74, 0, 8,    60,false}, //AURORA_CB_CFG_1
+  { 74, 4, 4,    15,false}, //AURORA_CB_WAIT_1
+  { 74, 0, 4,     0,false}, //AURORA_CB_SEND
+  { 75, 0,16,    60,false}, //AURORA_CB_CFG_0
+  { 75, 0,16,    15,false}, //AURORA_CB_WAIT_0
+  { 76, 0,16,    32,false}, //AURORA_INIT_WAIT
+  { 45, 0, 8,    50,false}, //MON_FRAME_SKIP
+  {101, 0, 8,   136,false}, //AUTO_READ_A0
+  {102, 0, 8,   130,false}, //AUTO_READ_B0
+  {103, 0, 8,   118,false}, //AUTO_READ_A1
+  {104, 0, 8,   119,false}, //AUTO_READ_B1
+  {105, 0, 8,   120,false}, //AUTO_READ_A2
+  {106, 0, 8,   121,false}, //AUTO_READ_B2
+  {107, 0, 8,   122,false}, //AUTO_READ_A3
+  {108, 0, 8,   123,false}, //AUTO_READ_B3
+  {  0, 0, 0,     0,false}, //MONITOR_MUX
+  {  0, 0, 0,     0,false}, //MONITOR_EN
+  {  0, 0, 0,     0,false}, //MONITOR_IMON_MUX
+  { 77, 0,16,     0,false}, //MONITOR_VMON_MUX
+  { 78, 0,16,     0,false}, //HITOR_MASK_SYNC_1
+  { 79, 0,16,     0,false}, //HITOR_MASK_SYNC_2
+  { 80, 0,16,     0,false}, //HITOR_MASK_SYNC_3
+  { 81, 0,16,     0,false}, //HITOR_MASK_SYNC_4
+  { 82, 0,16,     0,false}, //HITOR_MASK_LIN_11
+  { 83, 0, 1,     0,false}, //HITOR_MASK_LIN_12
+  { 84, 0,16,     0,false}, //HITOR_MASK_LIN_21
+  { 85, 0, 1,     0,false}, //HITOR_MASK_LIN_22
+  { 86, 0,16,     0,false}, //HITOR_MASK_LIN_31
+  { 87, 0, 1,     0,false}, //HITOR_MASK_LIN_32
+  { 88, 0,16,     0,false}, //HITOR_MASK_LIN_41
+  { 89, 0, 1,     0,false}, //HITOR_MASK_LIN_42
+  { 90, 0,16,     0,false}, //HITOR_MASK_DIFF_11
+  { 91, 0, 1,     0,false}, //HITOR_MASK_DIFF_12
+  { 92, 0,16,     0,false}, //HITOR_MASK_DIFF_21
+  { 93, 0, 1,     0,false}, //HITOR_MASK_DIFF_22
+  { 94, 0,16,     0,false}, //HITOR_MASK_DIFF_31
+  { 95, 0, 1,     0,false}, //HITOR_MASK_DIFF_32
+  { 96, 0,16,     0,false}, //HITOR_MASK_DIFF_41
+  { 97, 0, 1,     0,false}, //HITOR_MASK_DIFF_42
+  {  0, 0, 0,     0,false}, //ADC_CONFIG
+  { 98, 6, 5,     0,false}, //BANDGAP_TRIM
+  { 98, 0, 6,     0,false}, //ADC_TRIM
+  { 99, 0,16,     0,false}, //SENSOR_CONFIG_0
+  { 99, 0, 1,     0,false}, //SENSOR_BIAS_0
+  { 99, 1, 4,     0,false}, //SENSOR_CURRENT_0
+  { 99, 5, 1,     0,false}, //SENSOR_ENABLE_0
+  { 99, 6, 1,     0,false}, //SENSOR_BIAS_1
+  { 99, 7, 4,     0,false}, //SENSOR_CURRENT_1
+  { 99,11, 1,     0,false}, //SENSOR_ENABLE_1
+  {100, 0,16,     0,false}, //SENSOR_CONFIG_1
+  {100, 0, 1,     0,false}, //SENSOR_BIAS_2
+  {100, 1, 4,     0,false}, //SENSOR_CURRENT_2
+  {100, 5, 1,     0,false}, //SENSOR_ENABLE_2
+  {100, 6, 1,     0,false}, //SENSOR_BIAS_3
+  {100, 7, 4,     0,false}, //SENSOR_CURRENT_3
+  {100,11, 1,     0,false}, //SENSOR_ENABLE_3
+  {109, 0, 8,     0,false}, //RING_OSC_ENABLE
+  {110, 0,16,     0,false}, //RING_OSC_1
+  {111, 0,16,     0,false}, //RING_OSC_2
+  {112, 0,16,     0,false}, //RING_OSC_3
+  {113, 0,16,     0,false}, //RING_OSC_4
+  {114, 0,16,     0,false}, //RING_OSC_5
+  {115, 0,16,     0,false}, //RING_OSC_6
+  {116, 0,16,     0,false}, //RING_OSC_7
+  {117, 0,16,     0,false}, //RING_OSC_8
+  {118, 0,16,     0,false}, //BC_CTR
+  {119, 0,16,     0,false}, //TRIG_CTR
+  {120, 0,16,     0,false}, //LCK_LOSS_CTR
+  {121, 0,16,     0,false}, //BFLIP_WARN_CTR
+  {122, 0,16,     0,false}, //BFLIP_ERR_CTR
+  {123, 0,16,     0,false}, //CMD_ERR_CTR
+  {124, 8, 8,     0,false}, //FIFO_FULL_CTR_1
+  {124, 0, 8,     0,false}, //FIFO_FULL_CTR_2
+  {125, 8, 8,     0,false}, //FIFO_FULL_CTR_3
+  {125, 0, 8,     0,false}, //FIFO_FULL_CTR_4
+  {126, 8, 8,     0,false}, //FIFO_FULL_CTR_5
+  {126, 0, 8,     0,false}, //FIFO_FULL_CTR_6
+  {127, 8, 8,     0,false}, //FIFO_FULL_CTR_7
+  {127, 0, 8,     0,false}, //FIFO_FULL_CTR_8
+  {128, 0, 8,     0,false}, //AI_PIX_COL
+  {129, 0, 9,     0,false}, //AI_PIX_ROW
+  {130, 0,16,     0,false}, //HITOR_CNT_1
+  {131, 0,16,     0,false}, //HITOR_CNT_2
+  {132, 0,16,     0,false}, //HITOR_CNT_3
+  {133, 0,16,     0,false}, //HITOR_CNT_4
+  {134, 0,16,     0,false}, //SKP_TRIG_CNT
+  {135, 0,14,     0,false}, //ERR_MASK
+  {136, 0,16,     0,false}, //ADC_READ
+  {137, 0,16,     0,false}, //SELF_TRIG_EN
+  {  0, 0, 0,     0,false}  //NONE
 };
 
-Configuration::Configuration(){
+/**
+ * Field names as in the YARR configuration files
+ **/
+struct FieldName{
+  const char * name;
+  uint32_t field;
+  bool listed;  /**< Written by Configuration::GetRegisters */
+  bool ignored; /**< Not read nor written, EJS 2020-10-27, let's ignore it for now */
+};
 
-  m_verbose = 1;
+constexpr FieldName fieldnames[] = {
+  {"AdcRead",             Configuration::ADC_READ,               true, false},
+  {"AdcRefTrim",          Configuration::ADC_TRIM,               true, false},
+  {"AdcTrim",             Configuration::ADC_TRIM,               true, false},
+  {"AiPixCol",            Configuration::AI_PIX_COL,             true, false},
+  {"AiPixRow",            Configuration::AI_PIX_ROW,             true, false},
+  {"AuroraCbSend",        Configuration::AURORA_CB_SEND,         true, false},
+  {"AuroraCbWaitHigh",    Configuration::AURORA_CB_WAIT_1,       true, false},
+  {"AuroraCbWaitLow",     Configuration::AURORA_CB_WAIT_0,       true, false},
+  {"AuroraCcSend",        Configuration::AURORA_CC_SEND,         true, false},
+  {"AuroraCcWait",        Configuration::AURORA_CC_WAIT,         true, false},
+  {"AuroraInitWait",      Configuration::AURORA_INIT_WAIT,       true, false},
+  {"AutoReadA0",          Configuration::AUTO_READ_A0,           true, false},
+  {"AutoReadA1",          Configuration::AUTO_READ_A1,           true, false},
+  {"AutoReadA2",          Configuration::AUTO_READ_A2,           true, false},
+  {"AutoReadA3",          Configuration::AUTO_READ_A3,           true, false},
+  {"AutoReadB0",          Configuration::AUTO_READ_B0,           true, false},
+  {"AutoReadB1",          Configuration::AUTO_READ_B1,           true, false},
+  {"AutoReadB2",          Configuration::AUTO_READ_B2,           true, false},
+  {"AutoReadB3",          Configuration::AUTO_READ_B3,           true, false},
+  {"BcCounter",           Configuration::BC_CTR,                 true, false},
+  {"BflipErrCounter",     Configuration::BFLIP_ERR_CTR,          true, false},
+  {"BflipWarnCounter",    Configuration::BFLIP_WARN_CTR,         true, false},
+  {"CalColprDiff1",       Configuration::CAL_COLPR_DIFF_1,       true, false},
+  {"CalColprDiff2",       Configuration::CAL_COLPR_DIFF_2,       true, false},
+  {"CalColprDiff3",       Configuration::CAL_COLPR_DIFF_3,       true, false},
+  {"CalColprDiff4",       Configuration::CAL_COLPR_DIFF_4,       true, false},
+  {"CalColprDiff5",       Configuration::CAL_COLPR_DIFF_5,       true, false},
+  {"CalColprLin1",        Configuration::CAL_COLPR_LIN_1,        true, false},
+  {"CalColprLin2",        Configuration::CAL_COLPR_LIN_2,        true, false},
+  {"CalColprLin3",        Configuration::CAL_COLPR_LIN_3,        true, false},
+  {"CalColprLin4",        Configuration::CAL_COLPR_LIN_4,        true, false},
+  {"CalColprLin5",        Configuration::CAL_COLPR_LIN_5,        true, false},
+  {"CalColprSync1",       Configuration::CAL_COLPR_SYNC_1,       true, false},
+  {"CalColprSync2",       Configuration::CAL_COLPR_SYNC_2,       true, false},
+  {"CalColprSync3",       Configuration::CAL_COLPR_SYNC_3,       true, false},
+  {"CalColprSync4",       Configuration::CAL_COLPR_SYNC_4,       true, false},
+  {"CdrCpIbias",          Configuration::CDR_CP_IBIAS,           true, false},
+  {"CdrEnGck",            Configuration::CDR_CONFIG,             true, false},
+  {"CdrPdDel",            Configuration::CDR_CONFIG,             true, false},
+  {"CdrPdSel",            Configuration::CDR_CONFIG,             true, false},
+  {"CdrSelDelClk",        Configuration::CDR_CONFIG,             true, false},
+  {"CdrSelSerClk",        Configuration::CDR_CONFIG,             true, false},
+  {"CdrVcoGain",          Configuration::CDR_CONFIG,             true, false},
+  {"ChSyncLock",          Configuration::CH_SYNC_LOCK,           true, false},
+  {"ChSyncPhase",         Configuration::CH_SYNC_PHASE,          true, false},
+  {"ChSyncUnlock",        Configuration::CH_SYNC_UNLOCK,         true, false},
+  {"ClkDelay",            Configuration::CLK_DELAY,              true, false},
+  {"ClkDelaySel",         Configuration::CLK_DELAY_SEL,          true, false},
+  {"CmdDelay",            Configuration::CMD_DELAY,              true, false},
+  {"CmdErrCounter",       Configuration::CMD_ERR_CTR,            true, false},
+  {"CmlEn",               Configuration::CML_EN,                 true, false},
+  {"CmlEnTap",            Configuration::CML_EN_TAP,             true, false},
+  {"CmlInvTap",           Configuration::CML_INV_TAP,            true, false},
+  {"CmlTapBias0",         Configuration::CML_TAP_BIAS_1,         true, false},
+  {"CmlTapBias1",         Configuration::CML_TAP_BIAS_2,         true, false},
+  {"CmlTapBias2",         Configuration::CML_TAP_BIAS_3,         true, false},
+  {"DebugConfig",         Configuration::DEBUG_CONFIG,           true, false},
+  {"DiffComp",            Configuration::COMP_DIFF,              true, false},
+  {"DiffFbCapEn",         Configuration::DIFF_FB_CAP_EN,         true, false},
+  {"DiffFol",             Configuration::FOL_DIFF,               true, false},
+  {"DiffLcc",             Configuration::LCC_DIFF,               true, false},
+  {"DiffLccEn",           Configuration::LCC_EN,                 true, false},
+  {"DiffPrecomp",         Configuration::PRECOMP_DIFF,           true, false},
+  {"DiffPrmp",            Configuration::PRMP_DIFF,              true, false},
+  {"DiffVff",             Configuration::VFF_DIFF,               true, false},
+  {"DiffVth1",            Configuration::VTH1_DIFF,              true, false},
+  {"DiffVth2",            Configuration::VTH2_DIFF,              true, false},
+  {"EnCoreColDiff1",      Configuration::EN_CORE_COL_DIFF_1,     true, false},
+  {"EnCoreColDiff2",      Configuration::EN_CORE_COL_DIFF_2,     true, false},
+  {"EnCoreColLin1",       Configuration::EN_CORE_COL_LIN_1,      true, false},
+  {"EnCoreColLin2",       Configuration::EN_CORE_COL_LIN_2,      true, false},
+  {"EnCoreColSync",       Configuration::EN_CORE_COL_SYNC,       true, false},
+  {"ErrMask",             Configuration::ERR_MASK,               true, false},
+  {"FifoFullCounter0",    Configuration::FIFO_FULL_CTR_1,        true, false},
+  {"FifoFullCounter1",    Configuration::FIFO_FULL_CTR_2,        true, false},
+  {"FifoFullCounter2",    Configuration::FIFO_FULL_CTR_3,        true, false},
+  {"FifoFullCounter3",    Configuration::FIFO_FULL_CTR_4,        true, false},
+  {"GlobalPulseRt",       Configuration::GLOBAL_PULSE_RT,        true, false},
+  {"GpLvdsRoute",         Configuration::GP_LVDS_ROUTE,          true, false},
+  {"HitOr0MaskDiff0",     Configuration::HITOR_MASK_DIFF_11,     true, false},
+  {"HitOr0MaskDiff1",     Configuration::HITOR_MASK_DIFF_12,     true, false},
+  {"HitOr0MaskLin0",      Configuration::HITOR_MASK_LIN_11,      true, false},
+  {"HitOr0MaskLin1",      Configuration::HITOR_MASK_LIN_12,      true, false},
+  {"HitOr0MaskSync",      Configuration::HITOR_MASK_SYNC_1,      true, false},
+  {"HitOr1MaskDiff0",     Configuration::HITOR_MASK_DIFF_21,     true, false},
+  {"HitOr1MaskDiff1",     Configuration::HITOR_MASK_DIFF_22,     true, false},
+  {"HitOr1MaskLin0",      Configuration::HITOR_MASK_LIN_21,      true, false},
+  {"HitOr1MaskLin1",      Configuration::HITOR_MASK_LIN_22,      true, false},
+  {"HitOr1MaskSync",      Configuration::HITOR_MASK_SYNC_2,      true, false},
+  {"HitOr2MaskDiff0",     Configuration::HITOR_MASK_DIFF_31,     true, false},
+  {"HitOr2MaskDiff1",     Configuration::HITOR_MASK_DIFF_32,     true, false},
+  {"HitOr2MaskLin0",      Configuration::HITOR_MASK_LIN_31,      true, false},
+  {"HitOr2MaskLin1",      Configuration::HITOR_MASK_LIN_32,      true, false},
+  {"HitOr2MaskSync",      Configuration::HITOR_MASK_SYNC_3,      true, false},
+  {"HitOr3MaskDiff0",     Configuration::HITOR_MASK_DIFF_41,     true, false},
+  {"HitOr3MaskDiff1",     Configuration::HITOR_MASK_DIFF_42,     true, false},
+  {"HitOr3MaskLin0",      Configuration::HITOR_MASK_LIN_41,      true, false},
+  {"HitOr3MaskLin1",      Configuration::HITOR_MASK_LIN_42,      true, false},
+  {"HitOr3MaskSync",      Configuration::HITOR_MASK_SYNC_4,      true, false},
+  {"HitOrCounter0",       Configuration::HITOR_CNT_1,            true, false},
+  {"HitOrCounter1",       Configuration::HITOR_CNT_2,            true, false},
+  {"HitOrCounter2",       Configuration::HITOR_CNT_3,            true, false},
+  {"HitOrCounter3",       Configuration::HITOR_CNT_4,            true, false},
+  {"InjAnaMode",          Configuration::INJ_MODE_ANA,           true, false},
+  {"InjDelay",            Configuration::INJ_FINE_DELAY,         true, false},
+  {"InjEnDig",            Configuration::INJ_MODE_DIG,           true, false},
+  {"InjVcalDiff",         Configuration::NONE,                   true, true},
+  {"InjVcalHigh",         Configuration::VCAL_HIGH,              true, false},
+  {"InjVcalMed",          Configuration::VCAL_MED,               true, false},
+  {"LatencyConfig",       Configuration::LATENCY_CONFIG,         true, false},
+  {"LinComp",             Configuration::COMP_LIN,               true, false},
+  {"LinFcBias",           Configuration::FC_BIAS_LIN,            true, false},
+  {"LinKrumCurr",         Configuration::KRUM_CURR_LIN,          true, false},
+  {"LinLdac",             Configuration::LDAC_LIN,               true, false},
+  {"LinPaInBias",         Configuration::PA_IN_BIAS_LIN,         true, false},
+  {"LinRefKrum",          Configuration::REF_KRUM_LIN,           true, false},
+  {"LinVth",              Configuration::VTH_LIN,                true, false},
+  {"LockLossCounter",     Configuration::LCK_LOSS_CTR,           true, false},
+  {"MonFrameSkip",        Configuration::MON_FRAME_SKIP,         true, false},
+  {"MonitorEnable",       Configuration::MONITOR_EN,             true, true},
+  {"MonitorImonMux",      Configuration::MONITOR_IMON_MUX,       true, true},
+  {"MonitorVmonMux",      Configuration::MONITOR_VMON_MUX,       true, true},
+  {"OutPadConfig",        Configuration::OUT_PAD_CONFIG,         true, false},
+  {"OutputActiveLanes",   Configuration::OUT_ACTIVE_LANES,       true, false},
+  {"OutputDataReadDelay", Configuration::OUT_DATA_DELAY,         true, false},
+  {"OutputFmt",           Configuration::OUT_FORMAT,             true, false},
+  {"OutputSerType",       Configuration::OUT_SERIAL_TYPE,        true, false},
+  {"PixAutoCol",          Configuration::PIX_AUTO_COL,           true, false},
+  {"PixAutoRow",          Configuration::PIX_AUTO_ROW,           true, false},
+  {"PixBroadcastEn",      Configuration::PIX_BCAST_EN,           true, false},
+  {"PixBroadcastMask",    Configuration::PIX_BCAST_MASK,         true, false},
+  {"PixDefaultConfig",    Configuration::PIX_DEFAULT_CONFIG,     true, false},
+  {"PixPortal",           Configuration::PIX_PORTAL,             true, false},
+  {"PixRegionCol",        Configuration::REGION_COL,             true, false},
+  {"PixRegionRow",        Configuration::REGION_ROW,             true, false},
+  {"RingOsc0",            Configuration::RING_OSC_1,             true, false},
+  {"RingOsc1",            Configuration::RING_OSC_2,             true, false},
+  {"RingOsc2",            Configuration::RING_OSC_3,             true, false},
+  {"RingOsc3",            Configuration::RING_OSC_4,             true, false},
+  {"RingOsc4",            Configuration::RING_OSC_5,             true, false},
+  {"RingOsc5",            Configuration::RING_OSC_6,             true, false},
+  {"RingOsc6",            Configuration::RING_OSC_7,             true, false},
+  {"RingOsc7",            Configuration::RING_OSC_8,             true, false},
+  {"RingOscEn",           Configuration::RING_OSC_ENABLE,        true, false},
+  {"SelfTrigEn",          Configuration::SELF_TRIG_EN,           true, false},
+  {"SensorBias0",         Configuration::SENSOR_BIAS_0,          false, false},
+  {"SensorBias1",         Configuration::SENSOR_BIAS_1,          false, false},
+  {"SensorBias2",         Configuration::SENSOR_BIAS_2,          false, false},
+  {"SensorBias3",         Configuration::SENSOR_BIAS_3,          false, false},
+  {"SensorCfg0",          Configuration::SENSOR_CONFIG_0,        true, false},
+  {"SensorCfg1",          Configuration::SENSOR_CONFIG_1,        true, false},
+  {"SensorCurrent0",      Configuration::SENSOR_CURRENT_0,       false, false},
+  {"SensorCurrent1",      Configuration::SENSOR_CURRENT_1,       false, false},
+  {"SensorCurrent2",      Configuration::SENSOR_CURRENT_2,       false, false},
+  {"SensorCurrent3",      Configuration::SENSOR_CURRENT_3,       false, false},
+  {"SensorEnable0",       Configuration::SENSOR_ENABLE_0,        false, false},
+  {"SensorEnable1",       Configuration::SENSOR_ENABLE_1,        false, false},
+  {"SensorEnable2",       Configuration::SENSOR_ENABLE_2,        false, false},
+  {"SensorEnable3",       Configuration::SENSOR_ENABLE_3,        false, false},
+  {"SerSelOut0",          Configuration::SER_SEL_OUT_0,          true, true},
+  {"SerSelOut1",          Configuration::SER_SEL_OUT_1,          true, true},
+  {"SerSelOut2",          Configuration::SER_SEL_OUT_2,          true, true},
+  {"SerSelOut3",          Configuration::SER_SEL_OUT_3,          true, true},
+  {"SkipTriggerCounter",  Configuration::SKP_TRIG_CNT,           true, false},
+  {"SldoAnalogTrim",      Configuration::SLDO_ANALOG_TRIM,       true, false},
+  {"SldoDigitalTrim",     Configuration::SLDO_DIGITAL_TRIM,      true, false},
+  {"SyncAutoZero",        Configuration::AUTO_ZERO,              true, false},
+  {"SyncFastTot",         Configuration::FAST_TOT,               true, false},
+  {"SyncIbiasDisc",       Configuration::IBIAS_DISC_SYNC,        true, false},
+  {"SyncIbiasKrum",       Configuration::IBIAS_KRUM_SYNC,        true, false},
+  {"SyncIbiasSf",         Configuration::IBIAS_SF_SYNC,          true, false},
+  {"SyncIbiasp1",         Configuration::IBIASP1_SYNC,           true, false},
+  {"SyncIbiasp2",         Configuration::IBIASP2_SYNC,           true, false},
+  {"SyncIctrlSynct",      Configuration::ICTRL_SYNCT_SYNC,       true, false},
+  {"SyncSelC2F",          Configuration::SEL_C2F,                true, false},
+  {"SyncSelC4F",          Configuration::SEL_C4F,                true, false},
+  {"SyncVbl",             Configuration::VBL_SYNC,               true, false},
+  {"SyncVrefKrum",        Configuration::VREF_KRUM_SYNC,         true, false},
+  {"SyncVth",             Configuration::VTH_SYNC,               true, false},
+  {"TrigCounter",         Configuration::TRIG_CTR,               true, false},
+  {"VcoBuffBias",         Configuration::VCO_BUFF_BIAS,          true, false},
+  {"VcoIbias",            Configuration::VCO_IBIAS,              true, false},
+  {"WrSyncDelaySync",     Configuration::WR_SYNC_DELAY_SYNC,     true, false}
+};
+
+const uint32_t NUM_NAMES = sizeof(fieldnames)/sizeof(FieldName);
+const uint32_t NUM_SLOTS = 4096;
+const uint32_t NO_SEED = 0xFFFFFFFF;
+const uint8_t NO_NAME = 0xFF;
+
+static_assert(NUM_NAMES<NO_NAME, "Too many field names for the name hash");
+
+/**
+ * Default register values and updated flags, built from the Field layouts
+ **/
+struct Defaults{
+  uint16_t values[Configuration::NUM_REGISTERS];
+  uint64_t updated[(Configuration::NUM_REGISTERS+63)/64];
+};
+
+constexpr Defaults BuildDefaults(){
+  Defaults ret={};
+  for(uint32_t i=0;i<Configuration::NONE;i++){
+    const Field::Layout & layout=layouts[i];
+    if(layout.length==0){continue;}
+    uint32_t mask=((1<<layout.length)-1)<<layout.start;
+    ret.values[layout.address]&=~mask;
+    ret.values[layout.address]|=(layout.defval<<layout.start)&mask;
+    ret.updated[layout.address/64]|=1ULL<<(layout.address%64);
+  }
+  return ret;
+}
+
+constexpr Defaults defaults=BuildDefaults();
 
-  m_registers.resize(138);
-
-  m_fields[PIX_PORTAL]           = new Field(&m_registers[  0], 0,16,0);
-  m_fields[REGION_COL]           = new Field(&m_registers[  1], 0, 8,0);
-  m_fields[REGION_ROW]           = new Field(&m_registers[  2], 0, 9,0);
-  m_fields[PIX_MODE]             = new Field(&m_registers[  3], 3, 3,0);
-  m_fields[PIX_BCAST_EN]         = new Field(&m_registers[  3], 5, 1,0);
-  m_fields[PIX_AUTO_COL]         = new Field(&m_registers[  3], 4, 1,0);
-  m_fields[PIX_AUTO_ROW]         = new Field(&m_registers[  3], 3, 1,0);
-  m_fields[PIX_BCAST_MASK]       = new Field(&m_registers[  3], 0, 3,0);
-  m_fields[PIX_DEFAULT_CONFIG]   = new Field(&m_registers[  4], 0,16,0x9CE2);
-
-  m_fields[IBIASP1_SYNC]         = new Field(&m_registers[  5], 0,16,100);
-  m_fields[IBIASP2_SYNC]         = new Field(&m_registers[  6], 0,16,150);
-  m_fields[IBIAS_SF_SYNC]        = new Field(&m_registers[  7], 0,16,100);
-  m_fields[IBIAS_KRUM_SYNC]      = new Field(&m_registers[  8], 0,16,140);
-  m_fields[IBIAS_DISC_SYNC]      = new Field(&m_registers[  9], 0,16,200);
-  m_fields[ICTRL_SYNCT_SYNC]     = new Field(&m_registers[ 10], 0,16,100);
-  m_fields[VBL_SYNC]             = new Field(&m_registers[ 11], 0,16,450);
-  m_fields[VTH_SYNC]             = new Field(&m_registers[ 12], 0,16,300);
-  m_fields[VREF_KRUM_SYNC]       = new Field(&m_registers[ 13], 0,16,490);
-  m_fields[AUTO_ZERO]            = new Field(&m_registers[ 30], 3, 1,0);
-  m_fields[SEL_C2F]              = new Field(&m_registers[ 30], 2, 1,1);
-  m_fields[SEL_C4F]              = new Field(&m_registers[ 30], 1, 1,0);
-  m_fields[FAST_TOT]             = new Field(&m_registers[ 30], 0, 1,0);
-
-  m_fields[PA_IN_BIAS_LIN]       = new Field(&m_registers[ 14], 0, 9,300);
-  m_fields[FC_BIAS_LIN]          = new Field(&m_registers[ 15], 0, 8,20);
-  m_fields[KRUM_CURR_LIN]        = new Field(&m_registers[ 16], 0, 9,50);
-  m_fields[LDAC_LIN]             = new Field(&m_registers[ 17], 0,10,80);
-  m_fields[COMP_LIN]             = new Field(&m_registers[ 18], 0, 9,110);
-  m_fields[REF_KRUM_LIN]         = new Field(&m_registers[ 19], 0,10,300);
-  m_fields[VTH_LIN]              = new Field(&m_registers[ 20], 0,10,408);
-
-  m_fields[PRMP_DIFF]            = new Field(&m_registers[ 21], 0,10,533);
-  m_fields[FOL_DIFF]             = new Field(&m_registers[ 22], 0,10,542);
-  m_fields[PRECOMP_DIFF]         = new Field(&m_registers[ 23], 0,10,551);
-  m_fields[COMP_DIFF]            = new Field(&m_registers[ 24], 0,10,528);
-  m_fields[VFF_DIFF]             = new Field(&m_registers[ 25], 0,10,164);
-  m_fields[VTH1_DIFF]            = new Field(&m_registers[ 26], 0,10,1023);
-  m_fields[VTH2_DIFF]            = new Field(&m_registers[ 27], 0,10,0);
-  m_fields[LCC_DIFF]             = new Field(&m_registers[ 28], 0,10,20);
-  m_fields[LCC_EN]               = new Field(&m_registers[ 29], 1, 1,1);
-  m_fields[DIFF_FB_CAP_EN]       = new Field(&m_registers[ 29], 0, 1,0);
-
-  m_fields[SLDO_ANALOG_TRIM]     = new Field(&m_registers[ 31], 5,5,16);
-  m_fields[SLDO_DIGITAL_TRIM]    = new Field(&m_registers[ 31], 0,5,16);
-
-  m_fields[EN_CORE_COL_SYNC]     = new Field(&m_registers[ 32], 0,16,0xFF);
-  m_fields[EN_CORE_COL_LIN_1]    = new Field(&m_registers[ 33], 0,16,0xFF);
-  m_fields[EN_CORE_COL_LIN_2]    = new Field(&m_registers[ 34], 0, 1,1);
-  m_fields[EN_CORE_COL_DIFF_1]   = new Field(&m_registers[ 35], 0,16,0xFF);
-  m_fields[EN_CORE_COL_DIFF_2]   = new Field(&m_registers[ 36], 0, 1,1);
-  m_fields[LATENCY_CONFIG]       = new Field(&m_registers[ 37], 0, 9,500);
-  m_fields[WR_SYNC_DELAY_SYNC]   = new Field(&m_registers[ 38], 0, 5,16);
-
-  m_fields[INJ_MODE_ANA]         = new Field(&m_registers[ 39], 5, 1,0);
-  m_fields[INJ_MODE_DIG]         = new Field(&m_registers[ 39], 4, 1,1);
-  m_fields[INJ_FINE_DELAY]       = new Field(&m_registers[ 39], 0, 4,0);
-  m_fields[VCAL_HIGH]            = new Field(&m_registers[ 41], 0,12,500);
-  m_fields[VCAL_MED]             = new Field(&m_registers[ 42], 0,12,300);
-  m_fields[CAL_COLPR_SYNC_1]     = new Field(&m_registers[ 46], 0,16,0xFFFF);
-  m_fields[CAL_COLPR_SYNC_2]     = new Field(&m_registers[ 47], 0,16,0xFFFF);
-  m_fields[CAL_COLPR_SYNC_3]     = new Field(&m_registers[ 48], 0,16,0xFFFF);
-  m_fields[CAL_COLPR_SYNC_4]     = new Field(&m_registers[ 49], 0,16,0xFFFF);
-  m_fields[CAL_COLPR_LIN_1]      = new Field(&m_registers[ 50], 0,16,0xFFFF);
-  m_fields[CAL_COLPR_LIN_2]      = new Field(&m_registers[ 51], 0,16,0xFFFF);
-  m_fields[CAL_COLPR_LIN_3]      = new Field(&m_registers[ 52], 0,16,0xFFFF);
-  m_fields[CAL_COLPR_LIN_4]      = new Field(&m_registers[ 53], 0,16,0xFFFF);
-  m_fields[CAL_COLPR_LIN_5]      = new Field(&m_registers[ 54], 0, 4,0xF);
-  m_fields[CAL_COLPR_DIFF_1]     = new Field(&m_registers[ 55], 0,16,0xFFFF);
-  m_fields[CAL_COLPR_DIFF_2]     = new Field(&m_registers[ 56], 0,16,0xFFFF);
-  m_fields[CAL_COLPR_DIFF_3]     = new Field(&m_registers[ 57], 0,16,0xFFFF);
-  m_fields[CAL_COLPR_DIFF_4]     = new Field(&m_registers[ 58], 0,16,0xFFFF);
-  m_fields[CAL_COLPR_DIFF_5]     = new Field(&m_registers[ 59], 0, 4,0xF);
-
-  m_fields[CLK_DATA_DELAY]       = new Field(&m_registers[ 40], 0, 9,0);
-  m_fields[CLK_DELAY]            = new Field(&m_registers[ 40], 8, 1,0);
-  m_fields[CLK_DELAY_SEL]        = new Field(&m_registers[ 40], 4, 4,0);
-  m_fields[CMD_DELAY]            = new Field(&m_registers[ 40], 0, 4,0);
-  m_fields[CH_SYNC_CONF]         = new Field(&m_registers[ 43], 0,11,0);
-  m_fields[CH_SYNC_PHASE]        = new Field(&m_registers[ 43],10, 1,0);
-  m_fields[CH_SYNC_LOCK]         = new Field(&m_registers[ 43], 5, 5,0);
-  m_fields[CH_SYNC_UNLOCK]       = new Field(&m_registers[ 43], 0, 5,0);
-  m_fields[GLOBAL_PULSE_RT]      = new Field(&m_registers[ 44], 0,16,0);
-
-  m_fields[DEBUG_CONFIG]         = new Field(&m_registers[ 60], 0, 2,0);
-  m_fields[OUT_DATA_DELAY]       = new Field(&m_registers[ 61], 7, 2,0);
-  m_fields[OUT_SERIAL_TYPE]      = new Field(&m_registers[ 61], 6, 1,0);
-  m_fields[OUT_ACTIVE_LANES]     = new Field(&m_registers[ 61], 2, 4,1);
-  m_fields[OUT_FORMAT]           = new Field(&m_registers[ 61], 0,1,0);
-  m_fields[OUT_PAD_CONFIG]       = new Field(&m_registers[ 62], 0,14,0);
-  m_fields[GP_LVDS_ROUTE]        = new Field(&m_registers[ 63], 0, 3,0);
-  m_fields[CDR_CONFIG]           = new Field(&m_registers[ 64], 0,14,0);
-  m_fields[VCO_BUFF_BIAS]        = new Field(&m_registers[ 65], 0,10,0);
-  m_fields[CDR_CP_IBIAS]         = new Field(&m_registers[ 66], 0,10,0);
-  m_fields[VCO_IBIAS]            = new Field(&m_registers[ 67], 0,14,0);
-  m_fields[SER_SEL_OUT]          = new Field(&m_registers[ 68], 0, 8,0);
-  m_fields[CML_CONFIG]           = new Field(&m_registers[ 69], 0, 8,0xF);
-  m_fields[CML_INV_TAP]          = new Field(&m_registers[ 69], 6, 2,0);
-  m_fields[CML_EN_TAP]           = new Field(&m_registers[ 69], 4, 2,0);
-  m_fields[CML_EN]               = new Field(&m_registers[ 69], 0, 4,0xF);
-  m_fields[CML_TAP_BIAS_1]       = new Field(&m_registers[ 70], 0,10,500);
-  m_fields[CML_TAP_BIAS_2]       = new Field(&m_registers[ 71], 0,10,0);
-  m_fields[CML_TAP_BIAS_3]       = new Field(&m_registers[ 72], 0,10,0);
-  m_fields[AURORA_CC_CFG]        = new Field(&m_registers[ 73], 0, 8,103);
-  m_fields[AURORA_CC_WAIT]       = new Field(&m_registers[ 73], 2, 6,25);
-  m_fields[AURORA_CC_SEND]       = new Field(&m_registers[ 73], 0, 2,3);
-  m_fields[AURORA_CB_CFG_1]      = new Field(&m_registers[ 74], 0, 8,60);
-  m_fields[AURORA_CB_WAIT_1]     = new Field(&m_registers[ 74], 4, 4,15);
-  m_fields[AURORA_CB_SEND]       = new Field(&m_registers[ 74], 0, 4,0);
-  m_fields[AURORA_CB_CFG_0]      = new Field(&m_registers[ 75], 0,16,60);
-  m_fields[AURORA_CB_WAIT_0]     = new Field(&m_registers[ 75], 0,16,15);
-  m_fields[AURORA_INIT_WAIT]     = new Field(&m_registers[ 76], 0,16,32);
-  m_fields[MON_FRAME_SKIP]       = new Field(&m_registers[ 45], 0, 8,50);
-  m_fields[AUTO_READ_A0]         = new Field(&m_registers[101], 0, 8,136);
-  m_fields[AUTO_READ_B0]         = new Field(&m_registers[102], 0, 8,130);
-  m_fields[AUTO_READ_A1]         = new Field(&m_registers[103], 0, 8,118);
-  m_fields[AUTO_READ_B1]         = new Field(&m_registers[104], 0, 8,119);
-  m_fields[AUTO_READ_A2]         = new Field(&m_registers[105], 0, 8,120);
-  m_fields[AUTO_READ_B2]         = new Field(&m_registers[106], 0, 8,121);
-  m_fields[AUTO_READ_A3]         = new Field(&m_registers[107], 0, 8,122);
-  m_fields[AUTO_READ_B3]         = new Field(&m_registers[108], 0, 8,123);
-
-  m_fields[MONITOR_VMON_MUX]     = new Field(&m_registers[ 77], 0,16,0);
-  m_fields[HITOR_MASK_SYNC_1]    = new Field(&m_registers[ 78], 0,16,0);
-  m_fields[HITOR_MASK_SYNC_2]    = new Field(&m_registers[ 79], 0,16,0);
-  m_fields[HITOR_MASK_SYNC_3]    = new Field(&m_registers[ 80], 0,16,0);
-  m_fields[HITOR_MASK_SYNC_4]    = new Field(&m_registers[ 81], 0,16,0);
-  m_fields[HITOR_MASK_LIN_11]    = new Field(&m_registers[ 82], 0,16,0);
-  m_fields[HITOR_MASK_LIN_12]    = new Field(&m_registers[ 83], 0, 1,0);
-  m_fields[HITOR_MASK_LIN_21]    = new Field(&m_registers[ 84], 0,16,0);
-  m_fields[HITOR_MASK_LIN_22]    = new Field(&m_registers[ 85], 0, 1,0);
-  m_fields[HITOR_MASK_LIN_31]    = new Field(&m_registers[ 86], 0,16,0);
-  m_fields[HITOR_MASK_LIN_32]    = new Field(&m_registers[ 87], 0, 1,0);
-  m_fields[HITOR_MASK_LIN_41]    = new Field(&m_registers[ 88], 0,16,0);
-  m_fields[HITOR_MASK_LIN_42]    = new Field(&m_registers[ 89], 0, 1,0);
-  m_fields[HITOR_MASK_DIFF_11]   = new Field(&m_registers[ 90], 0,16,0);
-  m_fields[HITOR_MASK_DIFF_12]   = new Field(&m_registers[ 91], 0, 1,0);
-  m_fields[HITOR_MASK_DIFF_21]   = new Field(&m_registers[ 92], 0,16,0);
-  m_fields[HITOR_MASK_DIFF_22]   = new Field(&m_registers[ 93], 0, 1,0);
-  m_fields[HITOR_MASK_DIFF_31]   = new Field(&m_registers[ 94], 0,16,0);
-  m_fields[HITOR_MASK_DIFF_32]   = new Field(&m_registers[ 95], 0, 1,0);
-  m_fields[HITOR_MASK_DIFF_41]   = new Field(&m_registers[ 96], 0,16,0);
-  m_fields[HITOR_MASK_DIFF_42]   = new Field(&m_registers[ 97], 0, 1,0);
-  m_fields[BANDGAP_TRIM]         = new Field(&m_registers[ 98], 6, 5,0);
-  m_fields[ADC_TRIM]             = new Field(&m_registers[ 98], 0, 6,0);
-  m_fields[SENSOR_CONFIG_0]      = new Field(&m_registers[ 99], 0,16,0);
-  m_fields[SENSOR_BIAS_0]        = new Field(&m_registers[ 99], 0, 1,0);
-  m_fields[SENSOR_CURRENT_0]     = new Field(&m_registers[ 99], 1, 4,0);
-  m_fields[SENSOR_ENABLE_0]      = new Field(&m_registers[ 99], 5, 1,0);
-  m_fields[SENSOR_BIAS_1]        = new Field(&m_registers[ 99], 6, 1,0);
-  m_fields[SENSOR_CURRENT_1]     = new Field(&m_registers[ 99], 7, 4,0);
-  m_fields[SENSOR_ENABLE_1]      = new Field(&m_registers[ 99],11, 1,0);
-  m_fields[SENSOR_CONFIG_1]      = new Field(&m_registers[100], 0,16,0);
-  m_fields[SENSOR_BIAS_2]        = new Field(&m_registers[100], 0, 1,0);
-  m_fields[SENSOR_CURRENT_2]     = new Field(&m_registers[100], 1, 4,0);
-  m_fields[SENSOR_ENABLE_2]      = new Field(&m_registers[100], 5, 1,0);
-  m_fields[SENSOR_BIAS_3]        = new Field(&m_registers[100], 6, 1,0);
-  m_fields[SENSOR_CURRENT_3]     = new Field(&m_registers[100], 7, 4,0);
-  m_fields[SENSOR_ENABLE_3]      = new Field(&m_registers[100],11, 1,0);
-  m_fields[RING_OSC_ENABLE]      = new Field(&m_registers[109], 0, 8,0);
-  m_fields[RING_OSC_1]           = new Field(&m_registers[110], 0,16,0);
-  m_fields[RING_OSC_2]           = new Field(&m_registers[111], 0,16,0);
-  m_fields[RING_OSC_3]           = new Field(&m_registers[112], 0,16,0);
-  m_fields[RING_OSC_4]           = new Field(&m_registers[113], 0,16,0);
-  m_fields[RING_OSC_5]           = new Field(&m_registers[114], 0,16,0);
-  m_fields[RING_OSC_6]           = new Field(&m_registers[115], 0,16,0);
-  m_fields[RING_OSC_7]           = new Field(&m_registers[116], 0,16,0);
-  m_fields[RING_OSC_8]           = new Field(&m_registers[117], 0,16,0);
-  m_fields[BC_CTR]               = new Field(&m_registers[118], 0,16,0);
-  m_fields[TRIG_CTR]             = new Field(&m_registers[119], 0,16,0);
-  m_fields[LCK_LOSS_CTR]         = new Field(&m_registers[120], 0,16,0);
-  m_fields[BFLIP_WARN_CTR]       = new Field(&m_registers[121], 0,16,0);
-  m_fields[BFLIP_ERR_CTR]        = new Field(&m_registers[122], 0,16,0);
-  m_fields[CMD_ERR_CTR]          = new Field(&m_registers[123], 0,16,0);
-  m_fields[FIFO_FULL_CTR_1]      = new Field(&m_registers[124], 8, 8,0);
-  m_fields[FIFO_FULL_CTR_2]      = new Field(&m_registers[124], 0, 8,0);
-  m_fields[FIFO_FULL_CTR_3]      = new Field(&m_registers[125], 8, 8,0);
-  m_fields[FIFO_FULL_CTR_4]      = new Field(&m_registers[125], 0, 8,0);
-  m_fields[FIFO_FULL_CTR_5]      = new Field(&m_registers[126], 8, 8,0);
-  m_fields[FIFO_FULL_CTR_6]      = new Field(&m_registers[126], 0, 8,0);
-  m_fields[FIFO_FULL_CTR_7]      = new Field(&m_registers[127], 8, 8,0);
-  m_fields[FIFO_FULL_CTR_8]      = new Field(&m_registers[127], 0, 8,0);
-  m_fields[AI_PIX_COL]           = new Field(&m_registers[128], 0, 8,0);
-  m_fields[AI_PIX_ROW]           = new Field(&m_registers[129], 0, 9,0);
-  m_fields[HITOR_CNT_1]          = new Field(&m_registers[130], 0,16,0);
-  m_fields[HITOR_CNT_2]          = new Field(&m_registers[131], 0,16,0);
-  m_fields[HITOR_CNT_3]          = new Field(&m_registers[132], 0,16,0);
-  m_fields[HITOR_CNT_4]          = new Field(&m_registers[133], 0,16,0);
-  m_fields[SKP_TRIG_CNT]         = new Field(&m_registers[134], 0,16,0);
-  m_fields[ERR_MASK]             = new Field(&m_registers[135], 0,14,0);
-  m_fields[ADC_READ]             = new Field(&m_registers[136], 0,16,0);
-  m_fields[SELF_TRIG_EN]         = new Field(&m_registers[137], 0,16,0);
-
-
-  m_names_yarr={
-      "AdcRead", "AdcRefTrim", "AdcTrim", "AiPixCol", "AiPixRow",
-      "AuroraCbSend", "AuroraCbWaitHigh", "AuroraCbWaitLow", "AuroraCcSend", "AuroraCcWait", "AuroraInitWait",
-      "AutoReadA0", "AutoReadA1", "AutoReadA2", "AutoReadA3", "AutoReadB0", "AutoReadB1", "AutoReadB2", "AutoReadB3",
-      "BcCounter", "BflipErrCounter", "BflipWarnCounter",
-      "CalColprDiff1", "CalColprDiff2", "CalColprDiff3", "CalColprDiff4", "CalColprDiff5",
-      "CalColprLin1", "CalColprLin2", "CalColprLin3", "CalColprLin4", "CalColprLin5",
-      "CalColprSync1", "CalColprSync2", "CalColprSync3", "CalColprSync4",
-      "CdrCpIbias", "CdrEnGck", "CdrPdDel", "CdrPdSel", "CdrSelDelClk", "CdrSelSerClk", "CdrVcoGain", "ChSyncLock",
-      "ChSyncPhase", "ChSyncUnlock", "ClkDelay", "ClkDelaySel", "CmdDelay", "CmdErrCounter", "CmlEn", "CmlEnTap",
-      "CmlInvTap", "CmlTapBias0", "CmlTapBias1", "CmlTapBias2", "DebugConfig", "DiffComp", "DiffFbCapEn",
-      "DiffFol", "DiffLcc", "DiffLccEn", "DiffPrecomp", "DiffPrmp", "DiffVff", "DiffVth1", "DiffVth2",
-      "EnCoreColDiff1", "EnCoreColDiff2", "EnCoreColLin1", "EnCoreColLin2", "EnCoreColSync", "ErrMask",
-      "FifoFullCounter0", "FifoFullCounter1", "FifoFullCounter2", "FifoFullCounter3", "GlobalPulseRt",
-      "GpLvdsRoute",
-      "HitOr0MaskDiff0", "HitOr0MaskDiff1", "HitOr0MaskLin0", "HitOr0MaskLin1", "HitOr0MaskSync",
-      "HitOr1MaskDiff0", "HitOr1MaskDiff1", "HitOr1MaskLin0", "HitOr1MaskLin1", "HitOr1MaskSync",
-      "HitOr2MaskDiff0", "HitOr2MaskDiff1", "HitOr2MaskLin0", "HitOr2MaskLin1", "HitOr2MaskSync",
-      "HitOr3MaskDiff0", "HitOr3MaskDiff1", "HitOr3MaskLin0", "HitOr3MaskLin1", "HitOr3MaskSync",
-      "HitOrCounter0", "HitOrCounter1", "HitOrCounter2", "HitOrCounter3",
-      "InjAnaMode", "InjDelay", "InjEnDig", "InjVcalDiff", "InjVcalHigh", "InjVcalMed",
-      "LatencyConfig", "LinComp", "LinFcBias", "LinKrumCurr", "LinLdac", "LinPaInBias", "LinRefKrum", "LinVth",
-      "LockLossCounter", "MonFrameSkip", "MonitorEnable", "MonitorImonMux", "MonitorVmonMux",
-      "OutPadConfig", "OutputActiveLanes", "OutputDataReadDelay", "OutputFmt", "OutputSerType",
-      "PixAutoCol", "PixAutoRow", "PixBroadcastEn", "PixBroadcastMask", "PixDefaultConfig",
-      "PixPortal", "PixRegionCol", "PixRegionRow",
-      "RingOsc0", "RingOsc1", "RingOsc2", "RingOsc3", "RingOsc4", "RingOsc5", "RingOsc6", "RingOsc7", "RingOscEn",
-      "SelfTrigEn",
-      "SensorCfg0", "SensorCfg1", "SerSelOut0", "SerSelOut1", "SerSelOut2", "SerSelOut3",
-      "SkipTriggerCounter", "SldoAnalogTrim", "SldoDigitalTrim", "SyncAutoZero", "SyncFastTot",
-      "SyncIbiasDisc", "SyncIbiasKrum", "SyncIbiasSf", "SyncIbiasp1", "SyncIbiasp2",
-      "SyncIctrlSynct", "SyncSelC2F", "SyncSelC4F", "SyncVbl", "SyncVrefKrum", "SyncVth",
-      "TrigCounter", "VcoBuffBias", "VcoIbias", "WrSyncDelaySync"
-  };
+constexpr uint32_t Slot(const char * name, uint32_t length, uint32_t seed){
+  uint32_t hash=2166136261u^seed;
+  for(uint32_t i=0;i<length;i++){
+    hash^=(uint8_t)name[i];
+    hash*=16777619u;
+  }
+  return (hash^(hash>>16))&(NUM_SLOTS-1);
+}
 
+constexpr uint32_t Length(const char * name){
+  uint32_t ret=0;
+  while(name[ret]){ret++;}
+  return ret;
 }
 
-Configuration::~Configuration(){
-  for(auto it : m_fields){
-    delete it.second;
+/**
+ * Find the first seed of the hash that gives a different slot to every name
+ **/
+constexpr uint32_t FindSeed(){
+  for(uint32_t seed=0;seed<1000;seed++){
+    bool used[NUM_SLOTS]={};
+    bool ok=true;
+    for(uint32_t i=0;i<NUM_NAMES and ok;i++){
+      uint32_t slot=Slot(fieldnames[i].name,Length(fieldnames[i].name),seed);
+      if(used[slot]){ok=false;}
+      used[slot]=true;
+    }
+    if(ok){return seed;}
   }
-  m_fields.clear();
+  return NO_SEED;
+}
+
+constexpr uint32_t seed=FindSeed();
+
+static_assert(seed!=NO_SEED, "No perfect hash found for the field names");
+
+struct Slots{
+  uint8_t names[NUM_SLOTS];
+};
+
+constexpr Slots BuildSlots(){
+  Slots ret={};
+  for(uint32_t i=0;i<NUM_SLOTS;i++){ret.names[i]=NO_NAME;}
+  for(uint32_t i=0;i<NUM_NAMES;i++){
+    ret.names[Slot(fieldnames[i].name,Length(fieldnames[i].name),seed)]=i;
+  }
+  return ret;
+}
+
+constexpr Slots slots=BuildSlots();
+
+const FieldName * FindName(const string & name){
+  uint8_t index=slots.names[Slot(name.c_str(),name.size(),seed)];
+  if(index==NO_NAME){return 0;}
+  if(name!=fieldnames[index].name){return 0;}
+  return &fieldnames[index];
+}
+
 }
 
+Configuration::Configuration(){
+  m_verbose = 1;
+  for(uint32_t i=0;i<NUM_REGISTERS;i++){m_registers[i]=defaults.values[i];}
+  for(uint32_t i=0;i<(NUM_REGISTERS+63)/64;i++){m_updated[i]=defaults.updated[i];}
+}
+
+Configuration::~Configuration(){}
+
 void Configuration::SetVerbose(bool enable){
   m_verbose = enable;
 }
 
 uint32_t Configuration::Size(){
-  return m_registers.size();
+  return NUM_REGISTERS;
 }
 
 uint16_t Configuration::GetRegister(uint32_t index){
-  if(index>m_registers.size()-1){return 0;}
-  return m_registers[index].GetValue();
+  if(index>NUM_REGISTERS-1){return 0;}
+  return m_registers[index];
 }
 
 void Configuration::SetRegister(uint32_t index, uint16_t value){
-  if(index>m_registers.size()-1){return;}
-  m_registers[index].SetValue(value);
+  if(index>NUM_REGISTERS-1){return;}
+  m_registers[index]=value;
+  m_updated[index/64]|=1ULL<<(index%64);
 }
 
-void Configuration::SetField(string name, uint16_t value){
+void Configuration::LoadRegister(uint32_t index, uint16_t value){
+  if(index>NUM_REGISTERS-1){return;}
+  m_registers[index]=value;
+  m_updated[index/64]&=~(1ULL<<(index%64));
+}
+
+void Configuration::Update(uint32_t index, bool enable){
+  if(index>NUM_REGISTERS-1){return;}
+  if(enable){m_updated[index/64]|=1ULL<<(index%64);}
+  else{m_updated[index/64]&=~(1ULL<<(index%64));}
+}
 
-  if(name == "InjVcalDiff") return ; // EJS 2020-10-27, let's ignore it for now
-  if(name == "MonitorEnable") return ; // EJS 2020-10-27, let's ignore it for now
-  if(name == "MonitorImonMux") return ; // EJS 2020-10-27, let's ignore it for now
-  if(name == "MonitorVmonMux") return ; // EJS 2020-10-27, let's ignore it for now
-  if(name == "SerSelOut0") return ; // EJS 2020-10-27, let's ignore it for now
-  if(name == "SerSelOut1") return ; // EJS 2020-10-27, let's ignore it for now
-  if(name == "SerSelOut2") return ; // EJS 2020-10-27, let's ignore it for now
-  if(name == "SerSelOut3") return ; // EJS 2020-10-27, let's ignore it for now
+bool Configuration::IsUpdated(uint32_t index){
+  if(index>NUM_REGISTERS-1){return false;}
+  return (m_updated[index/64]>>(index%64))&1;
+}
+
+void Configuration::SetField(string name, uint16_t value){
 
   //  if(m_verbose) std::cout << __PRETTY_FUNCTION__ << "Setting field: " << name << ", " << value << std::endl;
-  auto it=m_name2index.find(name);
-  if(it==m_name2index.end()){
+  const FieldName * entry=FindName(name);
+  if(!entry){
     if(m_verbose) std::cout << __PRETTY_FUNCTION__ << " WARNING!!! - Reached end of name2index dictionary" << std::endl;
     return;
   }
-  else{
-    //    if(m_verbose) std::cout << __PRETTY_FUNCTION__ << " Found in dictionary: " << it -> first << ", " << it -> second << std::endl;
-  }
-  m_fields[it->second]->SetValue(value);
+  if(entry->ignored){return;}
+  SetField(entry->field,value);
 }
 
 void Configuration::SetField(uint32_t index, uint16_t value){
-  m_fields[index]->SetValue(value);
+  GetField(index).SetValue(value);
 }
 
-Field * Configuration::GetField(uint32_t index){
-  return m_fields[index];
+Field Configuration::GetField(uint32_t index){
+  if(index>NONE){index=NONE;}
+  return Field(this,&layouts[index]);
 }
 
-Field * Configuration::GetField(string name){
-  auto it=m_name2index.find(name);
-  if(it==m_name2index.end()){return 0;}
-  return m_fields[it->second];
+Field Configuration::GetField(const string & name){
+  const FieldName * entry=FindName(name);
+  if(!entry){return Field(this,&layouts[NONE]);}
+  return Field(this,&layouts[entry->field]);
+}
+
+vector<string> Configuration::GetFieldNames(uint32_t index){
+  vector<string> ret;
+  if(index>NUM_REGISTERS-1){return ret;}
+  for(const FieldName & entry : fieldnames){
+    const Field::Layout & layout=layouts[entry.field];
+    if(layout.length==0){continue;}
+    if(layout.address==index){ret.push_back(entry.name);}
+  }
+  return ret;
 }
 
 vector<uint32_t> Configuration::GetUpdatedRegisters(){
   vector<uint32_t> ret;
-  for(uint32_t i=0;i<m_registers.size();i++){
-    if(m_registers[i].IsUpdated()){ret.push_back(i);m_registers[i].Update(false);}
-  }
+  uint32_t index;
+  while(NextUpdatedRegister(index)){ret.push_back(index);}
   return ret;
 }
 
+bool Configuration::NextUpdatedRegister(uint32_t & index){
+  for(uint32_t i=0;i<(NUM_REGISTERS+63)/64;i++){
+    if(m_updated[i]==0){continue;}
+    index=i*64+__builtin_ctzll(m_updated[i]);
+    m_updated[i]&=m_updated[i]-1;
+    return true;
+  }
+  return false;
+}
+
 map<string,uint32_t> Configuration::GetRegisters(){
   map<string,uint32_t> ret;
-  for(auto name : m_names_yarr){
-    if(name == "InjVcalDiff") continue ; // EJS 2020-10-27, let's ignore it for now
-    if(name == "MonitorEnable") continue ; // EJS 2020-10-27, let's ignore it for now
-    if(name == "MonitorImonMux") continue ; // EJS 2020-10-27, let's ignore it for now
-    if(name == "MonitorVmonMux") continue ; // EJS 2020-10-27, let's ignore it for now
-    if(name == "SerSelOut0") continue ; // EJS 2020-10-27, let's ignore it for now
-    if(name == "SerSelOut1") continue ; // EJS 2020-10-27, let's ignore it for now
-    if(name == "SerSelOut2") continue ; // EJS 2020-10-27, let's ignore it for now
-    if(name == "SerSelOut3") continue ; // EJS 2020-10-27, let's ignore it for now
-
-    if(m_fields.count(m_name2index[name])==0){
-      cout << "Skipping register: " << m_name2index[name] << endl;
-      continue;
-    }
-    ret[name]=m_fields[m_name2index[name]]->GetValue();
+  for(const FieldName & entry : fieldnames){
+    if(!entry.listed or entry.ignored){continue;}
+    ret[entry.name]=GetField(entry.field).GetValue();
   }
   return ret;
 }
@@ -3,6 +3,7 @@
 #include "RD53Emulator/Decoder.h"
 #include "RD53Emulator/RdReg.h"
 #include "RD53Emulator/Tools.h"
+#include "RD53Emulator/FlightRecorder.h"
 
 #include <iostream>
 #include <iomanip>
@@ -53,6 +54,7 @@ uint32_t Emulator::GetChipID(){
 void Emulator::HandleCommand(uint8_t *recv_data, uint32_t recv_size){
 
   if(recv_size==0){return;}
+  FlightRecorder::Record(FlightRecorder::MESSAGE_RECEIVED,m_chipid,recv_size);
   if(m_verbose) cout << "Emulator::HandleCommand received commands size : " << recv_size << endl;
 
   m_encoder->Clear();
@@ -72,7 +74,7 @@ void Emulator::ProcessQueue(){
 
   m_decoder->Clear();
 
-  //uint32_t nfs = m_config->GetField(Configuration::MON_FRAME_SKIP)->GetValue();
+  //uint32_t nfs = m_config->GetField(Configuration::MON_FRAME_SKIP).GetValue();
   uint32_t nfs = 10;
 
   m_ndf++;
@@ -96,17 +98,20 @@ void Emulator::ProcessQueue(){
     }
     else if(cmd->GetType()==Command::WRREG){
       WrReg*wrreg=dynamic_cast<WrReg*>(cmd);
-      if(wrreg->GetType()==1){continue;}
       //Read ADC
       if(wrreg->GetAddress() == 44 && wrreg->GetValue() == 8){
         m_config->SetRegister(wrreg->GetAddress(), wrreg->GetValue());
       }
-      //PIXEL PORTAL
+      //PIXEL PORTAL, 6 values in mode 1
       if(wrreg->GetAddress()==0){
-        m_matrix->SetPair(m_config->GetField(Configuration::REGION_COL)->GetValue(),
-            m_config->GetField(Configuration::REGION_ROW)->GetValue(),
-            wrreg->GetValue());
-      }else{
+        for(uint32_t i=0;i<(wrreg->GetMode()==1?6:1);i++){
+          uint32_t row=m_config->GetField(Configuration::REGION_ROW).GetValue();
+          m_matrix->SetPair(m_config->GetField(Configuration::REGION_COL).GetValue(),row,wrreg->GetValue(i));
+          if(m_config->GetField(Configuration::PIX_AUTO_ROW).GetValue()){
+            m_config->GetField(Configuration::REGION_ROW).SetValue(row+1);
+          }
+        }
+      }else if(wrreg->GetMode()==0){
         m_config->SetRegister(wrreg->GetAddress(),wrreg->GetValue());      
       }
     }
@@ -119,7 +124,7 @@ void Emulator::ProcessQueue(){
         return;
       }
 
-      if(m_th_syn!=m_config->GetField(Configuration::VTH_SYNC)->GetValue() or m_th_lin!=m_config->GetField(Configuration::VTH_LIN)->GetValue() or m_th_diff!=m_config->GetField(Configuration::VTH1_DIFF)->GetValue()){
+      if(m_th_syn!=m_config->GetField(Configuration::VTH_SYNC).GetValue() or m_th_lin!=m_config->GetField(Configuration::VTH_LIN).GetValue() or m_th_diff!=m_config->GetField(Configuration::VTH1_DIFF).GetValue()){
         InitThresholds();
       } //This is needed in order to perform a threshold tuning, which consists in a loop of analog scan inside a loop over threshold values. Whitout this if condition, the InitThreshold function is called inside the first loop only. 
 
@@ -134,12 +139,12 @@ void Emulator::ProcessQueue(){
       //Loop over the matrix
       uint32_t reg, off, DAC; 
       for(uint32_t ccol=0;ccol<50;ccol++){
-        if     (ccol>= 0 and ccol<16){ reg=Configuration::EN_CORE_COL_SYNC;   off= 0; DAC=m_config->GetField(Configuration::IBIAS_KRUM_SYNC)->GetValue();}
-        else if(ccol>=16 and ccol<32){ reg=Configuration::EN_CORE_COL_LIN_1;  off=16; DAC=m_config->GetField(Configuration::KRUM_CURR_LIN)->GetValue();}
-        else if(ccol==32)            { reg=Configuration::EN_CORE_COL_LIN_2;  off=32; DAC=m_config->GetField(Configuration::KRUM_CURR_LIN)->GetValue();}
-        else if(ccol>=33 and ccol<49){ reg=Configuration::EN_CORE_COL_DIFF_1; off=33; DAC=m_config->GetField(Configuration::VFF_DIFF)->GetValue();}
-        else if(ccol==49)            { reg=Configuration::EN_CORE_COL_DIFF_2; off=49; DAC=m_config->GetField(Configuration::VFF_DIFF)->GetValue();}
-        bool enable = (m_config->GetField(reg)->GetValue() & (1<<(ccol-off)));
+        if     (ccol>= 0 and ccol<16){ reg=Configuration::EN_CORE_COL_SYNC;   off= 0; DAC=m_config->GetField(Configuration::IBIAS_KRUM_SYNC).GetValue();}
+        else if(ccol>=16 and ccol<32){ reg=Configuration::EN_CORE_COL_LIN_1;  off=16; DAC=m_config->GetField(Configuration::KRUM_CURR_LIN).GetValue();}
+        else if(ccol==32)            { reg=Configuration::EN_CORE_COL_LIN_2;  off=32; DAC=m_config->GetField(Configuration::KRUM_CURR_LIN).GetValue();}
+        else if(ccol>=33 and ccol<49){ reg=Configuration::EN_CORE_COL_DIFF_1; off=33; DAC=m_config->GetField(Configuration::VFF_DIFF).GetValue();}
+        else if(ccol==49)            { reg=Configuration::EN_CORE_COL_DIFF_2; off=49; DAC=m_config->GetField(Configuration::VFF_DIFF).GetValue();}
+        bool enable = (m_config->GetField(reg).GetValue() & (1<<(ccol-off)));
 
         if(enable){
           //loop over quad columns
@@ -152,12 +157,12 @@ void Emulator::ProcessQueue(){
               for(uint32_t i=0;i<4;i++){
                 //check enabled
                 if(m_matrix->GetPixel(qcol*4+i,row)->GetEnable()){
-		  if(m_config->GetField(Configuration::INJ_MODE_DIG)->GetValue()==1) {
+		  if(m_config->GetField(Configuration::INJ_MODE_DIG).GetValue()==1) {
 		      hashit=true;
 		      tot[i]=4; //don't remove, otherwise the digital scan won't work
 		    }
 		  else {
-		    unsigned int vcal = m_config->GetField(Configuration::VCAL_HIGH)->GetValue() - m_config->GetField(Configuration::VCAL_MED)->GetValue();
+		    unsigned int vcal = m_config->GetField(Configuration::VCAL_HIGH).GetValue() - m_config->GetField(Configuration::VCAL_MED).GetValue();
 		    double chargeInj = Tools::injToCharge(vcal);
 		    double pixelNoise = 0.;
 		    m_generator.seed(std::chrono::system_clock::now().time_since_epoch().count());
@@ -269,11 +274,11 @@ void Emulator::InitThresholds(){
   uint32_t vth, vthIndex;
   for(uint32_t ccol=0;ccol<50;ccol++){
 
-    if     (ccol>= 0 and ccol<16){vth=m_config->GetField(Configuration::VTH_SYNC)->GetValue(); vthIndex=0; m_th_syn=vth;}
-    else if(ccol>=16 and ccol<32){vth=m_config->GetField(Configuration::VTH_LIN)->GetValue(); vthIndex=1; m_th_lin=vth;}
-    else if(ccol==32)            {vth=m_config->GetField(Configuration::VTH_LIN)->GetValue(); vthIndex=1; m_th_lin=vth;}
-    else if(ccol>=33 and ccol<49){vth=m_config->GetField(Configuration::VTH1_DIFF)->GetValue(); vthIndex=2; m_th_diff=vth;}
-    else if(ccol==49)            {vth=m_config->GetField(Configuration::VTH1_DIFF)->GetValue(); vthIndex=2; m_th_diff=vth;}
+    if     (ccol>= 0 and ccol<16){vth=m_config->GetField(Configuration::VTH_SYNC).GetValue(); vthIndex=0; m_th_syn=vth;}
+    else if(ccol>=16 and ccol<32){vth=m_config->GetField(Configuration::VTH_LIN).GetValue(); vthIndex=1; m_th_lin=vth;}
+    else if(ccol==32)            {vth=m_config->GetField(Configuration::VTH_LIN).GetValue(); vthIndex=1; m_th_lin=vth;}
+    else if(ccol>=33 and ccol<49){vth=m_config->GetField(Configuration::VTH1_DIFF).GetValue(); vthIndex=2; m_th_diff=vth;}
+    else if(ccol==49)            {vth=m_config->GetField(Configuration::VTH1_DIFF).GetValue(); vthIndex=2; m_th_diff=vth;}
 
     for(uint32_t qcol=ccol*2; qcol<(ccol+1)*2; qcol++){
       for(uint32_t row=0; row<192; row++){
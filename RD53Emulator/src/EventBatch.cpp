@@ -0,0 +1,111 @@
+#include "RD53Emulator/EventBatch.h"
+
+using namespace std;
+using namespace RD53A;
+
+EventBatch::EventBatch(uint32_t max_hits, uint32_t max_events){
+  m_max_hits=max_hits;
+  m_max_events=max_events;
+  m_sequence=0;
+  m_tids.reserve(max_events);
+  m_ttags.reserve(max_events);
+  m_bcids.reserve(max_events);
+  m_first.reserve(max_events);
+  m_cols.reserve(max_hits);
+  m_rows.reserve(max_hits);
+  m_tots.reserve(max_hits);
+}
+
+EventBatch::~EventBatch(){}
+
+void EventBatch::Clear(){
+  m_tids.clear();
+  m_ttags.clear();
+  m_bcids.clear();
+  m_first.clear();
+  m_cols.clear();
+  m_rows.clear();
+  m_tots.clear();
+}
+
+void EventBatch::AddEvent(uint32_t tid, uint32_t ttag, uint32_t bcid){
+  m_tids.push_back(tid);
+  m_ttags.push_back(ttag);
+  m_bcids.push_back(bcid);
+  m_first.push_back(m_cols.size());
+}
+
+void EventBatch::AddHit(uint32_t col, uint32_t row, uint32_t tot){
+  m_cols.push_back(col);
+  m_rows.push_back(row);
+  m_tots.push_back(tot);
+}
+
+bool EventBatch::IsFull() const{
+  return (m_cols.size()>=m_max_hits or m_first.size()>=m_max_events);
+}
+
+bool EventBatch::IsEmpty() const{
+  return m_first.empty();
+}
+
+uint32_t EventBatch::GetNumEvents() const{
+  return m_first.size();
+}
+
+uint32_t EventBatch::GetNumHits() const{
+  return m_cols.size();
+}
+
+uint64_t EventBatch::GetSequence() const{
+  return m_sequence;
+}
+
+void EventBatch::SetSequence(uint64_t sequence){
+  m_sequence=sequence;
+}
+
+Span<uint8_t> EventBatch::GetTIDs() const{
+  return Span<uint8_t>(m_tids.data(),m_tids.size());
+}
+
+Span<uint8_t> EventBatch::GetTTags() const{
+  return Span<uint8_t>(m_ttags.data(),m_ttags.size());
+}
+
+Span<uint16_t> EventBatch::GetBCIDs() const{
+  return Span<uint16_t>(m_bcids.data(),m_bcids.size());
+}
+
+Span<uint32_t> EventBatch::GetFirstHits() const{
+  return Span<uint32_t>(m_first.data(),m_first.size());
+}
+
+Span<uint16_t> EventBatch::GetCols() const{
+  return Span<uint16_t>(m_cols.data(),m_cols.size());
+}
+
+Span<uint16_t> EventBatch::GetRows() const{
+  return Span<uint16_t>(m_rows.data(),m_rows.size());
+}
+
+Span<uint8_t> EventBatch::GetTOTs() const{
+  return Span<uint8_t>(m_tots.data(),m_tots.size());
+}
+
+uint32_t EventBatch::GetNumHits(uint32_t event) const{
+  uint32_t last=(event+1<m_first.size()?m_first[event+1]:m_cols.size());
+  return last-m_first[event];
+}
+
+Span<uint16_t> EventBatch::GetCols(uint32_t event) const{
+  return Span<uint16_t>(m_cols.data()+m_first[event],GetNumHits(event));
+}
+
+Span<uint16_t> EventBatch::GetRows(uint32_t event) const{
+  return Span<uint16_t>(m_rows.data()+m_first[event],GetNumHits(event));
+}
+
+Span<uint8_t> EventBatch::GetTOTs(uint32_t event) const{
+  return Span<uint8_t>(m_tots.data()+m_first[event],GetNumHits(event));
+}
@@ -0,0 +1,130 @@
+#include "RD53Emulator/EventBuilder.h"
+
+using namespace std;
+using namespace RD53A;
+
+EventBuilder::EventBuilder(uint32_t max_hits, uint32_t max_events, uint32_t max_batches){
+  m_max_hits=max_hits;
+  m_max_events=max_events;
+  m_max_batches=max_batches;
+  m_tid=0;
+  m_ttag=0;
+  m_bcid=0;
+  m_sequence=0;
+  m_allocated=0;
+  m_dropped=0;
+  m_open=Acquire();
+}
+
+EventBuilder::~EventBuilder(){
+  delete m_open;
+  for(auto batch : m_ready){delete batch;}
+  for(auto batch : m_free){delete batch;}
+  m_ready.clear();
+  m_free.clear();
+}
+
+EventBatch * EventBuilder::Acquire(){
+  lock_guard<mutex> lock(m_mutex);
+  if(m_free.empty()){
+    m_allocated++;
+    return new EventBatch(m_max_hits,m_max_events);
+  }
+  EventBatch * batch=m_free.back();
+  m_free.pop_back();
+  return batch;
+}
+
+void EventBuilder::Publish(){
+  m_open->SetSequence(m_sequence++);
+  {
+    lock_guard<mutex> lock(m_monitor_mutex);
+    if(m_monitor){m_monitor(m_open);}
+  }
+  {
+    lock_guard<mutex> lock(m_mutex);
+    //nobody takes the batches, the open one is reused
+    if(m_max_batches==0){
+      m_open->Clear();
+      return;
+    }
+    if(m_ready.size()>=m_max_batches){
+      EventBatch * oldest=m_ready.front();
+      m_ready.pop_front();
+      oldest->Clear();
+      m_free.push_back(oldest);
+      m_dropped++;
+    }
+    m_ready.push_back(m_open);
+  }
+  m_open=Acquire();
+}
+
+void EventBuilder::AddHeader(uint32_t tid, uint32_t ttag, uint32_t bcid){
+  if(m_open->IsFull()){Publish();}
+  m_tid=tid;
+  m_ttag=ttag;
+  m_bcid=bcid;
+  m_open->AddEvent(tid,ttag,bcid);
+}
+
+void EventBuilder::AddHit(uint32_t col, uint32_t row, uint32_t tot){
+  if(m_open->IsFull()){Publish();}
+  //continue the current event in a new batch
+  if(m_open->IsEmpty()){m_open->AddEvent(m_tid,m_ttag,m_bcid);}
+  m_open->AddHit(col,row,tot);
+}
+
+void EventBuilder::Flush(){
+  if(m_open->IsEmpty()){return;}
+  Publish();
+}
+
+bool EventBuilder::HasEvents(){
+  lock_guard<mutex> lock(m_mutex);
+  return !m_ready.empty();
+}
+
+const EventBatch * EventBuilder::GetEvents(){
+  lock_guard<mutex> lock(m_mutex);
+  if(m_ready.empty()){return NULL;}
+  EventBatch * batch=m_ready.front();
+  m_ready.pop_front();
+  return batch;
+}
+
+void EventBuilder::ReleaseEvents(const EventBatch * batch){
+  if(!batch){return;}
+  EventBatch * mbatch=const_cast<EventBatch*>(batch);
+  mbatch->Clear();
+  lock_guard<mutex> lock(m_mutex);
+  m_free.push_back(mbatch);
+}
+
+void EventBuilder::SetMaxBatches(uint32_t max_batches){
+  lock_guard<mutex> lock(m_mutex);
+  m_max_batches=max_batches;
+  //the batches that no longer fit are dropped
+  while(m_ready.size()>m_max_batches){
+    EventBatch * oldest=m_ready.front();
+    m_ready.pop_front();
+    oldest->Clear();
+    m_free.push_back(oldest);
+    m_dropped++;
+  }
+}
+
+void EventBuilder::SetMonitor(function<void(const EventBatch *)> monitor){
+  lock_guard<mutex> lock(m_monitor_mutex);
+  m_monitor=monitor;
+}
+
+uint64_t EventBuilder::GetDropped(){
+  lock_guard<mutex> lock(m_mutex);
+  return m_dropped;
+}
+
+uint32_t EventBuilder::GetAllocated(){
+  lock_guard<mutex> lock(m_mutex);
+  return m_allocated;
+}
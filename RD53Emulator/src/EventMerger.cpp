@@ -0,0 +1,301 @@
+#include "RD53Emulator/EventMerger.h"
+
+using namespace std;
+using namespace RD53A;
+
+EventMerger::EventMerger(uint32_t num_fes, uint32_t window, uint32_t timeout_ms, uint32_t queue_size, uint32_t hits_size){
+  m_num_fes=(num_fes<MAX_FES?num_fes:MAX_FES);
+  m_window=(window>0?window:1);
+  m_timeout=chrono::milliseconds(timeout_ms);
+  m_all_fes=(m_num_fes==64?~0ULL:(1ULL<<m_num_fes)-1);
+  //the sizes of the rings are rounded up to a power of 2
+  uint32_t nfrags=1, nhits=1;
+  while(nfrags<queue_size){nfrags<<=1;}
+  while(nhits<hits_size){nhits<<=1;}
+  for(uint32_t i=0;i<m_num_fes;i++){
+    Queue * queue=new Queue();
+    queue->head=0;
+    queue->tail=0;
+    queue->hit_head=0;
+    queue->hit_tail=0;
+    queue->fragments.resize(nfrags);
+    queue->hits.resize(nhits);
+    queue->last_tid=0;
+    queue->last_ttag=0;
+    queue->last_bcid=0;
+    queue->has_last=false;
+    queue->dropped=0;
+    queue->received=0;
+    queue->matched=0;
+    queue->missing=0;
+    queue->last_event=~0ULL;
+    m_queues.push_back(queue);
+  }
+  m_slots.resize(m_window);
+  m_first=0;
+  m_count=0;
+  m_number=0;
+  m_complete=0;
+  m_incomplete=0;
+  m_running=true;
+  m_thread=thread(&EventMerger::Run,this);
+}
+
+EventMerger::~EventMerger(){
+  m_running=false;
+  m_thread.join();
+  Flush();
+  for(auto queue : m_queues){delete queue;}
+  m_queues.clear();
+}
+
+void EventMerger::AddFragments(uint32_t fe, const EventBatch * batch){
+  if(fe>=m_num_fes or !batch){return;}
+  Queue * queue=m_queues[fe];
+  uint64_t fmask=queue->fragments.size()-1;
+  uint64_t hmask=queue->hits.size()-1;
+  uint64_t head=queue->head.load(memory_order_relaxed);
+  uint64_t hit_head=queue->hit_head.load(memory_order_relaxed);
+  uint64_t tail=queue->tail.load(memory_order_acquire);
+  uint64_t hit_tail=queue->hit_tail.load(memory_order_acquire);
+
+  Span<uint8_t> tids=batch->GetTIDs();
+  Span<uint8_t> ttags=batch->GetTTags();
+  Span<uint16_t> bcids=batch->GetBCIDs();
+  for(uint32_t ev=0;ev<batch->GetNumEvents();ev++){
+    Fragment fragment;
+    fragment.tid=tids[ev];
+    fragment.ttag=ttags[ev];
+    fragment.bcid=bcids[ev];
+    //an event split between two batches repeats the trigger header
+    fragment.continuation=(ev==0 and queue->has_last and queue->last_tid==fragment.tid and
+                           queue->last_ttag==fragment.ttag and queue->last_bcid==fragment.bcid);
+    Span<uint16_t> cols=batch->GetCols(ev);
+    Span<uint16_t> rows=batch->GetRows(ev);
+    Span<uint8_t> tots=batch->GetTOTs(ev);
+    fragment.nhits=cols.size();
+
+    //check the free space once more before giving up, the helper thread may have taken something
+    if(head-tail>fmask or hit_head-hit_tail+fragment.nhits>hmask+1){
+      tail=queue->tail.load(memory_order_acquire);
+      hit_tail=queue->hit_tail.load(memory_order_acquire);
+    }
+    if(head-tail>fmask or hit_head-hit_tail+fragment.nhits>hmask+1){
+      queue->dropped.fetch_add(1,memory_order_relaxed);
+      queue->has_last=false;
+      continue;
+    }
+    for(uint32_t i=0;i<cols.size();i++){
+      queue->hits[(hit_head+i)&hmask]=(cols[i]<<16)|(rows[i]<<4)|(tots[i]&0xF);
+    }
+    queue->fragments[head&fmask]=fragment;
+    hit_head+=fragment.nhits;
+    head++;
+    queue->last_tid=fragment.tid;
+    queue->last_ttag=fragment.ttag;
+    queue->last_bcid=fragment.bcid;
+    queue->has_last=true;
+  }
+  //the hits are visible before the fragments that refer to them
+  queue->hit_head.store(hit_head,memory_order_release);
+  queue->head.store(head,memory_order_release);
+}
+
+void EventMerger::SetConsumer(function<void(const Event &)> consumer){
+  lock_guard<mutex> lock(m_mutex);
+  m_consumer=consumer;
+}
+
+void EventMerger::Run(){
+  while(m_running){
+    uint32_t taken;
+    {
+      lock_guard<mutex> lock(m_deliver_mutex);
+      {
+        lock_guard<mutex> lock(m_mutex);
+        taken=Process();
+      }
+      Deliver();
+    }
+    if(taken==0){this_thread::sleep_for(chrono::milliseconds(1));}
+  }
+}
+
+void EventMerger::Deliver(){
+  vector<Event> closed;
+  function<void(const Event &)> consumer;
+  {
+    lock_guard<mutex> lock(m_mutex);
+    if(m_closed.empty()){return;}
+    closed.swap(m_closed);
+    consumer=m_consumer;
+  }
+  if(consumer){
+    for(auto & event : closed){consumer(event);}
+  }
+  //keep the memory of the events for the next ones
+  lock_guard<mutex> lock(m_mutex);
+  for(auto & event : closed){
+    m_spare.push_back(Event());
+    swap(m_spare.back(),event);
+  }
+}
+
+uint32_t EventMerger::Process(){
+  //take the fragments of the front-ends in turns, a few at a time,
+  //so that a front-end that is ahead does not fill the window alone
+  uint32_t chunk=(m_window>=2*m_num_fes?m_window/(2*m_num_fes):1);
+  uint32_t taken=0;
+  bool more=true;
+  while(more){
+    more=false;
+    for(uint32_t fe=0;fe<m_num_fes;fe++){
+      Queue * queue=m_queues[fe];
+      uint64_t head=queue->head.load(memory_order_acquire);
+      uint64_t tail=queue->tail.load(memory_order_relaxed);
+      if(tail==head){continue;}
+      uint64_t hit_tail=queue->hit_tail.load(memory_order_relaxed);
+      uint64_t fmask=queue->fragments.size()-1;
+      uint64_t last=(head-tail>chunk?tail+chunk:head);
+      while(tail<last){
+        const Fragment & fragment=queue->fragments[tail&fmask];
+        Assign(fe,queue,fragment,hit_tail);
+        hit_tail+=fragment.nhits;
+        tail++;
+        taken++;
+      }
+      queue->hit_tail.store(hit_tail,memory_order_release);
+      queue->tail.store(tail,memory_order_release);
+      if(tail<head){more=true;}
+    }
+  }
+
+  //the events leave the window in order, when they are complete or too old.
+  //a complete event waits until no front-end can continue it, that is,
+  //until every front-end has sent the fragment of a later trigger
+  Clock::time_point now=Clock::now();
+  while(m_count>0){
+    Slot & slot=m_slots[m_first];
+    if(now-slot.opened<m_timeout){
+      if(slot.event.fes!=m_all_fes){break;}
+      bool last=false;
+      for(uint32_t fe=0;fe<m_num_fes;fe++){
+        if(m_queues[fe]->last_event==slot.number){last=true; break;}
+      }
+      if(last){break;}
+    }
+    Close();
+  }
+  return taken;
+}
+
+void EventMerger::Assign(uint32_t fe, Queue * queue, const Fragment & fragment, uint64_t first_hit){
+  uint64_t bit=1ULL<<fe;
+  Slot * slot=0;
+  if(fragment.continuation){
+    //the newest event of the same trigger that has the first part
+    for(uint32_t i=m_count;i>0;i--){
+      Slot & candidate=m_slots[(m_first+i-1)%m_window];
+      if(candidate.event.ttag!=fragment.ttag or candidate.event.bcid!=fragment.bcid){continue;}
+      if(!(candidate.event.fes&bit)){continue;}
+      slot=&candidate;
+      break;
+    }
+  }
+  if(!slot){
+    queue->received++;
+    //the oldest event of the same trigger that misses this front-end
+    for(uint32_t i=0;i<m_count;i++){
+      Slot & candidate=m_slots[(m_first+i)%m_window];
+      if(candidate.event.ttag!=fragment.ttag or candidate.event.bcid!=fragment.bcid){continue;}
+      if(candidate.event.fes&bit){continue;}
+      slot=&candidate;
+      break;
+    }
+  }
+  if(!slot){
+    if(m_count==m_window){Close();}
+    slot=&m_slots[(m_first+m_count)%m_window];
+    m_count++;
+    slot->number=m_number++;
+    slot->opened=Clock::now();
+    Event & event=slot->event;
+    event.ttag=fragment.ttag;
+    event.bcid=fragment.bcid;
+    event.fes=0;
+    event.tids.assign(m_num_fes,0);
+    event.hit_fes.clear();
+    event.cols.clear();
+    event.rows.clear();
+    event.tots.clear();
+  }
+
+  queue->last_event=slot->number;
+  Event & event=slot->event;
+  event.fes|=bit;
+  event.tids[fe]=fragment.tid;
+  uint64_t hmask=queue->hits.size()-1;
+  for(uint32_t i=0;i<fragment.nhits;i++){
+    uint32_t hit=queue->hits[(first_hit+i)&hmask];
+    event.hit_fes.push_back(fe);
+    event.cols.push_back(hit>>16);
+    event.rows.push_back((hit>>4)&0xFFF);
+    event.tots.push_back(hit&0xF);
+  }
+}
+
+void EventMerger::Close(){
+  Event & event=m_slots[m_first].event;
+  if(event.fes==m_all_fes){m_complete++;}
+  else{m_incomplete++;}
+  for(uint32_t fe=0;fe<m_num_fes;fe++){
+    if(event.fes&(1ULL<<fe)){m_queues[fe]->matched++;}
+    else{m_queues[fe]->missing++;}
+  }
+  //the consumer is called without the mutex (EventMerger::Deliver), the slot takes a spare event
+  if(m_consumer){
+    m_closed.push_back(Event());
+    swap(m_closed.back(),event);
+    if(!m_spare.empty()){
+      swap(event,m_spare.back());
+      m_spare.pop_back();
+    }
+  }
+  m_first=(m_first+1)%m_window;
+  m_count--;
+}
+
+void EventMerger::Flush(){
+  lock_guard<mutex> dlock(m_deliver_mutex);
+  {
+    lock_guard<mutex> lock(m_mutex);
+    Process();
+    while(m_count>0){Close();}
+  }
+  Deliver();
+}
+
+EventMerger::Statistics EventMerger::GetStatistics(uint32_t fe){
+  Statistics stats={0,0,0,0};
+  if(fe>=m_num_fes){return stats;}
+  lock_guard<mutex> lock(m_mutex);
+  stats.fragments=m_queues[fe]->received;
+  stats.matched=m_queues[fe]->matched;
+  stats.missing=m_queues[fe]->missing;
+  stats.dropped=m_queues[fe]->dropped.load(memory_order_relaxed);
+  return stats;
+}
+
+uint64_t EventMerger::GetComplete(){
+  lock_guard<mutex> lock(m_mutex);
+  return m_complete;
+}
+
+uint64_t EventMerger::GetIncomplete(){
+  lock_guard<mutex> lock(m_mutex);
+  return m_incomplete;
+}
+
+uint32_t EventMerger::GetNumFEs(){
+  return m_num_fes;
+}
@@ -1,25 +1,12 @@
 #include "RD53Emulator/Field.h"
+#include "RD53Emulator/Configuration.h"
 
 using namespace std;
 using namespace RD53A;
 
-vector<uint32_t> Field::m_masks = {
-  0x0000,
-  0x0001,0x0003,0x0007,0x000F,
-  0x001F,0x003F,0x007F,0x00FF,
-  0x01FF,0x03FF,0x07FF,0x0FFF,
-  0x1FFF,0x3FFF,0x7FFF,0xFFFF,
-};
-
-Field::Field(Register * data, uint32_t start, uint32_t len, uint32_t defval, bool reversed){
-  m_data=data;
-  m_start=start;
-  m_len=len;
-  m_defval=defval;
-  m_mask=m_masks[len];
-  m_smask=m_mask<<m_start;
-  m_reversed=reversed;
-  SetValue(m_defval);
+Field::Field(Configuration * config, const Layout * layout){
+  m_config=config;
+  m_layout=layout;
 }
 
 Field::~Field(){}
@@ -34,15 +21,22 @@ uint32_t Field::Reverse(uint32_t value, uint32_t sz){
 }
 
 void Field::SetValue(uint32_t value){
-  if(m_reversed){value=Reverse(value,m_len);}
-  uint32_t val=m_data->GetValue();
-  val&=~(m_smask);
-  val|=((value&m_mask)<<m_start);
-  m_data->SetValue(val);
+  if(m_layout->length==0){return;}
+  uint32_t mask=(1<<m_layout->length)-1;
+  if(m_layout->reversed){value=Reverse(value,m_layout->length);}
+  uint32_t val=m_config->GetRegister(m_layout->address);
+  val&=~(mask<<m_layout->start);
+  val|=((value&mask)<<m_layout->start);
+  m_config->SetRegister(m_layout->address,val);
 }
 
 uint32_t Field::GetValue(){
-  uint32_t value = (m_data->GetValue()>>m_start)&m_mask;
-  if(m_reversed){value=Reverse(value,m_len);}
+  uint32_t mask=(1<<m_layout->length)-1;
+  uint32_t value = (m_config->GetRegister(m_layout->address)>>m_layout->start)&mask;
+  if(m_layout->reversed){value=Reverse(value,m_layout->length);}
   return value;
 }
+
+Register Field::GetRegister(){
+  return Register(m_config,m_layout->address);
+}
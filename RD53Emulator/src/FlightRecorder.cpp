@@ -0,0 +1,191 @@
+#include "RD53Emulator/FlightRecorder.h"
+
+#include <cstring>
+#include <cerrno>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+using namespace std;
+using namespace RD53A;
+
+atomic<bool> FlightRecorder::m_enabled(false);
+thread_local FlightRecorder::Ring * FlightRecorder::m_ring = 0;
+
+namespace{
+
+  /** Dump file header, followed by one RingHeader and its events per ring */
+  struct FileHeader{
+    char magic[8];
+    uint32_t version;
+    uint32_t num_rings;
+    uint32_t event_size;
+    uint32_t ring_size;
+    uint64_t time0;      /**< event clock at the reference point */
+    int64_t realtime0;   /**< CLOCK_REALTIME in ns at the reference point */
+    uint64_t time1;      /**< event clock at the time of the dump */
+    int64_t realtime1;   /**< CLOCK_REALTIME in ns at the time of the dump */
+  };
+
+  struct RingHeader{
+    uint32_t tid;
+    uint32_t num_events;
+  };
+
+  atomic<FlightRecorder::Ring*> g_rings[FlightRecorder::MAX_THREADS];
+  atomic<uint32_t> g_num_rings(0);
+  atomic<uint64_t> g_time0(0);
+  atomic<int64_t> g_realtime0(0);
+
+  //paths are built when the handlers are installed, nothing can be allocated in a signal handler
+  char g_dump_path[1024];
+  char g_crash_path[1024];
+
+  int64_t RealTime(){
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME,&ts);
+    return (int64_t)ts.tv_sec*1000000000LL+ts.tv_nsec;
+  }
+
+  bool WriteAll(int fd, const void * data, size_t size){
+    const char * ptr=(const char*)data;
+    while(size>0){
+      ssize_t ret=write(fd,ptr,size);
+      if(ret<0){if(errno==EINTR){continue;} return false;}
+      ptr+=ret;
+      size-=ret;
+    }
+    return true;
+  }
+
+  /** Give the ring back when its thread finishes, so that a new thread can reuse it */
+  struct RingOwner{
+    FlightRecorder::Ring * ring;
+    ~RingOwner(){if(ring){ring->owned.store(false,memory_order_release);}}
+  };
+
+}
+
+void FlightRecorder::SetEnable(bool enable){
+  if(enable and !m_enabled.load()){
+    g_time0.store(Now());
+    g_realtime0.store(RealTime());
+  }
+  m_enabled.store(enable);
+}
+
+bool FlightRecorder::IsEnabled(){
+  return m_enabled.load();
+}
+
+FlightRecorder::Ring * FlightRecorder::Attach(){
+  static thread_local RingOwner owner{0};
+
+  Ring * ring = 0;
+  //a new ring while there is room, so that the events of finished threads are kept
+  uint32_t index = g_num_rings.load();
+  while(index<MAX_THREADS){
+    if(g_num_rings.compare_exchange_weak(index,index+1)){
+      ring = new Ring();
+      ring->owned.store(true);
+      g_rings[index].store(ring,memory_order_release);
+      break;
+    }
+  }
+  //otherwise reuse the ring of a finished thread
+  for(uint32_t i=0;i<MAX_THREADS and !ring;i++){
+    Ring * candidate = g_rings[i].load(memory_order_acquire);
+    bool owned = false;
+    if(candidate and candidate->owned.compare_exchange_strong(owned,true)){ring=candidate;}
+  }
+  if(!ring){return 0;}
+  ring->tid = syscall(SYS_gettid);
+  ring->head.store(0,memory_order_release);
+  owner.ring = ring;
+  m_ring = ring;
+  return ring;
+}
+
+int64_t FlightRecorder::Dump(const char * path){
+
+  int fd = open(path, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+  if(fd<0){return -1;}
+
+  FileHeader hdr;
+  memcpy(hdr.magic,"RD53AFR1",8);
+  hdr.version = 1;
+  hdr.num_rings = g_num_rings.load(memory_order_acquire);
+  if(hdr.num_rings>MAX_THREADS){hdr.num_rings=MAX_THREADS;}
+  hdr.event_size = sizeof(Event);
+  hdr.ring_size = NUM_EVENTS;
+  hdr.time0 = g_time0.load();
+  hdr.realtime0 = g_realtime0.load();
+  hdr.time1 = Now();
+  hdr.realtime1 = RealTime();
+
+  bool ok = WriteAll(fd,&hdr,sizeof(hdr));
+  int64_t total = 0;
+  for(uint32_t i=0;i<hdr.num_rings and ok;i++){
+    Ring * ring = g_rings[i].load(memory_order_acquire);
+    RingHeader rhdr{0,0};
+    uint64_t head = 0;
+    if(ring){
+      head = ring->head.load(memory_order_acquire);
+      rhdr.tid = ring->tid;
+      rhdr.num_events = (head<NUM_EVENTS?head:NUM_EVENTS);
+    }
+    ok = WriteAll(fd,&rhdr,sizeof(rhdr));
+    if(!ok or rhdr.num_events==0){continue;}
+    //oldest first
+    uint32_t first = (head-rhdr.num_events)&(NUM_EVENTS-1);
+    uint32_t n1 = (first+rhdr.num_events>NUM_EVENTS ? NUM_EVENTS-first : rhdr.num_events);
+    ok = WriteAll(fd,&ring->events[first],n1*sizeof(Event));
+    if(ok and n1<rhdr.num_events){
+      ok = WriteAll(fd,&ring->events[0],(rhdr.num_events-n1)*sizeof(Event));
+    }
+    total += rhdr.num_events;
+  }
+
+  close(fd);
+  return (ok?total:-1);
+}
+
+int64_t FlightRecorder::Dump(const string & path){
+  return Dump(path.c_str());
+}
+
+namespace{
+
+  void HandleDumpSignal(int){
+    int saved_errno = errno;
+    FlightRecorder::Dump(g_dump_path);
+    errno = saved_errno;
+  }
+
+  void HandleCrashSignal(int signo){
+    FlightRecorder::Dump(g_crash_path);
+    //the default action was restored by SA_RESETHAND
+    raise(signo);
+  }
+
+}
+
+void FlightRecorder::InstallSignalHandlers(const string & directory, int dump_signal){
+  string prefix = directory + "/flightrecorder-" + to_string(getpid());
+  strncpy(g_dump_path,(prefix+".bin").c_str(),sizeof(g_dump_path)-1);
+  strncpy(g_crash_path,(prefix+"-crash.bin").c_str(),sizeof(g_crash_path)-1);
+
+  struct sigaction action;
+  memset(&action,0,sizeof(action));
+  sigemptyset(&action.sa_mask);
+  action.sa_handler = HandleDumpSignal;
+  action.sa_flags = SA_RESTART;
+  sigaction(dump_signal,&action,0);
+
+  action.sa_handler = HandleCrashSignal;
+  action.sa_flags = SA_RESETHAND;
+  for(int signo : {SIGSEGV,SIGBUS,SIGFPE,SIGILL,SIGABRT}){
+    sigaction(signo,&action,0);
+  }
+}
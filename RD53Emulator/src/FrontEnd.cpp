@@ -1,4 +1,6 @@
 #include "RD53Emulator/FrontEnd.h"
+#include "RD53Emulator/FlightRecorder.h"
+#include "RD53Emulator/Macro.h"
 
 #include <iostream>
 #include <iomanip>
@@ -12,6 +14,16 @@ FrontEnd::FrontEnd(){
   m_encoder = new Encoder();
   m_config  = new Configuration();
   m_matrix  = new Matrix();
+  m_macros  = new MacroCache();
+  m_verifier = new ConfigVerifier();
+  m_events  = new EventBuilder();
+  m_histos  = 0;
+  m_merger  = 0;
+  m_merger_index = 0;
+  m_writer  = 0;
+  m_writer_index = 0;
+  m_registers = std::make_shared<RegisterCache>();
+  m_reads = std::make_shared<ReadTransactions>();
   m_verbose = 1;
   m_chipid = 0;
   m_name = "RD53A";
@@ -27,6 +39,10 @@ FrontEnd::~FrontEnd(){
   delete m_encoder;
   delete m_config;
   delete m_matrix;
+  delete m_macros;
+  delete m_verifier;
+  delete m_events;
+  if(m_histos) delete m_histos;
   for(uint32_t i=0;i<4;i++){
     delete m_ntcs[i];
     delete m_bjts[i];
@@ -75,18 +91,18 @@ void FrontEnd::SetActive(bool active){
 
 uint32_t FrontEnd::GetGlobalThreshold(uint32_t type){
   switch (type){
-  case Pixel::Lin: return m_config->GetField(Configuration::VTH_LIN)->GetValue();
-  case Pixel::Diff: return m_config->GetField(Configuration::VTH1_DIFF)->GetValue();
-  case Pixel::Sync: return m_config->GetField(Configuration::VTH_SYNC)->GetValue();
+  case Pixel::Lin: return m_config->GetField(Configuration::VTH_LIN).GetValue();
+  case Pixel::Diff: return m_config->GetField(Configuration::VTH1_DIFF).GetValue();
+  case Pixel::Sync: return m_config->GetField(Configuration::VTH_SYNC).GetValue();
   }
   return 0;
 }
 
 void FrontEnd::SetGlobalThreshold(uint32_t type, uint32_t threshold){
   switch (type){
-  case Pixel::Lin: return m_config->GetField(Configuration::VTH_LIN)->SetValue(threshold);
-  case Pixel::Diff: return m_config->GetField(Configuration::VTH1_DIFF)->SetValue(threshold);
-  case Pixel::Sync: return m_config->GetField(Configuration::VTH_SYNC)->SetValue(threshold);
+  case Pixel::Lin: return m_config->GetField(Configuration::VTH_LIN).SetValue(threshold);
+  case Pixel::Diff: return m_config->GetField(Configuration::VTH1_DIFF).SetValue(threshold);
+  case Pixel::Sync: return m_config->GetField(Configuration::VTH_SYNC).SetValue(threshold);
   }
 }
 
@@ -146,31 +162,66 @@ RadiationSensor * FrontEnd::GetRadiationSensor(uint32_t index){
   return m_bjts[index];
 }
 
+std::shared_ptr<RegisterCache> FrontEnd::GetRegisterCache(){
+  return m_registers;
+}
+
+std::shared_ptr<ReadTransactions> FrontEnd::GetReadTransactions(){
+  return m_reads;
+}
+
 void FrontEnd::WriteGlobal(){
-  for(auto addr : m_config->GetUpdatedRegisters()){
+  uint32_t addr;
+  while(m_config->NextUpdatedRegister(addr)){
     m_encoder->AddCommand(new WrReg(m_chipid,addr,m_config->GetRegister(addr)));
   }
 }
 
 void FrontEnd::ReadGlobal(){
+  //an answer of the pixel portal would be taken for the next pair of a running verification
+  bool verifying = m_verifier->IsActive();
   for(uint32_t addr=0;addr<=137;addr++){
+    if(verifying and addr==Configuration::PIX_PORTAL){continue;}
     m_encoder->AddCommand(new RdReg(m_chipid,addr));
   }
 }
 
+future<vector<uint16_t> > FrontEnd::ReadGlobal(uint32_t timeout_ms){
+  vector<uint32_t> addresses;
+  for(uint32_t addr=0;addr<=137;addr++){addresses.push_back(addr);}
+  return m_reads->Read(addresses,timeout_ms);
+}
+
 void FrontEnd::WritePixels(){
+  //6 rows per WrReg with the automatic row increment
+  uint32_t auto_row=m_config->GetField(Configuration::PIX_AUTO_ROW).GetValue();
+  m_config->GetField(Configuration::PIX_AUTO_ROW).SetValue(1);
   for(uint32_t dcol=0;dcol<200;dcol++){
-    for(uint32_t row=0;row<192;row++){
-      WritePixelPair(dcol,row);
+    m_config->GetField(Configuration::REGION_COL).SetValue(dcol);
+    m_config->GetField(Configuration::REGION_ROW).SetValue(0);
+    WriteGlobal();
+    for(uint32_t row=0;row<192;row+=6){
+      WrReg * wrreg = new WrReg(m_chipid,Configuration::PIX_PORTAL,m_matrix->GetPair(dcol,row));
+      for(uint32_t i=1;i<6;i++){wrreg->SetValue(m_matrix->GetPair(dcol,row+i),i);}
+      m_encoder->AddCommand(wrreg);
     }
+    //follow the chip, that incremented the row after each value
+    m_config->GetField(Configuration::REGION_ROW).SetValue(192);
+    m_config->GetField(Configuration::REGION_ROW).GetRegister().Update(false);
+    m_config->GetField(Configuration::PIX_PORTAL).SetValue(m_matrix->GetPair(dcol,191));
+    m_config->GetField(Configuration::PIX_PORTAL).GetRegister().Update(false);
   }
+  m_config->GetField(Configuration::PIX_AUTO_ROW).SetValue(auto_row);
+  WriteGlobal();
 }
 
 void FrontEnd::WritePixelPair(uint32_t double_col, uint32_t row){
   uint32_t value = m_matrix->GetPair(double_col,row);
-  m_config->GetField(Configuration::REGION_COL)->SetValue(double_col);
-  m_config->GetField(Configuration::REGION_ROW)->SetValue(row);
-  m_config->GetField(Configuration::PIX_PORTAL)->SetValue(value);
+  m_config->GetField(Configuration::REGION_COL).SetValue(double_col);
+  m_config->GetField(Configuration::REGION_ROW).SetValue(row);
+  //the region has to be written before the portal, that has a lower address
+  WriteGlobal();
+  m_config->GetField(Configuration::PIX_PORTAL).SetValue(value);
   WriteGlobal();
 }
 
@@ -183,10 +234,25 @@ void FrontEnd::ReadPixels(){
 }
 
 void FrontEnd::ReadPixelPair(uint32_t double_col, uint32_t row){
-  m_config->GetField(Configuration::REGION_COL)->SetValue(double_col);
-  m_config->GetField(Configuration::REGION_ROW)->SetValue(row);
+  m_config->GetField(Configuration::REGION_COL).SetValue(double_col);
+  m_config->GetField(Configuration::REGION_ROW).SetValue(row);
   WriteGlobal();
   m_encoder->AddCommand(new RdReg(m_chipid,0));
+  m_verifier->ExpectPair(double_col,row);
+}
+
+void FrontEnd::VerifyConfig(){
+  //pending registers first, so that they are part of the intended state
+  WriteGlobal();
+  m_verifier->Start(m_config,m_matrix);
+  for(uint32_t addr=ConfigVerifier::FIRST_REGISTER;addr<=ConfigVerifier::LAST_REGISTER;addr++){
+    m_encoder->AddCommand(new RdReg(m_chipid,addr));
+  }
+  ReadPixels();
+}
+
+ConfigVerifier * FrontEnd::GetConfigVerifier(){
+  return m_verifier;
 }
 
 void FrontEnd::SetMask(uint32_t mask_mode, uint32_t mask_iter){
@@ -214,10 +280,10 @@ void FrontEnd::SelectCoreColumn(uint32_t ccol, bool enable){
   else if(ccol==32)            { reg=Configuration::EN_CORE_COL_LIN_2;  off=32; }
   else if(ccol>=33 and ccol<49){ reg=Configuration::EN_CORE_COL_DIFF_1; off=33; }
   else if(ccol==49)            { reg=Configuration::EN_CORE_COL_DIFF_2; off=49; }
-  uint32_t value = m_config->GetField(reg)->GetValue();
+  uint32_t value = m_config->GetField(reg).GetValue();
   if(enable) value |= (1<<(ccol-off));
   else       value &= ~(1<<(ccol-off));
-  m_config->GetField(reg)->SetValue(value);
+  m_config->GetField(reg).SetValue(value);
   WriteGlobal();
 }
 
@@ -238,79 +304,119 @@ void FrontEnd::SetCoreColumn(uint32_t mode, uint32_t index, string frontend){
   }
 }
 
+MacroCache * FrontEnd::GetMacroCache(){
+  return m_macros;
+}
+
+bool FrontEnd::ReplayMacro(uint32_t operation, uint32_t arg0, uint32_t arg1){
+  //pending registers go first, they are not part of the sequence
+  WriteGlobal();
+  const MacroCache::Entry * entry = m_macros->Find(m_chipid,operation,arg0,arg1,m_config);
+  if(!entry){return false;}
+  for(auto & reg : entry->after){
+    m_config->LoadRegister(reg.first,reg.second);
+  }
+  m_encoder->AddCommand(new Macro(entry->bytes));
+  return true;
+}
+
+uint32_t FrontEnd::BeginMacro(){
+  m_macro_before.resize(m_config->Size());
+  for(uint32_t addr=0;addr<m_macro_before.size();addr++){
+    m_macro_before[addr]=m_config->GetRegister(addr);
+  }
+  return m_encoder->GetCommands().size();
+}
+
+void FrontEnd::EndMacro(uint32_t operation, uint32_t arg0, uint32_t arg1, uint32_t first){
+  vector<Command*> & cmds = m_encoder->GetCommands();
+  auto bytes = make_shared<vector<uint8_t> >();
+  uint8_t buffer[32];
+  MacroCache::Entry entry;
+  for(uint32_t i=first;i<cmds.size();i++){
+    uint32_t len=cmds[i]->Pack(buffer);
+    bytes->insert(bytes->end(),buffer,buffer+len);
+    if(cmds[i]->GetType()!=Command::WRREG){continue;}
+    uint32_t addr=dynamic_cast<WrReg*>(cmds[i])->GetAddress();
+    bool known=false;
+    for(auto & reg : entry.before){if(reg.first==addr){known=true;break;}}
+    if(known or addr>=m_macro_before.size()){continue;}
+    entry.before.push_back(make_pair(addr,m_macro_before[addr]));
+    entry.after.push_back(make_pair(addr,m_config->GetRegister(addr)));
+  }
+  entry.bytes = bytes;
+  m_macros->Store(m_chipid,operation,arg0,arg1,entry);
+}
+
 void FrontEnd::InitAdc(){
-  m_config->GetField(Configuration::ADC_TRIM)->SetValue(0);
-  m_config->GetField(Configuration::BANDGAP_TRIM)->SetValue(0);
-  m_config->GetField(Configuration::GLOBAL_PULSE_RT)->SetValue(8);
+  if(ReplayMacro(MacroCache::INIT_ADC,0,0)){return;}
+  uint32_t first=BeginMacro();
+  m_config->GetField(Configuration::ADC_TRIM).SetValue(0);
+  m_config->GetField(Configuration::BANDGAP_TRIM).SetValue(0);
+  m_config->GetField(Configuration::GLOBAL_PULSE_RT).SetValue(8);
   WriteGlobal();
   m_encoder->AddCommand(new Pulse(m_chipid));
+  EndMacro(MacroCache::INIT_ADC,0,0,first);
 }
 
 void FrontEnd::ReadSensor(uint32_t pos, bool read_radiation_sensor){
-  if(pos==0){
-    m_config->GetField(Configuration::SENSOR_BIAS_0)->SetValue(1);
-    m_config->GetField(Configuration::SENSOR_CURRENT_0)->SetValue(1);
-    m_config->GetField(Configuration::SENSOR_ENABLE_0)->SetValue(1);
+  if(pos<4){
     if(read_radiation_sensor == true)
-       m_bjts[pos]->SetPower(true);
+      m_bjts[pos]->SetPower(true);
     else
       m_ntcs[pos]->SetPower(true);
+  }
+  if(ReplayMacro(MacroCache::READ_SENSOR,pos,read_radiation_sensor)){return;}
+  uint32_t first=BeginMacro();
+  if(pos==0){
+    m_config->GetField(Configuration::SENSOR_BIAS_0).SetValue(1);
+    m_config->GetField(Configuration::SENSOR_CURRENT_0).SetValue(1);
+    m_config->GetField(Configuration::SENSOR_ENABLE_0).SetValue(1);
   }else if(pos==1){
-    m_config->GetField(Configuration::SENSOR_BIAS_1)->SetValue(1);
-    m_config->GetField(Configuration::SENSOR_CURRENT_1)->SetValue(1);
-    m_config->GetField(Configuration::SENSOR_ENABLE_1)->SetValue(1);
-    if(read_radiation_sensor == true)
-       m_bjts[pos]->SetPower(true);
-    else
-      m_ntcs[pos]->SetPower(true);
+    m_config->GetField(Configuration::SENSOR_BIAS_1).SetValue(1);
+    m_config->GetField(Configuration::SENSOR_CURRENT_1).SetValue(1);
+    m_config->GetField(Configuration::SENSOR_ENABLE_1).SetValue(1);
   }else if(pos==2){
-    m_config->GetField(Configuration::SENSOR_BIAS_2)->SetValue(1);
-    m_config->GetField(Configuration::SENSOR_CURRENT_2)->SetValue(1);
-    m_config->GetField(Configuration::SENSOR_ENABLE_2)->SetValue(1);
-    if(read_radiation_sensor == true)
-       m_bjts[pos]->SetPower(true);
-    else
-      m_ntcs[pos]->SetPower(true);
+    m_config->GetField(Configuration::SENSOR_BIAS_2).SetValue(1);
+    m_config->GetField(Configuration::SENSOR_CURRENT_2).SetValue(1);
+    m_config->GetField(Configuration::SENSOR_ENABLE_2).SetValue(1);
   }else if(pos==3){
-    m_config->GetField(Configuration::SENSOR_BIAS_3)->SetValue(1);
-    m_config->GetField(Configuration::SENSOR_CURRENT_3)->SetValue(1);
-    m_config->GetField(Configuration::SENSOR_ENABLE_3)->SetValue(1);
-    if(read_radiation_sensor == true)
-       m_bjts[pos]->SetPower(true);
-    else
-      m_ntcs[pos]->SetPower(true);
+    m_config->GetField(Configuration::SENSOR_BIAS_3).SetValue(1);
+    m_config->GetField(Configuration::SENSOR_CURRENT_3).SetValue(1);
+    m_config->GetField(Configuration::SENSOR_ENABLE_3).SetValue(1);
   }
-  m_config->GetField(Configuration::GLOBAL_PULSE_RT)->SetValue(6);
+  m_config->GetField(Configuration::GLOBAL_PULSE_RT).SetValue(6);
   WriteGlobal();
   m_encoder->AddCommand(new Pulse(m_chipid));
-  m_config->GetField(Configuration::GLOBAL_PULSE_RT)->SetValue(3);
+  m_config->GetField(Configuration::GLOBAL_PULSE_RT).SetValue(3);
   WriteGlobal();
   m_encoder->AddCommand(new Pulse(m_chipid));
   if(pos==0){
 	if(read_radiation_sensor == true)
-	  m_config->GetField(Configuration::MONITOR_VMON_MUX)->SetValue(4);
+	  m_config->GetField(Configuration::MONITOR_VMON_MUX).SetValue(4);
 	else
-	  m_config->GetField(Configuration::MONITOR_VMON_MUX)->SetValue(3);
+	  m_config->GetField(Configuration::MONITOR_VMON_MUX).SetValue(3);
   }else if(pos==1){
     if(read_radiation_sensor == true)
-      m_config->GetField(Configuration::MONITOR_VMON_MUX)->SetValue(6);
+      m_config->GetField(Configuration::MONITOR_VMON_MUX).SetValue(6);
 	else
-	  m_config->GetField(Configuration::MONITOR_VMON_MUX)->SetValue(5);
+	  m_config->GetField(Configuration::MONITOR_VMON_MUX).SetValue(5);
   }else if(pos==2){
     if(read_radiation_sensor == true)
-	  m_config->GetField(Configuration::MONITOR_VMON_MUX)->SetValue(15);
+	  m_config->GetField(Configuration::MONITOR_VMON_MUX).SetValue(15);
     else
-	  m_config->GetField(Configuration::MONITOR_VMON_MUX)->SetValue(14);
+	  m_config->GetField(Configuration::MONITOR_VMON_MUX).SetValue(14);
   }else if(pos==3){
 	if(read_radiation_sensor == true)
-	  m_config->GetField(Configuration::MONITOR_VMON_MUX)->SetValue(8);
+	  m_config->GetField(Configuration::MONITOR_VMON_MUX).SetValue(8);
 	else
-	  m_config->GetField(Configuration::MONITOR_VMON_MUX)->SetValue(7);
+	  m_config->GetField(Configuration::MONITOR_VMON_MUX).SetValue(7);
   }
-  m_config->GetField(Configuration::GLOBAL_PULSE_RT)->SetValue(12);
+  m_config->GetField(Configuration::GLOBAL_PULSE_RT).SetValue(12);
   WriteGlobal();
   m_encoder->AddCommand(new Pulse(m_chipid));
   m_encoder->AddCommand(new RdReg(m_chipid,136));
+  EndMacro(MacroCache::READ_SENSOR,pos,read_radiation_sensor,first);
 }
 
 void FrontEnd::Trigger(uint32_t delay){
@@ -325,26 +431,80 @@ void FrontEnd::Trigger(uint32_t delay){
 
 }
 
-Hit * FrontEnd::GetHit(){
-  Hit * tmp = NULL;
-  m_mutex.lock();
-  tmp = m_hits.front();
-  m_mutex.unlock();
-  return tmp;
+const EventBatch * FrontEnd::GetEvents(){
+  return m_events->GetEvents();
+}
+
+void FrontEnd::ReleaseEvents(const EventBatch * batch){
+  m_events->ReleaseEvents(batch);
+}
+
+bool FrontEnd::HasEvents(){
+  return m_events->HasEvents();
+}
+
+EventBuilder * FrontEnd::GetEventBuilder(){
+  return m_events;
 }
 
-bool FrontEnd::NextHit(){
-  if (m_hits.empty()) return false;
-  m_mutex.lock();
-  Hit * hit = m_hits.front();
-  m_hits.pop_front();
-  delete hit;
-  m_mutex.unlock();
-  return (!m_hits.empty());
+void FrontEnd::SetMonitoring(bool enable){
+  if(enable==(m_histos!=0)){return;}
+  m_events->SetMonitor(nullptr);
+  if(m_histos){delete m_histos; m_histos=0;}
+  if(enable){m_histos = new HistogramEngine();}
+  UpdateMonitor();
 }
 
-bool FrontEnd::HasHits(){
-  return (not m_hits.empty());
+HistogramEngine * FrontEnd::GetHistograms(){
+  return m_histos;
+}
+
+void FrontEnd::SetEventMerger(EventMerger * merger, uint32_t index){
+  m_events->SetMonitor(nullptr);
+  m_merger = merger;
+  m_merger_index = index;
+  UpdateMonitor();
+}
+
+EventMerger * FrontEnd::GetEventMerger(){
+  return m_merger;
+}
+
+uint32_t FrontEnd::GetEventMergerIndex(){
+  return m_merger_index;
+}
+
+void FrontEnd::SetHitWriter(HitWriter * writer, uint32_t index){
+  m_events->SetMonitor(nullptr);
+  m_writer = writer;
+  m_writer_index = index;
+  UpdateMonitor();
+}
+
+HitWriter * FrontEnd::GetHitWriter(){
+  return m_writer;
+}
+
+void FrontEnd::UpdateMonitor(){
+  HistogramEngine * histos = m_histos;
+  EventMerger * merger = m_merger;
+  uint32_t index = m_merger_index;
+  HitWriter * writer = m_writer;
+  uint32_t stream = m_writer_index;
+  if(!histos and !merger and !writer){m_events->SetMonitor(nullptr); return;}
+  m_events->SetMonitor([histos,merger,index,writer,stream](const EventBatch * batch){
+    if(histos){histos->Fill(0,batch);}
+    if(merger){merger->AddFragments(index,batch);}
+    if(writer){writer->Write(stream,batch);}
+  });
+}
+
+void FrontEnd::AddHits(DataFrame * data, uint32_t pos){
+  for(uint32_t idx=0;idx<4;idx++){
+    if(data->GetTOT(pos,idx)>0){
+      m_events->AddHit(data->GetCol(pos)+idx,data->GetRow(pos),data->GetTOT(pos,idx));
+    }
+  }
 }
 
 void FrontEnd::HandleData(uint8_t *recv_data, uint32_t recv_size){
@@ -353,8 +513,8 @@ void FrontEnd::HandleData(uint8_t *recv_data, uint32_t recv_size){
   m_decoder->SetBytes(recv_data,recv_size);
   if(m_verbose){cout << "FrontEnd::HandleData Decode" << endl;}
   m_decoder->Decode(m_verbose);
+  FlightRecorder::Record(FlightRecorder::FRAMES_DECODED,m_chipid,m_decoder->GetFrames().size());
 
-  Hit hit;
   for(auto frame: m_decoder->GetFrames()){
 
     if(m_verbose) cout << "FrontEnd::HandleData() processing frame of type " << frame->GetType() << endl;
@@ -365,23 +525,31 @@ void FrontEnd::HandleData(uint8_t *recv_data, uint32_t recv_size){
       if(m_verbose) cout << __PRETTY_FUNCTION__ << reg->ToString() << endl;
       if(reg->GetAuroraCode()!=0xCC){
         for(uint32_t i=0;i<2;i++){
-          if(reg->GetAddress(i)==Configuration::PIX_PORTAL){
-            uint32_t reg_col=m_config->GetField(Configuration::REGION_COL)->GetValue();
-            uint32_t reg_row=m_config->GetField(Configuration::REGION_ROW)->GetValue();
+          if(reg->GetAuto(i)==0 and m_verifier->Receive(reg->GetAddress(i),reg->GetValue(i))){
+            //read back for the verification, the intended configuration stays
+          }
+          else if(reg->GetAddress(i)==Configuration::PIX_PORTAL){
+            uint32_t reg_col=m_config->GetField(Configuration::REGION_COL).GetValue();
+            uint32_t reg_row=m_config->GetField(Configuration::REGION_ROW).GetValue();
             m_matrix->SetPair(reg_col,reg_row,reg->GetValue(i));
           }
           else if(reg->GetAddress(i)>Configuration::PIX_PORTAL and reg->GetAddress(i)<=0x1FF){
             m_config->SetRegister(reg->GetAddress(i),reg->GetValue(i));
           }
+          m_registers->Update(reg->GetAddress(i),reg->GetValue(i));
+          if(reg->GetAuto(i)==0){m_reads->Match(reg->GetAddress(i),reg->GetValue(i));}
+          FlightRecorder::Record(FlightRecorder::REGISTER_MATCHED,m_chipid,(reg->GetAddress(i)<<16)|reg->GetValue(i));
           if(reg->GetAddress(i) == 136){
         	for(int j=0; j < 4; j++){
         	  if(m_ntcs[j]->GetPower() == true && m_ntcs[j]->isUpdated() == false && reg->GetAuto(i) == 0){
         	    m_ntcs[j]->SetADC(reg->GetValue(i));
         	    m_ntcs[j]->Update(true);
+        	    FlightRecorder::Record(FlightRecorder::SENSOR_UPDATED,m_chipid,(0<<24)|(j<<16)|reg->GetValue(i));
         	  }
         	  else if(m_bjts[j]->GetPower() == true && m_bjts[j]->isUpdated() == false && reg->GetAuto(i) == 0){
         		m_bjts[j]->SetADC(reg->GetValue(i));
         		m_bjts[j]->Update(true);
+        		FlightRecorder::Record(FlightRecorder::SENSOR_UPDATED,m_chipid,(1<<24)|(j<<16)|reg->GetValue(i));
           	  }
           	}
           }
@@ -391,58 +559,26 @@ void FrontEnd::HandleData(uint8_t *recv_data, uint32_t recv_size){
       if(m_verbose) cout << "FrontEnd::HandleData: Data " << frame->ToString() << endl;
       DataFrame * dat=dynamic_cast<DataFrame*>(frame);
       if(dat->GetType()==DataFrame::SYN_HDR){
-        hit.Update(dat->GetTID(1),dat->GetTTag(1),dat->GetBCID(1));
+        m_events->AddHeader(dat->GetTID(1),dat->GetTTag(1),dat->GetBCID(1));
       }else if(dat->GetType()==DataFrame::HDR_HDR){
-        hit.Update(dat->GetTID(0),dat->GetTTag(0),dat->GetBCID(0));
-        hit.Update(dat->GetTID(1),dat->GetTTag(1),dat->GetBCID(1));
+        m_events->AddHeader(dat->GetTID(0),dat->GetTTag(0),dat->GetBCID(0));
+        m_events->AddHeader(dat->GetTID(1),dat->GetTTag(1),dat->GetBCID(1));
       }else if(dat->GetType()==DataFrame::HDR_HIT){
-        hit.Update(dat->GetTID(0),dat->GetTTag(0),dat->GetBCID(0));
-        for(uint32_t idx=0;idx<4;idx++){
-          if(dat->GetTOT(1,idx)>0){
-            Hit * nhit = hit.Clone();
-            nhit->Set(dat->GetCol(1)+idx,dat->GetRow(1),dat->GetTOT(1,idx));
-            m_mutex.lock();
-            m_hits.push_back(nhit);
-            m_mutex.unlock();
-          }
-        }
+        m_events->AddHeader(dat->GetTID(0),dat->GetTTag(0),dat->GetBCID(0));
+        AddHits(dat,1);
       }else if(dat->GetType()==DataFrame::SYN_HIT){
-        for(uint32_t idx=0;idx<4;idx++){
-          if(dat->GetTOT(1,idx)>0){
-            Hit * nhit = hit.Clone();
-            nhit->Set(dat->GetCol(1)+idx,dat->GetRow(1),dat->GetTOT(1,idx));
-            m_mutex.lock();
-            m_hits.push_back(nhit);
-            m_mutex.unlock();
-          }
-        }
+        AddHits(dat,1);
       }else if(dat->GetType()==DataFrame::HIT_HDR){
-        for(uint32_t idx=0;idx<4;idx++){
-          if(dat->GetTOT(0,idx)>0){
-            Hit * nhit = hit.Clone();
-            nhit->Set(dat->GetCol(0)+idx,dat->GetRow(0),dat->GetTOT(0,idx));
-            m_mutex.lock();
-            m_hits.push_back(nhit);
-            m_mutex.unlock();
-          }
-        }
-        hit.Update(dat->GetTID(1),dat->GetTTag(1),dat->GetBCID(1));
+        AddHits(dat,0);
+        m_events->AddHeader(dat->GetTID(1),dat->GetTTag(1),dat->GetBCID(1));
       }else if(dat->GetType()==DataFrame::HIT_HIT){
-        for(uint32_t i=0;i<2;i++){
-          for(uint32_t idx=0;idx<4;idx++){
-            if(dat->GetTOT(i,idx)>0){
-              Hit * nhit = hit.Clone();
-              nhit->Set(dat->GetCol(i)+idx,dat->GetRow(i),dat->GetTOT(i,idx));
-              m_mutex.lock();
-              m_hits.push_back(nhit);
-              m_mutex.unlock();
-            }
-          }
-        }
+        AddHits(dat,0);
+        AddHits(dat,1);
       }
 
     }
   }
+  m_events->Flush();
 }
 
 void FrontEnd::ProcessCommands(){
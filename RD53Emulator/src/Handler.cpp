@@ -1,5 +1,7 @@
 #include "RD53Emulator/Handler.h"
 #include "RD53Emulator/RunNumber.h"
+#include "RD53Emulator/RdReg.h"
+#include "RD53Emulator/FlightRecorder.h"
 #include "netio/netio.hpp"
 #include <json.hpp>
 #include <iostream>
@@ -9,6 +11,9 @@
 #include <sstream>
 #include <iomanip>
 #include "TFile.h"
+#include "TH1I.h"
+#include "TH2I.h"
+#include "TH2F.h"
 
 using json=nlohmann::basic_json<std::map, std::vector, std::string, bool, std::int32_t, std::uint32_t, float>;
 using namespace std;
@@ -38,12 +43,21 @@ Handler::Handler(){
 
   m_verbose = false;
   m_backend = "posix";
+  m_event_loops = 1;
+  m_busy_poll = 0;
+  m_context = 0;
   m_retune = false;
   m_enable = false;
   m_rootfile = 0;
   m_outpath = (getenv("ITK_DATA_PATH")?string(getenv("ITK_DATA_PATH")):".");
   m_rn = new RunNumber();
   m_output = true;
+  m_monitoring = false;
+  m_merging = false;
+  m_merger = 0;
+  m_hit_output = false;
+  m_direct_io = false;
+  m_writer = 0;
   m_nrow = 192;
   m_ncol = 400;
   m_fulloutpath = "";
@@ -56,6 +70,8 @@ Handler::~Handler(){
     delete fe;
   }
   m_fes.clear();
+  if(m_merger) delete m_merger;
+  if(m_writer) delete m_writer;
   if(m_rootfile) delete m_rootfile;
   delete m_rn;
 }
@@ -71,6 +87,14 @@ void Handler::SetContext(string context){
   m_backend = context;
 }
 
+void Handler::SetEventLoops(uint32_t num_loops){
+  m_event_loops = num_loops;
+}
+
+void Handler::SetBusyPoll(uint32_t usecs){
+  m_busy_poll = usecs;
+}
+
 void Handler::SetInterface(string interface){
   m_interface = interface;
 }
@@ -145,6 +169,18 @@ std::vector<FrontEnd*> Handler::GetFEs(){
   return m_fes;
 }
 
+netio::socket_stats* Handler::GetCmdStats(string name){
+  auto it=m_fe_tx.find(name);
+  if(it==m_fe_tx.end() or m_tx.count(it->second)==0){return nullptr;}
+  return &m_tx[it->second]->stats();
+}
+
+netio::socket_stats* Handler::GetDataStats(string name){
+  auto it=m_fe_rx.find(name);
+  if(it==m_fe_rx.end() or m_rx.count(it->second)==0){return nullptr;}
+  return &m_rx[it->second]->stats();
+}
+
 bool Handler::GetEnable(){
   return m_enable;
 }
@@ -153,6 +189,40 @@ bool Handler::GetEnableOutput(){
   return m_output;
 }
 
+void Handler::EnableMonitoring(bool enable){
+  m_monitoring=enable;
+  for(auto fe : m_fes){fe->SetMonitoring(enable);}
+}
+
+bool Handler::GetEnableMonitoring(){
+  return m_monitoring;
+}
+
+void Handler::EnableEventMerging(bool enable){
+  m_merging=enable;
+}
+
+bool Handler::GetEnableEventMerging(){
+  return m_merging;
+}
+
+EventMerger * Handler::GetEventMerger(){
+  return m_merger;
+}
+
+void Handler::EnableHitOutput(bool enable, bool direct){
+  m_hit_output=enable;
+  m_direct_io=direct;
+}
+
+bool Handler::GetEnableHitOutput(){
+  return m_hit_output;
+}
+
+HitWriter * Handler::GetHitWriter(){
+  return m_writer;
+}
+
 bool Handler::GetRetune(){
   return m_retune;
 }
@@ -185,6 +255,7 @@ void Handler::AddFE(string name, FrontEnd* fe){
 
   fe->SetName(name);
   fe->SetActive(true);
+  fe->SetMonitoring(m_monitoring);
   m_fe[name]=fe;
   m_fes.push_back(fe);
   m_enabled[name]=true;
@@ -217,6 +288,7 @@ void Handler::AddFE(string name, string path){
    //Actually read the file
    fe->SetChipID(config["RD53A"]["Parameter"]["ChipId"]);
    fe->SetActive(true);
+   fe->SetMonitoring(m_monitoring);
 
    if(m_verbose) cout << "Handler::AddFE" << " Reading global registers" << endl;
    fe->SetGlobalConfig(config["RD53A"]["GlobalConfig"]);
@@ -285,10 +357,15 @@ void Handler::SaveFE(FrontEnd * fe, string path){
 
 void Handler::Connect(){
 
-  //Connect to FELIX
-  cout << "Handler::Connect Create the context" << endl;
-  m_context = new netio::context(m_backend.c_str());
-  m_context_thread = thread([&](){m_context->event_loop()->run_forever();});
+  //Connect to FELIX, the sockets of a previous Connect keep running on the same context
+  if(!m_context){
+    cout << "Handler::Connect Create the context" << endl;
+    m_context = new netio::context(m_backend.c_str(), m_event_loops);
+    for(uint32_t i=0; i<m_context->num_event_loops(); i++){
+      m_context->event_loop(i)->set_busy_poll(m_busy_poll);
+    }
+    m_context->start(m_event_loops>1);
+  }
 
   //TX
   for(auto it : m_fe_tx){
@@ -296,20 +373,79 @@ void Handler::Connect(){
     uint32_t tx_elink = it.second;
     if(m_tx.count(tx_elink)==0){
       cout << "Handler::Connect Connect to cmd elink: " << tx_elink << " at " << m_cmd_host[tx_elink] << ":" << m_cmd_port[tx_elink] << endl;
-      m_tx[tx_elink]=new netio::low_latency_send_socket(m_context);
+      m_tx[tx_elink]=new netio::low_latency_send_socket(m_context, netio::sockcfg::cfg()(netio::sockcfg::BUSY_POLL_USECS, m_busy_poll));
       m_tx[tx_elink]->connect(netio::endpoint(m_cmd_host[tx_elink],m_cmd_port[tx_elink]));
+      m_tx_mutex[tx_elink];
     }
     m_tx_fes[tx_elink].push_back(m_fe[it.first]);
+
+    //Register reads requested from other threads are sent as one message per batch,
+    //with their own encoder so they don't interfere with the commands of the scan
+    FrontEnd * fe = m_fe[it.first];
+    shared_ptr<Encoder> encoder = make_shared<Encoder>();
+    auto sender = [this,fe,tx_elink,encoder](const vector<uint32_t> & addresses){
+      //the encoder is shared by the register cache and the read transactions
+      //the pixel portal answers carry no address, they belong to a running verification
+      bool verifying = fe->GetConfigVerifier()->IsActive();
+      lock_guard<mutex> lock(m_tx_mutex.at(tx_elink));
+      for(auto addr : addresses){
+        if(verifying and addr==Configuration::PIX_PORTAL){continue;}
+        encoder->AddCommand(new RdReg(fe->GetChipID(),addr));
+      }
+      if(encoder->GetCommands().empty()){return;}
+      encoder->Encode();
+      FelixCmdHeader hdr;
+      hdr.elink=tx_elink;
+      hdr.length=encoder->GetLength();
+      netio::message msg;
+      msg.add_fragment((uint8_t*)&hdr,sizeof(hdr));
+      msg.add_fragment(encoder->GetBytes(),encoder->GetLength());
+      m_tx[tx_elink]->send(msg);
+      FlightRecorder::Record(FlightRecorder::COMMAND_SENT,tx_elink,msg.size());
+      encoder->Clear();
+    };
+    fe->GetRegisterCache()->SetSender(sender);
+    fe->GetReadTransactions()->SetSender(sender);
+  }
+
+  //Match the events of the enabled front-ends, fed from the threads of their data elinks
+  if(m_merging){
+    vector<FrontEnd*> fes;
+    for(auto it : m_fe_rx){
+      if(m_enabled[it.first]==false){continue;}
+      fes.push_back(m_fe[it.first]);
+    }
+    //Connect is called for every front-end, keep the merger while the set of front-ends is the same
+    bool same = (m_merger && m_merger->GetNumFEs()==fes.size());
+    for(uint32_t i=0;same && i<fes.size();i++){
+      same = (fes[i]->GetEventMerger()==m_merger && fes[i]->GetEventMergerIndex()==i);
+    }
+    if(!same){
+      //the monitors of the front-ends use the previous merger until they are detached
+      for(auto fe : m_fes){fe->SetEventMerger(NULL,0);}
+      if(m_merger) delete m_merger;
+      m_merger = new EventMerger(fes.size());
+      for(uint32_t i=0;i<fes.size();i++){fes[i]->SetEventMerger(m_merger,i);}
+      cout << "Handler::Connect Build events across " << fes.size() << " front-ends" << endl;
+    }
   }
 
   //RX
   for(auto it : m_fe_rx){
     if(m_enabled[it.first]==false){continue;}
     uint32_t rx_elink = it.second;
+    if(m_rx.count(rx_elink)){continue;}
     m_rx_fe[rx_elink] = m_fe[it.first];
+    //nothing here takes the event batches, they only go through the monitor of the FrontEnd
+    m_fe[it.first]->GetEventBuilder()->SetMaxBatches(0);
     m_mutex[rx_elink].unlock();
+    //Keep all the elinks of one FELIX data port on the same event loop
+    netio::endpoint data_ep(m_data_host[rx_elink], m_data_port[rx_elink]);
+    netio::sockcfg data_cfg = netio::sockcfg::cfg()(netio::sockcfg::EVENT_LOOP, m_context->event_loop_index(data_ep))
+                                                   (netio::sockcfg::BUSY_POLL_USECS, m_busy_poll);
     m_rx[rx_elink] = new netio::low_latency_subscribe_socket(m_context, [&,rx_elink](netio::endpoint& ep, netio::message& msg){
       m_mutex[rx_elink].lock();
+      FlightRecorder::Record(FlightRecorder::MESSAGE_RECEIVED,rx_elink,msg.size());
       if(m_verbose) cout << "Handler::Connect Received data from " << ep.address() << ":" << ep.port() << " size:" << msg.size() << endl;
       vector<uint8_t> data = msg.data_copy();
       //We should remove any potential header before decoding
@@ -317,9 +453,9 @@ void Handler::Connect(){
       memcpy(&hdr,(const void*)&data[0], sizeof(hdr));
       m_rx_fe[rx_elink]->HandleData(&data[sizeof(hdr)],data.size()-sizeof(hdr));
       m_mutex[rx_elink].unlock();
-    });
+    }, data_cfg);
     cout << "Handler::Connect Subscribe to data elink: " << rx_elink << " at " << m_data_host[rx_elink] << ":" << m_data_port[rx_elink] << endl;
-    m_rx[rx_elink]->subscribe(rx_elink, netio::endpoint(m_data_host[rx_elink], m_data_port[rx_elink]));
+    m_rx[rx_elink]->subscribe(rx_elink, data_ep);
   }
 
   if(!m_output) return;
@@ -341,6 +477,26 @@ void Handler::Connect(){
   m_rootfile=TFile::Open(opath.str().c_str(),"RECREATE");
   if(m_verbose) cout << "Handler::Connect Created root file " << opath.str().c_str() << endl;
 
+  //Write the hits of the enabled front-ends in the background
+  if(m_hit_output){
+    vector<FrontEnd*> fes;
+    for(auto it : m_fe_rx){
+      if(m_enabled[it.first]==false){continue;}
+      fes.push_back(m_fe[it.first]);
+    }
+    //the front-ends stop writing before the writer of a previous Connect goes away
+    if(m_writer){
+      for(auto fe : m_fes){fe->SetHitWriter(NULL,0);}
+      delete m_writer;
+    }
+    m_writer = new HitWriter(fes.size());
+    string hpath = m_fulloutpath + "/hits.rd53";
+    if(m_writer->Open(hpath,m_direct_io)){
+      for(uint32_t i=0;i<fes.size();i++){fes[i]->SetHitWriter(m_writer,i);}
+      cout << "Handler::Connect Writing hits to " << hpath << endl;
+    }
+  }
+
 }
 
 void Handler::Config(){
@@ -359,32 +515,42 @@ void Handler::Config(){
 
 }
 
-void Handler::PrepareTrigger(uint32_t cal_delay){
-  cout << "Handler::PrepareTrigger: Preparing trigger with delay " << cal_delay << endl;
+void Handler::PrepareTrigger(uint32_t cal_delay, uint32_t ntriggers){
+  cout << "Handler::PrepareTrigger: Preparing " << ntriggers << " triggers with delay " << cal_delay << endl;
   for(auto it : m_tx_fes){
     if(m_verbose) cout << "Handler::PrepareTrigger: Composing trigger message for tx " << it.first << endl;
-    FrontEnd * fe = it.second.at(0);
-    fe->Trigger(cal_delay);
-    fe->ProcessCommands();
-    m_trigger_msgs[it.first]=vector<uint8_t>();
-    for(uint32_t i=0;i<fe->GetLength();i++){m_trigger_msgs[it.first].push_back(fe->GetBytes()[i]);}
-    fe->Clear();
+    //same sequence as FrontEnd::Trigger, encoded once for the whole burst
+    lock_guard<mutex> lock(m_tx_mutex[it.first]);
+    m_trigger_templates[it.first].Build(7,cal_delay,ntriggers);
   }
 }
 
 void Handler::Trigger(){
+  SendTrigger(false,0);
+}
+
+void Handler::Trigger(uint32_t first_tag){
+  SendTrigger(true,first_tag);
+}
+
+void Handler::SendTrigger(bool retag, uint32_t first_tag){
 
   for(auto it : m_tx){
     if(m_verbose) cout << "Handler::Trigger: Trigger! for tx " << it.first << endl;
 
+    //the message points to the template bytes, keep them under the lock until it is sent
+    lock_guard<mutex> lock(m_tx_mutex.at(it.first));
+    TriggerTemplate & burst = m_trigger_templates[it.first];
+    if(retag){burst.SetTags(first_tag);}
     FelixCmdHeader hdr;
     hdr.elink=it.first;
-    hdr.length=m_trigger_msgs[it.first].size();
+    hdr.length=burst.GetLength();
     netio::message msg;
     msg.add_fragment((uint8_t*)&hdr,sizeof(hdr));
-    msg.add_fragment(m_trigger_msgs[it.first].data(), m_trigger_msgs[it.first].size());
+    msg.add_fragment(burst.GetBytes(), burst.GetLength());
     //send message
     it.second->send(msg);
+    FlightRecorder::Record(FlightRecorder::COMMAND_SENT,it.first,msg.size());
 
     if(m_verbose){
       cout << "Handler::Trigger: Message: 0x" << hex;
@@ -418,7 +584,11 @@ void Handler::Send(FrontEnd * fe){
   //msg.add_fragment(fe->GetBytes(), fe->GetLength());
   msg.add_fragment(payload.data(), payload.size());
   //send message
-  m_tx[tx_elink]->send(msg); // EJS: this one hangs, probably because there's no active listener
+  {
+    lock_guard<mutex> lock(m_tx_mutex.at(tx_elink));
+    m_tx[tx_elink]->send(msg); // EJS: this one hangs, probably because there's no active listener
+  }
+  FlightRecorder::Record(FlightRecorder::COMMAND_SENT,tx_elink,msg.size());
   std::this_thread::sleep_for(std::chrono::milliseconds(10));
   fe->Clear();
 }
@@ -427,6 +597,12 @@ void Handler::Disconnect(){
 
   sleep(3); // 2020-11-06: EJS hack to avoid crash at the end of Dig scan (waiting for all data buffers to empty)
 
+  //Stop serving register reads before the sockets go away
+  for(auto fe : m_fes){
+    fe->GetRegisterCache()->SetSender(nullptr);
+    fe->GetReadTransactions()->SetSender(nullptr);
+  }
+
   for(auto it : m_tx){
     cout << __PRETTY_FUNCTION__ << "Disconnect from cmd elink: " << it.first << " at " << m_cmd_host[it.first] << ":" << m_cmd_port[it.first] << endl;
     it.second->disconnect();
@@ -441,14 +617,36 @@ void Handler::Disconnect(){
   }
   m_rx.clear();
 
-  cout << __PRETTY_FUNCTION__ << "Stop event loop" << endl;
-  m_context->event_loop()->stop();
+  cout << __PRETTY_FUNCTION__ << "Stop event loops and join their threads" << endl;
+  if(m_context){
+    m_context->stop();
+    cout << __PRETTY_FUNCTION__ << "Delete the context" << endl;
+    delete m_context;
+    m_context = 0;
+  }
 
-  cout << __PRETTY_FUNCTION__ << "Join context thread" << endl;
-  m_context_thread.join();
+  if(m_writer){
+    for(auto fe : m_fes){fe->SetHitWriter(NULL,0);}
+    bool ok = m_writer->Close();
+    cout << __PRETTY_FUNCTION__ << "Hits file: " << m_writer->GetNumBlocks() << " blocks, "
+         << m_writer->GetBytesWritten() << " bytes (" << m_writer->GetBytesRaw() << " uncompressed), "
+         << m_writer->GetDropped() << " events dropped" << (ok?"":", write errors") << endl;
+  }
 
-  cout << __PRETTY_FUNCTION__ << "Delete the context" << endl;
-  delete m_context;
+  if(m_merger){
+    for(auto fe : m_fes){fe->SetEventMerger(NULL,0);}
+    m_merger->Flush();
+    cout << __PRETTY_FUNCTION__ << "Events across front-ends: " << m_merger->GetComplete() << " complete, "
+         << m_merger->GetIncomplete() << " incomplete" << endl;
+    uint32_t index=0;
+    for(auto it : m_fe_rx){
+      if(m_enabled[it.first]==false){continue;}
+      EventMerger::Statistics stats = m_merger->GetStatistics(index++);
+      cout << __PRETTY_FUNCTION__ << it.first << " fragments: " << stats.fragments
+           << " matched: " << stats.matched << " missing: " << stats.missing
+           << " dropped: " << stats.dropped << endl;
+    }
+  }
 
 }
 
@@ -503,9 +701,54 @@ void Handler::Save(){
   }
 
 
+  SaveHistograms();
+
   if(m_rootfile){
     cout << "Save ROOT file: " << m_rootfile->GetName() << endl;
     m_rootfile->Close();
   }
 }
 
+void Handler::SaveHistograms(){
+  if(!m_output) return;
+  HitHistograms histos;
+  for(auto fe: m_fes){
+    if(!fe->IsActive() or !fe->GetHistograms()){continue;}
+    fe->GetHistograms()->Snapshot(histos);
+    string name=fe->GetName();
+
+    ostringstream os;
+    os << m_fulloutpath << "/" << name << "_histograms.bin";
+    if(!histos.Save(os.str())){cout << "Handler::SaveHistograms Cannot write: " << os.str() << endl;}
+
+    if(!m_rootfile){continue;}
+    m_rootfile->cd();
+    uint32_t ncols=HitHistograms::NUM_COLS;
+    uint32_t nrows=HitHistograms::NUM_ROWS;
+    TH2I * occ = new TH2I(("occupancy_"+name).c_str(),"Occupancy;Column;Row",ncols,-0.5,ncols-0.5,nrows,-0.5,nrows-0.5);
+    TH2F * tot = new TH2F(("meantot_"+name).c_str(),"Mean ToT;Column;Row",ncols,-0.5,ncols-0.5,nrows,-0.5,nrows-0.5);
+    TH1I * tots = new TH1I(("tot_"+name).c_str(),"ToT;ToT;Hits",HitHistograms::NUM_TOT,-0.5,HitHistograms::NUM_TOT-0.5);
+    TH1I * time = new TH1I(("time_"+name).c_str(),"Time;BC after the trigger;Hits",HitHistograms::NUM_TIME,-0.5,HitHistograms::NUM_TIME-0.5);
+    for(uint32_t col=0;col<ncols;col++){
+      for(uint32_t row=0;row<nrows;row++){
+        occ->SetBinContent(col+1,row+1,histos.GetOccupancy(col,row));
+        tot->SetBinContent(col+1,row+1,histos.GetMeanTot(col,row));
+      }
+    }
+    for(uint32_t i=0;i<HitHistograms::NUM_TOT;i++){tots->SetBinContent(i+1,histos.GetTot()[i]);}
+    for(uint32_t i=0;i<HitHistograms::NUM_TIME;i++){time->SetBinContent(i+1,histos.GetTime()[i]);}
+    occ->SetEntries(histos.GetNumHits());
+    tot->SetEntries(histos.GetNumHits());
+    tots->SetEntries(histos.GetNumHits());
+    time->SetEntries(histos.GetNumHits());
+    occ->Write();
+    tot->Write();
+    tots->Write();
+    time->Write();
+    delete occ;
+    delete tot;
+    delete tots;
+    delete time;
+  }
+}
+
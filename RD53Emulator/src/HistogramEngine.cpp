@@ -0,0 +1,67 @@
+#include "RD53Emulator/HistogramEngine.h"
+
+using namespace std;
+using namespace RD53A;
+
+HistogramEngine::HistogramEngine(uint32_t num_workers, uint32_t period_ms){
+  m_period=chrono::milliseconds(period_ms);
+  for(uint32_t i=0;i<num_workers;i++){
+    Worker * worker=new Worker();
+    worker->last_merge=Clock::now();
+    worker->filled=false;
+    m_workers.push_back(worker);
+  }
+}
+
+HistogramEngine::~HistogramEngine(){
+  for(auto worker : m_workers){delete worker;}
+  m_workers.clear();
+}
+
+void HistogramEngine::Fill(uint32_t worker, const EventBatch * batch){
+  Worker * w=m_workers[worker];
+  lock_guard<mutex> lock(w->mutex);
+  w->histos.Fill(batch);
+  w->filled=true;
+  if(Clock::now()-w->last_merge>=m_period){MergeLocked(w);}
+}
+
+void HistogramEngine::Merge(uint32_t worker){
+  Worker * w=m_workers[worker];
+  lock_guard<mutex> lock(w->mutex);
+  MergeLocked(w);
+}
+
+void HistogramEngine::MergeLocked(Worker * w){
+  w->last_merge=Clock::now();
+  if(!w->filled){return;}
+  {
+    lock_guard<mutex> lock(m_mutex);
+    m_merged.Add(w->histos);
+  }
+  w->histos.Clear();
+  w->filled=false;
+}
+
+void HistogramEngine::Snapshot(HitHistograms & copy){
+  for(auto w : m_workers){
+    lock_guard<mutex> lock(w->mutex);
+    MergeLocked(w);
+  }
+  lock_guard<mutex> lock(m_mutex);
+  copy=m_merged;
+}
+
+void HistogramEngine::Clear(){
+  for(auto w : m_workers){
+    lock_guard<mutex> lock(w->mutex);
+    w->histos.Clear();
+    w->filled=false;
+  }
+  lock_guard<mutex> lock(m_mutex);
+  m_merged.Clear();
+}
+
+uint32_t HistogramEngine::GetNumWorkers(){
+  return m_workers.size();
+}
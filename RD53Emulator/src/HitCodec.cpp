@@ -0,0 +1,152 @@
+#include "RD53Emulator/HitCodec.h"
+
+#include <cstddef>
+
+using namespace std;
+using namespace RD53A;
+
+namespace{
+
+inline uint32_t ZigZag(int32_t value){
+  return (uint32_t(value)<<1)^uint32_t(value>>31);
+}
+
+inline int32_t UnZigZag(uint32_t value){
+  return int32_t(value>>1)^-int32_t(value&1);
+}
+
+inline uint8_t * PutVarint(uint8_t * out, uint32_t value){
+  while(value>=0x80){
+    *out++=(value&0x7F)|0x80;
+    value>>=7;
+  }
+  *out++=value;
+  return out;
+}
+
+inline const uint8_t * GetVarint(const uint8_t * in, const uint8_t * end, uint32_t & value){
+  value=0;
+  for(uint32_t shift=0;shift<35 and in<end;shift+=7){
+    uint8_t byte=*in++;
+    value|=uint32_t(byte&0x7F)<<shift;
+    if(!(byte&0x80)){return in;}
+  }
+  return NULL;
+}
+
+inline void PutUInt32(uint8_t * out, uint32_t value){
+  out[0]=value;
+  out[1]=value>>8;
+  out[2]=value>>16;
+  out[3]=value>>24;
+}
+
+inline uint32_t GetUInt32(const uint8_t * in){
+  return uint32_t(in[0])|(uint32_t(in[1])<<8)|(uint32_t(in[2])<<16)|(uint32_t(in[3])<<24);
+}
+
+template<typename T>
+uint8_t * PutDeltas(uint8_t * out, const Span<T> & values){
+  int32_t last=0;
+  for(uint32_t i=0;i<values.size();i++){
+    out=PutVarint(out,ZigZag(int32_t(values[i])-last));
+    last=values[i];
+  }
+  return out;
+}
+
+bool GetDeltas(const uint8_t * in, const uint8_t * end, uint32_t count, vector<uint32_t> & values){
+  int32_t last=0;
+  values.resize(count);
+  for(uint32_t i=0;i<count;i++){
+    uint32_t value;
+    in=GetVarint(in,end,value);
+    if(!in){return false;}
+    last+=UnZigZag(value);
+    values[i]=last;
+  }
+  return in==end;
+}
+
+}
+
+uint32_t HitCodec::GetMaxSize(uint32_t max_hits, uint32_t max_events){
+  //worst case of the variable length integers: 2 bytes for 8 bits, 3 bytes for 16 bits, 5 bytes for 32 bits
+  return HEADER_SIZE+max_events*(2+2+3+5)+max_hits*(3+3)+(max_hits+1)/2;
+}
+
+uint32_t HitCodec::Encode(const EventBatch & batch, vector<uint8_t> & out){
+  uint32_t nevents=batch.GetNumEvents();
+  uint32_t nhits=batch.GetNumHits();
+  size_t start=out.size();
+  out.resize(start+GetMaxSize(nhits,nevents));
+  uint8_t * header=&out[start];
+  uint8_t * pos=header+HEADER_SIZE;
+  uint8_t * column[NUM_COLUMNS+1];
+
+  column[0]=pos; pos=PutDeltas(pos,batch.GetTIDs());
+  column[1]=pos; pos=PutDeltas(pos,batch.GetTTags());
+  column[2]=pos; pos=PutDeltas(pos,batch.GetBCIDs());
+  column[3]=pos;
+  for(uint32_t ev=0;ev<nevents;ev++){pos=PutVarint(pos,batch.GetNumHits(ev));}
+  column[4]=pos; pos=PutDeltas(pos,batch.GetCols());
+  column[5]=pos; pos=PutDeltas(pos,batch.GetRows());
+  column[6]=pos;
+  Span<uint8_t> tots=batch.GetTOTs();
+  for(uint32_t i=0;i<nhits;i+=2){
+    *pos++=(tots[i]&0xF)|(i+1<nhits?(tots[i+1]&0xF)<<4:0);
+  }
+  column[7]=pos;
+
+  PutUInt32(header,nevents);
+  PutUInt32(header+4,nhits);
+  for(uint32_t i=0;i<NUM_COLUMNS;i++){
+    PutUInt32(header+8+4*i,column[i+1]-column[i]);
+  }
+  uint32_t size=pos-header;
+  out.resize(start+size);
+  return size;
+}
+
+bool HitCodec::Decode(const uint8_t * data, uint32_t size, EventBatch & batch){
+  batch.Clear();
+  if(size<HEADER_SIZE){return false;}
+  uint32_t nevents=GetUInt32(data);
+  uint32_t nhits=GetUInt32(data+4);
+  //every event and every hit take at least one byte
+  if(nevents>size or nhits>size){return false;}
+  const uint8_t * column[NUM_COLUMNS+1];
+  column[0]=data+HEADER_SIZE;
+  for(uint32_t i=0;i<NUM_COLUMNS;i++){
+    uint32_t length=GetUInt32(data+8+4*i);
+    if(length>size or column[i]+length>data+size){return false;}
+    column[i+1]=column[i]+length;
+  }
+  if(column[7]-column[6]!=(nhits+1)/2){return false;}
+
+  vector<uint32_t> tids, ttags, bcids, nums, cols, rows;
+  if(!GetDeltas(column[0],column[1],nevents,tids)){return false;}
+  if(!GetDeltas(column[1],column[2],nevents,ttags)){return false;}
+  if(!GetDeltas(column[2],column[3],nevents,bcids)){return false;}
+  if(!GetDeltas(column[4],column[5],nhits,cols)){return false;}
+  if(!GetDeltas(column[5],column[6],nhits,rows)){return false;}
+  nums.resize(nevents);
+  const uint8_t * pos=column[3];
+  uint64_t total=0;
+  for(uint32_t ev=0;ev<nevents;ev++){
+    pos=GetVarint(pos,column[4],nums[ev]);
+    if(!pos){return false;}
+    total+=nums[ev];
+  }
+  if(pos!=column[4] or total!=nhits){return false;}
+
+  const uint8_t * tots=column[6];
+  uint32_t hit=0;
+  for(uint32_t ev=0;ev<nevents;ev++){
+    batch.AddEvent(tids[ev],ttags[ev],bcids[ev]);
+    for(uint32_t i=0;i<nums[ev];i++,hit++){
+      batch.AddHit(cols[hit],rows[hit],(tots[hit/2]>>(4*(hit&1)))&0xF);
+    }
+  }
+  return true;
+}
@@ -0,0 +1,168 @@
+#include "RD53Emulator/HitHistograms.h"
+
+#include <fstream>
+#include <cstring>
+
+using namespace std;
+using namespace RD53A;
+
+namespace{
+  const char MAGIC[8]={'R','D','5','3','A','H','I','S'};
+  const uint32_t VERSION=1;
+}
+
+HitHistograms::HitHistograms(){
+  m_occupancy.resize(NUM_PIXELS,0);
+  m_totsum.resize(NUM_PIXELS,0);
+  m_last_ttag=0xFFFFFFFF;
+  m_first_bcid=0;
+  Clear();
+}
+
+HitHistograms::~HitHistograms(){}
+
+void HitHistograms::Fill(const EventBatch * batch){
+  Span<uint8_t> ttags=batch->GetTTags();
+  Span<uint16_t> bcids=batch->GetBCIDs();
+  Span<uint32_t> first=batch->GetFirstHits();
+  Span<uint16_t> cols=batch->GetCols();
+  Span<uint16_t> rows=batch->GetRows();
+  Span<uint8_t> tots=batch->GetTOTs();
+  uint32_t * occupancy=m_occupancy.data();
+  uint32_t * totsum=m_totsum.data();
+
+  for(uint32_t ev=0;ev<first.size();ev++){
+    //the bunch crossings of a trigger share the trigger tag
+    if(ttags[ev]!=m_last_ttag){
+      m_last_ttag=ttags[ev];
+      m_first_bcid=bcids[ev];
+    }
+    uint32_t time=(bcids[ev]-m_first_bcid)&0x7FFF;
+    if(time>NUM_TIME-1){time=NUM_TIME-1;}
+
+    uint32_t last=(ev+1<first.size()?first[ev+1]:cols.size());
+    for(uint32_t i=first[ev];i<last;i++){
+      if(cols[i]>=NUM_COLS or rows[i]>=NUM_ROWS){continue;}
+      uint32_t pixel=cols[i]*NUM_ROWS+rows[i];
+      occupancy[pixel]++;
+      totsum[pixel]+=tots[i];
+      m_tot[tots[i]&(NUM_TOT-1)]++;
+    }
+    m_time[time]+=last-first[ev];
+    m_hits+=last-first[ev];
+  }
+  m_events+=first.size();
+}
+
+void HitHistograms::Add(const HitHistograms & other){
+  uint32_t * occupancy=m_occupancy.data();
+  uint32_t * totsum=m_totsum.data();
+  const uint32_t * other_occupancy=other.m_occupancy.data();
+  const uint32_t * other_totsum=other.m_totsum.data();
+  for(uint32_t i=0;i<NUM_PIXELS;i++){
+    occupancy[i]+=other_occupancy[i];
+    totsum[i]+=other_totsum[i];
+  }
+  for(uint32_t i=0;i<NUM_TOT;i++){m_tot[i]+=other.m_tot[i];}
+  for(uint32_t i=0;i<NUM_TIME;i++){m_time[i]+=other.m_time[i];}
+  m_hits+=other.m_hits;
+  m_events+=other.m_events;
+}
+
+void HitHistograms::Clear(){
+  memset(m_occupancy.data(),0,NUM_PIXELS*sizeof(uint32_t));
+  memset(m_totsum.data(),0,NUM_PIXELS*sizeof(uint32_t));
+  memset(m_tot,0,sizeof(m_tot));
+  memset(m_time,0,sizeof(m_time));
+  m_hits=0;
+  m_events=0;
+}
+
+uint64_t HitHistograms::GetNumHits() const{
+  return m_hits;
+}
+
+uint64_t HitHistograms::GetNumEvents() const{
+  return m_events;
+}
+
+const uint32_t * HitHistograms::GetOccupancy() const{
+  return m_occupancy.data();
+}
+
+const uint32_t * HitHistograms::GetTotSum() const{
+  return m_totsum.data();
+}
+
+const uint64_t * HitHistograms::GetTot() const{
+  return m_tot;
+}
+
+const uint64_t * HitHistograms::GetTime() const{
+  return m_time;
+}
+
+uint32_t HitHistograms::GetOccupancy(uint32_t col, uint32_t row) const{
+  if(col>=NUM_COLS or row>=NUM_ROWS){return 0;}
+  return m_occupancy[col*NUM_ROWS+row];
+}
+
+double HitHistograms::GetMeanTot(uint32_t col, uint32_t row) const{
+  if(col>=NUM_COLS or row>=NUM_ROWS){return 0;}
+  uint32_t pixel=col*NUM_ROWS+row;
+  if(m_occupancy[pixel]==0){return 0;}
+  return (double)m_totsum[pixel]/m_occupancy[pixel];
+}
+
+void HitHistograms::GetColumnOccupancy(vector<uint64_t> & projection) const{
+  projection.assign(NUM_COLS,0);
+  for(uint32_t col=0;col<NUM_COLS;col++){
+    const uint32_t * column=&m_occupancy[col*NUM_ROWS];
+    uint64_t sum=0;
+    for(uint32_t row=0;row<NUM_ROWS;row++){sum+=column[row];}
+    projection[col]=sum;
+  }
+}
+
+void HitHistograms::GetRowOccupancy(vector<uint64_t> & projection) const{
+  projection.assign(NUM_ROWS,0);
+  for(uint32_t col=0;col<NUM_COLS;col++){
+    const uint32_t * column=&m_occupancy[col*NUM_ROWS];
+    for(uint32_t row=0;row<NUM_ROWS;row++){projection[row]+=column[row];}
+  }
+}
+
+bool HitHistograms::Save(const string & path) const{
+  ofstream fw(path,ios::binary);
+  if(!fw){return false;}
+  uint32_t header[5]={VERSION,NUM_COLS,NUM_ROWS,NUM_TOT,NUM_TIME};
+  fw.write(MAGIC,sizeof(MAGIC));
+  fw.write((const char*)header,sizeof(header));
+  fw.write((const char*)&m_hits,sizeof(m_hits));
+  fw.write((const char*)&m_events,sizeof(m_events));
+  fw.write((const char*)m_occupancy.data(),NUM_PIXELS*sizeof(uint32_t));
+  fw.write((const char*)m_totsum.data(),NUM_PIXELS*sizeof(uint32_t));
+  fw.write((const char*)m_tot,sizeof(m_tot));
+  fw.write((const char*)m_time,sizeof(m_time));
+  return fw.good();
+}
+
+bool HitHistograms::Load(const string & path){
+  ifstream fr(path,ios::binary);
+  if(!fr){return false;}
+  char magic[8];
+  uint32_t header[5];
+  fr.read(magic,sizeof(magic));
+  fr.read((char*)header,sizeof(header));
+  if(!fr or memcmp(magic,MAGIC,sizeof(MAGIC))!=0){return false;}
+  if(header[0]!=VERSION or header[1]!=NUM_COLS or header[2]!=NUM_ROWS or header[3]!=NUM_TOT or header[4]!=NUM_TIME){return false;}
+  Clear();
+  fr.read((char*)&m_hits,sizeof(m_hits));
+  fr.read((char*)&m_events,sizeof(m_events));
+  fr.read((char*)m_occupancy.data(),NUM_PIXELS*sizeof(uint32_t));
+  fr.read((char*)m_totsum.data(),NUM_PIXELS*sizeof(uint32_t));
+  fr.read((char*)m_tot,sizeof(m_tot));
+  fr.read((char*)m_time,sizeof(m_time));
+  if(!fr){Clear(); return false;}
+  return true;
+}
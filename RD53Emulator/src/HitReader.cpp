@@ -0,0 +1,136 @@
+#include "RD53Emulator/HitReader.h"
+#include "RD53Emulator/HitCodec.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+using namespace RD53A;
+
+namespace{
+
+inline uint32_t GetUInt32(const uint8_t * in){
+  return uint32_t(in[0])|(uint32_t(in[1])<<8)|(uint32_t(in[2])<<16)|(uint32_t(in[3])<<24);
+}
+
+inline uint64_t GetUInt64(const uint8_t * in){
+  return uint64_t(GetUInt32(in))|(uint64_t(GetUInt32(in+4))<<32);
+}
+
+}
+
+HitReader::HitReader(){
+  m_num_streams=0;
+  m_max_hits=0;
+  m_max_events=0;
+}
+
+HitReader::~HitReader(){
+  Close();
+}
+
+bool HitReader::Open(const string & path){
+  Close();
+  m_file.open(path.c_str(),ios::binary);
+  if(!m_file){return false;}
+
+  uint8_t header[HitWriter::HEADER_SIZE];
+  m_file.read((char*)header,sizeof(header));
+  if(!m_file or memcmp(header,"RD53AHIT",8)!=0 or GetUInt32(header+8)!=HitWriter::VERSION){Close(); return false;}
+  if(GetUInt32(header+12)!=HitCodec::CODEC){Close(); return false;}
+  m_num_streams=GetUInt32(header+16);
+  m_max_hits=GetUInt32(header+20);
+  m_max_events=GetUInt32(header+24);
+
+  uint8_t trailer[HitWriter::TRAILER_SIZE];
+  m_file.seekg(0,ios::end);
+  uint64_t size=m_file.tellg();
+  if(size<HitWriter::HEADER_SIZE+HitWriter::TRAILER_SIZE){Close(); return false;}
+  m_file.seekg(size-sizeof(trailer));
+  m_file.read((char*)trailer,sizeof(trailer));
+  if(!m_file or memcmp(trailer+16,"RD53AIDX",8)!=0){Close(); return false;}
+  uint64_t offset=GetUInt64(trailer);
+  uint64_t entries=GetUInt64(trailer+8);
+  //bound both values by the file size first, so that a corrupted trailer cannot overflow the check
+  if(offset<HitWriter::HEADER_SIZE or offset>size-sizeof(trailer)){Close(); return false;}
+  if(entries>(size-sizeof(trailer)-offset)/40){Close(); return false;}
+  if(offset+entries*40+sizeof(trailer)!=size){Close(); return false;}
+
+  vector<uint8_t> index(entries*40);
+  m_file.seekg(offset);
+  m_file.read((char*)index.data(),index.size());
+  if(!m_file){Close(); return false;}
+  m_index.resize(entries);
+  for(uint64_t i=0;i<entries;i++){
+    const uint8_t * pos=&index[i*40];
+    HitWriter::IndexEntry & entry=m_index[i];
+    entry.offset=GetUInt64(pos);
+    entry.size=GetUInt32(pos+8);
+    entry.stream=GetUInt32(pos+12);
+    entry.sequence=GetUInt64(pos+16);
+    entry.first_event=GetUInt64(pos+24);
+    entry.num_events=GetUInt32(pos+32);
+    entry.num_hits=GetUInt32(pos+36);
+    //FindBlock relies on the order of HitWriter::Close
+    if(i>0 and (entry.stream<m_index[i-1].stream or
+                (entry.stream==m_index[i-1].stream and entry.first_event<m_index[i-1].first_event))){Close(); return false;}
+  }
+  return true;
+}
+
+void HitReader::Close(){
+  if(m_file.is_open()){m_file.close();}
+  m_file.clear();
+  m_index.clear();
+  m_num_streams=0;
+  m_max_hits=0;
+  m_max_events=0;
+}
+
+uint32_t HitReader::GetNumStreams(){
+  return m_num_streams;
+}
+
+uint32_t HitReader::GetMaxHits(){
+  return m_max_hits;
+}
+
+uint32_t HitReader::GetMaxEvents(){
+  return m_max_events;
+}
+
+uint32_t HitReader::GetNumBlocks(){
+  return m_index.size();
+}
+
+const HitWriter::IndexEntry & HitReader::GetEntry(uint32_t index){
+  return m_index.at(index);
+}
+
+int32_t HitReader::FindBlock(uint32_t stream, uint64_t event){
+  //the index is sorted by stream and first event, look for the last block that starts at or before the event
+  auto it=upper_bound(m_index.begin(),m_index.end(),make_pair(stream,event),
+                      [](const pair<uint32_t,uint64_t> & key, const HitWriter::IndexEntry & entry){
+    return (key.first!=entry.stream ? key.first<entry.stream : key.second<entry.first_event);
+  });
+  if(it==m_index.begin()){return -1;}
+  --it;
+  if(it->stream!=stream or event>=it->first_event+it->num_events){return -1;}
+  return it-m_index.begin();
+}
+
+bool HitReader::ReadBlock(uint32_t index, EventBatch & batch){
+  if(index>=m_index.size()){return false;}
+  const HitWriter::IndexEntry & entry=m_index[index];
+  if(entry.size<HitWriter::BLOCK_HEADER_SIZE){return false;}
+  m_buffer.resize(entry.size);
+  m_file.clear();
+  m_file.seekg(entry.offset);
+  m_file.read((char*)m_buffer.data(),entry.size);
+  if(!m_file){return false;}
+  const uint8_t * header=m_buffer.data();
+  if(memcmp(header,"BLK1",4)!=0 or GetUInt32(header+8)!=HitCodec::CODEC){return false;}
+  uint32_t size=GetUInt32(header+12);
+  if(size+HitWriter::BLOCK_HEADER_SIZE!=entry.size){return false;}
+  return HitCodec::Decode(header+HitWriter::BLOCK_HEADER_SIZE,size,batch);
+}
@@ -0,0 +1,360 @@
+#include "RD53Emulator/HitWriter.h"
+#include "RD53Emulator/HitCodec.h"
+
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <cstdlib>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace RD53A;
+
+namespace{
+
+inline uint8_t * PutUInt32(uint8_t * out, uint32_t value){
+  for(uint32_t i=0;i<4;i++){out[i]=value>>(8*i);}
+  return out+4;
+}
+
+inline uint8_t * PutUInt64(uint8_t * out, uint64_t value){
+  for(uint32_t i=0;i<8;i++){out[i]=value>>(8*i);}
+  return out+8;
+}
+
+bool WriteAll(int fd, const uint8_t * data, uint64_t size, uint64_t offset){
+  while(size>0){
+    ssize_t nb=pwrite(fd,data,size,offset);
+    if(nb<=0){return false;}
+    data+=nb;
+    size-=nb;
+    offset+=nb;
+  }
+  return true;
+}
+
+}
+
+HitWriter::HitWriter(uint32_t num_streams, uint32_t num_workers, uint32_t max_hits, uint32_t max_events,
+                     uint32_t max_blocks, uint32_t chunk_size){
+  m_num_streams=num_streams;
+  m_max_hits=max_hits;
+  m_max_events=max_events;
+  m_max_blocks=(max_blocks>0?max_blocks:1);
+  m_chunk_size=((chunk_size+ALIGNMENT-1)/ALIGNMENT)*ALIGNMENT;
+  if(m_chunk_size==0){m_chunk_size=ALIGNMENT;}
+  for(uint32_t i=0;i<m_num_streams;i++){
+    Stream * stream=new Stream();
+    stream->block=NULL;
+    stream->sequence=0;
+    stream->events=0;
+    m_streams.push_back(stream);
+  }
+  m_open=false;
+  m_dropped=0;
+  m_allocated=0;
+  m_pending=0;
+  m_fd=-1;
+  m_direct=false;
+  m_error=false;
+  m_offset=0;
+  m_bytes_written=0;
+  m_bytes_raw=0;
+
+  //a chunk, the largest block that can be appended to it, and the padding of the last write
+  m_staging_size=0;
+  m_staging_capacity=m_chunk_size+BLOCK_HEADER_SIZE+HitCodec::GetMaxSize(m_max_hits,m_max_events)+ALIGNMENT;
+  m_staging_capacity=((m_staging_capacity+ALIGNMENT-1)/ALIGNMENT)*ALIGNMENT;
+  void * staging=NULL;
+  if(posix_memalign(&staging,ALIGNMENT,m_staging_capacity)!=0){staging=NULL;}
+  m_staging=(uint8_t*)staging;
+
+  m_running=true;
+  for(uint32_t i=0;i<(num_workers>0?num_workers:1);i++){
+    m_workers.push_back(thread(&HitWriter::Compress,this));
+  }
+  m_writer=thread(&HitWriter::Store,this);
+}
+
+HitWriter::~HitWriter(){
+  Close();
+  {
+    lock_guard<mutex> lock(m_mutex);
+    m_running=false;
+  }
+  m_sealed_cv.notify_all();
+  m_compressed_cv.notify_all();
+  for(auto & worker : m_workers){worker.join();}
+  m_writer.join();
+  for(auto stream : m_streams){
+    if(stream->block){m_free.push_back(stream->block);}
+    delete stream;
+  }
+  for(auto block : m_free){
+    delete block->batch;
+    delete block;
+  }
+  m_free.clear();
+  free(m_staging);
+}
+
+bool HitWriter::Open(const string & path, bool direct){
+  Close();
+  if(!m_staging){return false;}
+  int flags=O_WRONLY|O_CREAT|O_TRUNC;
+  m_direct=direct;
+  m_fd=open(path.c_str(),flags|(direct?O_DIRECT:0),0644);
+  if(m_fd<0 and direct){
+    cout << "HitWriter::Open O_DIRECT not supported for " << path << ", using buffered writes" << endl;
+    m_direct=false;
+    m_fd=open(path.c_str(),flags,0644);
+  }
+  if(m_fd<0){
+    cout << "HitWriter::Open Cannot create: " << path << endl;
+    return false;
+  }
+  m_error=false;
+  m_offset=0;
+  m_bytes_written=0;
+  m_bytes_raw=0;
+  m_index.clear();
+  m_dropped=0;
+  for(auto stream : m_streams){
+    lock_guard<mutex> lock(stream->mutex);
+    stream->sequence=0;
+    stream->events=0;
+  }
+
+  //the header is the beginning of the first write
+  uint8_t * pos=m_staging;
+  memcpy(pos,"RD53AHIT",8); pos+=8;
+  pos=PutUInt32(pos,VERSION);
+  pos=PutUInt32(pos,HitCodec::CODEC);
+  pos=PutUInt32(pos,m_num_streams);
+  pos=PutUInt32(pos,m_max_hits);
+  pos=PutUInt32(pos,m_max_events);
+  pos=PutUInt32(pos,0);
+  m_staging_size=HEADER_SIZE;
+
+  m_open=true;
+  return true;
+}
+
+HitWriter::Block * HitWriter::Acquire(){
+  lock_guard<mutex> lock(m_mutex);
+  if(!m_free.empty()){
+    Block * block=m_free.back();
+    m_free.pop_back();
+    return block;
+  }
+  if(m_allocated>=m_max_blocks){return NULL;}
+  m_allocated++;
+  Block * block=new Block();
+  block->batch=new EventBatch(m_max_hits,m_max_events);
+  block->data.reserve(BLOCK_HEADER_SIZE+HitCodec::GetMaxSize(m_max_hits,m_max_events));
+  return block;
+}
+
+void HitWriter::Write(uint32_t stream_index, const EventBatch * batch){
+  if(!m_open or stream_index>=m_num_streams or !batch){return;}
+  Stream * stream=m_streams[stream_index];
+  lock_guard<mutex> lock(stream->mutex);
+  //the file may have been closed while waiting for the lock
+  if(!m_open){return;}
+  Span<uint8_t> tids=batch->GetTIDs();
+  Span<uint8_t> ttags=batch->GetTTags();
+  Span<uint16_t> bcids=batch->GetBCIDs();
+  for(uint32_t ev=0;ev<batch->GetNumEvents();ev++){
+    uint32_t nhits=batch->GetNumHits(ev);
+    if(stream->block){
+      EventBatch * block=stream->block->batch;
+      if(block->GetNumEvents()>=m_max_events or block->GetNumHits()+nhits>m_max_hits){Seal(stream);}
+    }
+    if(!stream->block){
+      stream->block=Acquire();
+      if(stream->block){stream->block->stream=stream_index;}
+    }
+    if(!stream->block or nhits>m_max_hits){
+      m_dropped++;
+      continue;
+    }
+    EventBatch * block=stream->block->batch;
+    block->AddEvent(tids[ev],ttags[ev],bcids[ev]);
+    Span<uint16_t> cols=batch->GetCols(ev);
+    Span<uint16_t> rows=batch->GetRows(ev);
+    Span<uint8_t> tots=batch->GetTOTs(ev);
+    for(uint32_t i=0;i<nhits;i++){
+      block->AddHit(cols[i],rows[i],tots[i]);
+    }
+  }
+}
+
+void HitWriter::Seal(Stream * stream){
+  Block * block=stream->block;
+  if(!block or block->batch->IsEmpty()){return;}
+  block->sequence=stream->sequence++;
+  block->first_event=stream->events;
+  stream->events+=block->batch->GetNumEvents();
+  stream->block=NULL;
+  {
+    lock_guard<mutex> lock(m_mutex);
+    m_sealed.push_back(block);
+    m_pending++;
+  }
+  m_sealed_cv.notify_one();
+}
+
+void HitWriter::Flush(){
+  for(auto stream : m_streams){
+    lock_guard<mutex> lock(stream->mutex);
+    Seal(stream);
+  }
+}
+
+void HitWriter::Compress(){
+  unique_lock<mutex> lock(m_mutex);
+  while(true){
+    while(m_running and m_sealed.empty()){m_sealed_cv.wait(lock);}
+    if(m_sealed.empty()){break;}
+    Block * block=m_sealed.front();
+    m_sealed.pop_front();
+    lock.unlock();
+
+    block->data.resize(BLOCK_HEADER_SIZE);
+    uint32_t size=HitCodec::Encode(*block->batch,block->data);
+    uint8_t * pos=&block->data[0];
+    memcpy(pos,"BLK1",4); pos+=4;
+    pos=PutUInt32(pos,block->stream);
+    pos=PutUInt32(pos,HitCodec::CODEC);
+    pos=PutUInt32(pos,size);
+
+    lock.lock();
+    m_compressed.push_back(block);
+    m_compressed_cv.notify_one();
+  }
+}
+
+void HitWriter::Store(){
+  unique_lock<mutex> lock(m_mutex);
+  while(true){
+    while(m_running and m_compressed.empty()){m_compressed_cv.wait(lock);}
+    if(m_compressed.empty()){break;}
+    Block * block=m_compressed.front();
+    m_compressed.pop_front();
+    lock.unlock();
+
+    IndexEntry entry;
+    entry.offset=m_offset+m_staging_size;
+    entry.size=block->data.size();
+    entry.stream=block->stream;
+    entry.sequence=block->sequence;
+    entry.first_event=block->first_event;
+    entry.num_events=block->batch->GetNumEvents();
+    entry.num_hits=block->batch->GetNumHits();
+    memcpy(m_staging+m_staging_size,block->data.data(),block->data.size());
+    m_staging_size+=block->data.size();
+    if(m_staging_size>=m_chunk_size){WriteStaging(false);}
+    uint64_t raw=entry.num_events*(1+1+2+4)+entry.num_hits*(2+2+1);
+    block->batch->Clear();
+    block->data.clear();
+
+    lock.lock();
+    m_bytes_raw+=raw;
+    m_index.push_back(entry);
+    m_free.push_back(block);
+    m_pending--;
+    m_done_cv.notify_all();
+  }
+}
+
+void HitWriter::WriteStaging(bool all){
+  uint32_t size=(all?m_staging_size:m_staging_size&~(ALIGNMENT-1));
+  uint32_t length=size;
+  //O_DIRECT only takes whole aligned pages, the padding is removed afterwards
+  if(m_direct and length%ALIGNMENT!=0){
+    uint32_t padded=((length+ALIGNMENT-1)/ALIGNMENT)*ALIGNMENT;
+    memset(m_staging+length,0,padded-length);
+    length=padded;
+  }
+  if(length>0 and !WriteAll(m_fd,m_staging,length,m_offset)){
+    if(!m_error){cout << "HitWriter::WriteStaging Error writing the file: " << strerror(errno) << endl;}
+    m_error=true;
+  }
+  if(length!=size and ftruncate(m_fd,m_offset+size)!=0){m_error=true;}
+  {
+    lock_guard<mutex> lock(m_mutex);
+    m_bytes_written+=size;
+  }
+  m_offset+=size;
+  m_staging_size-=size;
+  memmove(m_staging,m_staging+size,m_staging_size);
+}
+
+bool HitWriter::Close(){
+  if(!m_open){return true;}
+  m_open=false;
+  Flush();
+  {
+    unique_lock<mutex> lock(m_mutex);
+    while(m_pending>0){m_done_cv.wait(lock);}
+  }
+
+  //the writer thread is idle, the rest is written from here
+  WriteStaging(true);
+  if(m_direct){
+    int flags=fcntl(m_fd,F_GETFL);
+    if(flags<0 or fcntl(m_fd,F_SETFL,flags&~O_DIRECT)!=0){m_error=true;}
+  }
+  //the blocks are written as they are compressed, the index lists them in the order of the streams
+  sort(m_index.begin(),m_index.end(),[](const IndexEntry & a, const IndexEntry & b){
+    return (a.stream!=b.stream ? a.stream<b.stream : a.sequence<b.sequence);
+  });
+  vector<uint8_t> tail(m_index.size()*40+TRAILER_SIZE);
+  uint8_t * pos=tail.data();
+  for(auto & entry : m_index){
+    pos=PutUInt64(pos,entry.offset);
+    pos=PutUInt32(pos,entry.size);
+    pos=PutUInt32(pos,entry.stream);
+    pos=PutUInt64(pos,entry.sequence);
+    pos=PutUInt64(pos,entry.first_event);
+    pos=PutUInt32(pos,entry.num_events);
+    pos=PutUInt32(pos,entry.num_hits);
+  }
+  pos=PutUInt64(pos,m_offset);
+  pos=PutUInt64(pos,m_index.size());
+  memcpy(pos,"RD53AIDX",8);
+  if(!WriteAll(m_fd,tail.data(),tail.size(),m_offset)){m_error=true;}
+  {
+    lock_guard<mutex> lock(m_mutex);
+    m_bytes_written+=tail.size();
+  }
+  m_offset+=tail.size();
+  if(close(m_fd)!=0){m_error=true;}
+  m_fd=-1;
+  return !m_error;
+}
+
+bool HitWriter::IsOpen(){
+  return m_open;
+}
+
+uint64_t HitWriter::GetDropped(){
+  return m_dropped;
+}
+
+uint64_t HitWriter::GetNumBlocks(){
+  lock_guard<mutex> lock(m_mutex);
+  return m_index.size();
+}
+
+uint64_t HitWriter::GetBytesWritten(){
+  lock_guard<mutex> lock(m_mutex);
+  return m_bytes_written;
+}
+
+uint64_t HitWriter::GetBytesRaw(){
+  lock_guard<mutex> lock(m_mutex);
+  return m_bytes_raw;
+}
@@ -0,0 +1,44 @@
+#include "RD53Emulator/Macro.h"
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+
+using namespace std;
+using namespace RD53A;
+
+Macro::Macro(shared_ptr<const vector<uint8_t> > bytes){
+  m_bytes = bytes;
+}
+
+Macro::Macro(Macro * copy){
+  m_bytes = copy->m_bytes;
+}
+
+Macro::~Macro(){}
+
+Macro * Macro::Clone(){
+  return new Macro(this);
+}
+
+string Macro::ToString(){
+  ostringstream os;
+  os << "Macro " << m_bytes->size() << " bytes (0x" << hex;
+  for(auto byte : *m_bytes){os << setw(2) << setfill('0') << (uint32_t) byte;}
+  os << dec << ")";
+  return os.str();
+}
+
+uint32_t Macro::UnPack(uint8_t * bytes, uint32_t maxlen){
+  if(maxlen<m_bytes->size()){return 0;}
+  if(memcmp(bytes,m_bytes->data(),m_bytes->size())!=0){return 0;}
+  return m_bytes->size();
+}
+
+uint32_t Macro::Pack(uint8_t * bytes){
+  memcpy(bytes,m_bytes->data(),m_bytes->size());
+  return m_bytes->size();
+}
+
+uint32_t Macro::GetType(){
+  return Command::MACRO;
+}
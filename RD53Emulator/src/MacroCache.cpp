@@ -0,0 +1,48 @@
+#include "RD53Emulator/MacroCache.h"
+#include "RD53Emulator/Configuration.h"
+
+using namespace std;
+using namespace RD53A;
+
+MacroCache::MacroCache(){
+  m_hits=0;
+  m_misses=0;
+}
+
+MacroCache::~MacroCache(){
+  m_entries.clear();
+}
+
+const MacroCache::Entry * MacroCache::Find(uint32_t chipid, uint32_t operation, uint32_t arg0, uint32_t arg1,
+                                           Configuration * config){
+  auto it = m_entries.find(Key(chipid,operation,arg0,arg1));
+  if(it!=m_entries.end()){
+    for(const Entry & entry : it->second){
+      bool match=true;
+      for(auto & reg : entry.before){
+        if(config->GetRegister(reg.first)!=reg.second){match=false;break;}
+      }
+      if(match){m_hits++; return &entry;}
+    }
+  }
+  m_misses++;
+  return 0;
+}
+
+void MacroCache::Store(uint32_t chipid, uint32_t operation, uint32_t arg0, uint32_t arg1, const Entry & entry){
+  vector<Entry> & variants = m_entries[Key(chipid,operation,arg0,arg1)];
+  if(variants.size()>=MAX_VARIANTS){variants.erase(variants.begin());}
+  variants.push_back(entry);
+}
+
+void MacroCache::Clear(){
+  m_entries.clear();
+}
+
+uint64_t MacroCache::GetHits(){
+  return m_hits;
+}
+
+uint64_t MacroCache::GetMisses(){
+  return m_misses;
+}
@@ -0,0 +1,156 @@
+#include "RD53Emulator/ReadTransactions.h"
+
+#include <stdexcept>
+
+using namespace std;
+using namespace RD53A;
+
+ReadTransactions::ReadTransactions(){
+  m_running = true;
+  m_timeouts = 0;
+  m_unmatched = 0;
+}
+
+ReadTransactions::~ReadTransactions(){
+  {
+    lock_guard<mutex> lock(m_mutex);
+    m_running = false;
+    for(auto & request : m_requests){
+      Fail(*request.transaction,"register read cancelled");
+    }
+    m_requests.clear();
+  }
+  m_changed.notify_all();
+  if(m_thread.joinable()){m_thread.join();}
+}
+
+void ReadTransactions::SetSender(function<void(const vector<uint32_t> &)> sender){
+  lock_guard<mutex> lock(m_sender_mutex);
+  m_sender = sender;
+}
+
+future<uint16_t> ReadTransactions::Read(uint32_t address, uint32_t timeout_ms){
+  auto transaction = make_shared<Transaction>();
+  transaction->single = true;
+  future<uint16_t> ret = transaction->value.get_future();
+  Submit(transaction,vector<uint32_t>(1,address),timeout_ms);
+  return ret;
+}
+
+future<vector<uint16_t> > ReadTransactions::Read(const vector<uint32_t> & addresses, uint32_t timeout_ms){
+  auto transaction = make_shared<Transaction>();
+  transaction->single = false;
+  future<vector<uint16_t> > ret = transaction->values.get_future();
+  Submit(transaction,addresses,timeout_ms);
+  return ret;
+}
+
+void ReadTransactions::Submit(shared_ptr<Transaction> transaction, const vector<uint32_t> & addresses, uint32_t timeout_ms){
+  transaction->results.resize(addresses.size(),0);
+  transaction->remaining = addresses.size();
+  transaction->done = false;
+  if(addresses.empty()){
+    transaction->done = true;
+    if(transaction->single){transaction->value.set_value(0);}
+    else{transaction->values.set_value(transaction->results);}
+    return;
+  }
+
+  //the requests go in the table before the RdReg commands are sent, the answer can be fast
+  Clock::time_point deadline = Clock::now() + chrono::milliseconds(timeout_ms);
+  {
+    lock_guard<mutex> lock(m_mutex);
+    for(uint32_t i=0;i<addresses.size();i++){
+      m_requests.push_back(Request{transaction,i,addresses[i],deadline});
+    }
+    //the helper thread is only needed once there is something to expire
+    if(!m_thread.joinable()){m_thread = thread(&ReadTransactions::Expire,this);}
+  }
+  m_changed.notify_all();
+
+  bool sent = false;
+  {
+    lock_guard<mutex> slock(m_sender_mutex);
+    if(m_sender){m_sender(addresses); sent = true;}
+  }
+  if(sent){return;}
+
+  lock_guard<mutex> lock(m_mutex);
+  for(auto it=m_requests.begin();it!=m_requests.end();){
+    if(it->transaction==transaction){it=m_requests.erase(it);}
+    else{it++;}
+  }
+  Fail(*transaction,"no sender for register reads");
+}
+
+void ReadTransactions::Fail(Transaction & transaction, const string & reason){
+  if(transaction.done){return;}
+  transaction.done = true;
+  auto error = make_exception_ptr(runtime_error(reason));
+  if(transaction.single){transaction.value.set_exception(error);}
+  else{transaction.values.set_exception(error);}
+}
+
+bool ReadTransactions::Match(uint32_t address, uint16_t value){
+  lock_guard<mutex> lock(m_mutex);
+  for(auto it=m_requests.begin();it!=m_requests.end();it++){
+    if(it->address!=address){continue;}
+    Transaction & transaction = *it->transaction;
+    transaction.results[it->index] = value;
+    transaction.remaining--;
+    if(transaction.remaining==0 and !transaction.done){
+      transaction.done = true;
+      if(transaction.single){transaction.value.set_value(value);}
+      else{transaction.values.set_value(transaction.results);}
+    }
+    m_requests.erase(it);
+    return true;
+  }
+  m_unmatched++;
+  return false;
+}
+
+void ReadTransactions::Expire(){
+  unique_lock<mutex> lock(m_mutex);
+  while(m_running){
+    if(m_requests.empty()){
+      m_changed.wait(lock);
+      continue;
+    }
+    Clock::time_point next = Clock::time_point::max();
+    for(auto & request : m_requests){
+      if(request.deadline<next){next=request.deadline;}
+    }
+    if(Clock::now()<next){
+      m_changed.wait_until(lock,next);
+      continue;
+    }
+    //fail every transaction with an expired request, and drop all of its requests
+    Clock::time_point now = Clock::now();
+    for(auto & request : m_requests){
+      if(request.deadline<=now and !request.transaction->done){
+        Fail(*request.transaction,"register read timed out");
+        m_timeouts++;
+      }
+    }
+    for(auto it=m_requests.begin();it!=m_requests.end();){
+      if(it->transaction->done){it=m_requests.erase(it);}
+      else{it++;}
+    }
+  }
+}
+
+uint32_t ReadTransactions::GetOutstanding(){
+  lock_guard<mutex> lock(m_mutex);
+  return m_requests.size();
+}
+
+uint64_t ReadTransactions::GetTimeouts(){
+  lock_guard<mutex> lock(m_mutex);
+  return m_timeouts;
+}
+
+uint64_t ReadTransactions::GetUnmatched(){
+  lock_guard<mutex> lock(m_mutex);
+  return m_unmatched;
+}
@@ -1,28 +1,32 @@
 #include "RD53Emulator/Register.h"
+#include "RD53Emulator/Configuration.h"
 
 using namespace std;
 using namespace RD53A;
 
-Register::Register(){
-  m_value=0;
-  m_updated=false;
+Register::Register(Configuration * config, uint32_t index){
+  m_config=config;
+  m_index=index;
 }
 
 Register::~Register(){}
 
 void Register::SetValue(uint16_t value){
-  m_updated=true;
-  m_value=value;
+  m_config->SetRegister(m_index,value);
 }
 
 uint16_t Register::GetValue(){
-  return m_value;
+  return m_config->GetRegister(m_index);
 }
 
 void Register::Update(bool enable){
-  m_updated=enable;
+  m_config->Update(m_index,enable);
 }
 
 bool Register::IsUpdated(){
-  return m_updated;
+  return m_config->IsUpdated(m_index);
+}
+
+uint32_t Register::GetIndex(){
+  return m_index;
 }
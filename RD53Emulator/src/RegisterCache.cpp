@@ -0,0 +1,105 @@
+#include "RD53Emulator/RegisterCache.h"
+
+#include <thread>
+
+using namespace std;
+using namespace RD53A;
+
+RegisterCache::RegisterCache(){
+  m_entries.resize(NUM_REGISTERS,Entry{0,false,false,Clock::time_point()});
+  m_collecting = false;
+  m_has_sender = false;
+  m_batch_window = 1000;
+  m_requests = 0;
+  m_batches = 0;
+}
+
+RegisterCache::~RegisterCache(){}
+
+void RegisterCache::SetSender(function<void(const vector<uint32_t> &)> sender){
+  //wait for any batch being sent with the previous sender
+  lock_guard<mutex> slock(m_sender_mutex);
+  m_sender = sender;
+  lock_guard<mutex> lock(m_mutex);
+  m_has_sender = (bool)sender;
+}
+
+void RegisterCache::SetBatchWindow(uint32_t usecs){
+  lock_guard<mutex> lock(m_mutex);
+  m_batch_window = usecs;
+}
+
+void RegisterCache::Update(uint32_t address, uint16_t value){
+  if(address>=NUM_REGISTERS){return;}
+  {
+    lock_guard<mutex> lock(m_mutex);
+    Entry & entry = m_entries[address];
+    entry.value = value;
+    entry.valid = true;
+    entry.requested = false;
+    entry.updated = Clock::now();
+  }
+  m_updated.notify_all();
+}
+
+bool RegisterCache::Read(uint32_t address, uint32_t max_age_ms, uint32_t timeout_ms,
+                         uint16_t & value, Clock::time_point * updated){
+  if(address>=NUM_REGISTERS){return false;}
+  unique_lock<mutex> lock(m_mutex);
+  Entry & entry = m_entries[address];
+  Clock::time_point requested_at = Clock::now();
+  Clock::time_point oldest = requested_at - chrono::milliseconds(max_age_ms);
+  auto fresh = [&](){ return entry.valid and entry.updated >= oldest; };
+
+  if(!fresh()){
+    if(!m_has_sender){return false;}
+    //ask for the register unless somebody else already did
+    if(!entry.requested){
+      entry.requested = true;
+      m_pending.push_back(address);
+    }
+    //the first reader with something to ask collects the batch and sends it
+    if(!m_collecting and !m_pending.empty()){
+      m_collecting = true;
+      uint32_t window = m_batch_window;
+      lock.unlock();
+      if(window>0){this_thread::sleep_for(chrono::microseconds(window));}
+      lock.lock();
+      vector<uint32_t> batch;
+      batch.swap(m_pending);
+      m_collecting = false;
+      lock.unlock();
+      bool sent = false;
+      {
+        lock_guard<mutex> slock(m_sender_mutex);
+        if(m_sender){m_sender(batch); sent = true;}
+      }
+      lock.lock();
+      if(sent){
+        m_requests += batch.size();
+        m_batches++;
+      }else{
+        for(auto addr : batch){m_entries[addr].requested = false;}
+        return false;
+      }
+    }
+    if(!m_updated.wait_until(lock, requested_at + chrono::milliseconds(timeout_ms), fresh)){
+      //the request or its answer got lost, let the next reader ask again
+      entry.requested = false;
+      return false;
+    }
+  }
+  value = entry.value;
+  if(updated){*updated = entry.updated;}
+  return true;
+}
+
+uint64_t RegisterCache::GetRequests(){
+  lock_guard<mutex> lock(m_mutex);
+  return m_requests;
+}
+
+uint64_t RegisterCache::GetBatches(){
+  lock_guard<mutex> lock(m_mutex);
+  return m_batches;
+}
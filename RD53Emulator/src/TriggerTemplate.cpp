@@ -0,0 +1,88 @@
+#include "RD53Emulator/TriggerTemplate.h"
+#include "RD53Emulator/Sync.h"
+#include "RD53Emulator/Noop.h"
+#include "RD53Emulator/Cal.h"
+#include "RD53Emulator/Trigger.h"
+
+#include <cstring>
+
+using namespace std;
+using namespace RD53A;
+
+TriggerTemplate::TriggerTemplate(){
+  m_sequence_length=0;
+  //trigger tag symbols, as encoded by the Trigger command
+  uint8_t bytes[2];
+  for(uint32_t tag=0;tag<32;tag++){
+    RD53A::Trigger trigger(RD53A::Trigger::Trigger_08,tag);
+    trigger.Pack(bytes);
+    m_tag_symbols[tag]=bytes[1];
+  }
+}
+
+TriggerTemplate::~TriggerTemplate(){
+  m_bytes.clear();
+  m_pattern_offsets.clear();
+  m_tag_offsets.clear();
+}
+
+void TriggerTemplate::Build(uint32_t chipid, uint32_t cal_delay, uint32_t ntriggers){
+
+  //encode one injection
+  Sync sync;
+  Noop noop;
+  Cal cal(chipid,0,0,1,0,0);
+  RD53A::Trigger trigger(RD53A::Trigger::Trigger_08,0);
+
+  vector<uint8_t> sequence(2+2+6+2*cal_delay+2);
+  uint32_t pos=0;
+  pos+=sync.Pack(&sequence[pos]);
+  pos+=noop.Pack(&sequence[pos]);
+  pos+=cal.Pack(&sequence[pos]);
+  for(uint32_t i=0;i<cal_delay;i++){
+    pos+=noop.Pack(&sequence[pos]);
+  }
+  uint32_t trigger_offset=pos;
+  pos+=trigger.Pack(&sequence[pos]);
+  m_sequence_length=pos;
+
+  //replicate it for the whole burst
+  m_bytes.resize(m_sequence_length*ntriggers);
+  m_pattern_offsets.resize(ntriggers);
+  m_tag_offsets.resize(ntriggers);
+  for(uint32_t i=0;i<ntriggers;i++){
+    memcpy(&m_bytes[i*m_sequence_length],sequence.data(),m_sequence_length);
+    m_pattern_offsets[i]=i*m_sequence_length+trigger_offset;
+    m_tag_offsets[i]=i*m_sequence_length+trigger_offset+1;
+  }
+}
+
+void TriggerTemplate::SetTag(uint32_t index, uint32_t tag){
+  m_bytes[m_tag_offsets[index]]=m_tag_symbols[tag&0x1F];
+}
+
+void TriggerTemplate::SetTags(uint32_t first_tag){
+  for(uint32_t i=0;i<m_tag_offsets.size();i++){
+    m_bytes[m_tag_offsets[i]]=m_tag_symbols[(first_tag+i)&0x1F];
+  }
+}
+
+void TriggerTemplate::SetPattern(uint32_t index, uint32_t pattern){
+  m_bytes[m_pattern_offsets[index]]=pattern&0xFF;
+}
+
+const uint8_t * TriggerTemplate::GetBytes() const{
+  return m_bytes.data();
+}
+
+uint32_t TriggerTemplate::GetLength() const{
+  return m_bytes.size();
+}
+
+uint32_t TriggerTemplate::GetNumTriggers() const{
+  return m_tag_offsets.size();
+}
+
+uint32_t TriggerTemplate::GetSequenceLength() const{
+  return m_sequence_length;
+}
@@ -67,7 +67,7 @@ uint32_t WrReg::UnPack(uint8_t * bytes, uint32_t maxlen){
   m_value[0]|= m_symbol2data[bytes[6]]<<5;
   m_value[0]|= m_symbol2data[bytes[7]]<<0; 
   
-  for(uint32_t i=1;i<5;i++){m_value[i] = 0;}
+  for(uint32_t i=1;i<6;i++){m_value[i] = 0;}
  if(m_mode==1 and maxlen>=24){
 
     m_value[1]|=((m_symbol2data[bytes[8] ]>>0)&0x1F)<<11;
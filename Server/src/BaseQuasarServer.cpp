@@ -164,6 +164,7 @@ int BaseQuasarServer::serverRun(
         serverReturnCode = 1;
     }
     AddressSpace::SourceVariables_destroySourceVariablesThreadPool ();
+    CalculatedVariables::Engine::printUpdateStatistics();
     shutdown();  // this is typically overridden by the developer
 
     unlinkAllDevices(m_nodeManager);
@@ -29,10 +29,14 @@
 #include <DRoot.h>
 #include <DRD53A.h>
 #include <ASRD53A.h>
+#include <DNetioStats.h>
+#include <DDataTaking.h>
+#include <CalculatedVariablesEngine.h>
 
 #include "RD53Emulator/SensorScan.h"
 #include "RD53Emulator/Handler.h"
 #include "RD53Emulator/FrontEnd.h"
+#include "RD53Emulator/FlightRecorder.h"
 
 using namespace RD53A;
 
@@ -54,6 +58,15 @@ void QuasarServer::mainLoop()
 
     // Create a SensorScan Handler
     SensorScan *scan = new SensorScan();
+    // Data taking settings, the defaults of the design apply without a DataTaking object
+    for(Device::DDataTaking *settings : Device::DRoot::getInstance()->datatakings()){
+      scan->SetEventLoops(settings->EventLoops());
+      scan->SetBusyPoll(settings->BusyPollUsecs());
+      scan->EnableEventMerging(settings->EventMerging());
+      scan->EnableHitOutput(settings->HitOutput(), settings->HitOutputDirect());
+    }
+    // Online occupancy, ToT and time histograms of the hits of every RD53A
+    scan->EnableMonitoring(true);
     // Add each RD53A to the Sensor Scan
 
     LOG(Log::INF) << "Load RD53As" ;
@@ -75,19 +88,28 @@ void QuasarServer::mainLoop()
                       rd53a->getAddressSpaceLink()->getDataPort());
 
       scan->AddFE(rd53a->getFullName());
+      // Serve the register reads of this chip from its register cache
+      rd53a->attach(scan->GetFE(rd53a->getFullName()));
       scan->Connect();
       scan->Config();
     }
 
     // Run the scan in a different thread
 
+    // The histograms are published once per second
+    RD53A::HitHistograms histos;
+    uint32_t cycles = 0;
     while(ShutDownFlag() == 0)
     {
       std::this_thread::sleep_for(std::chrono::milliseconds(100));
 
       // Write the values 
       scan->Loop();
-      
+
+      cycles++;
+
+      // Calculated variables depending on these inputs are evaluated once, after all writes
+      CalculatedVariables::UpdateCycle cycle;
       for(Device::DRD53A *rd53a : Device::DRoot::getInstance()->rd53as()){
         RD53A::FrontEnd *fe = scan->GetFE(rd53a->getFullName());
         //Fill in the results
@@ -100,10 +122,28 @@ void QuasarServer::mainLoop()
         rd53a->getAddressSpaceLink()->setRad_2(fe->GetRadiationSensor(1)->GetADC(),OpcUa_Good);
         rd53a->getAddressSpaceLink()->setRad_3(fe->GetRadiationSensor(2)->GetADC(),OpcUa_Good);
         rd53a->getAddressSpaceLink()->setRad_4(fe->GetRadiationSensor(3)->GetADC(),OpcUa_Good);
+        //Publish the netio counters of the command and data links
+        for(Device::DNetioStats *link : rd53a->netiostatss()){
+          netio::socket_stats *stats = 0;
+          if(link->Link()=="Cmd"){stats = scan->GetCmdStats(rd53a->getFullName());}
+          else if(link->Link()=="Data"){stats = scan->GetDataStats(rd53a->getFullName());}
+          if(stats){link->update(*stats);}
+        }
+        //Publish the online histograms, and the completeness of the events built across the chips
+        if(cycles%10==0 and fe->GetHistograms()){
+          fe->GetHistograms()->Snapshot(histos);
+          rd53a->updateHistograms(histos);
+        }
+        if(cycles%10==0 and fe->GetEventMerger()){
+          rd53a->updateMerging(*fe->GetEventMerger(), fe->GetEventMergerIndex());
+        }
       }
     }
 
     // Stop the scan
+    for(Device::DRD53A *rd53a : Device::DRoot::getInstance()->rd53as()){
+      rd53a->detach();
+    }
     scan->Disconnect();
 
     // Delete the sensor scan
@@ -114,12 +154,29 @@ void QuasarServer::mainLoop()
 void QuasarServer::initialize()
 {
     LOG(Log::INF) << "Initializing Quasar server.";
+    // Trace events of the data path, dumped on SIGUSR1, on a crash, or with the dumpFlightRecorder method
+    for(Device::DDataTaking *settings : Device::DRoot::getInstance()->datatakings()){
+      if(!settings->FlightRecorder()){continue;}
+      LOG(Log::INF) << "Flight recorder enabled, dumps are written to " << settings->FlightRecorderDirectory();
+      FlightRecorder::SetEnable(true);
+      FlightRecorder::InstallSignalHandlers(settings->FlightRecorderDirectory());
+    }
+    // the data handling threads must not wait for stdout or the log files,
+    // at the price of the records still queued when the server crashes
+    for(Device::DDataTaking *settings : Device::DRoot::getInstance()->datatakings()){
+      if(!settings->AsyncLogging()){continue;}
+      LOG(Log::INF) << "Asynchronous logging enabled";
+      Log::startAsyncLogging();
+    }
 
 }
 
 void QuasarServer::shutdown()
 {
 	LOG(Log::INF) << "Shutting down Quasar server.";
+	// write out the pending records of the asynchronous logging if it is on,
+	// LOG is synchronous again from here on
+	Log::stopAsyncLogging();
 }
 
 void QuasarServer::initializeLogIt()
@@ -7,6 +7,7 @@
 #include <map>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 #include <cstdint>
 #include <unordered_map>
 #include <memory>
@@ -30,6 +31,8 @@ class backend_recv_socket;
 class backend_send_socket;
 class backend_buffer;
 class reusable_buffer;
+class endpoint;
+class sockcfg;
 
 
 class spinlock
@@ -95,10 +98,30 @@ public:
 
     bool is_running() const;
 
+    /**
+     * Low-latency mode: run_forever polls epoll without blocking for up to
+     * usecs microseconds before falling back to a blocking wait.
+     * A budget of 0 (the default) disables spinning.
+     */
+    void set_busy_poll(unsigned usecs);
+    unsigned busy_poll() const;
+
+    /**
+     * Number of wake-ups served while spinning, and number of blocking waits.
+     */
+    uint64_t spin_hits() const;
+    uint64_t sleeps() const;
+    void reset_counters();
+
 private:
     int epollfd;
     spinlock lock;
     std::atomic_bool running;
+    std::atomic<unsigned> busy_poll_usecs;
+    std::atomic<uint64_t> spin_hits_;
+    std::atomic<uint64_t> sleeps_;
+
+    bool spin_for_events(unsigned usecs);
 
     unsigned wait_for_events(int epollfd, unsigned timeout_millisecs);
 
@@ -113,6 +136,7 @@ public:
     ~timer();
 
     void start(unsigned millisecs);
+    void start_oneshot(unsigned microsecs);
     void stop();
 
 private:
@@ -136,20 +160,46 @@ private:
 };
 
 
+/**
+ * A NetIO context owns the backend and one or more event loops.
+ *
+ * With a single event loop (the default) the user drives it, e.g. with
+ * event_loop()->run_forever() from a dedicated thread. With N event loops
+ * start() runs each loop on its own thread, optionally pinned to a core,
+ * and sockets are spread over the loops: round-robin by default, or on the
+ * loop given by sockcfg::EVENT_LOOP (see event_loop_index() for an affinity
+ * by remote endpoint). Timers and signals of a socket live on its loop.
+ */
 class context
 {
 public:
-    context(std::string name);
+    context(std::string name, unsigned num_event_loops=1);
     ~context();
 
     netio::event_loop* event_loop();
+    netio::event_loop* event_loop(unsigned index);
+    unsigned select_event_loop(const sockcfg& cfg);
+    unsigned event_loop_index(const endpoint& ep) const;
+    unsigned num_event_loops() const;
     netio::backend* backend();
 
+    void start(bool pin_threads=false);
+    void stop();
+
 private:
-    netio::event_loop evloop;
+    std::vector<std::unique_ptr<netio::event_loop>> evloops;
+    std::vector<std::thread> threads;
+    std::vector<std::unique_ptr<std::atomic_bool>> finished;
+    std::atomic<unsigned> next_loop;
     netio::backend* backend_;
 };
 
+/**
+ * A message is a list of fragments, each node holding up to two data slices.
+ * The first INLINE_FRAGMENTS slices live inside the message object, so
+ * building, moving and destroying a typical header + payload message does not
+ * allocate. Further nodes come from a per-thread pool of recycled nodes.
+ */
 class message
 {
 public:
@@ -173,10 +223,10 @@ public:
             cleanup_fn hook=NULL);
     message(const std::string& str, reusable_buffer* rb=NULL);
     message(const message& msg);
-    message(message&& other);
+    message(message&& other) noexcept;
     ~message();
     message& operator= (const message& other);
-    message& operator= (message&& other);
+    message& operator= (message&& other) noexcept;
 
     uint8_t operator[](size_t i) const;
 
@@ -188,12 +238,23 @@ public:
     const fragment* fragment_list() const;
     size_t num_fragments() const;
 
+    static const unsigned INLINE_NODES = 3;
+    static const unsigned INLINE_FRAGMENTS = 2*INLINE_NODES;
+
 private:
     fragment head;
+    fragment spare[INLINE_NODES-1];
+    unsigned spare_used;
+    fragment* tail;
 
     cleanup_fn cleanup_hook;
 
-    void clean_fragment(netio::message::fragment* f);
+    void init_head();
+    fragment* new_node();
+    bool is_inline(const fragment* f) const;
+    void take_fragments(message& other);
+    void copy_fragments(const message& other);
+    void clean_fragments();
     void copy_data_to_buffer(uint8_t* buffer) const;
 };
 
@@ -249,9 +310,24 @@ public:
         CALLBACK,
 
         /* User data for callback */
-        CALLBACK_DATA
+        CALLBACK_DATA,
+
+        /* Index of the context event loop serving the socket.
+           Sockets without it are assigned to the loops round-robin. */
+        EVENT_LOOP,
+
+        /* SO_BUSY_POLL budget in microseconds for the socket file
+           descriptors (0 disables it). */
+        BUSY_POLL_USECS,
+
+        /* Maximum time in microseconds a message waits in a partially
+           filled page of a buffered socket before the page is flushed
+           (0: only full pages and the FLUSH_INTERVAL_MILLISECS timer). */
+        FLUSH_LATENCY_USECS
     };
 
+    static const uint64_t ANY_EVENT_LOOP = ~0ULL;
+
 
     static sockcfg cfg();
     sockcfg& operator()(cfgtype_t);
@@ -269,19 +345,60 @@ private:
     bool zero_copy;
     msg_rcvd_cb_t callback;
     void* callback_data;
+    uint64_t event_loop;
+    uint32_t busy_poll_usecs;
+    uint32_t flush_latency_usecs;
 
     friend class socket;
 };
 
 
+/**
+ * Counters of a socket, updated lock-free by the sending threads, the event
+ * loop and the buffer feeders of the socket. Gauges (pages, queue depth) can
+ * be read at any time; the message-size histogram has power-of-two bins.
+ */
+class socket_stats
+{
+public:
+    /* bin 0: < 64 bytes, bin i: [2^(i+5), 2^(i+6)), last bin: everything above */
+    static const unsigned NUM_SIZE_BINS = 16;
+
+    std::atomic<uint64_t> bytes_in;
+    std::atomic<uint64_t> bytes_out;
+    std::atomic<uint64_t> msgs_in;
+    std::atomic<uint64_t> msgs_out;
+    std::atomic<int64_t> pages_total;
+    std::atomic<int64_t> pages_in_use;
+    std::atomic<uint64_t> page_starvation;
+    std::atomic<int64_t> send_queue_depth;
+    std::atomic<uint64_t> eagain;
+    std::atomic<uint64_t> connects;
+    std::atomic<uint64_t> msg_size_hist[NUM_SIZE_BINS];
+
+    socket_stats();
+
+    void count_in(size_t bytes);
+    void count_out(size_t bytes);
+    uint64_t reconnects() const;
+    int64_t pages_available() const;
+
+    static unsigned size_bin(size_t bytes);
+};
+
+
 class socket
 {
 public:
     socket(context* ctx, sockcfg cfg = sockcfg::cfg());
 
+    socket_stats& stats();
+
 protected:
     context* ctx;
     sockcfg cfg;
+    netio::event_loop* evloop;
+    std::shared_ptr<socket_stats> stats_;
 
     netio::backend* backend();
     netio::event_loop* event_loop();
@@ -369,20 +486,28 @@ class buffer_feeder
     size_t buffersize_;
     unsigned max_buffers;
     context* ctx;
+    event_loop* evloop;
+    std::shared_ptr<socket_stats> stats;
 
     std::unique_ptr<signal> buf_available_signal;
 
+    std::mutex wait_mutex;
+    std::condition_variable wait_cv;
+    std::atomic<unsigned> waiters;
+
     void allocate_buffer();
 
 public:
-    buffer_feeder(unsigned num_buffers, size_t size, context* ctx);
+    buffer_feeder(unsigned num_buffers, size_t size, context* ctx, event_loop* evloop=nullptr);
     ~buffer_feeder();
     bool try_pop(reusable_buffer** buffer);
+    bool wait_for_buffer(unsigned timeout_ms);
     size_t buffersize() const;
     size_t num_total_buffers() const;
     size_t num_available_buffers() const;
     void release(reusable_buffer* b);
     void clear_all_pages();
+    void set_stats(std::shared_ptr<socket_stats> s);
 
     typedef void(*buf_available_fn)(void*);
     void register_buf_available_cb(buf_available_fn fn, void* data );
@@ -400,6 +525,11 @@ public:
     void send(const message& msg);
     void flush();
 
+    /* Like send(), but never waits for a free page: returns false without
+     * sending anything if the message does not fit into the pages at hand.
+     * The writable callback is invoked once a page comes back. */
+    bool try_send(const message& msg);
+
     bool is_connecting() const;
     bool is_open() const;
     bool is_closed() const;
@@ -408,17 +538,30 @@ public:
 
     void register_cb_on_connection_opened(std::function<void()> fn);
     void register_cb_on_connection_closed(std::function<void()> fn);
+    void register_cb_on_writable(std::function<void()> fn);
 private:
-    void non_mutex_flush();
+    bool non_mutex_flush(bool block=true);
+    bool next_page(bool block);
+    bool fits(size_t msg_size) const;
+    void write_message(const message& msg);
+    bool try_flush();
+
+    static void on_deadline(void* data);
+    static void on_buffer_available(void* data);
 
     static const unsigned QUEUE_LENGTH = 64;
 
     netio::endpoint peer_;
     backend_send_socket* socket;
     timer tmr;
+    timer deadline_tmr;
+    unsigned flush_latency_usecs;
+    std::atomic<bool> deadline_armed;
+    std::atomic<bool> would_block;
+    std::function<void()> cb_writable;
     spinlock lock;
     buffer_feeder feeder;
-    reusable_buffer* current_buffer;
+    reusable_buffer* current_buffer;    // nullptr while waiting for a free page
 };
 
 
@@ -431,14 +574,22 @@ public:
     void recv(message& msg);
     void recv(endpoint& ep, message& msg);
 
+    /* Append up to max queued messages to msgs. Blocks until at least one
+     * message is available or timeout_ms expires (-1: no timeout, 0: do not
+     * block) and returns the number of messages appended. */
+    size_t recv_many(std::vector<message>& msgs, size_t max, int timeout_ms=-1);
+
     void close();
 
     endpoint listen_endpoint() const;
 
 private:
-    enum { OPEN, CLOSED } connection_status;
+    enum status { OPEN, CLOSED };
+    std::atomic<status> connection_status;
 
     backend_listen_socket* socket;
+
+    bool wait_for_message(message& msg, endpoint* ep, int timeout_ms);
     std::function<void(recv_socket&)> cb_recv_msg;
 };
 
@@ -470,6 +621,7 @@ typedef std::map<tag, std::list<std::shared_ptr<buffered_send_socket>>>    subsc
 typedef std::map<tag, std::list<std::shared_ptr<low_latency_send_socket>>> subscription_map_ll;
 
 class publish_socket; // Forward declaration
+struct subscription_snapshot; // Forward declaration
 
 class tag_publisher
 {
@@ -480,8 +632,6 @@ public:
 private:
     tag t;
     publish_socket & pub_socket;
-    std::list<std::shared_ptr<buffered_send_socket>> const & ht_sockets;
-    std::list<std::shared_ptr<low_latency_send_socket>> const & ll_sockets;
 };
 
 class publish_socket : public socket
@@ -499,12 +649,23 @@ public:
 private:
     low_latency_recv_socket subscription_socket;
 
+    // Writer side: modified under subscription_mutex by the subscription
+    // callbacks, then published to the readers as an immutable snapshot
     connection_map connections;
     connection_map_ll connections_ll;
     subscription_map subscriptions;
     subscription_map_ll subscriptions_ll;
     std::mutex subscription_mutex;
 
+    // Reader side: publish() looks up the current snapshot without locking.
+    // Connections dropped by unsubscribe are closed at once, the replaced
+    // snapshots are only released once no publisher is inside publish()
+    // (see reclaim()).
+    std::atomic<subscription_snapshot*> snapshot;
+    std::atomic<unsigned> snapshot_readers;
+    std::atomic<bool> reclaim_pending;
+    std::vector<subscription_snapshot*> retired_snapshots;
+
     std::function<void(tag, endpoint)> cb_subscribe;
     std::function<void(tag, endpoint)> cb_unsubscribe;
 
@@ -512,6 +673,12 @@ private:
     void subscribe(tag tag, const endpoint& ep);
     void subscribe_ll(tag tag, const endpoint& ep);
     void unsubscribe(tag tag, const endpoint& ep);
+    void remove_closed_sockets(std::set<low_latency_send_socket*> const & closed_ll,
+                               std::set<buffered_send_socket*> const & closed);
+
+    // Do NOT call if you don't lock subscription_mutex
+    void update_snapshot();
+    void reclaim();
 
     // Do NOT call if you don't lock subscription_mutex
     template <typename TSubMap, typename TConnMap, typename TSocket>
@@ -550,7 +717,10 @@ void publish_socket::clean_closed_socket(
     }
 
     for (TSocket* socket: sockets) {
-        conn_map.erase(socket->peer());
+        // an unsubscribed socket is gone already, the peer may have a new one
+        auto itcon = conn_map.find(socket->peer());
+        if (itcon != conn_map.end() && itcon->second.get() == socket)
+            conn_map.erase(itcon);
     }
 }
 
@@ -568,7 +738,9 @@ public:
     void unsubscribe(tag* tags, unsigned n, endpoint ep);
     void recv(message& msg);
     void recv(endpoint& ep, message& msg);
+    size_t recv_many(std::vector<message>& msgs, size_t max, int timeout_ms=-1);
     void close();
+    socket_stats& stats();
 
 private:
     recv_socket receiving_socket;
@@ -587,6 +759,7 @@ public:
     void subscribe(tag* tags, unsigned n, endpoint ep);
     void unsubscribe(tag tag, endpoint ep);
     void unsubscribe(tag* tags, unsigned n, endpoint ep);
+    socket_stats& stats();
 
 private:
     low_latency_recv_socket receiving_socket;
@@ -57,9 +57,16 @@ netio::backend_send_socket::register_cb_on_connection_closed(std::function<void(
 }
 
 
+void
+netio::backend_send_socket::set_stats(std::shared_ptr<socket_stats> s)
+{
+    stats = s;
+}
+
+
 netio::backend_listen_socket::backend_listen_socket(event_loop* evloop, netio::endpoint ep,
                                                     netio::context* c, sockcfg cfg)
-    : cfg(cfg)
+    : cfg(cfg), waiters(0), wakeups(0)
 {
     this->evloop = evloop;
     this->ep = ep;
@@ -93,6 +100,13 @@ netio::backend_listen_socket::register_cb_on_msg_received(std::function<void(voi
 }
 
 
+void
+netio::backend_listen_socket::set_stats(std::shared_ptr<socket_stats> s)
+{
+    stats = s;
+}
+
+
 void
 netio::backend_listen_socket::add_page_entry(netio::reusable_buffer* page, size_t pos,
                                              backend_recv_socket* socket)
@@ -107,6 +121,7 @@ netio::backend_listen_socket::add_page_entry(netio::reusable_buffer* page, size_
     {
         page->inc_refcount();
         page_queue.push(page_entry(page, pos, socket));
+        notify_waiters();
         if(on_data_received) on_data_received();
     }
 }
@@ -117,6 +132,7 @@ netio::backend_listen_socket::add_message_entry(netio::message& m, netio::endpoi
 {
     if (ep.port()!=0){
         message_queue.emplace(m, ep);
+        notify_waiters();
         if(on_msg_received) on_msg_received();
     }
     else{
@@ -172,6 +188,44 @@ netio::backend_listen_socket::try_process_page()
 }
 
 
+bool
+netio::backend_listen_socket::wait_for_entries(unsigned timeout_ms)
+{
+    std::unique_lock<std::mutex> lock(wait_mutex);
+    // Registering as waiter before looking at the queues pairs with the
+    // producer pushing before looking at the waiter count: one of the two
+    // always sees the other.
+    waiters++;
+    uint64_t wakeup = wakeups.load();
+    bool ready = wait_cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this, wakeup]()
+    {
+        return !message_queue.empty() || !page_queue.empty() || wakeups.load() != wakeup;
+    });
+    waiters--;
+    return ready;
+}
+
+
+void
+netio::backend_listen_socket::wake_waiters()
+{
+    std::lock_guard<std::mutex> lock(wait_mutex);
+    wakeups++;
+    wait_cv.notify_all();
+}
+
+
+void
+netio::backend_listen_socket::notify_waiters()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(waiters.load() == 0)
+        return;
+    std::lock_guard<std::mutex> lock(wait_mutex);
+    wait_cv.notify_all();
+}
+
+
 void callback_add_to_ls_msg_queue(netio::message& m, void* data)
 {
     netio::backend_recv_socket* s = (netio::backend_recv_socket*)data;
@@ -180,12 +234,14 @@ void callback_add_to_ls_msg_queue(netio::message& m, void* data)
 
 netio::backend_recv_socket::backend_recv_socket(event_loop* evloop, backend_listen_socket* ls)
     : feeder(ls->cfg.get(sockcfg::BUFFER_PAGES_PER_CONNECTION), ls->cfg.get(sockcfg::PAGESIZE),
-             ls->context)
-    , active_pages(0)
+             ls->context, evloop)
+    , active_pages(0), released(false)
 {
     status = OPEN;
     this->evloop = evloop;
     this->listen_socket = ls;
+    if(ls->stats)
+        feeder.set_stats(ls->stats);
     msg_rcvd_cb_t callback = (msg_rcvd_cb_t)ls->cfg.get(sockcfg::CALLBACK);
     if(callback != nullptr)
     {
@@ -235,7 +291,6 @@ void
 netio::backend_recv_socket::close()
 {
     status = CLOSED;
-    active_pages.store(0);
     release();
 }
 
@@ -262,6 +317,7 @@ void
 netio::backend_recv_socket::release()
 {
     DEBUG_LOG("release: status=%d  active_pages=%d", status, active_pages.load());
-    if(status==CLOSED && active_pages==0)
+    // the event loop (close) and a consumer (process_page) can race here
+    if(status==CLOSED && active_pages==0 && !released.exchange(true))
         delete this;
 }
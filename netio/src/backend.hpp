@@ -5,6 +5,9 @@
 #include "deserialization.hpp"
 #include "tbb/concurrent_queue.h"
 
+#include <condition_variable>
+#include <mutex>
+
 
 #define NETIO_INITIAL_PAGES (64)
 #define NETIO_PAGESIZE (netio::buffered_send_socket::BUFFERSIZE)
@@ -28,13 +31,16 @@ public:
 
     void register_cb_on_connection_opened(std::function<void()> fn);
     void register_cb_on_connection_closed(std::function<void()> fn);
+    void set_stats(std::shared_ptr<socket_stats> s);
 
 protected:
     event_loop* evloop;
     event_loop::context ctx;
     sockcfg cfg;
+    std::shared_ptr<socket_stats> stats;
 
-    state status;
+    // read by publishers without the lock of the backend
+    std::atomic<state> status;
 
     std::function<void()> on_connection_opened;
     std::function<void()> on_connection_closed;
@@ -63,7 +69,8 @@ protected:
     netio::buffer_feeder feeder;
 
     std::unique_ptr<netio::new_deserializer> deserializer;
-    std::atomic_int active_pages;
+    std::atomic_int active_pages;          // fetched pages not yet processed
+    std::atomic_bool released;
     enum connection_status
     {
         OPEN, CLOSED
@@ -95,6 +102,12 @@ public:
     bool pop_message_entry(netio::message*, netio::endpoint* ep=NULL);
     void process_page();
     bool try_process_page();
+    void set_stats(std::shared_ptr<socket_stats> s);
+
+    // Block until a page or a message is queued, the timeout expires or
+    // wake_waiters() is called. Returns false on timeout.
+    bool wait_for_entries(unsigned timeout_ms);
+    void wake_waiters();
 
 protected:
     netio::context* context;
@@ -102,6 +115,7 @@ protected:
     event_loop::context ctx;
     netio::endpoint ep;
     sockcfg cfg;
+    std::shared_ptr<socket_stats> stats;
 
     struct message_entry
     {
@@ -129,6 +143,15 @@ protected:
     std::function<void(void)> on_data_received;
     std::function<void(void)> on_msg_received;
 
+    // Consumers of the queues sleep here instead of polling. Producers only
+    // take the mutex when somebody is actually waiting.
+    std::mutex wait_mutex;
+    std::condition_variable wait_cv;
+    std::atomic<unsigned> waiters;
+    std::atomic<uint64_t> wakeups;
+
+    void notify_waiters();
+
     friend class backend_recv_socket;
 };
 
@@ -240,11 +240,13 @@ netio::reusable_buffer::dec_refcount()
 }
 
 
-netio::buffer_feeder::buffer_feeder(unsigned num_buffers, size_t size, context* ctx)
+netio::buffer_feeder::buffer_feeder(unsigned num_buffers, size_t size, context* ctx, event_loop* evloop)
 {
     this->ctx = ctx;
+    this->evloop = evloop ? evloop : ctx->event_loop();
     this->buffersize_ = size;
     this->max_buffers = num_buffers;
+    this->waiters = 0;
     for(unsigned i=0; i<num_buffers; i++)
     {
         allocate_buffer();
@@ -260,6 +262,13 @@ netio::buffer_feeder::~buffer_feeder()
         page->detach();
     }
 
+    if(stats)
+    {
+        int64_t n = all_buffers.size();
+        stats->pages_total -= n;
+        stats->pages_in_use -= n - (int64_t)queue.unsafe_size();
+    }
+
     // clear free pages
     while(!queue.empty())
     {
@@ -284,6 +293,13 @@ bool
 netio::buffer_feeder::try_pop(reusable_buffer** buffer)
 {
     bool bufavailable = queue.try_pop(*buffer);
+    if(stats)
+    {
+        if(bufavailable)
+            stats->pages_in_use.fetch_add(1, std::memory_order_relaxed);
+        else
+            stats->page_starvation.fetch_add(1, std::memory_order_relaxed);
+    }
     if(bufavailable)
     {
         DEBUG_LOG("buffer_feeder::try_pop got reusable_buffer: %p with buffer: (data: %p, pos: %lu, size: %lu)",
@@ -302,6 +318,20 @@ netio::buffer_feeder::try_pop(reusable_buffer** buffer)
 }
 
 
+bool
+netio::buffer_feeder::wait_for_buffer(unsigned timeout_ms)
+{
+    std::unique_lock<std::mutex> lock(wait_mutex);
+    waiters++;
+    bool available = wait_cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this]()
+    {
+        return !queue.empty();
+    });
+    waiters--;
+    return available;
+}
+
+
 size_t
 netio::buffer_feeder::buffersize() const
 {
@@ -327,6 +357,14 @@ void
 netio::buffer_feeder::release(netio::reusable_buffer* b)
 {
     queue.push(b);
+    if(stats)
+        stats->pages_in_use.fetch_sub(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(waiters.load() != 0)
+    {
+        std::lock_guard<std::mutex> lock(wait_mutex);
+        wait_cv.notify_all();
+    }
     if(buf_available_signal)
         buf_available_signal->fire();
     DEBUG_LOG("buffer_feeder::release reusable buffer: %p, available/total: %lu/%lu",
@@ -337,7 +375,15 @@ netio::buffer_feeder::release(netio::reusable_buffer* b)
 void
 netio::buffer_feeder::register_buf_available_cb(buf_available_fn fn, void* data)
 {
-    buf_available_signal = std::make_unique<netio::signal>(ctx->event_loop(), fn, data);
+    buf_available_signal = std::make_unique<netio::signal>(evloop, fn, data);
+}
+
+
+void
+netio::buffer_feeder::set_stats(std::shared_ptr<socket_stats> s)
+{
+    stats = s;
+    stats->pages_total += all_buffers.size();
 }
 
 
@@ -345,6 +391,12 @@ void
 netio::buffer_feeder::clear_all_pages()
 {
     DEBUG_LOG("clear_all_pages()");
+    if(stats)
+    {
+        int64_t n = all_buffers.size();
+        stats->pages_total -= n;
+        stats->pages_in_use -= n - (int64_t)queue.unsafe_size();
+    }
     queue.clear();
     for(auto b : all_buffers)
     {
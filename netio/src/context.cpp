@@ -1,26 +1,45 @@
 #include "netio/netio.hpp"
 #include "backend.hpp"
 #include "posix.hpp"
+#include "shm.hpp"
 #include "fi_verbs.hpp"
+#include "utility.hpp"
 #include "config.h"
 
-netio::context::context(std::string name)
+#include <pthread.h>
+#include <sched.h>
+
+netio::context::context(std::string name, unsigned num_event_loops)
+    : next_loop(0)
 {
     backend_ = nullptr;
     if(name == "posix")
     {
         backend_ = new netio::posix_backend();
     }
+    if(name == "shm")
+    {
+        backend_ = new netio::shm_backend();
+    }
 #ifdef ENABLE_FIVERBS
     if(name == "fi_verbs")
     {
         backend_ = new netio::fi_verbs_backend();
     }
 #endif
+    if(num_event_loops == 0)
+    {
+        num_event_loops = 1;
+    }
+    for(unsigned i=0; i<num_event_loops; i++)
+    {
+        evloops.emplace_back(new netio::event_loop());
+    }
 }
 
 netio::context::~context()
 {
+    stop();
     if(backend_)
         delete backend_;
 }
@@ -29,7 +48,42 @@ netio::context::~context()
 netio::event_loop*
 netio::context::event_loop()
 {
-    return &(this->evloop);
+    return evloops[0].get();
+}
+
+
+netio::event_loop*
+netio::context::event_loop(unsigned index)
+{
+    return evloops[index % evloops.size()].get();
+}
+
+
+unsigned
+netio::context::num_event_loops() const
+{
+    return evloops.size();
+}
+
+
+unsigned
+netio::context::select_event_loop(const sockcfg& cfg)
+{
+    uint64_t index = cfg.get(sockcfg::EVENT_LOOP);
+    if(index != sockcfg::ANY_EVENT_LOOP)
+    {
+        return index % evloops.size();
+    }
+    return next_loop.fetch_add(1) % evloops.size();
+}
+
+
+unsigned
+netio::context::event_loop_index(const endpoint& ep) const
+{
+    size_t h = std::hash<std::string>()(ep.address());
+    h = h * 31 + ep.port();
+    return h % evloops.size();
 }
 
 
@@ -38,3 +92,63 @@ netio::context::backend()
 {
     return this->backend_;
 }
+
+
+void
+netio::context::start(bool pin_threads)
+{
+    if(!threads.empty())
+    {
+        THROW_WITH_MSG(std::runtime_error, "netio::context event loops are already running");
+    }
+    unsigned ncpus = std::thread::hardware_concurrency();
+    for(unsigned i=0; i<evloops.size(); i++)
+    {
+        netio::event_loop* evloop = evloops[i].get();
+        finished.emplace_back(new std::atomic_bool(false));
+        std::atomic_bool* done = finished.back().get();
+        threads.emplace_back([evloop,done](){ evloop->run_forever(); done->store(true); });
+        if(pin_threads && ncpus > 0)
+        {
+            cpu_set_t cpuset;
+            CPU_ZERO(&cpuset);
+            CPU_SET(i % ncpus, &cpuset);
+            pthread_setaffinity_np(threads.back().native_handle(), sizeof(cpu_set_t), &cpuset);
+        }
+    }
+}
+
+
+void
+netio::context::stop()
+{
+    if(threads.empty())
+    {
+        return;
+    }
+    // a loop that enters run_forever after stop() sets it running again,
+    // so stop the loops until all their threads have left run_forever
+    bool running = true;
+    while(running)
+    {
+        running = false;
+        for(unsigned i=0; i<threads.size(); i++)
+        {
+            if(!finished[i]->load())
+            {
+                evloops[i]->stop();
+                running = true;
+            }
+        }
+        if(running)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    for(auto& t : threads)
+    {
+        t.join();
+    }
+    threads.clear();
+    finished.clear();
+}
@@ -27,6 +27,7 @@ namespace netio
 class new_deserializer
 {
 public:
+    virtual ~new_deserializer() {}
 
     void feed(netio::reusable_buffer* page)
     {
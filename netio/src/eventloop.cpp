@@ -19,6 +19,7 @@ ssize_t safe_write(int fd, const void* buf, size_t bufsz);
 
 
 netio::event_loop::event_loop()
+    : running(false), busy_poll_usecs(0), spin_hits_(0), sleeps_(0)
 {
     epollfd = epoll_create(1024); // size argument ignored, see EPOLL_CREATE(2)
     DEBUG_LOG("EPOLLFD is %d", epollfd);
@@ -105,27 +106,62 @@ netio::event_loop::wait_for_events(int epollfd, unsigned timeout_millisecs)
 }
 
 
-void
-netio::event_loop::run_forever()
+static unsigned long long
+now_millisecs()
 {
-    const unsigned TIMEOUT_MILLISECS = 100;
-    running.store(true);
-    while(running.load())
+    struct timespec t;
+    if(-1 == clock_gettime(CLOCK_MONOTONIC_COARSE, &t))
     {
-        wait_for_events(epollfd, TIMEOUT_MILLISECS);
+        netio::raise_errno_exception();
     }
+    return t.tv_sec*1000 + t.tv_nsec/(1000*1000);
 }
 
 
 static unsigned long long
-now_millisecs()
+now_microsecs()
 {
     struct timespec t;
-    if(-1 == clock_gettime(CLOCK_MONOTONIC_COARSE, &t))
+    if(-1 == clock_gettime(CLOCK_MONOTONIC, &t))
     {
         netio::raise_errno_exception();
     }
-    return t.tv_sec*1000 + t.tv_nsec/(1000*1000);
+    return t.tv_sec*1000000ULL + t.tv_nsec/1000;
+}
+
+
+bool
+netio::event_loop::spin_for_events(unsigned usecs)
+{
+    unsigned long long tp = now_microsecs();
+    do
+    {
+        if(wait_for_events(epollfd, 0) > 0)
+        {
+            return true;
+        }
+    }
+    while(running.load() && (now_microsecs() - tp) < usecs);
+    return false;
+}
+
+
+void
+netio::event_loop::run_forever()
+{
+    const unsigned TIMEOUT_MILLISECS = 100;
+    running.store(true);
+    while(running.load())
+    {
+        unsigned budget = busy_poll_usecs.load(std::memory_order_relaxed);
+        if(budget > 0 && spin_for_events(budget))
+        {
+            spin_hits_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        sleeps_.fetch_add(1, std::memory_order_relaxed);
+        wait_for_events(epollfd, TIMEOUT_MILLISECS);
+    }
 }
 
 
@@ -231,6 +267,42 @@ netio::event_loop::is_running() const
 }
 
 
+void
+netio::event_loop::set_busy_poll(unsigned usecs)
+{
+    busy_poll_usecs.store(usecs);
+}
+
+
+unsigned
+netio::event_loop::busy_poll() const
+{
+    return busy_poll_usecs.load();
+}
+
+
+uint64_t
+netio::event_loop::spin_hits() const
+{
+    return spin_hits_.load(std::memory_order_relaxed);
+}
+
+
+uint64_t
+netio::event_loop::sleeps() const
+{
+    return sleeps_.load(std::memory_order_relaxed);
+}
+
+
+void
+netio::event_loop::reset_counters()
+{
+    spin_hits_.store(0);
+    sleeps_.store(0);
+}
+
+
 netio::timer::timer(event_loop* evloop, std::function<void(void*)> fn, void* data)
 {
     this->evloop = evloop;
@@ -281,6 +353,22 @@ netio::timer::start(unsigned millisecs)
 }
 
 
+void
+netio::timer::start_oneshot(unsigned microsecs)
+{
+    struct itimerspec it;
+    it.it_interval.tv_sec = 0;
+    it.it_interval.tv_nsec = 0;
+    // a zero it_value would disarm the timer
+    if(microsecs == 0)
+        microsecs = 1;
+    it.it_value.tv_sec = microsecs / 1000000;
+    it.it_value.tv_nsec = (microsecs % 1000000) * 1000;
+    if(timerfd_settime(ctx.fd, 0, &it, NULL))
+        netio::raise_errno_exception();
+}
+
+
 void
 netio::timer::stop()
 {
@@ -13,14 +13,89 @@
 namespace netio
 {
 
+// Overflow nodes (beyond the inline ones) are recycled through a small
+// per-thread free list instead of going back to the allocator. A node freed
+// on another thread than the one that allocated it simply changes pools.
+#define FRAGMENT_POOL_MAX_NODES (256)
 
-message::message(cleanup_fn hook) : cleanup_hook(hook)
+namespace
+{
+
+struct fragment_pool
+{
+    message::fragment* free_list = nullptr;
+    unsigned free_nodes = 0;
+
+    ~fragment_pool()
+    {
+        while(free_list != nullptr)
+        {
+            message::fragment* next = free_list->next;
+            delete free_list;
+            free_list = next;
+        }
+    }
+
+    message::fragment* get()
+    {
+        if(free_list == nullptr)
+            return new message::fragment;
+        message::fragment* f = free_list;
+        free_list = f->next;
+        free_nodes--;
+        return f;
+    }
+
+    void put(message::fragment* f)
+    {
+        if(free_nodes >= FRAGMENT_POOL_MAX_NODES)
+        {
+            delete f;
+            return;
+        }
+        f->next = free_list;
+        free_list = f;
+        free_nodes++;
+    }
+};
+
+thread_local fragment_pool pool;
+
+}
+
+
+void message::init_head()
 {
-    DEBUG_LOG("message()");
     head.data[0] = head.data[1] = nullptr;
     head.size[0] = head.size[1] = 0;
     head.buffer[0] = head.buffer[1] = nullptr;
     head.next = nullptr;
+    spare_used = 0;
+    tail = &head;
+}
+
+
+message::fragment* message::new_node()
+{
+    fragment* f = spare_used < INLINE_NODES-1 ? &spare[spare_used++] : pool.get();
+    f->data[0] = f->data[1] = nullptr;
+    f->size[0] = f->size[1] = 0;
+    f->buffer[0] = f->buffer[1] = nullptr;
+    f->next = nullptr;
+    return f;
+}
+
+
+bool message::is_inline(const fragment* f) const
+{
+    return f == &head || (f >= spare && f < spare + (INLINE_NODES-1));
+}
+
+
+message::message(cleanup_fn hook) : cleanup_hook(hook)
+{
+    DEBUG_LOG("message()");
+    init_head();
 }
 
 
@@ -28,16 +103,10 @@ message::message(const uint8_t* d, size_t size, reusable_buffer* rb, cleanup_fn
     : cleanup_hook(hook)
 {
     DEBUG_LOG("message(uint8_t*, size_t)");
-
+    init_head();
     head.data[0] = d;
     head.size[0] = size;
     head.buffer[0] = rb;
-
-    head.data[1] = nullptr;
-    head.size[1] = 0;
-    head.buffer[1] = nullptr;
-
-    head.next = nullptr;
 }
 
 
@@ -47,34 +116,10 @@ message::message(const std::vector<const uint8_t*>& data,
     : cleanup_hook(hook)
 {
     DEBUG_LOG("message(stdvec<uint8_t*>, stdvec<size_t>)");
-    fragment* p = &head;
-    for(unsigned i=0; i<data.size(); )
+    init_head();
+    for(unsigned i=0; i<data.size(); i++)
     {
-        p->data[0] = data[i];
-        p->size[0] = sizes[i];
-        p->buffer[0] = p->buffer[1] = nullptr;
-        ++i;
-
-        if(i < data.size()-1)
-        {
-            p->data[1] = data[i];
-            p->size[1] = sizes[i];
-            p->next = new fragment;
-        }
-        else if(data.size()==i)
-        {
-            p->data[1] = nullptr;
-            p->size[1] = 0;
-            p->next = nullptr;
-        }
-        else
-        {
-            p->data[1] = data[i];
-            p->size[1] = sizes[i];
-            p->next = nullptr;
-        }
-        p = p->next;
-        ++i;
+        add_fragment(data[i], sizes[i]);
     }
 }
 
@@ -83,24 +128,14 @@ message::message(const std::vector<const uint8_t*>& data,
                  const std::vector<size_t>& sizes,
                  const std::vector<reusable_buffer*>& rbs,
                  cleanup_fn hook)
-    : message(data, sizes, hook)
+    : cleanup_hook(hook)
 {
     DEBUG_LOG("message(stdvec<uint8_t*>, stdvec<size_t>, stdvec<reusable_buffer*>)");
-
-    fragment* p = &head;
-    for(unsigned i=0; i<rbs.size(); )
+    init_head();
+    for(unsigned i=0; i<data.size(); i++)
     {
-        DEBUG_LOG("setting buffer %i of msg 0x%x to 0x%x", i, this, rbs[i]);
-        p->buffer[0] = rbs[i];
-        ++i;
-
-        if(i<rbs.size())
-        {
-            DEBUG_LOG("setting buffer %i of msg 0x%x to 0x%x", i, this, rbs[i]);
-            p->buffer[1] = rbs[i];
-        }
-        p = p->next;
-        ++i;
+        DEBUG_LOG("setting buffer %i of msg 0x%x to 0x%x", i, this, i<rbs.size() ? rbs[i] : nullptr);
+        add_fragment(data[i], sizes[i], i<rbs.size() ? rbs[i] : nullptr);
     }
 }
 
@@ -113,46 +148,10 @@ message::message(const uint8_t* const* data,
     : cleanup_hook(hook)
 {
     DEBUG_LOG("message(uint8_t**, size_t*)");
-    fragment* p = &head;
-    for(unsigned i=0; i<n; )
+    init_head();
+    for(unsigned i=0; i<n; i++)
     {
-        p->data[0] = data[i];
-        p->size[0] = sizes[i];
-        if(rbs)
-        {
-            p->buffer[0] = rbs[i];
-        }
-        ++i;
-
-        if(i<n-1)
-        {
-            p->data[1] = data[i];
-            p->size[1] = sizes[i];
-            if(rbs)
-            {
-                p->buffer[1] = rbs[i];
-            }
-            p->next = new fragment;
-        }
-        else if(n==i)
-        {
-            p->data[1] = nullptr;
-            p->size[1] = 0;
-            p->buffer[1] = nullptr;
-            p->next = nullptr;
-        }
-        else
-        {
-            p->data[1] = data[i];
-            p->size[1] = sizes[i];
-            if(rbs)
-            {
-                p->buffer[1] = rbs[i];
-            }
-            p->next = nullptr;
-        }
-        p = p->next;
-        ++i;
+        add_fragment(data[i], sizes[i], rbs ? rbs[i] : nullptr);
     }
 }
 
@@ -161,83 +160,95 @@ message::message(const std::string& str, reusable_buffer* rb)
     : cleanup_hook(message_cleanup_delete_data)
 {
     DEBUG_LOG("message(string)");
-
+    init_head();
     head.data[0] = new uint8_t[str.size()];
     memcpy((void*)head.data[0], (void*)str.c_str(), str.size());
     head.size[0] = str.length();
     head.buffer[0] = rb;
-
-    head.data[1] = nullptr;
-    head.size[1] = 0;
-    head.buffer[1] = nullptr;
-
-    head.next = nullptr;
 }
 
 
 void temp_null_cleanup(netio::message&) {}
 
 
-message::message(const message& msg)
+/*
+ * Rebuild the node structure of other in this (empty) message, using the
+ * inline nodes first. The data itself is shared, not copied.
+ */
+void message::copy_fragments(const message& other)
 {
-    DEBUG_LOG("message(const message&)");
-    cleanup_hook = msg.cleanup_hook;
-    const fragment* p_other = &(msg.head);
     fragment* p_this = &head;
-    while(p_this != nullptr)
+    for(const fragment* p_other = &other.head; p_other != nullptr; p_other = p_other->next)
     {
-        p_this->data[0] = p_other->data[0];
-        p_this->size[0] = p_other->size[0];
-        p_this->buffer[0] = p_other->buffer[0];
-
-        p_this->data[1] = p_other->data[1];
-        p_this->size[1] = p_other->size[1];
-        p_this->buffer[1] = p_other->buffer[1];
-
-        if(p_other->next != nullptr)
-            p_this->next = new fragment;
-        else
-            p_this->next = nullptr;
-        p_this = p_this->next;
-        p_other = p_other->next;
+        if(p_other != &other.head)
+        {
+            p_this->next = new_node();
+            p_this = p_this->next;
+        }
+        for(unsigned i=0; i<2; i++)
+        {
+            p_this->data[i] = p_other->data[i];
+            p_this->size[i] = p_other->size[i];
+            p_this->buffer[i] = p_other->buffer[i];
+        }
     }
+    tail = p_this;
 }
 
 
-message::message(message&& other)
-    : cleanup_hook(other.cleanup_hook)
+/*
+ * Move the fragments of other into this (empty) message. Inline nodes are
+ * copied and relinked, pooled nodes change owner. other is left empty.
+ */
+void message::take_fragments(message& other)
 {
-    DEBUG_LOG("message(messagse&&) (this=0x%x)", this);
+    head = other.head;
+    for(unsigned i=0; i<other.spare_used; i++)
+        spare[i] = other.spare[i];
+    spare_used = other.spare_used;
 
-    head.size[0] = other.head.size[0];
-    head.data[0] = other.head.data[0];
-    head.buffer[0] = other.head.buffer[0];
+    tail = &head;
+    for(fragment* p = &head; p != nullptr; p = p->next)
+    {
+        if(p->next != nullptr && other.is_inline(p->next))
+            p->next = spare + (p->next - other.spare);
+        tail = p;
+    }
 
-    head.size[1] = other.head.size[1];
-    head.data[1] = other.head.data[1];
-    head.buffer[1] = other.head.buffer[1];
+    other.init_head();
+}
 
-    head.next = other.head.next;
 
-    other.head.data[0] = other.head.data[1] = nullptr;
-    other.head.size[0] = other.head.size[1] = 0;
-    other.head.buffer[0] = other.head.buffer[1] = nullptr;
-    other.head.next = nullptr;
+message::message(const message& msg)
+{
+    DEBUG_LOG("message(const message&)");
+    cleanup_hook = msg.cleanup_hook;
+    init_head();
+    copy_fragments(msg);
+}
 
+
+message::message(message&& other) noexcept
+    : cleanup_hook(other.cleanup_hook)
+{
+    DEBUG_LOG("message(messagse&&) (this=0x%x)", this);
+    take_fragments(other);
     other.cleanup_hook = nullptr;
     DEBUG_LOG("move constructor, buffer[0]=0x%x, buffer[1]=0x%x", head.buffer[0], head.buffer[1]);
 }
 
 
-void message::clean_fragment(netio::message::fragment* f)
+void message::clean_fragments()
 {
-    if(f->next != nullptr)
-        clean_fragment(f->next);
-    delete f->next;
-    f->data[0] = f->data[1] = nullptr;
-    f->size[0] = f->size[1] = 0;
-    f->buffer[0] = f->buffer[1] = nullptr;
-    f->next = nullptr;
+    fragment* p = head.next;
+    while(p != nullptr)
+    {
+        fragment* next = p->next;
+        if(!is_inline(p))
+            pool.put(p);
+        p = next;
+    }
+    init_head();
 }
 
 
@@ -247,7 +258,7 @@ message::~message()
     if(cleanup_hook)
         cleanup_hook(*this);
 
-    clean_fragment(&head);
+    clean_fragments();
 }
 
 
@@ -258,57 +269,26 @@ message& message::operator= (const message& other)
     {
         if(cleanup_hook)
             cleanup_hook(*this);
-        clean_fragment(&head);
-        const fragment* p_other = &(other.head);
-        fragment* p_this = &head;
-        while(p_this != nullptr)
-        {
-            p_this->data[0] = p_other->data[0];
-            p_this->size[0] = p_other->size[0];
-            p_this->buffer[0] = p_other->buffer[0];
-
-            p_this->data[1] = p_other->data[1];
-            p_this->size[1] = p_other->size[1];
-            p_this->buffer[1] = p_other->buffer[1];
-
-            if(p_other->next != nullptr)
-                p_this->next = new fragment;
-            else
-                p_this->next = nullptr;
-            p_this = p_this->next;
-            p_other = p_other->next;
-        }
+        clean_fragments();
+        cleanup_hook = other.cleanup_hook;
+        copy_fragments(other);
     }
     return *this;
 }
 
 
-message& message::operator= (message&& other)
+message& message::operator= (message&& other) noexcept
 {
     DEBUG_LOG("message::operator=(message&&)");
     if(this != &other)
     {
         if(cleanup_hook)
             cleanup_hook(*this);
-        clean_fragment(&head);
+        clean_fragments();
 
         cleanup_hook = other.cleanup_hook;
         other.cleanup_hook = nullptr;
-
-        head.data[0] = other.head.data[0];
-        head.size[0] = other.head.size[0];
-        head.buffer[0] = other.head.buffer[0];
-
-        head.data[1] = other.head.data[1];
-        head.size[1] = other.head.size[1];
-        head.buffer[1] = other.head.buffer[1];
-
-        head.next = other.head.next;
-
-        other.head.data[0] = other.head.data[1] = nullptr;
-        other.head.size[0] = other.head.size[1] = 0;
-        other.head.buffer[0] = other.head.buffer[1] = nullptr;
-        other.head.next = nullptr;
+        take_fragments(other);
     }
     return *this;
 }
@@ -340,36 +320,24 @@ uint8_t message::operator[](size_t i) const
 
 void message::add_fragment(const uint8_t* data, size_t size, reusable_buffer* rb)
 {
-    fragment* p = &head;
+    fragment* p = tail;
 
     if(p->data[0])
     {
-        while(p->next != nullptr) p = p->next;
-
         if(p->data[1] == nullptr)
         {
             p->data[1] = data;
             p->size[1] = size;
             p->buffer[1] = rb;
-
             return;
         }
-        else
-        {
-            p->next = new fragment;
-            p = p->next;
-        }
+        p->next = new_node();
+        p = tail = p->next;
     }
 
     p->data[0] = data;
     p->size[0] = size;
     p->buffer[0] = rb;
-
-    p->data[1] = nullptr;
-    p->size[1] = 0;
-    p->buffer[1] = nullptr;
-
-    p->next = nullptr;
 }
 
 
@@ -440,17 +408,10 @@ void message::serialize_to_usr_buffer(void* buffer)
         cleanup_hook(*this);
     cleanup_hook = NULL;
 
-    clean_fragment(&head);
+    clean_fragments();
 
     head.data[0] = (uint8_t*)buffer;
     head.size[0] = s;
-    head.buffer[0] = nullptr;
-
-    head.data[1] = nullptr;
-    head.size[1] = 0;
-    head.buffer[1] = nullptr;
-
-    head.next = nullptr;
 }
 
 
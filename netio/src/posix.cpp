@@ -11,6 +11,7 @@
 #include <netinet/tcp.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <poll.h>
 
 #define MAXCONN (1024)
 
@@ -28,6 +29,22 @@
 //#define AFDW
 
 
+static void
+set_busy_poll(int sfd, uint64_t usecs)
+{
+    if(usecs == 0)
+        return;
+#ifdef SO_BUSY_POLL
+    int value = usecs;
+    // raising the value above net.core.busy_read requires CAP_NET_ADMIN
+    if(setsockopt(sfd, SOL_SOCKET, SO_BUSY_POLL, &value, sizeof(value)) == -1)
+    {
+        DEBUG_LOG("SO_BUSY_POLL not applied to FD %d: %s", sfd, strerror(errno));
+    }
+#endif
+}
+
+
 #ifdef AFDW
 static void make_socket_non_blocking (int sfd);
 
@@ -57,6 +74,7 @@ netio::async_fd_writer& netio::async_fd_writer::operator=(const netio::async_fd_
         this->size = other.size;
         this->bytes_written = other.bytes_written;
         this->connection_dead = other.connection_dead;
+        this->stats = other.stats;
     }
     return *this;
 }
@@ -73,6 +91,7 @@ void netio::async_fd_writer::add_buffer(netio::reusable_buffer* buffer)
   }
   DEBUG_LOG("async_fd_writer: adding buffer 0x%x", buffer);
   buffers_to_send.push(buffer);
+  if(stats) stats->send_queue_depth++;
   this->send();
 }
 
@@ -91,6 +110,7 @@ void netio::async_fd_writer::send()
         DEBUG_LOG("async_fd_writer: no more buffers to send");
         return;
       }
+      if(stats) stats->send_queue_depth--;
       bytes_written = 0;
       size = current_buffer->buffer()->pos();
       DEBUG_LOG("async_fd_writer: fetched new buffer size: %d", size);
@@ -110,6 +130,7 @@ void netio::async_fd_writer::send()
         {
             if(errno == EAGAIN || errno == EWOULDBLOCK) {
               DEBUG_LOG("async_fd_writer: EAGAIN");
+              if(stats) stats->eagain++;
               return;
             } else {
               DEBUG_LOG("connection died");
@@ -118,6 +139,7 @@ void netio::async_fd_writer::send()
               while(buffers_to_send.try_pop(current_buffer)) {
                 current_buffer->release();
               }
+              if(stats) stats->send_queue_depth = 0;
               return;
             }
         } else {
@@ -153,7 +175,7 @@ static void async_write_to_fd(int fd, void* p)
 #endif
 
 netio::posix_send_socket::posix_send_socket(event_loop* evloop, sockcfg cfg)
-    : backend_send_socket(evloop, cfg)
+    : backend_send_socket(evloop, cfg), closing(false)
 {
 }
 
@@ -190,10 +212,12 @@ netio::posix_send_socket::connect(const endpoint& ep)
     setsockopt(ctx.fd, IPPROTO_TCP, TCP_NODELAY, &state, sizeof(state));
     state = 1;
     setsockopt(ctx.fd, SOL_SOCKET, SO_KEEPALIVE, &state, sizeof(state));
+    set_busy_poll(ctx.fd, cfg.get(sockcfg::BUSY_POLL_USECS));
 
 #ifdef AFDW
     //async_fd_writer
     fd_writer = async_fd_writer(ctx.fd);
+    fd_writer.stats = stats;
     // We register the FD in the eventloop with an empty callback
     // so a peer disconnect is handled (EPOLLRDHUP)
     ctx.data = &fd_writer;
@@ -207,6 +231,7 @@ netio::posix_send_socket::connect(const endpoint& ep)
 
     if(on_connection_opened)
         on_connection_opened();
+    closing = false;
     status = OPEN;
 }
 
@@ -214,6 +239,12 @@ netio::posix_send_socket::connect(const endpoint& ep)
 void
 netio::posix_send_socket::disconnect()
 {
+  // Only the first caller closes the FD. The shutdown wakes up a sender
+  // that waits for a peer that does not read anymore, the FD is closed
+  // once no sender is using it. The FD leaves the event loop first, which
+  // would otherwise close it on the hang-up the shutdown raises.
+  if(status != OPEN || closing.exchange(true))
+      return;
 #ifdef AFDW
   DEBUG_LOG("posix_send_socket::disconnect");
   try {
@@ -223,28 +254,59 @@ netio::posix_send_socket::disconnect()
   }
 #endif
   evloop->unregister_fd(&ctx);
-  close(ctx.fd);
-  status = CLOSED;
+  shutdown(ctx.fd, SHUT_RDWR);
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    close(ctx.fd);
+    status = CLOSED;
+  }
   if(on_connection_closed)
       on_connection_closed();
 }
 
 
 #ifndef AFDW
+// The write is synchronous: a full socket buffer counts as EAGAIN and the
+// caller waits for the FD to become writable again. send_queue_depth holds
+// the number of buffers waiting inside this function.
 static void
-write_to_fd(int fd, const char* buffer, size_t size)
+write_to_fd(int fd, const char* buffer, size_t size, netio::socket_stats* stats)
 {
     size_t bytes_written = 0;
-    while(bytes_written < size)
+    if(stats) stats->send_queue_depth++;
+    try
     {
-        int result = send(fd, (char*)buffer + bytes_written,
-                          size-bytes_written, MSG_NOSIGNAL);
-        if(result == -1)
+        while(bytes_written < size)
         {
-            netio::raise_errno_exception();
+            int result = send(fd, (char*)buffer + bytes_written,
+                              size-bytes_written, MSG_NOSIGNAL | MSG_DONTWAIT);
+            if(result == -1)
+            {
+                if(errno == EAGAIN || errno == EWOULDBLOCK)
+                {
+                    if(stats) stats->eagain++;
+                    struct pollfd pfd = { fd, POLLOUT, 0 };
+                    if(poll(&pfd, 1, -1) == -1 && errno != EINTR)
+                    {
+                        netio::raise_errno_exception();
+                    }
+                    continue;
+                }
+                if(errno == EINTR)
+                {
+                    continue;
+                }
+                netio::raise_errno_exception();
+            }
+            bytes_written += result;
         }
-        bytes_written += result;
     }
+    catch(...)
+    {
+        if(stats) stats->send_queue_depth--;
+        throw;
+    }
+    if(stats) stats->send_queue_depth--;
 }
 #endif
 
@@ -254,26 +316,46 @@ void
 netio::posix_send_socket::send_buffer(netio::reusable_buffer* buffer)
 {
     DEBUG_LOG("POSIX: send a reusable buffer");
-    try
+    bool broken = false;
     {
+        std::lock_guard<std::mutex> lock(mtx);
+        if(status != OPEN)
+        {
+            // a publisher can still hold a socket that was just disconnected
+            buffer->release();
+            return;
+        }
+        try
+        {
 #ifdef AFDW
-        fd_writer.add_buffer(buffer);
+            fd_writer.add_buffer(buffer);
 #else
-        write_to_fd(ctx.fd, buffer->buffer()->data(), buffer->buffer()->pos());
-        DEBUG_LOG("written to FD, releasing buffer now");
-        buffer->release();
+            write_to_fd(ctx.fd, buffer->buffer()->data(), buffer->buffer()->pos(), stats.get());
+            DEBUG_LOG("written to FD, releasing buffer now");
+            buffer->release();
+#endif
+        }
+        catch(std::system_error& e)
+        {
+            // Connection was closed (or is otherwise broken). The caller sees
+            // the CLOSED state.
+            DEBUG_LOG("There was an exception: system_error %s", e.what());
+#ifndef AFDW
+            buffer->release();
 #endif
+            broken = true;
+        }
+        catch(...)
+        {
+            DEBUG_LOG("There was an unknown exception");
+#ifndef AFDW
+            buffer->release();
+#endif
+            broken = true;
+        }
     }
-    catch(std::system_error& e)
-    {
-        // Connection was closed (or is otherwise broken)
-        DEBUG_LOG("There was an exception: system_error %s", e.what());
+    if(broken)
         disconnect();
-    }
-    catch(...)
-    {
-        DEBUG_LOG("There was an unknown exception");
-    }
 }
 
 
@@ -357,6 +439,7 @@ netio::posix_listen_socket::accept_connections()
         /* Make the incoming socket non-blocking and add it to the
            list of fds to monitor. */
         make_socket_non_blocking (infd);
+        set_busy_poll(infd, cfg.get(sockcfg::BUSY_POLL_USECS));
         try {
             netio::posix_recv_socket* socket = new netio::posix_recv_socket(evloop, this, infd);
             if(on_connected) on_connected(*socket);
@@ -429,6 +512,9 @@ netio::posix_end_processing_and_close_socket(netio::posix_recv_socket* socket)
       if (socket->current_page->buffer()->pos() > 0) {
         socket->listen_socket->add_page_entry(socket->current_page, socket->current_page->buffer()->pos(),
                                             socket);
+      } else {
+        // never queued, so never processed: give back its page count
+        socket->active_pages--;
       }
       socket->current_page->dec_refcount();
       socket->current_page = nullptr;
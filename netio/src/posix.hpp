@@ -29,6 +29,9 @@ private:
   tbb::concurrent_queue<netio::reusable_buffer*> buffers_to_send;
   netio::reusable_buffer* current_buffer = NULL;
   size_t bytes_written, size;
+
+public:
+  std::shared_ptr<netio::socket_stats> stats;
 };
 #endif
 
@@ -47,6 +50,11 @@ public:
     virtual void connect(const endpoint& ep);
     virtual void disconnect();
     virtual void send_buffer(netio::reusable_buffer* buffer);
+
+private:
+    // serializes the writes, and a write against the close of the FD
+    std::mutex mtx;
+    std::atomic<bool> closing;
 };
 
 
@@ -0,0 +1,780 @@
+#include "shm.hpp"
+#include "backend.hpp"
+#include "utility.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#define MAXCONN (1024)
+
+// memfd, data eventfd, space eventfd
+#define SHM_NUM_FDS (3)
+
+// range of ports handed out to listen sockets bound to port 0
+#define SHM_FIRST_DYNAMIC_PORT (49152)
+#define SHM_NUM_DYNAMIC_PORTS (16384)
+
+
+//#define TEST_IT
+#ifdef TEST_IT
+# define DEBUG_LOG( ... ) do { printf("[shm@%s:%3d] ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); fflush(stdout); } while(0)
+#else
+# define DEBUG_LOG( ... )
+#endif
+
+
+// name of the listener of an endpoint, also used for the memfd of its connections
+static std::string
+make_shm_name(const std::string& address, unsigned short port)
+{
+    return "netio-shm-" + address + "-" + std::to_string(port);
+}
+
+
+static socklen_t
+make_shm_address(struct sockaddr_un* addr, const std::string& address, unsigned short port)
+{
+    memset(addr, 0, sizeof(struct sockaddr_un));
+    addr->sun_family = AF_UNIX;
+    // abstract namespace: leading NUL byte, no file system entry to clean up
+    int n = snprintf(addr->sun_path + 1, sizeof(addr->sun_path) - 1, "%s",
+                     make_shm_name(address, port).c_str());
+    n = std::min<int>(n, sizeof(addr->sun_path) - 2);
+    return offsetof(struct sockaddr_un, sun_path) + 1 + n;
+}
+
+
+static bool
+is_wildcard_address(const std::string& address)
+{
+    return address == "0.0.0.0" || address == "::";
+}
+
+
+static void
+send_fds(int sfd, const int* fds)
+{
+    char byte = 0;
+    struct iovec iov;
+    iov.iov_base = &byte;
+    iov.iov_len = 1;
+
+    union
+    {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(SHM_NUM_FDS * sizeof(int))];
+    } control;
+    memset(&control, 0, sizeof(control));
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(SHM_NUM_FDS * sizeof(int));
+    memcpy(CMSG_DATA(cmsg), fds, SHM_NUM_FDS * sizeof(int));
+
+    if(sendmsg(sfd, &msg, MSG_NOSIGNAL) == -1)
+    {
+        netio::raise_errno_exception();
+    }
+}
+
+
+/* Returns the result of recvmsg: -1 on error (errno is set), 0 when the
+ * peer hung up, otherwise the descriptors are stored in fds. */
+static ssize_t
+recv_fds(int sfd, int* fds)
+{
+    char byte;
+    struct iovec iov;
+    iov.iov_base = &byte;
+    iov.iov_len = 1;
+
+    union
+    {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(SHM_NUM_FDS * sizeof(int))];
+    } control;
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    ssize_t result = recvmsg(sfd, &msg, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+    if(result <= 0)
+    {
+        return result;
+    }
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if(cmsg == nullptr || cmsg->cmsg_type != SCM_RIGHTS
+            || cmsg->cmsg_len != CMSG_LEN(SHM_NUM_FDS * sizeof(int)))
+    {
+        errno = EPROTO;
+        return -1;
+    }
+    memcpy(fds, CMSG_DATA(cmsg), SHM_NUM_FDS * sizeof(int));
+    return result;
+}
+
+
+static void
+notify(int efd)
+{
+    eventfd_write(efd, 1);
+}
+
+
+netio::shm_send_socket::shm_send_socket(event_loop* evloop, sockcfg cfg)
+    : backend_send_socket(evloop, cfg), ring(nullptr), mapsize(0), data_efd(-1), pending_offset(0)
+{
+    ctx.fd = -1;
+    space_ctx.fd = -1;
+}
+
+
+netio::shm_send_socket::~shm_send_socket()
+{
+    disconnect();
+}
+
+
+void
+netio::shm_send_socket::connect(const endpoint& ep)
+{
+    ctx.fd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if(ctx.fd == -1)
+    {
+        raise_errno_exception();
+    }
+
+    // a listener bound to the endpoint address, or else to the wildcard address
+    std::string address = ep.address();
+    struct sockaddr_un addr;
+    socklen_t addrlen = make_shm_address(&addr, address, ep.port());
+    int result = ::connect(ctx.fd, (struct sockaddr*)&addr, addrlen);
+    if(result != 0 && errno == ECONNREFUSED && !is_wildcard_address(address))
+    {
+        address = (ep.sockaddr()->sa_family == AF_INET6 ? "::" : "0.0.0.0");
+        addrlen = make_shm_address(&addr, address, ep.port());
+        result = ::connect(ctx.fd, (struct sockaddr*)&addr, addrlen);
+    }
+    if(result != 0)
+    {
+        DEBUG_LOG("shm_send_socket, closing ctx.fd %d", ctx.fd);
+        close(ctx.fd);
+        ctx.fd = -1;
+        THROW_WITH_MSG(std::runtime_error, "could not connect to shm endpoint "
+                       << ep.address()  << ":" << ep.port());
+    }
+
+    // Two pages in flight let the receiver drain one while the next is written
+    uint64_t capacity = 2 * cfg.get(sockcfg::PAGESIZE);
+    mapsize = sizeof(shm_ring) + capacity;
+
+    int fds[SHM_NUM_FDS];
+    fds[0] = memfd_create(make_shm_name(address, ep.port()).c_str(), MFD_CLOEXEC);
+    if(fds[0] == -1 || ftruncate(fds[0], mapsize) == -1)
+    {
+        int errsv = errno;
+        if(fds[0] != -1) close(fds[0]);
+        close(ctx.fd);
+        ctx.fd = -1;
+        throw std::system_error(errsv, std::generic_category());
+    }
+
+    void* p = mmap(NULL, mapsize, PROT_READ | PROT_WRITE, MAP_SHARED, fds[0], 0);
+    if(p == MAP_FAILED)
+    {
+        int errsv = errno;
+        close(fds[0]);
+        close(ctx.fd);
+        ctx.fd = -1;
+        throw std::system_error(errsv, std::generic_category());
+    }
+    ring = new (p) shm_ring;
+    ring->head.store(0);
+    ring->tail.store(0);
+    ring->producer_waiting.store(0);
+    ring->consumer_closed.store(0);
+    ring->capacity = capacity;
+
+    data_efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    space_ctx.fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    fds[1] = data_efd;
+    fds[2] = space_ctx.fd;
+    try
+    {
+        if(data_efd == -1 || space_ctx.fd == -1)
+        {
+            raise_errno_exception();
+        }
+        send_fds(ctx.fd, fds);
+    }
+    catch(...)
+    {
+        close(fds[0]);
+        disconnect();
+        throw;
+    }
+    // the receiver holds its own mapping now
+    close(fds[0]);
+
+    // The peer never writes to the control socket: any read event is a hang-up
+    ctx.data = this;
+    ctx.fn = [](int fd, void* data)
+    {
+        shm_send_socket* socket = (shm_send_socket*)data;
+        char c;
+        if(recv(fd, &c, 1, MSG_DONTWAIT) == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return;
+        DEBUG_LOG("peer hung up on FD %d", fd);
+        socket->disconnect();
+    };
+    evloop->register_read_fd(&ctx);
+
+    // The receiver signals the space eventfd when it frees space while the sender waits
+    space_ctx.data = this;
+    space_ctx.fn = [](int fd, void* data)
+    {
+        shm_send_socket* socket = (shm_send_socket*)data;
+        eventfd_t value;
+        eventfd_read(fd, &value);
+        bool broken = false;
+        {
+            std::lock_guard<std::mutex> lock(socket->mtx);
+            if(socket->ring == nullptr)
+                return;
+            socket->ring->producer_waiting.store(0);
+            try
+            {
+                socket->flush_pending();
+            }
+            catch(std::system_error& e)
+            {
+                DEBUG_LOG("There was an exception: system_error %s", e.what());
+                broken = true;
+            }
+        }
+        if(broken)
+            socket->disconnect();
+    };
+    evloop->register_read_fd(&space_ctx);
+
+    if(on_connection_opened)
+        on_connection_opened();
+    status = OPEN;
+}
+
+
+void
+netio::shm_send_socket::disconnect()
+{
+    DEBUG_LOG("shm_send_socket::disconnect");
+    std::unique_lock<std::mutex> lock(mtx);
+    if(ctx.fd != -1)
+    {
+        evloop->unregister_fd(&ctx);
+        close(ctx.fd);
+        ctx.fd = -1;
+    }
+    if(ring != nullptr)
+    {
+        // hand over what fits without waiting, a receiver that is gone takes nothing
+        try
+        {
+            flush_pending();
+        }
+        catch(std::system_error& e)
+        {
+            DEBUG_LOG("There was an exception: system_error %s", e.what());
+        }
+        munmap(ring, mapsize);
+        ring = nullptr;
+    }
+    release_pending();
+    if(data_efd != -1)
+    {
+        close(data_efd);
+        data_efd = -1;
+    }
+    if(space_ctx.fd != -1)
+    {
+        evloop->unregister_fd(&space_ctx);
+        close(space_ctx.fd);
+        space_ctx.fd = -1;
+    }
+    bool was_open = (status == OPEN);
+    status = CLOSED;
+    lock.unlock();
+    if(was_open && on_connection_closed)
+        on_connection_closed();
+}
+
+
+size_t
+netio::shm_send_socket::write_to_ring(const char* data, size_t size)
+{
+    const uint64_t capacity = ring->capacity;
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    uint64_t tail = ring->tail.load(std::memory_order_acquire);
+    size_t n = std::min<uint64_t>(capacity - (head - tail), size);
+    if(n == 0)
+    {
+        return 0;
+    }
+
+    uint64_t offset = head % capacity;
+    size_t first = std::min<uint64_t>(n, capacity - offset);
+    memcpy(ring->data() + offset, data, first);
+    memcpy(ring->data(), data + first, n - first);
+    ring->head.store(head + n, std::memory_order_release);
+
+    notify(data_efd);
+    return n;
+}
+
+
+/* Writes the pending buffers to the ring, with mtx held. Returns false when
+ * the ring is full, the space eventfd then resumes the flush. */
+bool
+netio::shm_send_socket::flush_pending()
+{
+    while(!pending.empty())
+    {
+        if(ring->consumer_closed.load() != 0)
+        {
+            throw std::system_error(EPIPE, std::generic_category());
+        }
+
+        netio::reusable_buffer* buffer = pending.front();
+        const char* data = buffer->buffer()->data();
+        size_t size = buffer->buffer()->pos();
+        pending_offset += write_to_ring(data + pending_offset, size - pending_offset);
+        if(pending_offset == size)
+        {
+            pending.pop_front();
+            pending_offset = 0;
+            if(stats) stats->send_queue_depth--;
+            buffer->release();
+            continue;
+        }
+
+        // Announce the wait before the re-check, the consumer tests the flag
+        // after publishing its tail (both sequentially consistent)
+        ring->producer_waiting.store(1);
+        if(ring->head.load() - ring->tail.load() == ring->capacity && ring->consumer_closed.load() == 0)
+        {
+            // a full ring is the shared-memory equivalent of EAGAIN
+            if(stats) stats->eagain++;
+            return false;
+        }
+        ring->producer_waiting.store(0);
+    }
+    return true;
+}
+
+
+void
+netio::shm_send_socket::release_pending()
+{
+    while(!pending.empty())
+    {
+        pending.front()->release();
+        pending.pop_front();
+        if(stats) stats->send_queue_depth--;
+    }
+    pending_offset = 0;
+}
+
+
+void
+netio::shm_send_socket::send_buffer(netio::reusable_buffer* buffer)
+{
+    DEBUG_LOG("SHM: send a reusable buffer");
+    bool broken = false;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        pending.push_back(buffer);
+        if(stats) stats->send_queue_depth++;
+        try
+        {
+            if(status != OPEN || ring == nullptr)
+            {
+                throw std::system_error(EPIPE, std::generic_category());
+            }
+            // buffers queued behind a full ring are written from the event loop
+            if(pending.size() == 1)
+            {
+                flush_pending();
+            }
+        }
+        catch(std::system_error& e)
+        {
+            // Connection was closed (or is otherwise broken)
+            DEBUG_LOG("There was an exception: system_error %s", e.what());
+            release_pending();
+            broken = true;
+        }
+    }
+    if(broken)
+        disconnect();
+}
+
+
+netio::shm_listen_socket::shm_listen_socket(event_loop* evloop, netio::endpoint ep,
+                                            netio::context* c, sockcfg cfg)
+    : backend_listen_socket(evloop, ep, c, cfg), address(ep.address()), port(0), next_peer_id(1)
+{
+    ctx.fd = -1;
+}
+
+
+netio::shm_listen_socket::~shm_listen_socket()
+{
+    if(ctx.fd != -1)
+    {
+        evloop->unregister_fd(&ctx);
+        close(ctx.fd);
+    }
+}
+
+
+void
+netio::shm_listen_socket::listen()
+{
+    ctx.fd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(ctx.fd == -1)
+    {
+        throw std::runtime_error("Could not create socket");
+    }
+
+    struct sockaddr_un addr;
+    if(this->ep.port() != 0)
+    {
+        port = this->ep.port();
+        if(bind(ctx.fd, (struct sockaddr*)&addr, make_shm_address(&addr, address, port)) != 0)
+        {
+            close(ctx.fd);
+            ctx.fd = -1;
+            throw std::runtime_error("Could not bind");
+        }
+    }
+    else
+    {
+        // Emulate an ephemeral port: probe the dynamic range from a
+        // per-process offset until a free name is found
+        unsigned offset = getpid() % SHM_NUM_DYNAMIC_PORTS;
+        bool bound = false;
+        for(unsigned i=0; i<SHM_NUM_DYNAMIC_PORTS && !bound; i++)
+        {
+            port = SHM_FIRST_DYNAMIC_PORT + (offset + i) % SHM_NUM_DYNAMIC_PORTS;
+            bound = (bind(ctx.fd, (struct sockaddr*)&addr, make_shm_address(&addr, address, port)) == 0);
+            if(!bound && errno != EADDRINUSE)
+                break;
+        }
+        if(!bound)
+        {
+            close(ctx.fd);
+            ctx.fd = -1;
+            throw std::runtime_error("Could not bind");
+        }
+    }
+
+    if(::listen(ctx.fd, MAXCONN) == -1)
+    {
+        raise_errno_exception();
+    }
+
+    ctx.fn = [this](int sfd, void*)
+    {
+        accept_connections();
+    };
+    evloop->register_read_fd(&ctx);
+}
+
+
+netio::endpoint
+netio::shm_listen_socket::endpoint() const
+{
+    return netio::endpoint(address, port);
+}
+
+
+void
+netio::shm_listen_socket::accept_connections()
+{
+    while(1)
+    {
+        int infd = accept4(ctx.fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        DEBUG_LOG("RECV_socket FD %d", infd);
+        if(infd == -1)
+        {
+            if((errno == EAGAIN) || (errno == EWOULDBLOCK))
+            {
+                break;
+            }
+            netio::raise_errno_exception();
+        }
+
+        // remote endpoints with port 0 are discarded by add_message_entry
+        unsigned short peer_id = next_peer_id++;
+        if(next_peer_id == 0)
+            next_peer_id = 1;
+
+        try {
+            netio::shm_recv_socket* socket = new netio::shm_recv_socket(evloop, this, infd, peer_id);
+            if(on_connected) on_connected(*socket);
+        } catch (const std::exception& e) {
+            printf("Ignored Exception %s\n", e.what());
+            fflush(stdout);
+            break;
+        }
+    }
+}
+
+
+void
+netio::shm_end_processing_and_close_socket(netio::shm_recv_socket* socket)
+{
+    socket->evloop->unregister_fd(&socket->ctx);
+    if(socket->data_ctx.fd != -1)
+        socket->evloop->unregister_fd(&socket->data_ctx);
+
+    if(socket->current_page != nullptr)
+    {
+        if(socket->current_page->buffer()->pos() > 0) {
+            socket->listen_socket->add_page_entry(socket->current_page, socket->current_page->buffer()->pos(),
+                                                  socket);
+        } else {
+            // never queued, so never processed: give back its page count
+            socket->active_pages--;
+        }
+        socket->current_page->dec_refcount();
+        socket->current_page = nullptr;
+    }
+
+    if(socket->ring != nullptr)
+    {
+        socket->ring->consumer_closed.store(1);
+        notify(socket->space_efd);
+    }
+
+    socket->close();
+}
+
+
+void
+netio::shm_process_control(netio::shm_recv_socket* socket)
+{
+    if(socket->ring == nullptr)
+    {
+        int fds[SHM_NUM_FDS];
+        ssize_t result = recv_fds(socket->ctx.fd, fds);
+        if(result == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            return;
+        }
+        if(result <= 0)
+        {
+            DEBUG_LOG("handshake failed on FD %d", socket->ctx.fd);
+            shm_end_processing_and_close_socket(socket);
+            return;
+        }
+
+        struct stat st;
+        void* p = MAP_FAILED;
+        if(fstat(fds[0], &st) == 0 && (size_t)st.st_size > sizeof(shm_ring))
+        {
+            p = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fds[0], 0);
+        }
+        close(fds[0]);
+        if(p == MAP_FAILED)
+        {
+            close(fds[1]);
+            close(fds[2]);
+            shm_end_processing_and_close_socket(socket);
+            return;
+        }
+
+        socket->ring = (shm_ring*)p;
+        socket->mapsize = st.st_size;
+        socket->space_efd = fds[2];
+        socket->data_ctx.fd = fds[1];
+        socket->data_ctx.data = socket;
+        socket->data_ctx.fn = [](int fd, void* data)
+        {
+            shm_process_incoming_data((shm_recv_socket*)data);
+        };
+        socket->evloop->register_read_fd(&socket->data_ctx);
+
+        // data may have been written before the handshake was read
+        shm_process_incoming_data(socket);
+    }
+
+    // The sender never writes again after the handshake: anything else is a hang-up
+    char c;
+    if(recv(socket->ctx.fd, &c, 1, MSG_DONTWAIT) == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+    {
+        return;
+    }
+    DEBUG_LOG("sender hung up, draining ring");
+    shm_process_incoming_data(socket);
+    shm_end_processing_and_close_socket(socket);
+}
+
+
+void
+netio::shm_process_incoming_data(netio::shm_recv_socket* socket)
+{
+    shm_ring* ring = socket->ring;
+    if(ring == nullptr)
+    {
+        return;
+    }
+
+    // Consume the wake-ups first: data published after this point
+    // raises the eventfd again
+    eventfd_t value;
+    eventfd_read(socket->data_ctx.fd, &value);
+
+    const uint64_t capacity = ring->capacity;
+    while(1)
+    {
+        uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        if(head == tail)
+        {
+            break;
+        }
+
+        if(socket->current_page == nullptr)
+        {
+            if(!socket->try_fetch_page(&(socket->current_page)))
+            {
+                DEBUG_LOG("No page available");
+                // resumed by the buffer available signal
+                return;
+            }
+            socket->current_page->buffer()->reset();
+            // See posix_process_incoming_data: own the page while filling it
+            socket->current_page->inc_refcount();
+        }
+
+        netio::buffer* page = socket->current_page->buffer();
+        size_t n = std::min<uint64_t>(head - tail, page->available());
+        uint64_t offset = tail % capacity;
+        size_t first = std::min<uint64_t>(n, capacity - offset);
+        memcpy(page->end(), ring->data() + offset, first);
+        memcpy(page->end() + first, ring->data(), n - first);
+        page->advance(n);
+
+        ring->tail.store(tail + n);
+        if(ring->producer_waiting.load())
+        {
+            notify(socket->space_efd);
+        }
+
+        if(page->available() == 0)
+        {
+            socket->listen_socket->add_page_entry(socket->current_page, socket->pagesize(), socket);
+            socket->current_page->dec_refcount();
+            socket->current_page = nullptr;
+        }
+    }
+
+    if(socket->current_page != nullptr && socket->current_page->buffer()->pos() > 0)
+    {
+        socket->listen_socket->add_page_entry(socket->current_page, socket->current_page->buffer()->pos(),
+                                              socket);
+        socket->current_page->dec_refcount();
+        socket->current_page = nullptr;
+    }
+}
+
+
+netio::shm_recv_socket::shm_recv_socket(event_loop* evloop, backend_listen_socket* ls, int fd,
+                                        unsigned short peer_id)
+    : backend_recv_socket(evloop, ls), ring(nullptr), mapsize(0), space_efd(-1), peer_id(peer_id)
+{
+    current_page = nullptr;
+    data_ctx.fd = -1;
+
+    ctx.fd = fd;
+    ctx.data = this;
+    ctx.fn = [](int sfd, void* data)
+    {
+        shm_process_control((shm_recv_socket*)data);
+    };
+    evloop->register_read_fd(&ctx);
+
+    feeder.register_buf_available_cb([](void* data)
+    {
+        shm_process_incoming_data((shm_recv_socket*)data);
+    }, this);
+}
+
+
+netio::endpoint
+netio::shm_recv_socket::remote_endpoint()
+{
+    return netio::endpoint("127.0.0.1", peer_id);
+}
+
+
+netio::shm_recv_socket::~shm_recv_socket()
+{
+    DEBUG_LOG("Closing shm recv socket 0x%x, FD %d", this, ctx.fd);
+    if(current_page)
+        current_page->release();
+    evloop->unregister_fd(&ctx);
+    ::close(ctx.fd);
+    if(data_ctx.fd != -1)
+    {
+        evloop->unregister_fd(&data_ctx);
+        ::close(data_ctx.fd);
+    }
+    if(ring != nullptr)
+    {
+        ring->consumer_closed.store(1);
+        notify(space_efd);
+        munmap(ring, mapsize);
+    }
+    if(space_efd != -1)
+        ::close(space_efd);
+}
+
+
+netio::backend_send_socket*
+netio::shm_backend::make_send_socket(event_loop* evloop, sockcfg cfg)
+{
+    return new shm_send_socket(evloop, cfg);
+}
+
+
+netio::backend_listen_socket*
+netio::shm_backend::make_listen_socket(event_loop* evloop, endpoint ep, netio::context* c,
+                                       sockcfg cfg)
+{
+    return new shm_listen_socket(evloop, ep, c, cfg);
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "backend.hpp"
+
+#include <deque>
+#include <mutex>
+
+namespace netio
+{
+
+/*
+ * Shared-memory backend for peers on the same host.
+ *
+ * A connection is set up through an abstract unix socket named after the
+ * endpoint address and port; a sender connecting to an address without a
+ * listener falls back to a listener bound to the wildcard address. The
+ * sender creates a memfd, named after the endpoint, holding a single-producer
+ * single-consumer byte ring plus two eventfds (data available, space
+ * available) and passes the three descriptors to the listener. Afterwards
+ * the serialized pages flow through the ring; the unix socket only signals
+ * a hang-up of either side.
+ *
+ * The sender never blocks on a full ring: the buffers that do not fit are
+ * queued and written from the event loop when the space eventfd fires, so
+ * sender and receiver can share an event loop.
+ */
+struct shm_ring
+{
+    std::atomic<uint64_t> head;          // bytes written, owned by the producer
+    char pad0[64 - sizeof(std::atomic<uint64_t>)];
+    std::atomic<uint64_t> tail;          // bytes read, owned by the consumer
+    char pad1[64 - sizeof(std::atomic<uint64_t>)];
+    std::atomic<uint32_t> producer_waiting;
+    std::atomic<uint32_t> consumer_closed;
+    uint64_t capacity;
+
+    uint8_t* data()
+    {
+        return (uint8_t*)this + sizeof(shm_ring);
+    }
+};
+
+
+class shm_send_socket : public backend_send_socket
+{
+public:
+    shm_send_socket(event_loop* evloop, sockcfg cfg = sockcfg::cfg());
+    virtual ~shm_send_socket();
+
+    virtual void connect(const endpoint& ep);
+    virtual void disconnect();
+    virtual void send_buffer(netio::reusable_buffer* buffer);
+
+private:
+    shm_ring* ring;
+    size_t mapsize;
+    int data_efd;
+    netio::event_loop::context space_ctx;
+
+    std::mutex mtx;
+    std::deque<netio::reusable_buffer*> pending;
+    size_t pending_offset;  // bytes of the first pending buffer already in the ring
+
+    size_t write_to_ring(const char* data, size_t size);
+    bool flush_pending();
+    void release_pending();
+};
+
+
+class shm_listen_socket : public backend_listen_socket
+{
+public:
+    shm_listen_socket(event_loop* evloop, netio::endpoint endpoint, netio::context* c,
+                      sockcfg cfg = sockcfg::cfg());
+    virtual ~shm_listen_socket();
+
+    virtual void listen();
+    virtual netio::endpoint endpoint() const;
+
+protected:
+    std::string address;
+    unsigned short port;
+    unsigned short next_peer_id;
+
+    void accept_connections();
+};
+
+
+class shm_recv_socket : public backend_recv_socket
+{
+public:
+    shm_recv_socket(event_loop* evloop, backend_listen_socket* ls, int fd, unsigned short peer_id);
+    virtual ~shm_recv_socket();
+
+    netio::endpoint remote_endpoint();
+
+    friend void shm_process_control(shm_recv_socket* socket);
+    friend void shm_process_incoming_data(shm_recv_socket* socket);
+    friend void shm_end_processing_and_close_socket(shm_recv_socket* socket);
+
+private:
+    netio::reusable_buffer* current_page;
+    netio::event_loop::context data_ctx;
+    shm_ring* ring;
+    size_t mapsize;
+    int space_efd;
+    unsigned short peer_id;
+};
+
+
+void shm_process_control(shm_recv_socket* socket);
+void shm_process_incoming_data(shm_recv_socket* socket);
+void shm_end_processing_and_close_socket(shm_recv_socket* socket);
+
+class shm_backend : public backend
+{
+    backend_send_socket* make_send_socket(event_loop* evloop, sockcfg cfg = sockcfg::cfg());
+    backend_listen_socket* make_listen_socket(event_loop* evloop, endpoint ep, netio::context* c,
+                                              sockcfg cfg = sockcfg::cfg());
+};
+
+
+}
@@ -10,6 +10,9 @@ sockcfg::sockcfg()
     pagesize = 1048576;
     callback = nullptr;
     callback_data = nullptr;
+    event_loop = ANY_EVENT_LOOP;
+    busy_poll_usecs = 0;
+    flush_latency_usecs = 0;
 }
 
 
@@ -50,6 +53,15 @@ sockcfg::operator()(sockcfg::cfgtype_t key, uint64_t value)
     case CALLBACK_DATA:
         callback_data = (void*)value;
         break;
+    case EVENT_LOOP:
+        event_loop = value;
+        break;
+    case BUSY_POLL_USECS:
+        busy_poll_usecs = value;
+        break;
+    case FLUSH_LATENCY_USECS:
+        flush_latency_usecs = value;
+        break;
     default:
         throw std::runtime_error("Key error in config value lookup");
     }
@@ -74,6 +86,12 @@ sockcfg::get(sockcfg::cfgtype_t key) const
         return (uint64_t)callback;
     case CALLBACK_DATA:
         return (uint64_t)callback_data;
+    case EVENT_LOOP:
+        return event_loop;
+    case BUSY_POLL_USECS:
+        return busy_poll_usecs;
+    case FLUSH_LATENCY_USECS:
+        return flush_latency_usecs;
     default:
         throw std::runtime_error("Key error in config value lookup");
     }
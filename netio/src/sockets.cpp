@@ -1,7 +1,10 @@
 #include "netio/netio.hpp"
 #include "backend.hpp"
 #include "serialization.hpp"
+#include "utility.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <mutex>
 
 
@@ -27,15 +30,42 @@ struct subscription_message_header
 
 netio::socket::socket(context* ctx, sockcfg cfg)
 {
+    unsigned index = ctx->select_event_loop(cfg);
     this->ctx = ctx;
-    this->cfg = cfg;
+    this->evloop = ctx->event_loop(index);
+    this->stats_ = std::make_shared<socket_stats>();
+    // pin the selection so that sockets created on behalf of this one
+    // (subscriptions, connections to subscribers) share the same event loop
+    this->cfg = cfg(sockcfg::EVENT_LOOP, index);
+}
+
+
+netio::socket_stats&
+netio::socket::stats()
+{
+    return *stats_;
+}
+
+
+netio::backend*
+netio::socket::backend()
+{
+    return ctx->backend();
+}
+
+
+netio::event_loop*
+netio::socket::event_loop()
+{
+    return evloop;
 }
 
 
 netio::low_latency_send_socket::low_latency_send_socket(context* ctx, sockcfg cfg)
     : netio::socket(ctx, cfg)
 {
-    socket = ctx->backend()->make_send_socket(ctx->event_loop(), cfg);
+    socket = ctx->backend()->make_send_socket(event_loop(), this->cfg);
+    socket->set_stats(stats_);
 }
 
 
@@ -52,6 +82,7 @@ void
 netio::low_latency_send_socket::connect(const endpoint& ep)
 {
     peer_ = ep;
+    stats_->connects++;
     socket->connect(ep);
 }
 
@@ -60,7 +91,8 @@ void
 netio::low_latency_send_socket::disconnect()
 {
     DEBUG_LOG("Calling low_latency_send_socket::disconnect");
-    //socket->disconnect(); already called by send_socket destructor
+    // the backend closes only once, its destructor calls this again
+    socket->disconnect();
 }
 
 
@@ -112,19 +144,20 @@ netio::low_latency_send_socket::send(const message& msg)
             buf->append((const char*)p->data[1], p->size[1]);
     }
 
-    try {
-        socket->send_buffer(rb);
-    } catch(std::runtime_error& e) {
-            // AGAIN
-    }
+    // the backend counts EAGAIN itself and closes the socket when the write
+    // fails; only messages that went out are counted
+    socket->send_buffer(rb);
+    if(socket->connection_state() == backend_send_socket::OPEN)
+        stats_->count_out(header.len);
 }
 
 
 netio::recv_socket::recv_socket(context* ctx, unsigned short port, sockcfg cfg)
     : netio::socket(ctx, cfg), connection_status(OPEN)
 {
-    socket = ctx->backend()->make_listen_socket(ctx->event_loop(), netio::endpoint("0.0.0.0", port),
-                                                ctx, cfg);
+    socket = ctx->backend()->make_listen_socket(event_loop(), netio::endpoint("0.0.0.0", port),
+                                                ctx, this->cfg);
+    socket->set_stats(stats_);
     socket->listen();
 }
 
@@ -140,41 +173,82 @@ netio::recv_socket::~recv_socket()
 }
 
 
-void
-netio::recv_socket::recv(message& msg)
+// Idle consumers sleep in slices so that close() from another thread is
+// noticed even if its wake-up races with the status check
+#define RECV_WAIT_SLICE_MS 100
+
+bool
+netio::recv_socket::wait_for_message(message& msg, endpoint* ep, int timeout_ms)
 {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
     while(connection_status == OPEN)
     {
-        if(socket->pop_message_entry(&msg) == true)
+        if(socket->pop_message_entry(&msg, ep) == true)
         {
-            return;
+            stats_->count_in(msg.size());
+            return true;
         }
-        else
+        if(socket->try_process_page())
+            continue;
+
+        unsigned slice = RECV_WAIT_SLICE_MS;
+        if(timeout_ms >= 0)
         {
-            socket->try_process_page();
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                            deadline - std::chrono::steady_clock::now()).count();
+            if(left <= 0)
+                return false;
+            slice = std::min<unsigned>(slice, left);
         }
+        socket->wait_for_entries(slice);
     }
     // if connection CLOSED
     throw netio::connection_closed();
 }
 
 
+void
+netio::recv_socket::recv(message& msg)
+{
+    wait_for_message(msg, nullptr, -1);
+}
+
+
 void
 netio::recv_socket::recv(endpoint& ep, message& msg)
 {
-    while(connection_status == OPEN)
+    wait_for_message(msg, &ep, -1);
+}
+
+
+size_t
+netio::recv_socket::recv_many(std::vector<message>& msgs, size_t max, int timeout_ms)
+{
+    if(max == 0)
+        return 0;
+
+    message msg;
+    if(!wait_for_message(msg, nullptr, timeout_ms))
+        return 0;
+    msgs.push_back(std::move(msg));
+
+    // drain whatever is already queued or sitting in received pages
+    size_t n = 1;
+    while(n < max)
     {
-        if(socket->pop_message_entry(&msg, &ep) == true)
+        message next;
+        if(socket->pop_message_entry(&next))
         {
-            return;
+            stats_->count_in(next.size());
+            msgs.push_back(std::move(next));
+            n++;
         }
-        else
+        else if(!socket->try_process_page())
         {
-            socket->try_process_page();
+            break;
         }
     }
-    // if connection CLOSED
-    throw netio::connection_closed();
+    return n;
 }
 
 
@@ -182,6 +256,7 @@ void
 netio::recv_socket::close()
 {
     connection_status = CLOSED;
+    socket->wake_waiters();
     //socket->close(); TODO close backend connection (ont only in desctructor)
 }
 
@@ -197,10 +272,11 @@ netio::low_latency_recv_socket::low_latency_recv_socket(context* ctx, unsigned s
                                                         callback_fn fn, sockcfg cfg)
     : netio::socket(ctx, cfg), feeder(cfg.get(sockcfg::BUFFER_PAGES_PER_CONNECTION),
                                       cfg.get(sockcfg::PAGESIZE),
-                                      ctx)
+                                      ctx, event_loop())
 {
-    socket = ctx->backend()->make_listen_socket(ctx->event_loop(), netio::endpoint("0.0.0.0", port),
-                                                ctx, cfg);
+    socket = ctx->backend()->make_listen_socket(event_loop(), netio::endpoint("0.0.0.0", port),
+                                                ctx, this->cfg);
+    socket->set_stats(stats_);
     socket->register_cb_on_data_received([this]()
     {
         socket->process_page();
@@ -210,6 +286,7 @@ netio::low_latency_recv_socket::low_latency_recv_socket(context* ctx, unsigned s
         netio::message msg;
         endpoint ep;
         socket->pop_message_entry(&msg, &ep);
+        stats_->count_in(msg.size());
         fn(ep, msg);
     });
 
@@ -249,16 +326,21 @@ periodic_flush(void* data)
 
 netio::buffered_send_socket::buffered_send_socket(context* ctx, sockcfg cfg)
     : netio::socket(ctx, cfg),
-      tmr(ctx->event_loop(), periodic_flush, this),
+      tmr(event_loop(), periodic_flush, this),
+      deadline_tmr(event_loop(), on_deadline, this),
+      flush_latency_usecs(cfg.get(sockcfg::FLUSH_LATENCY_USECS)),
+      deadline_armed(false),
+      would_block(false),
       feeder(cfg.get(sockcfg::BUFFER_PAGES_PER_CONNECTION),
              cfg.get(sockcfg::PAGESIZE),
-             ctx)
+             ctx, event_loop())
 {
-    socket = ctx->backend()->make_send_socket(ctx->event_loop(), cfg);
-    while(feeder.try_pop(&current_buffer) == false)
-    {
-        std::this_thread::yield();
-    }
+    socket = ctx->backend()->make_send_socket(event_loop(), this->cfg);
+    socket->set_stats(stats_);
+    feeder.set_stats(stats_);
+    feeder.register_buf_available_cb(on_buffer_available, this);
+    if(feeder.try_pop(&current_buffer) == false)
+        current_buffer = nullptr;
 }
 
 
@@ -277,6 +359,7 @@ netio::buffered_send_socket::connect(const endpoint& ep)
 {
     DEBUG_LOG("buffered_send_socket connect");
     peer_ = ep;
+    stats_->connects++;
     socket->connect(ep);
     tmr.start(cfg.get(sockcfg::FLUSH_INTERVAL_MILLISECS));
 }
@@ -288,6 +371,7 @@ netio::buffered_send_socket::disconnect()
   DEBUG_LOG("buffered_send_socket disconnect");
     if(this->is_open()){
         tmr.stop();
+        deadline_tmr.stop();
         socket->disconnect();
     }
     else return;
@@ -305,6 +389,67 @@ netio::buffered_send_socket::send(const message& msg)
       return;
     }
 
+    write_message(msg);
+}
+
+
+bool
+netio::buffered_send_socket::try_send(const message& msg)
+{
+    DEBUG_LOG("buffered_send_socket::try_send");
+    std::lock_guard<netio::spinlock> g(lock);
+
+    if(socket->connection_state() == backend_send_socket::CLOSED) {
+      return true;
+    }
+
+    if(!fits(msg.size()))
+    {
+        // raise the flag before looking again, so that a page released in
+        // between either shows up here or triggers the callback
+        would_block = true;
+        if(!fits(msg.size()))
+        {
+            stats_->eagain++;
+            return false;
+        }
+        would_block = false;
+    }
+
+    write_message(msg);
+    return true;
+}
+
+
+/*
+ * Whether a message of msg_size bytes can be serialized without waiting for
+ * pages: the rest of the current page plus the free pages of the feeder.
+ * Only the sending thread takes pages out of the feeder, so the answer
+ * cannot become wrong before the message is written.
+ */
+bool
+netio::buffered_send_socket::fits(size_t msg_size) const
+{
+    size_t needed = sizeof(msgheader) + msg_size;
+    size_t available = current_buffer ? current_buffer->buffer()->available() : 0;
+    size_t spill;
+    if(available < sizeof(msgheader) + 1)
+        spill = needed;     // the header goes to the next page
+    else
+        spill = needed > available ? needed - available : 0;
+    if(spill == 0)
+        return true;
+
+    size_t pages = (spill + feeder.buffersize() - 1) / feeder.buffersize();
+    return feeder.num_available_buffers() >= pages;
+}
+
+
+void
+netio::buffered_send_socket::write_message(const message& msg)
+{
+    next_page(true);
+
     // Write message header
     size_t msg_size = msg.size();
     msgheader header;
@@ -330,33 +475,17 @@ netio::buffered_send_socket::send(const message& msg)
     // Write message body
     for(const netio::message::fragment* p = msg.fragment_list(); p != nullptr; p = p->next)
     {
-        unsigned int n = 0;
-        while(n < p->size[0])
-        {
-            DEBUG_LOG("buffer: 0x%x   end: 0x%x   len: %d   bytes available: %d",
-                      current_buffer->buffer()->data(), current_buffer->buffer()->end(),
-                      current_buffer->buffer()->pos(), current_buffer->buffer()->available());
-            size_t bytes_written = serialize_to_buffer(current_buffer->buffer()->end(),
-                                                       current_buffer->buffer()->available(),
-                                                       (const char*)p->data[0], p->size[0], &n);
-            current_buffer->buffer()->advance(bytes_written);
-            DEBUG_LOG("wrote %d bytes (for fragment)", bytes_written);
-            if(bytes_written == 0)
-            {
-                non_mutex_flush();
-            }
-        }
-        if(p->data[1] != nullptr)
+        for(unsigned i=0; i<2 && p->data[i] != nullptr; i++)
         {
-            n = 0;
-            while(n < p->size[1])
+            unsigned int n = 0;
+            while(n < p->size[i])
             {
                 DEBUG_LOG("buffer: 0x%x   end: 0x%x   len: %d   bytes available: %d",
                           current_buffer->buffer()->data(), current_buffer->buffer()->end(),
                           current_buffer->buffer()->pos(), current_buffer->buffer()->available());
                 size_t bytes_written = serialize_to_buffer(current_buffer->buffer()->end(),
                                                            current_buffer->buffer()->available(),
-                                                           (const char*)p->data[1], p->size[1], &n);
+                                                           (const char*)p->data[i], p->size[i], &n);
                 current_buffer->buffer()->advance(bytes_written);
                 DEBUG_LOG("wrote %d bytes (for fragment)", bytes_written);
                 if(bytes_written == 0)
@@ -369,28 +498,74 @@ netio::buffered_send_socket::send(const message& msg)
     DEBUG_LOG("buffer: 0x%x   end: 0x%x   len: %d   bytes available: %d",
               current_buffer->buffer()->data(), current_buffer->buffer()->end(),
               current_buffer->buffer()->pos(), current_buffer->buffer()->available());
+    stats_->count_out(msg_size);
+
+    // A page that cannot take another header goes out right away; otherwise
+    // the first message of a page starts the latency deadline
+    if(current_buffer->buffer()->available() < sizeof(msgheader) + 1)
+    {
+        non_mutex_flush(false);
+    }
+    else if(flush_latency_usecs > 0 && !deadline_armed.exchange(true))
+    {
+        deadline_tmr.start_oneshot(flush_latency_usecs);
+    }
 }
 
 
-void
-netio::buffered_send_socket::non_mutex_flush()
+/*
+ * Make sure there is a page to write into. Without block, give up if the
+ * feeder is empty; otherwise sleep until a sent page comes back.
+ */
+bool
+netio::buffered_send_socket::next_page(bool block)
 {
-    if(current_buffer->buffer()->pos() > 0)
+    while(current_buffer == nullptr)
+    {
+        if(feeder.try_pop(&current_buffer))
+            return true;
+        current_buffer = nullptr;
+        if(!block)
+            return false;
+        feeder.wait_for_buffer(100);
+    }
+    return true;
+}
+
+
+bool
+netio::buffered_send_socket::non_mutex_flush(bool block)
+{
+    if(current_buffer != nullptr && current_buffer->buffer()->pos() > 0)
     {
         DEBUG_LOG("flush");
         try
         {
             socket->send_buffer(current_buffer);
-            while(feeder.try_pop(&current_buffer) == false)
-            {
-              std::this_thread::yield();
-            }
+            current_buffer = nullptr;
         }
         catch(std::runtime_error& e)
         {
             // AGAIN
+            return false;
         }
     }
+    return next_page(block);
+}
+
+
+bool
+netio::buffered_send_socket::try_flush()
+{
+    if(!lock.try_lock())
+        return false;
+    if(current_buffer == nullptr || current_buffer->buffer()->pos() > 0)
+    {
+        DEBUG_LOG("flush (single try)");
+        non_mutex_flush(false);
+    }
+    lock.unlock();
+    return true;
 }
 
 
@@ -398,38 +573,41 @@ void
 netio::buffered_send_socket::flush()
 {
     DEBUG_LOG("periodic flush");
-    if(lock.try_lock())
+    try_flush();
+}
+
+
+void
+netio::buffered_send_socket::on_deadline(void* data)
+{
+    netio::buffered_send_socket* socket = (netio::buffered_send_socket*)data;
+    socket->deadline_armed = false;
+    if(!socket->is_open())
+        return;
+    if(!socket->try_flush())
     {
-      if(current_buffer->buffer()->pos() > 0)
-	{
-	  DEBUG_LOG("flush (single try)");
-	  try
-	    {
-	      DEBUG_LOG("single flush: sending buffer");
-	      socket->send_buffer(current_buffer);
-	      DEBUG_LOG("single flush: buffer sent, now getting a new buffer");
-	      if(feeder.try_pop(&current_buffer) == false)
-		{
-		  DEBUG_LOG("single flush: no buffers available, yielding thread and then trying again");
-		}
-	    }
-	  catch(std::exception& e)
-	    {
-	      // AGAIN
-	      DEBUG_LOG(e.what());
-	      //lock.unlock();
-	    }
-	  catch(...)
-	    {
-	      DEBUG_LOG("single flush: unknown exception");
-	    }
-	}
-      DEBUG_LOG("unlocking");
-      lock.unlock();
+        // a sender holds the page: try again shortly
+        if(!socket->deadline_armed.exchange(true))
+            socket->deadline_tmr.start_oneshot(socket->flush_latency_usecs);
     }
 }
 
 
+void
+netio::buffered_send_socket::on_buffer_available(void* data)
+{
+    netio::buffered_send_socket* socket = (netio::buffered_send_socket*)data;
+    if(socket->would_block.exchange(false) && socket->cb_writable)
+        socket->cb_writable();
+}
+
+
+void netio::buffered_send_socket::register_cb_on_writable(std::function<void()> fn)
+{
+    cb_writable = fn;
+}
+
+
 void netio::buffered_send_socket::register_cb_on_connection_opened(std::function<void()> fn)
 {
     socket->register_cb_on_connection_opened(fn);
@@ -473,75 +651,103 @@ netio::endpoint netio::buffered_send_socket::peer() const
 }
 
 
-netio::tag_publisher::tag_publisher(tag t, publish_socket & pub_socket)
-    : t(t)
-    , pub_socket(pub_socket)
-    , ht_sockets(pub_socket.subscriptions[t])
-    , ll_sockets(pub_socket.subscriptions_ll[t])
-{}
-
-
-size_t
-netio::tag_publisher::publish(const message& msg)
+/*
+ * Immutable view of the subscriptions of a publish_socket, indexed by tag in
+ * an open-addressing hash table. The snapshot holds references on the
+ * sockets so that a publisher still using a replaced snapshot never sends
+ * through a destroyed socket.
+ */
+struct netio::subscription_snapshot
 {
-    DEBUG_LOG("Publish message using tag_publisher, tag=%d", t);
-    //return pub_socket.publish(t, msg);
+    struct subscribers
+    {
+        std::vector<low_latency_send_socket*> ll;
+        std::vector<buffered_send_socket*> ht;
+    };
 
-    //std::lock_guard<std::mutex> lock(pub_socket.subscription_mutex);
+    std::vector<tag> keys;
+    std::vector<int> slots;             // index into entries, -1 if empty
+    std::vector<subscribers> entries;
+    unsigned mask = 0;
 
-    size_t bytes_sent = 0;
-    size_t const msgsize = msg.size();
+    std::vector<std::shared_ptr<low_latency_send_socket>> owned_ll;
+    std::vector<std::shared_ptr<buffered_send_socket>> owned;
 
-    std::set<low_latency_send_socket*> closed_sockets_ll;
-    auto itll = ll_sockets.begin();
-    while(itll != ll_sockets.end())
+    static size_t
+    hash(tag t)
     {
-        low_latency_send_socket* socket = itll->get();
-        if(socket->is_connecting())
-        {
-          DEBUG_LOG("ll connection is still connecting, ignoring for publish");
-          ++itll;
-          continue;
-        }
-        socket->send(msg);
-        bytes_sent += msgsize;
-        if(!socket->is_open())
-        {
-            closed_sockets_ll.insert(socket);
-            bytes_sent -= msgsize;
-        }
-        ++itll;
+        return (size_t)((t * 0x9E3779B97F4A7C15ULL) >> 16);
     }
-    if (!closed_sockets_ll.empty())
-        pub_socket.clean_closed_socket(pub_socket.subscriptions_ll, pub_socket.connections_ll, closed_sockets_ll);
 
-    std::set<buffered_send_socket*> closed_sockets;
-    auto it = ht_sockets.begin();
-    while(it != ht_sockets.end())
+    void
+    build(const subscription_map& subs, const subscription_map_ll& subs_ll)
     {
-        buffered_send_socket* socket = it->get();
-        if(socket->is_connecting())
+        std::map<tag, subscribers> all;
+        std::set<void*> seen;
+        for(auto& kv : subs_ll)
         {
-          DEBUG_LOG("ht connection is still connecting, ignoring for publish");
-          ++it;
-          continue;
+            for(auto& sp : kv.second)
+            {
+                all[kv.first].ll.push_back(sp.get());
+                if(seen.insert(sp.get()).second)
+                    owned_ll.push_back(sp);
+            }
         }
-        socket->send(msg);
-        bytes_sent += msgsize;
-        if(!socket->is_open())
+        for(auto& kv : subs)
         {
-            closed_sockets.insert(socket);
-            bytes_sent -= msgsize;
+            for(auto& sp : kv.second)
+            {
+                all[kv.first].ht.push_back(sp.get());
+                if(seen.insert(sp.get()).second)
+                    owned.push_back(sp);
+            }
         }
-        else
+
+        // load factor at most 1/2
+        size_t capacity = 8;
+        while(capacity < 2*all.size())
+            capacity *= 2;
+        mask = capacity - 1;
+        keys.assign(capacity, 0);
+        slots.assign(capacity, -1);
+        entries.reserve(all.size());
+        for(auto& kv : all)
         {
-            it++;
+            if(kv.second.ll.empty() && kv.second.ht.empty())
+                continue;
+            size_t i = hash(kv.first) & mask;
+            while(slots[i] != -1)
+                i = (i + 1) & mask;
+            keys[i] = kv.first;
+            slots[i] = entries.size();
+            entries.push_back(std::move(kv.second));
         }
     }
-    if (!closed_sockets.empty())
-        pub_socket.clean_closed_socket(pub_socket.subscriptions, pub_socket.connections, closed_sockets);
 
-    return bytes_sent;
+    const subscribers*
+    find(tag t) const
+    {
+        for(size_t i = hash(t) & mask; slots[i] != -1; i = (i + 1) & mask)
+        {
+            if(keys[i] == t)
+                return &entries[slots[i]];
+        }
+        return nullptr;
+    }
+};
+
+
+netio::tag_publisher::tag_publisher(tag t, publish_socket & pub_socket)
+    : t(t)
+    , pub_socket(pub_socket)
+{}
+
+
+size_t
+netio::tag_publisher::publish(const message& msg)
+{
+    DEBUG_LOG("Publish message using tag_publisher, tag=%d", t);
+    return pub_socket.publish(t, msg);
 }
 
 
@@ -549,8 +755,12 @@ netio::publish_socket::publish_socket(context* ctx, unsigned short port, sockcfg
     : socket(ctx, cfg), subscription_socket(ctx, port, [this](endpoint& ep, message& m)
 {
     parse_message(ep, m);
-})
-{}
+}, sockcfg::cfg()(sockcfg::EVENT_LOOP, this->cfg.get(sockcfg::EVENT_LOOP)))
+    , snapshot(nullptr), snapshot_readers(0), reclaim_pending(false)
+{
+    std::lock_guard<std::mutex> lock(subscription_mutex);
+    update_snapshot();
+}
 
 
 netio::publish_socket::~publish_socket()
@@ -563,6 +773,42 @@ netio::publish_socket::~publish_socket()
         if(kv.second->is_closed()){continue;}
         kv.second->disconnect();
     }
+    {
+        std::lock_guard<std::mutex> lock(subscription_mutex);
+        reclaim();
+    }
+    delete snapshot.load();
+}
+
+
+void
+netio::publish_socket::update_snapshot()
+{
+    subscription_snapshot* fresh = new subscription_snapshot;
+    fresh->build(subscriptions, subscriptions_ll);
+    subscription_snapshot* old = snapshot.exchange(fresh);
+    if(old)
+        retired_snapshots.push_back(old);
+    reclaim_pending = true;
+    reclaim();
+}
+
+
+void
+netio::publish_socket::reclaim()
+{
+    // A publisher entering after the last exchange sees the current
+    // snapshot, so with no publisher inside publish() nobody can still be
+    // using a retired snapshot. The connections a retired snapshot owns are
+    // already closed; deleting it drops the last reference to them.
+    if(snapshot_readers.load() != 0)
+        return;
+
+    for(subscription_snapshot* s : retired_snapshots)
+        delete s;
+    retired_snapshots.clear();
+
+    reclaim_pending = false;
 }
 
 
@@ -618,6 +864,7 @@ netio::publish_socket::subscribe(tag tag, const endpoint& ep)
       std::lock_guard<std::mutex> lock(subscription_mutex);
       auto& subs_for_tag = subscriptions[tag];
       subs_for_tag.emplace_back(socket);
+      update_snapshot();
     }
 
     DEBUG_LOG("calling callback");
@@ -657,10 +904,7 @@ netio::publish_socket::subscribe_ll(tag tag, const endpoint& ep)
       std::lock_guard<std::mutex> lock(subscription_mutex);
       auto& subs_for_tag = subscriptions_ll[tag];
       subs_for_tag.emplace_back(socket);
-
-      //for(auto s : subscriptions_ll[tag]){
-      //  DEBUG_LOG("Check: sockets in list for tag %lu: %p address %s", tag, s, ep.address());
-      //}
+      update_snapshot();
     }
 
     DEBUG_LOG("calling callback");
@@ -672,65 +916,93 @@ netio::publish_socket::subscribe_ll(tag tag, const endpoint& ep)
 void
 netio::publish_socket::unsubscribe(tag tag, const endpoint& ep)
 {
-    auto& subsll = subscriptions_ll[tag];
-    auto itll = subsll.begin();
-    int count = 0;
-    while (itll != subsll.end()) {
-        low_latency_send_socket* socket = itll->get();
-        DEBUG_LOG("LLSOCK: unsubscribing tag %lu ll socket %p counter %d", tag, socket, count);
-        DEBUG_LOG("LLSOCK: peer ip %s %d ep ip %s %d", socket->peer().address().c_str(), socket->peer().port(),  ep.address().c_str(), socket->peer().port());
-        if (socket && socket->peer() == ep) {
-            std::lock_guard<std::mutex> lock(subscription_mutex);
-            itll = subsll.erase(itll);
-            DEBUG_LOG("LLSOCK: erased");
-        } else {
-            ++itll;
-            DEBUG_LOG("LLSOCK: advancing iterator");
-        }
-        ++count;
-    }
+    {
+        std::lock_guard<std::mutex> lock(subscription_mutex);
 
-    auto& subs = subscriptions[tag];
-    auto it = subs.begin();
-    while (it != subs.end()) {
-        DEBUG_LOG("unsubscribing ht subscription");
-        buffered_send_socket* socket = it->get();
-        if (socket && socket->peer() == ep) {
-            std::lock_guard<std::mutex> lock(subscription_mutex);
-            it = subs.erase(it);
-        } else {
-            ++it;
+        auto itsll = subscriptions_ll.find(tag);
+        if(itsll != subscriptions_ll.end()) {
+            auto& subsll = itsll->second;
+            for(auto itll = subsll.begin(); itll != subsll.end(); /* no inc */) {
+                low_latency_send_socket* socket = itll->get();
+                if (socket && socket->peer() == ep) {
+                    DEBUG_LOG("LLSOCK: unsubscribing tag %lu ll socket %p", tag, socket);
+                    itll = subsll.erase(itll);
+                } else {
+                    ++itll;
+                }
+            }
+            if(subsll.empty())
+                subscriptions_ll.erase(itsll);
         }
-    }
 
-    // Close connections that no longer have active subscriptions
-    for (connection_map::iterator itcon(connections.begin()); itcon != connections.end(); /* no inc */) {
-        if (itcon->second.use_count() == 1) {
-            // this reference is the last one <=> no subscription uses it
-            itcon->second->disconnect();
-            std::lock_guard<std::mutex> lock(subscription_mutex);
-            itcon = connections.erase(itcon);
-        } else {
-            ++itcon;
+        auto its = subscriptions.find(tag);
+        if(its != subscriptions.end()) {
+            auto& subs = its->second;
+            for(auto it = subs.begin(); it != subs.end(); /* no inc */) {
+                buffered_send_socket* socket = it->get();
+                if (socket && socket->peer() == ep) {
+                    DEBUG_LOG("unsubscribing ht subscription");
+                    it = subs.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            if(subs.empty())
+                subscriptions.erase(its);
         }
-    }
 
-    for (connection_map_ll::iterator itcon(connections_ll.begin()); itcon != connections_ll.end(); /* no inc */) {
-        if (itcon->second.use_count() == 1) {
-            // this reference is the last one <=> no subscription uses it
-            itcon->second->disconnect();
-            std::lock_guard<std::mutex> lock(subscription_mutex);
-            itcon = connections_ll.erase(itcon);
-        } else {
-            ++itcon;
+        // Close connections that no longer have active subscriptions right
+        // away, so the peer stops receiving data. The snapshots hold
+        // references too, so look at the subscription lists rather than at
+        // the reference count. A publisher still reading an old snapshot
+        // finds the socket closed and skips it.
+        std::set<void*> in_use;
+        for(auto& kv : subscriptions)
+            for(auto& sp : kv.second)
+                in_use.insert(sp.get());
+        for(auto& kv : subscriptions_ll)
+            for(auto& sp : kv.second)
+                in_use.insert(sp.get());
+
+        for (auto itcon(connections.begin()); itcon != connections.end(); /* no inc */) {
+            if (in_use.count(itcon->second.get()) == 0) {
+                itcon->second->disconnect();
+                itcon = connections.erase(itcon);
+            } else {
+                ++itcon;
+            }
+        }
+        for (auto itcon(connections_ll.begin()); itcon != connections_ll.end(); /* no inc */) {
+            if (in_use.count(itcon->second.get()) == 0) {
+                itcon->second->disconnect();
+                itcon = connections_ll.erase(itcon);
+            } else {
+                ++itcon;
+            }
         }
+
+        update_snapshot();
     }
 
+
     if(cb_unsubscribe)
         cb_unsubscribe(tag, ep);
 }
 
 
+void
+netio::publish_socket::remove_closed_sockets(std::set<low_latency_send_socket*> const & closed_ll,
+                                             std::set<buffered_send_socket*> const & closed)
+{
+    std::lock_guard<std::mutex> lock(subscription_mutex);
+    if(!closed_ll.empty())
+        clean_closed_socket(subscriptions_ll, connections_ll, closed_ll);
+    if(!closed.empty())
+        clean_closed_socket(subscriptions, connections, closed);
+    update_snapshot();
+}
+
+
 void
 netio::publish_socket::register_subscribe_callback(std::function<void(tag, endpoint)> cb)
 {
@@ -749,111 +1021,67 @@ size_t
 netio::publish_socket::publish(tag tag, const message& msg)
 {
     size_t bytes_sent = 0;
+    size_t const msgsize = msg.size();
     DEBUG_LOG("publishing message tag=%d", tag);
-    bool ll_tag_found = false; bool ht_tag_found = false;
-
-    std::list<std::shared_ptr<low_latency_send_socket>> subsll;
-    try{
-        subsll = subscriptions_ll.at(tag);
-        ll_tag_found = true;
-    }
-    catch (const std::exception& e) {
-        ll_tag_found = false;
-    }
-
-    if(ll_tag_found){
-        std::set<low_latency_send_socket*> closed_sockets_ll;
-        auto itll = subsll.begin();
-        while (itll != subsll.end()) {
-            DEBUG_LOG("publishing message to ll endpoint");
-            low_latency_send_socket* socket = nullptr;
-            try {
-                socket = itll->get();
-            }
-            catch (const std::exception& e) {
-                DEBUG_LOG("Invalid socket pointer from subscription list  %s\n", e.what());
-                ++itll;
-                continue;
-            }
 
-            if(socket->is_connecting())
-            {
-                DEBUG_LOG("ll connection is still connecting, ignoring for publish");
-                ++itll;
-                continue;
-            }
-            socket->send(msg);
-            bytes_sent += msg.size();
-            if(socket->is_closed())
-            {
-                closed_sockets_ll.insert(socket);
-                bytes_sent -= msg.size();
-            }
-            ++itll;
-        }
+    std::set<low_latency_send_socket*> closed_sockets_ll;
+    std::set<buffered_send_socket*> closed_sockets;
 
-        if (!closed_sockets_ll.empty()){
-            std::lock_guard<std::mutex> lock(subscription_mutex);
-            clean_closed_socket(subscriptions_ll, connections_ll, closed_sockets_ll);
-        }
+    snapshot_readers++;
+    const subscription_snapshot::subscribers* subs = snapshot.load()->find(tag);
+    if(subs == nullptr) {
+        snapshot_readers--;
+        DEBUG_LOG("Cannot publish message for tag %lu. No subscription.", tag);
+        return 0;
     }
 
-    std::list<std::shared_ptr<buffered_send_socket>> subs;
-    try {
-        subs = subscriptions.at(tag);
-        ht_tag_found = true;
-    }
-    catch (const std::exception& e) {
-        ht_tag_found = false;
+    for(low_latency_send_socket* socket : subs->ll) {
+        DEBUG_LOG("publishing message to ll endpoint");
+        if(socket->is_connecting())
+        {
+            DEBUG_LOG("ll connection is still connecting, ignoring for publish");
+            continue;
+        }
+        socket->send(msg);
+        if(socket->is_closed())
+            closed_sockets_ll.insert(socket);
+        else
+            bytes_sent += msgsize;
     }
 
-    if(ht_tag_found){
-        std::set<buffered_send_socket*> closed_sockets;
-        auto it = subs.begin();
-        while (it != subs.end()) {
-            DEBUG_LOG("publishing message to endpoint");
-            buffered_send_socket* socket;
-            try{
-                socket = it->get();
-            }
-            catch (const std::exception& e) {
-                DEBUG_LOG("Invalid socket pointer from subscription list  %s\n", e.what());
-                ++it;
-                continue;
-            }
-            if(!socket){continue;}
-            if(socket->is_connecting())
-            {
+    for(buffered_send_socket* socket : subs->ht) {
+        DEBUG_LOG("publishing message to endpoint");
+        if(socket->is_connecting())
+        {
             DEBUG_LOG("ht connection is still connecting, ignoring for publish");
-            ++it;
             continue;
-            }
-            socket->send(msg);
-            bytes_sent += msg.size();
-            if(socket->is_closed())
-            {
-                closed_sockets.insert(socket);
-                bytes_sent -= msg.size();
-            }
-            ++it;
-        }
-
-        if (!closed_sockets.empty()){
-            std::lock_guard<std::mutex> lock(subscription_mutex);
-            clean_closed_socket(subscriptions, connections, closed_sockets);
         }
+        socket->send(msg);
+        if(socket->is_closed())
+            closed_sockets.insert(socket);
+        else
+            bytes_sent += msgsize;
     }
 
-    if (!(ht_tag_found || ll_tag_found)) {
-      DEBUG_LOG("Cannot publish message for tag %lu. No subscription.", tag);
-      return 0;
+    // the closed sockets may only be owned by the snapshot, so drop them
+    // before leaving it
+    if (!closed_sockets_ll.empty() || !closed_sockets.empty())
+        remove_closed_sockets(closed_sockets_ll, closed_sockets);
+
+    // the last publisher out finishes a reclamation the writer had to defer
+    if(snapshot_readers.fetch_sub(1) == 1 && reclaim_pending.load())
+    {
+        std::unique_lock<std::mutex> lock(subscription_mutex, std::try_to_lock);
+        if(lock.owns_lock())
+            reclaim();
     }
+
     return bytes_sent;
 }
 
 
 netio::subscribe_socket::subscribe_socket(context* ctx, sockcfg cfg)
-    : socket(ctx, cfg), receiving_socket(ctx, 0, cfg)
+    : socket(ctx, cfg), receiving_socket(ctx, 0, this->cfg)
 {
 }
 
@@ -863,13 +1091,23 @@ netio::subscribe_socket::~subscribe_socket()
 }
 
 
+// The short-lived socket that sends the (un)subscription messages runs on the
+// event loop of the subscribing socket
+static netio::sockcfg
+subscription_cfg(const netio::sockcfg& cfg)
+{
+    return netio::sockcfg::cfg()(netio::sockcfg::EVENT_LOOP, cfg.get(netio::sockcfg::EVENT_LOOP));
+}
+
 static void
 subscription_connection(netio::low_latency_send_socket* subscription_socket, netio::endpoint& ep)
 {
-  // TODO Would be better to do this asynchronously rather than wait
+  // The backends connect synchronously: connect() either opens the socket
+  // or throws, so there is nothing to poll for
   subscription_socket->connect(ep);
-  while(!subscription_socket->is_open())
-      usleep(5); // TODO
+  if(!subscription_socket->is_open())
+      THROW_WITH_MSG(std::runtime_error, "could not open subscription connection to "
+                     << ep.address() << ":" << ep.port());
 }
 
 static void
@@ -889,7 +1127,7 @@ subscription_message(netio::low_latency_send_socket* subscription_socket, uint8_
 void
 netio::subscribe_socket::subscribe(tag tag, endpoint ep)
 {
-    netio::low_latency_send_socket subscription_socket(ctx);
+    netio::low_latency_send_socket subscription_socket(ctx, subscription_cfg(cfg));
     subscription_connection(&subscription_socket, ep);
 
     subscription_message(&subscription_socket,
@@ -902,7 +1140,7 @@ netio::subscribe_socket::subscribe(tag tag, endpoint ep)
 void
 netio::subscribe_socket::subscribe(tag* tags, unsigned n, endpoint ep)
 {
-    netio::low_latency_send_socket subscription_socket(ctx);
+    netio::low_latency_send_socket subscription_socket(ctx, subscription_cfg(cfg));
     subscription_connection(&subscription_socket, ep);
     for(unsigned i=0; i<n; i++)
     {
@@ -917,7 +1155,7 @@ netio::subscribe_socket::subscribe(tag* tags, unsigned n, endpoint ep)
 void
 netio::subscribe_socket::unsubscribe(tag tag, endpoint ep)
 {
-    netio::low_latency_send_socket subscription_socket(ctx);
+    netio::low_latency_send_socket subscription_socket(ctx, subscription_cfg(cfg));
     subscription_connection(&subscription_socket, ep);
 
     subscription_message(&subscription_socket,
@@ -930,7 +1168,7 @@ netio::subscribe_socket::unsubscribe(tag tag, endpoint ep)
 void
 netio::subscribe_socket::unsubscribe(tag* tags, unsigned n, endpoint ep)
 {
-    netio::low_latency_send_socket subscription_socket(ctx);
+    netio::low_latency_send_socket subscription_socket(ctx, subscription_cfg(cfg));
     subscription_connection(&subscription_socket, ep);
 
     for(unsigned i=0; i<n; i++)
@@ -957,6 +1195,13 @@ netio::subscribe_socket::recv(endpoint& ep, message& msg)
 }
 
 
+size_t
+netio::subscribe_socket::recv_many(std::vector<message>& msgs, size_t max, int timeout_ms)
+{
+    return receiving_socket.recv_many(msgs, max, timeout_ms);
+}
+
+
 void
 netio::subscribe_socket::close()
 {
@@ -964,9 +1209,16 @@ netio::subscribe_socket::close()
 }
 
 
+netio::socket_stats&
+netio::subscribe_socket::stats()
+{
+    return receiving_socket.stats();
+}
+
+
 netio::low_latency_subscribe_socket::low_latency_subscribe_socket(
     context* ctx, low_latency_recv_socket::callback_fn fn, sockcfg cfg)
-    : socket(ctx, cfg), receiving_socket(ctx, 0, fn, cfg)
+    : socket(ctx, cfg), receiving_socket(ctx, 0, fn, this->cfg)
 {
 }
 
@@ -976,10 +1228,17 @@ netio::low_latency_subscribe_socket::~low_latency_subscribe_socket()
 }
 
 
+netio::socket_stats&
+netio::low_latency_subscribe_socket::stats()
+{
+    return receiving_socket.stats();
+}
+
+
 void
 netio::low_latency_subscribe_socket::subscribe(tag tag, endpoint ep)
 {
-    netio::low_latency_send_socket subscription_socket(ctx);
+    netio::low_latency_send_socket subscription_socket(ctx, subscription_cfg(cfg));
     subscription_connection(&subscription_socket, ep);
 
     subscription_message(&subscription_socket,
@@ -993,7 +1252,7 @@ netio::low_latency_subscribe_socket::subscribe(tag tag, endpoint ep)
 void
 netio::low_latency_subscribe_socket::subscribe(tag* tags, unsigned n, endpoint ep)
 {
-    netio::low_latency_send_socket subscription_socket(ctx);
+    netio::low_latency_send_socket subscription_socket(ctx, subscription_cfg(cfg));
     subscription_connection(&subscription_socket, ep);
 
     for(unsigned i=0; i<n; i++)
@@ -1010,7 +1269,7 @@ netio::low_latency_subscribe_socket::subscribe(tag* tags, unsigned n, endpoint e
 void
 netio::low_latency_subscribe_socket::unsubscribe(tag tag, endpoint ep)
 {
-    netio::low_latency_send_socket subscription_socket(ctx);
+    netio::low_latency_send_socket subscription_socket(ctx, subscription_cfg(cfg));
     subscription_connection(&subscription_socket, ep);
 
     subscription_message(&subscription_socket,
@@ -1024,7 +1283,7 @@ netio::low_latency_subscribe_socket::unsubscribe(tag tag, endpoint ep)
 void
 netio::low_latency_subscribe_socket::unsubscribe(tag* tags, unsigned n, endpoint ep)
 {
-    netio::low_latency_send_socket subscription_socket(ctx);
+    netio::low_latency_send_socket subscription_socket(ctx, subscription_cfg(cfg));
     subscription_connection(&subscription_socket, ep);
 
     for(unsigned i=0; i<n; i++)
@@ -0,0 +1,57 @@
+#include "netio/netio.hpp"
+
+
+netio::socket_stats::socket_stats()
+    : bytes_in(0), bytes_out(0), msgs_in(0), msgs_out(0),
+      pages_total(0), pages_in_use(0), page_starvation(0),
+      send_queue_depth(0), eagain(0), connects(0)
+{
+    for(unsigned i=0; i<NUM_SIZE_BINS; i++)
+    {
+        msg_size_hist[i].store(0);
+    }
+}
+
+
+unsigned
+netio::socket_stats::size_bin(size_t bytes)
+{
+    if(bytes < 64)
+        return 0;
+    unsigned msb = 63 - __builtin_clzll(bytes);
+    unsigned bin = msb - 5;
+    return bin < NUM_SIZE_BINS ? bin : NUM_SIZE_BINS - 1;
+}
+
+
+void
+netio::socket_stats::count_in(size_t bytes)
+{
+    msgs_in.fetch_add(1, std::memory_order_relaxed);
+    bytes_in.fetch_add(bytes, std::memory_order_relaxed);
+    msg_size_hist[size_bin(bytes)].fetch_add(1, std::memory_order_relaxed);
+}
+
+
+void
+netio::socket_stats::count_out(size_t bytes)
+{
+    msgs_out.fetch_add(1, std::memory_order_relaxed);
+    bytes_out.fetch_add(bytes, std::memory_order_relaxed);
+    msg_size_hist[size_bin(bytes)].fetch_add(1, std::memory_order_relaxed);
+}
+
+
+uint64_t
+netio::socket_stats::reconnects() const
+{
+    uint64_t n = connects.load();
+    return n > 1 ? n - 1 : 0;
+}
+
+
+int64_t
+netio::socket_stats::pages_available() const
+{
+    return pages_total.load() - pages_in_use.load();
+}
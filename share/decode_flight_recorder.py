@@ -0,0 +1,70 @@
+#!/usr/bin/env python3
+############################################
+# Decoder for the flight recorder dumps
+# of the RD53A-OPC-server
+# (RD53A::FlightRecorder)
+# October 2026
+############################################
+
+import sys
+import struct
+import argparse
+import datetime
+
+FILE_HEADER = struct.Struct('<8sIIIIQqQq')
+RING_HEADER = struct.Struct('<II')
+EVENT = struct.Struct('<QIIQ')
+
+EVENT_TYPES = {1: "MESSAGE_RECEIVED",
+               2: "FRAMES_DECODED",
+               3: "COMMAND_SENT",
+               4: "REGISTER_MATCHED",
+               5: "SENSOR_UPDATED"}
+
+def describe(etype, arg0, arg1):
+    if etype == 1: return "elink=%i size=%i" % (arg0, arg1)
+    if etype == 2: return "chip=%i frames=%i" % (arg0, arg1)
+    if etype == 3: return "elink=%i size=%i" % (arg0, arg1)
+    if etype == 4: return "chip=%i address=%i value=0x%04x" % (arg0, (arg1>>16)&0xFFFF, arg1&0xFFFF)
+    if etype == 5: return "chip=%i sensor=%s%i adc=%i" % (arg0, ("NTC","BJT")[(arg1>>24)&1], (arg1>>16)&0xFF, arg1&0xFFFF)
+    return "arg0=%i arg1=%i" % (arg0, arg1)
+
+def read(path):
+    data = open(path, 'rb').read()
+    magic, version, num_rings, event_size, ring_size, t0, rt0, t1, rt1 = FILE_HEADER.unpack_from(data, 0)
+    if magic != b'RD53AFR1' or event_size != EVENT.size:
+        raise ValueError("%s is not a flight recorder dump" % path)
+    #event clock to wall clock, from the two reference points
+    scale = float(rt1-rt0)/(t1-t0) if t1 != t0 else 1.
+    events = []
+    offset = FILE_HEADER.size
+    for ring in range(num_rings):
+        tid, num_events = RING_HEADER.unpack_from(data, offset)
+        offset += RING_HEADER.size
+        for i in range(num_events):
+            time, etype, arg0, arg1 = EVENT.unpack_from(data, offset)
+            offset += EVENT.size
+            events.append((rt0 + (time-t0)*scale, tid, etype, arg0, arg1))
+            pass
+        pass
+    events.sort()
+    return events
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser("Decode a flight recorder dump")
+    parser.add_argument("dump", help="flightrecorder-<pid>.bin file")
+    parser.add_argument("-t", "--thread", type=int, help="only events of this thread id")
+    parser.add_argument("-e", "--event", choices=EVENT_TYPES.values(), help="only events of this type")
+    parser.add_argument("-n", "--last", type=int, help="only the last N events")
+    args = parser.parse_args()
+
+    events = read(args.dump)
+    if args.thread: events = [e for e in events if e[1] == args.thread]
+    if args.event: events = [e for e in events if EVENT_TYPES.get(e[2]) == args.event]
+    if args.last: events = events[-args.last:]
+
+    for ns, tid, etype, arg0, arg1 in events:
+        ts = datetime.datetime.fromtimestamp(ns/1e9).strftime("%Y-%m-%d %H:%M:%S")
+        print("%s.%09i tid=%-7i %-16s %s" % (ts, int(ns)%1000000000, tid, EVENT_TYPES.get(etype, str(etype)), describe(etype, arg0, arg1)))
+        pass
+    pass